@@ -49,7 +49,7 @@
 #include <pthread.h>
 
 #include "allocore/io/al_AudioIO.hpp"
-#include "allocore/types/al_SingleRWRingBuffer.hpp"
+#include "allocore/types/al_SPSCRing.hpp"
 #include "allocore/types/al_MsgQueue.hpp"
 #include "allocore/protocol/al_OSC.hpp"
 #include "allocore/system/al_Thread.hpp"
@@ -200,7 +200,7 @@ private:
 
     /* output data */
     std::vector<float> m_meters;
-    SingleRWRingBuffer m_meterBuffer;
+    SPSCRing<float> m_meterBuffer;
     int m_meterCounter; /* count samples for level updates */
     std::string m_sendAddress;
     int m_sendPort;
@@ -14,7 +14,7 @@ using namespace al;
 OutputMaster::OutputMaster(int num_chnls, double sampleRate, const char *address, int port,
 						   const char *sendAddress, int sendPort, al_sec msg_timeout):
 	m_numChnls(num_chnls),
-	m_meterBuffer(1024 * sizeof(float)), m_framesPerSec(sampleRate),
+	m_meterBuffer(1024), m_framesPerSec(sampleRate),
 	osc::Recv(port, address, msg_timeout),
 	m_sendAddress(sendAddress), m_sendPort(sendPort)
 {
@@ -121,7 +121,7 @@ void OutputMaster::setMeterOn(bool meterOn)
 
 int OutputMaster::getMeterValues(float *values)
 {
-	return m_meterBuffer.read((char *) values, m_numChnls * sizeof(float));
+	return m_meterBuffer.read(values, m_numChnls);
 }
 
 int OutputMaster::getNumChnls()
@@ -220,7 +220,7 @@ void OutputMaster::processBlock(AudioIOData &io)
 		}
 		m_meterCounter += nframes;
 		if (m_meterCounter >= m_meterUpdateSamples) {
-			m_meterBuffer.write( (char *) m_meters.data(), sizeof(float) * m_numChnls);
+			m_meterBuffer.write(m_meters.data(), m_numChnls);
 			memset(m_meters.data(), 0, sizeof(float) * m_numChnls);
 			m_meterCounter = 0; // A little jitter but efficient
 			pthread_cond_signal(&m_meterCond);
@@ -321,12 +321,12 @@ void *OutputMaster::meterThreadFunc(void *arg) {
 	while(om->m_runMeterThread) {
 		pthread_mutex_lock(&om->m_meterMutex);
 		pthread_cond_wait(&om->m_meterCond, &om->m_meterMutex);
-		int bytes_read = om->m_meterBuffer.read((char *) meter_levels, om->m_numChnls * sizeof(float));
-		if (bytes_read) {
-			if (bytes_read !=  om->m_numChnls * sizeof(float)) {
+		int values_read = om->m_meterBuffer.read(meter_levels, om->m_numChnls);
+		if (values_read) {
+			if (values_read != om->m_numChnls) {
 				std::cerr << "Alloaudio: Warning. Meter values underrun." << std::endl;
 			}
-			for (int i = 0; i < bytes_read/sizeof(float); i++) {
+			for (int i = 0; i < values_read; i++) {
 			  std::stringstream addr;
 			  addr << "/Alloaudio/meterdb/" <<  chanindex + 1;
 				//            lo_send(t, "/Alloaudio/meter", "if", i, meter_levels[i]);
@@ -42,11 +42,14 @@
 
 #include "allocore/graphics/al_DisplayList.hpp"
 #include "allocore/graphics/al_FBO.hpp"
+#include "allocore/graphics/al_GlyphAtlas.hpp"
 #include "allocore/graphics/al_Graphics.hpp"
 #include "allocore/graphics/al_Image.hpp"
+#include "allocore/graphics/al_ImageLoader.hpp"
 //#include "allocore/graphics/al_Isosurface.hpp"
 #include "allocore/graphics/al_Lens.hpp"
 #include "allocore/graphics/al_Light.hpp"
+#include "allocore/graphics/al_PolylineMesh.hpp"
 #include "allocore/graphics/al_Shader.hpp"
 #include "allocore/graphics/al_Shapes.hpp"
 #include "allocore/graphics/al_Stereographic.hpp"
@@ -60,6 +63,7 @@
 #include "allocore/math/al_Analysis.hpp"
 #include "allocore/math/al_Complex.hpp"
 #include "allocore/math/al_Constants.hpp"
+#include "allocore/math/al_FFT.hpp"
 #include "allocore/math/al_Frustum.hpp"
 #include "allocore/math/al_Functions.hpp"
 #include "allocore/math/al_Interpolation.hpp"
@@ -70,24 +74,35 @@
 #include "allocore/math/al_Random.hpp"
 #include "allocore/math/al_Ray.hpp"
 #include "allocore/math/al_Spherical.hpp"
+#include "allocore/math/al_Transform.hpp"
 #include "allocore/math/al_Vec.hpp"
 #include "allocore/protocol/al_OSC.hpp"
 #include "allocore/protocol/al_Serialize.hpp"
+#include "allocore/protocol/al_StateSync.hpp"
 #include "allocore/sound/al_Reverb.hpp"
 #include "allocore/sound/al_Speaker.hpp"
 #include "allocore/sound/al_AudioScene.hpp"
 #include "allocore/sound/al_Ambisonics.hpp"
+#include "allocore/sound/al_Binaural.hpp"
+#include "allocore/sound/al_Convolver.hpp"
 #include "allocore/sound/al_Dbap.hpp"
 #include "allocore/sound/al_Vbap.hpp"
 #include "allocore/spatial/al_Curve.hpp"
 #include "allocore/spatial/al_DistAtten.hpp"
+#include "allocore/spatial/al_FrustumCuller.hpp"
 #include "allocore/spatial/al_Pose.hpp"
+#include "allocore/system/al_Atomic.hpp"
 #include "allocore/system/al_Info.hpp"
 #include "allocore/system/al_MainLoop.hpp"
+#include "allocore/system/al_PeriodicThread.hpp"
 #include "allocore/system/al_Printing.hpp"
 #include "allocore/system/al_Thread.hpp"
+#include "allocore/system/al_ThreadPool.hpp"
 #include "allocore/system/al_Time.hpp"
 #include "allocore/types/al_Buffer.hpp"
 #include "allocore/types/al_Conversion.hpp"
 #include "allocore/types/al_Array.hpp"
+#include "allocore/types/al_BrickArray.hpp"
 #include "allocore/types/al_SingleRWRingBuffer.hpp"
+#include "allocore/types/al_SPSCRing.hpp"
+#include "allocore/types/al_TripleBuffer.hpp"
@@ -55,6 +55,8 @@
 
 namespace al{
 
+class GlyphAtlas;
+
 class Font {
 public:
 
@@ -114,12 +116,20 @@ public:
 	void write(Mesh& mesh, const std::string& text);
 
 	/*
-		Renders using an internal mesh (reset for each render() call)
-		For rendering large volumes of text, use write() instead.
+		Renders using an internal mesh, which is rewritten when the text changes
+		For rendering large volumes of text, use write() or a TextCache instead.
 	*/
 	void render(Graphics& g, const std::string& text);
 	void renderf(Graphics& g, const char * fmt, ...);
 
+	/// Add glyphs of font to an atlas as a new face
+
+	/// The glyph quads match those made by write(), so text written with a
+	/// TextCache using the face looks the same as text written by the font.
+	/// \returns index of face in atlas, or -1 if the font is not loaded or
+	/// the atlas ran out of room
+	int addTo(GlyphAtlas& atlas) const;
+
 	// TODO:
 	//int outline(int idx, Array *vertex, Array *index);
 
@@ -141,6 +151,7 @@ protected:
 	//The a bitmap of the font's ASCII characters in a 16x16 grid
 	Texture mTex;
 	Mesh mMesh;
+	std::string mMeshText;	// text in mMesh
 };
 
 inline void Font :: renderf(Graphics& g, const char * fmt, ...) {
@@ -153,7 +164,10 @@ inline void Font :: renderf(Graphics& g, const char * fmt, ...) {
 }
 
 inline void Font :: render(Graphics& g, const std::string& text) {
-	write(mMesh, text);
+	if(text != mMeshText){
+		write(mMesh, text);
+		mMeshText = text;
+	}
 	mTex.bind(0);
 	g.draw(mMesh);
 	mTex.unbind(0);
@@ -0,0 +1,247 @@
+#ifndef INCLUDE_AL_GLYPHATLAS_HPP
+#define INCLUDE_AL_GLYPHATLAS_HPP
+
+/*	Allocore --
+	Multimedia / virtual environment application class library
+
+	Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+	Copyright (C) 2012. The Regents of the University of California.
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice,
+		this list of conditions and the following disclaimer.
+
+		Redistributions in binary form must reproduce the above copyright
+		notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+
+		Neither the name of the University of California nor the names of its
+		contributors may be used to endorse or promote products derived from
+		this software without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+
+
+
+	File description:
+	Glyph atlas, cached text layouts and batched text meshes
+
+	A GlyphAtlas packs the glyph bitmaps of several fonts or font sizes into
+	one single-channel image, so that any mix of them can be drawn with one
+	texture. A TextCache lays out each distinct string once per face and
+	writes many labels into one mesh, sizing the mesh buffers once instead of
+	appending quad by quad. None of this needs a graphics context; the atlas
+	pixels are uploaded by the caller, e.g. with Texture::submit.
+*/
+
+#include <string>
+#include <vector>
+#include "allocore/graphics/al_Mesh.hpp"
+#include "allocore/math/al_Vec.hpp"
+#include "allocore/system/al_Config.h"
+
+namespace al{
+
+
+/// Rectangle of a glyph in text space and in an atlas
+struct GlyphQuad{
+	float x0, y0, x1, y1;	///< corners relative to the pen position, y up
+	float s0, t0, s1, t1;	///< texture coordinates of the corners
+};
+
+
+/// A glyph in an atlas
+struct Glyph{
+	GlyphQuad quad;			///< rectangle of glyph
+	float advance;			///< distance to move pen after glyph
+};
+
+
+/// Glyph bitmaps of several faces packed into one image
+
+/// A face is one font at one size. Glyphs are indexed by face and character
+/// code (0..255). Bitmaps are packed left to right in rows from the top of
+/// the image, with a pixel of padding between them so that filtering does
+/// not blend neighboring glyphs.
+///
+/// @ingroup allocore
+class GlyphAtlas{
+public:
+
+	/// @param[in] width	width of atlas image, in pixels
+	/// @param[in] height	height of atlas image, in pixels
+	GlyphAtlas(int width=512, int height=512);
+
+
+	/// Get width of atlas image
+	int width() const { return mWidth; }
+
+	/// Get height of atlas image
+	int height() const { return mHeight; }
+
+	/// Get pixels of atlas image, one byte per pixel, rows from the top
+	const unsigned char * pixels() const { return &mPixels[0]; }
+
+	/// Get a number that changes whenever the pixels change
+	unsigned version() const { return mVersion; }
+
+	/// Get number of faces
+	int numFaces() const { return mFaces.size(); }
+
+	/// Get distance between lines of a face
+	float lineHeight(int face) const { return mFaces[face].lineHeight; }
+
+	/// Get glyph of a face, or null if the glyph has not been added
+	const Glyph * glyph(int face, int code) const {
+		const Face& f = mFaces[face];
+		return f.has[code & 255] ? &f.glyphs[code & 255] : 0;
+	}
+
+
+	/// Add a face and return its index
+
+	/// @param[in] lineHeight	distance between lines of text
+	int addFace(float lineHeight);
+
+	/// Remove the most recently added face
+
+	/// The space taken by its glyphs is cleared and used by the next glyphs
+	/// added. This undoes a face whose glyphs did not all fit.
+	void removeLastFace();
+
+	/// Add a glyph to a face
+
+	/// @param[in] face		face index
+	/// @param[in] code		character code (0..255)
+	/// @param[in] bitmap	glyph pixels, one byte per pixel, rows from the top
+	/// @param[in] w		width of bitmap
+	/// @param[in] h		height of bitmap
+	/// @param[in] stride	bytes between rows of bitmap
+	/// @param[in] left		distance from pen to left edge of bitmap
+	/// @param[in] top		distance from baseline up to top edge of bitmap
+	/// @param[in] advance	distance to move pen after glyph
+	/// \returns whether there was room for the glyph
+	bool add(
+		int face, int code, const unsigned char * bitmap, int w, int h, int stride,
+		float left, float top, float advance
+	);
+
+	/// Remove all faces and glyphs
+	void clear();
+
+private:
+	struct Face{
+		Face()
+		:	glyphs(256), has(256, false), lineHeight(0),
+			penX(0), penY(0), rowHeight(0)
+		{}
+		std::vector<Glyph> glyphs;
+		std::vector<bool> has;
+		float lineHeight;
+		int penX, penY, rowHeight;	// packing position when face was added
+	};
+
+	int mWidth, mHeight;
+	int mPenX, mPenY, mRowHeight;	// packing position and height of current row
+	unsigned mVersion;
+	std::vector<unsigned char> mPixels;
+	std::vector<Face> mFaces;
+};
+
+
+/// A label to write with a TextCache
+struct TextLabel{
+	Vec3f pos;			///< position of pen at start of text
+	float scale;		///< size of an atlas pixel in the mesh
+	float align;		///< horizontal alignment; 0 is left, 0.5 center, 1 right
+	int layout;			///< layout from TextCache::layout
+
+	TextLabel(const Vec3f& p=Vec3f(0), int layoutID=0, float scl=1, float alg=0)
+	:	pos(p), scale(scl), align(alg), layout(layoutID)
+	{}
+};
+
+
+/// Cache of text layouts and writer of text meshes
+
+/// Laying out a string looks up each of its glyphs once; the resulting quads
+/// are kept in a hash table keyed by the string and face, and reused by every
+/// label showing that string. A newline moves the pen down one line of the
+/// face. Codes without a glyph in the face are skipped.
+///
+/// @ingroup allocore
+class TextCache{
+public:
+
+	/// @param[in] atlas	atlas to take glyphs from; must outlive the cache
+	TextCache(const GlyphAtlas& atlas): mAtlas(&atlas){}
+
+
+	/// Get layout of a string in a face, laying it out if it is not cached
+	int layout(const std::string& text, int face);
+
+	/// Get width of longest line of a layout
+	float width(int layout) const { return mLayouts[layout].width; }
+
+	/// Get number of glyph quads of a layout
+	int size(int layout) const { return mLayouts[layout].count; }
+
+	/// Get glyph quads of a layout
+	const GlyphQuad * quads(int layout) const { return &mQuads[mLayouts[layout].begin]; }
+
+	/// Get number of cached layouts
+	int numLayouts() const { return mLayouts.size(); }
+
+	/// Remove all cached layouts
+
+	/// This should be called when glyphs the layouts use have changed.
+	///
+	void clear();
+
+
+	/// Write labels into a mesh
+
+	/// The mesh's vertices, 2D texture coordinates and indices are replaced,
+	/// its other buffers are cleared and its primitive is set to triangles.
+	/// Quads lie in the xy-plane at each label's position.
+	void write(Mesh& m, const TextLabel * labels, int n);
+
+	/// Write labels into a mesh
+	void write(Mesh& m, const std::vector<TextLabel>& labels){
+		write(m, labels.empty() ? 0 : &labels[0], labels.size());
+	}
+
+private:
+	struct Layout{
+		std::string text;
+		int face;
+		uint32_t hash;
+		int begin, count;
+		float width;
+	};
+
+	const GlyphAtlas * mAtlas;
+	std::vector<Layout> mLayouts;
+	std::vector<int> mTable;			// open addressed hash table of layouts
+	std::vector<GlyphQuad> mQuads;
+	std::vector<int> mStarts;			// first quad of each label in mesh
+
+	void insert(int layout);
+};
+
+} // al::
+
+#endif
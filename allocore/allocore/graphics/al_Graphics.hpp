@@ -496,6 +496,13 @@ public:
 	/// @param[in] begin	Begin index of vertices or indices to draw (inclusive)
 	void draw(const Mesh& m, int count=-1, int begin=0);
 
+	/// Draw interleaved vertex data
+
+	/// @param[in] m		Vertex data to draw
+	/// @param[in] count	Number of vertices or indices to draw
+	/// @param[in] begin	Begin index of vertices or indices to draw (inclusive)
+	void draw(const InterleavedMesh& m, int count=-1, int begin=0);
+
 	/// Draw internal vertex data
 	void draw(){ draw(mMesh); }
 
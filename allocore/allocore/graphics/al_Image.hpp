@@ -214,6 +214,11 @@ public:
 	};
 
 protected:
+	friend class ImageLoader;
+
+	// Create library implementation, if not already
+	void initImpl();
+
 	Array mArray;			// pixel data
 	Impl * mImpl;			// library implementation
 	std::string mFilename;
@@ -0,0 +1,204 @@
+#ifndef INCLUDE_AL_IMAGE_LOADER_HPP
+#define INCLUDE_AL_IMAGE_LOADER_HPP
+
+/*	Allocore --
+	Multimedia / virtual environment application class library
+
+	Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+	Copyright (C) 2012. The Regents of the University of California.
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice,
+		this list of conditions and the following disclaimer.
+
+		Redistributions in binary form must reproduce the above copyright
+		notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+
+		Neither the name of the University of California nor the names of its
+		contributors may be used to endorse or promote products derived from
+		this software without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+
+
+
+	File description:
+	Decodes image files on background threads
+
+	Requests go into a lock-free queue that a few worker threads take from.
+	Idle workers sleep on a condition variable until a request is queued.
+	Each request owns the Image it is decoded into, so a request that is
+	reused for images of the same size and format (e.g. the frames of an
+	image sequence) decodes into the same pixel memory every time. Callbacks
+	and the cache of decoded images are only touched by the thread that
+	queues requests and calls poll(), which is typically the graphics thread
+	that uploads the images to textures.
+*/
+
+#include <map>
+#include <string>
+#include <vector>
+#include "allocore/graphics/al_Image.hpp"
+#include "allocore/system/al_Atomic.hpp"
+#include "allocore/system/al_Thread.hpp"
+
+namespace al{
+
+
+/// Loads images asynchronously using a pool of worker threads
+
+/// A typical use is
+/// \code
+///	ImageLoader loader;
+///	ImageLoader::Request req;
+///	loader.load(req, "image.png");
+///	...
+///	if(req.ready() && req.ok()) texture.submit(req.image().array());
+/// \endcode
+///
+/// load(), poll() and the cache methods must all be called from the same
+/// thread.
+///
+/// @ingroup allocore
+class ImageLoader{
+public:
+
+	struct Callback;
+
+	/// Handle to an image being loaded
+
+	/// A request must not be destroyed while it is pending. It can be reused
+	/// once poll() has handled it.
+	class Request{
+	public:
+		Request(): mCallback(0), mLoader(0), mState(EMPTY){}
+
+		/// Whether the image has been decoded or has failed to load
+		bool ready() const { return loadAcquire(mState) > PENDING; }
+
+		/// Whether the image was decoded successfully
+		bool ok() const { return LOADED == loadAcquire(mState); }
+
+		/// Block until the image is ready
+
+		/// Returns immediately if the request has never been queued.
+		///
+		void wait() const;
+
+		/// Get path of file being loaded
+		const std::string& path() const { return mPath; }
+
+		/// Get decoded image; only valid when ready
+		Image& image(){ return mImage; }
+		const Image& image() const { return mImage; }
+
+	private:
+		friend class ImageLoader;
+		enum{ EMPTY, PENDING, LOADED, FAILED };
+		Image mImage;
+		std::string mPath;
+		Callback * mCallback;
+		ImageLoader * mLoader;
+		volatile long mState;
+	};
+
+	/// Receives requests that have finished loading
+	struct Callback{
+		virtual ~Callback(){}
+
+		/// Called from poll() once a request is ready; check Request::ok()
+		virtual void onImageLoaded(Request& req) = 0;
+	};
+
+
+	/// @param[in] numThreads	number of decoding threads
+	/// @param[in] capacity		maximum number of queued requests; rounded up
+	///							to a power of two
+	ImageLoader(int numThreads = 2, int capacity = 64);
+
+	~ImageLoader();
+
+
+	/// Queue an image file to be decoded
+
+	/// If the file is in the cache, the cached image is copied into the
+	/// request, which is then immediately ready.
+	/// \returns false if the queue is full or the request has not yet been
+	/// handled by poll()
+	bool load(Request& req, const std::string& path, Callback * cb = 0);
+
+	/// Call back finished requests and add their images to the cache
+
+	/// \returns number of requests that finished
+	int poll();
+
+	/// Number of requests queued or being decoded
+	int pending() const { return mPending.size(); }
+
+
+	/// Set maximum number of decoded images kept by path
+
+	/// When the cache is full, the least recently used image is dropped. The
+	/// default size of 0 disables caching.
+	ImageLoader& cacheSize(int n);
+
+	/// Get maximum number of decoded images kept by path
+	int cacheSize() const { return mCacheSize; }
+
+	/// Get a cached image or 0 if the file is not in the cache
+	const Image * cached(const std::string& path);
+
+	/// Remove all images from the cache
+	void clearCache();
+
+private:
+	struct Impl;
+	struct Worker : public ThreadFunction{
+		ImageLoader * loader;
+		Worker(): loader(0){}
+		void operator()();
+	};
+
+	struct CacheEntry{
+		Image * image;
+		unsigned long used;
+	};
+	typedef std::map<std::string, CacheEntry> Cache;
+
+	Request * take();
+	void finish(Request& req, bool ok);
+	void decodeLoop();
+	void addToCache(const Request& req);
+	void evict(int maxSize);
+	static void copy(Image& dst, const Image& src);
+
+	std::vector<Request *> mQueue;		// ring of queued requests
+	volatile long mHead, mTail;			// next to take and next to queue
+	long mMask;
+	volatile bool mRunning;
+	Impl * mImpl;						// wakes idle workers and waiters
+	Threads<Worker> mWorkers;
+
+	std::vector<Request *> mPending;	// requests whose callbacks are due
+	Cache mCache;
+	int mCacheSize;
+	unsigned long mCacheClock;
+};
+
+} // al::
+
+#endif
@@ -47,6 +47,7 @@
 #include <stdio.h>
 #include "allocore/math/al_Vec.hpp"
 #include "allocore/math/al_Matrix4.hpp"
+#include "allocore/math/al_Transform.hpp"
 #include "allocore/types/al_Buffer.hpp"
 #include "allocore/types/al_Color.hpp"
 
@@ -76,6 +77,31 @@ public:
 	typedef Buffer<TexCoord3>	TexCoord3s;
 	typedef Buffer<Index>		Indices;
 
+	/// Vertex attributes
+	enum Attribute{
+		VERTEX		= 1<<0,		///< Vertex positions
+		NORMAL		= 1<<1,		///< Normals
+		COLOR		= 1<<2,		///< Floating-point colors
+		COLORI		= 1<<3,		///< Integer colors
+		TEXCOORD2	= 1<<4,		///< 2D texture coordinates
+		TEXCOORD3	= 1<<5		///< 3D texture coordinates
+	};
+
+	/// Range of vertices added in bulk
+
+	/// Attributes not requested when adding the vertices have null pointers.
+	///
+	struct Span{
+		Vertex * vertices;
+		Normal * normals;
+		Color * colors;
+		Colori * coloris;
+		TexCoord2 * texCoord2s;
+		TexCoord3 * texCoord3s;
+		int begin;				///< Index of first vertex
+		int size;				///< Number of vertices
+	};
+
 
 	/// @param[in] primitive	renderer-dependent primitive number
 	Mesh(int primitive=0): mPrimitive(primitive){}
@@ -117,8 +143,37 @@ public:
 	void merge(const Mesh& src);
 
 	/// Reset all buffers
+
+	/// Sizes are set to zero, but allocated memory is kept for reuse.
+	///
 	Mesh& reset();
 
+	/// Reserve memory for buffers
+
+	/// Meshes rebuilt every frame can reserve their largest sizes once so that
+	/// neither appending nor adding in bulk will allocate memory afterwards.
+	/// @param[in] vertices		number of vertices
+	/// @param[in] indices		number of indices
+	/// @param[in] attributes	bitwise-or of Attribute flags
+	Mesh& reserve(int vertices, int indices=0, int attributes=VERTEX);
+
+	/// Add vertices in bulk
+
+	/// This extends the requested attribute buffers by n elements and returns
+	/// pointers to them, to be written directly. Attribute buffers are first
+	/// set to the size of the vertex buffer so that new attributes line up
+	/// with the new vertices. The pointers are valid until the capacity of
+	/// their buffer next changes.
+	/// @param[in] n			number of vertices to add
+	/// @param[in] attributes	bitwise-or of Attribute flags
+	Span addVertices(int n, int attributes=VERTEX);
+
+	/// Add indices in bulk
+
+	/// \returns pointer to n new indices, valid until the capacity of the
+	/// index buffer next changes
+	Index * addIndices(int n){ return indices().extend(n); }
+
 	/// Scale all vertices to lie in [-1,1]
 	void unitize(bool proportional=true);
 
@@ -144,6 +199,26 @@ public:
 	template <class T>
 	Mesh& transform(const Mat<4,T>& m, int begin=0, int end=-1);
 
+	/// Transform normals by inverse transpose of matrix
+
+	/// This is the transform that keeps normals perpendicular to a surface
+	/// whose vertices are transformed by the matrix.
+	/// @param[in] m		affine transform matrix
+	/// @param[in] begin	beginning index of normals
+	/// @param[in] end		ending index of normals, negative amounts specify
+	///						distance from one past last element
+	template <class T>
+	Mesh& transformNormals(const Mat<4,T>& m, int begin=0, int end=-1);
+
+	/// Rotate vertices and normals by a unit quaternion
+
+	/// @param[in] q		rotation
+	/// @param[in] begin	beginning index of vertices and normals
+	/// @param[in] end		ending index of vertices and normals, negative
+	///						amounts specify distance from one past last element
+	template <class T>
+	Mesh& rotate(const Quat<T>& q, int begin=0, int end=-1);
+
 	/// Generates indices for a set of vertices
 	void compress();
 
@@ -337,13 +412,125 @@ protected:
 
 
 
+/// Vertex storing all of its attributes together
+struct InterleavedVertex{
+	Mesh::Vertex position;
+	Mesh::Normal normal;
+	Mesh::TexCoord2 texCoord;
+	Colori color;
+};
+
+
+/// Mesh with interleaved vertex attributes
+
+/// Where Mesh stores each vertex attribute in its own buffer, this stores
+/// whole vertices in one buffer so that each vertex is written and read from
+/// one place in memory. The attributes that are drawn are chosen from
+/// Mesh::VERTEX, Mesh::NORMAL, Mesh::COLORI and Mesh::TEXCOORD2; positions
+/// are always drawn. As with Mesh, resetting keeps allocated memory.
+class InterleavedMesh {
+public:
+
+	typedef InterleavedVertex	Vertex;
+	typedef Mesh::Index			Index;
+	typedef Buffer<Vertex>		Vertices;
+	typedef Buffer<Index>		Indices;
+
+
+	/// @param[in] primitive	renderer-dependent primitive number
+	/// @param[in] attributes	bitwise-or of Mesh::Attribute flags to draw
+	InterleavedMesh(int primitive=0, int attributes=Mesh::VERTEX)
+	:	mPrimitive(primitive), mAttributes(attributes)
+	{}
+
+
+	int primitive() const { return mPrimitive; }
+	int attributes() const { return mAttributes; }
+	const Vertices& vertices() const { return mVertices; }
+	const Indices& indices() const { return mIndices; }
+	Vertices& vertices(){ return mVertices; }
+	Indices& indices(){ return mIndices; }
+
+	/// Set geometric primitive
+	InterleavedMesh& primitive(int prim){ mPrimitive=prim; return *this; }
+
+	/// Set attributes to draw as bitwise-or of Mesh::Attribute flags
+	InterleavedMesh& attributes(int v){ mAttributes=v; return *this; }
+
+	/// Reserve memory for vertices and indices
+	InterleavedMesh& reserve(int vertices, int indices=0){
+		mVertices.reserve(vertices);
+		mIndices.reserve(indices);
+		return *this;
+	}
+
+	/// Reset vertices and indices, keeping allocated memory
+	InterleavedMesh& reset(){
+		mVertices.reset();
+		mIndices.reset();
+		return *this;
+	}
+
+	/// Add vertices in bulk
+
+	/// \returns pointer to n new vertices, valid until the capacity of the
+	/// vertex buffer next changes
+	Vertex * addVertices(int n){ return mVertices.extend(n); }
+
+	/// Add indices in bulk
+
+	/// \returns pointer to n new indices, valid until the capacity of the
+	/// index buffer next changes
+	Index * addIndices(int n){ return mIndices.extend(n); }
+
+	/// Append vertex
+	void vertex(const Vertex& v){ mVertices.append(v); }
+
+	/// Append index
+	void index(Index i){ mIndices.append(i); }
+
+protected:
+	Vertices mVertices;
+	Indices mIndices;
+	int mPrimitive;
+	int mAttributes;
+};
+
+
+
 
 template <class T>
 Mesh& Mesh::transform(const Mat<4,T>& m, int begin, int end){
 	if(end<0) end += vertices().size()+1; // negative index wraps to end of array
-	for(int i=begin; i<end; ++i){
-		Vertex& v = vertices()[i];
-		v.set(m * Vec<4,T>(v, 1));
+	if(end > begin){
+		Vertex * v = &vertices()[begin];
+		transformPoints(Mat4f(m), v, v, end-begin);
+	}
+	return *this;
+}
+
+template <class T>
+Mesh& Mesh::transformNormals(const Mat<4,T>& m, int begin, int end){
+	if(end<0) end += normals().size()+1;
+	if(end > begin){
+		Normal * n = &normals()[begin];
+		al::transformNormals(Mat4f(m), n, n, end-begin);
+	}
+	return *this;
+}
+
+template <class T>
+Mesh& Mesh::rotate(const Quat<T>& q, int begin, int end){
+	const Quatf qf(q.w, q.x, q.y, q.z);
+	int endV = end<0 ? end + vertices().size()+1 : end;
+	int endN = end<0 ? end + normals().size()+1 : end;
+	if(endV > begin){
+		Vertex * v = &vertices()[begin];
+		rotateVectors(qf, v, v, endV-begin);
+	}
+	if(endN > begin){
+		Normal * n = &normals()[begin];
+		rotateVectors(qf, n, n, endN-begin);
 	}
 	return *this;
 }
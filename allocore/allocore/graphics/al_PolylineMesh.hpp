@@ -0,0 +1,164 @@
+#ifndef INCLUDE_AL_POLYLINEMESH_HPP
+#define INCLUDE_AL_POLYLINEMESH_HPP
+
+/*	Allocore --
+	Multimedia / virtual environment application class library
+
+	Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+	Copyright (C) 2012. The Regents of the University of California.
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice,
+		this list of conditions and the following disclaimer.
+
+		Redistributions in binary form must reproduce the above copyright
+		notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+
+		Neither the name of the University of California nor the names of its
+		contributors may be used to endorse or promote products derived from
+		this software without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+
+
+
+	File description:
+	Ribbon and tube meshes for many polylines at once
+
+	All lines are written into one indexed triangle mesh. The number of
+	vertices and indices of each line is known from its number of points, so
+	the output ranges of the lines are found first by a running sum and the
+	mesh buffers are sized once. The lines can then be generated in any order
+	or in parallel over a ThreadPool. Frenet frames are computed for blocks of
+	points held in separate component arrays, which the compiler vectorizes.
+*/
+
+#include <vector>
+#include "allocore/graphics/al_Mesh.hpp"
+#include "allocore/math/al_Vec.hpp"
+
+namespace al{
+
+class ThreadPool;
+
+
+/// A set of polylines stored end to end in one point array
+
+/// Lines can be added with add() or by appending to the point array and then
+/// pushing the new total number of points onto the start array.
+struct Polylines{
+	std::vector<Vec3f> points;	///< points of all lines
+	std::vector<float> widths;	///< width factor per point; empty for all ones
+	std::vector<int> starts;	///< index of first point of each line, then the number of points
+
+	Polylines(){ clear(); }
+
+	/// Get number of lines
+	int size() const { return int(starts.size()) - 1; }
+
+	/// Get number of points of a line
+	int size(int line) const { return starts[line+1] - starts[line]; }
+
+	/// Remove all lines
+	void clear(){ points.clear(); widths.clear(); starts.assign(1, 0); }
+
+	/// Add a line
+
+	/// @param[in] pts		points of line
+	/// @param[in] n		number of points
+	/// @param[in] w		width factor per point; if null, the widths are one
+	void add(const Vec3f * pts, int n, const float * w=0){
+		if(w || !widths.empty()){
+			widths.resize(points.size(), 1.f);
+			if(w)	widths.insert(widths.end(), w, w+n);
+			else	widths.resize(points.size()+n, 1.f);
+		}
+		points.insert(points.end(), pts, pts+n);
+		starts.push_back(points.size());
+	}
+};
+
+
+/// Generates ribbon or tube meshes for sets of polylines
+
+/// The frame at each point is computed from it and its two neighbors as in
+/// Mesh::ribbonize; end points use the frame of their neighbor. Lines with
+/// fewer than three points produce no geometry. As with Frenet, runs of
+/// colinear points have no defined frame and give degenerate geometry.
+///
+/// The mesh's vertices, normals and indices are replaced, its other buffers
+/// are cleared and its primitive is set to triangles. Buffers keep their
+/// capacity, so regenerating lines of similar sizes does not allocate.
+///
+/// @ingroup allocore
+class PolylineMesher{
+public:
+
+	PolylineMesher();
+
+
+	/// Set distance of ribbon edges or tube surface from the curve
+
+	/// This is multiplied by the width factors of the points, if any.
+	///
+	PolylineMesher& width(float v){ mWidth=v; return *this; }
+
+	/// Set number of sides of tubes
+	PolylineMesher& sides(int v);
+
+	/// Set whether ribbons face the binormal, rather than the normal, of the curve
+	PolylineMesher& faceBinormal(bool v){ mFaceBinormal=v; return *this; }
+
+
+	/// Generate ribbons, two vertices per point
+	void ribbons(Mesh& m, const Polylines& lines);
+
+	/// Generate ribbons, splitting the lines over a thread pool
+	void ribbons(Mesh& m, const Polylines& lines, ThreadPool& pool);
+
+	/// Generate tubes, one ring of vertices per point
+	void tubes(Mesh& m, const Polylines& lines);
+
+	/// Generate tubes, splitting the lines over a thread pool
+	void tubes(Mesh& m, const Polylines& lines, ThreadPool& pool);
+
+
+	/// Get index of first vertex of a line in the last generated mesh
+	int firstVertex(int line) const { return mVertexStarts[line]; }
+
+	/// Get index of first index of a line in the last generated mesh
+	int firstIndex(int line) const { return mIndexStarts[line]; }
+
+private:
+	float mWidth;
+	int mSides;
+	bool mFaceBinormal;
+	bool mTubes;
+	std::vector<int> mVertexStarts, mIndexStarts;
+	std::vector<float> mCos, mSin;	// ring directions of tubes
+
+	// Size mesh and find output ranges of lines
+	void layout(Mesh& m, const Polylines& lines, bool tubes);
+	void generate(Mesh& m, const Polylines& lines, int begin, int end) const;
+	void generate(Mesh& m, const Polylines& lines, ThreadPool& pool) const;
+
+	struct Generate;
+};
+
+} // al::
+
+#endif
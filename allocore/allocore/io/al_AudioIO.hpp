@@ -214,6 +214,12 @@ public:
 class AudioIO : public AudioIOData {
 public:
 
+	/// Audio backend
+	enum Backend{
+		PORTAUDIO,	/**< Stream to and from audio devices using PortAudio */
+		OFFLINE		/**< Process buffers without a device, e.g. to render to memory or disk */
+	};
+
 	/// Creates AudioIO using default I/O devices.
 
 	/// @param[in] framesPerBuf		Number of sample frames to process per callback
@@ -222,12 +228,13 @@ public:
 	/// @param[in] userData			Pointer to user data accessible within callback (optional)
 	/// @param[in] outChans			Number of output channels to open
 	/// @param[in] inChans			Number of input channels to open
+	/// @param[in] backend			Audio backend
 	/// If the number of input or output channels is greater than the device
 	/// supports, virtual buffers will be created.
 	AudioIO(
 		int framesPerBuf=64, double framesPerSec=44100.0,
 		void (* callback)(AudioIOData &) = 0, void * userData = 0,
-		int outChans = 2, int inChans = 0 );
+		int outChans = 2, int inChans = 0, Backend backend = PORTAUDIO );
 
 	virtual ~AudioIO();
 
@@ -246,6 +253,7 @@ public:
 	AudioIO& remove(AudioCallback& v);
 
 	bool autoZeroOut() const { return mAutoZeroOut; }
+	Backend backend() const { return mBackend; }	///< Returns audio backend
 	int channels(bool forOutput) const;
 	bool clipOut() const { return mClipOut; }	///< Returns clipOut setting
 	double cpu() const;							///< Returns current CPU usage of audio thread
@@ -260,6 +268,9 @@ public:
 
 	void autoZeroOut(bool v){ mAutoZeroOut=v; }
 
+	/// Set audio backend (closes the stream)
+	void backend(Backend v);
+
 	/// Sets number of effective channels on input or output device depending on 'forOutput' flag.
 
 	/// An effective channel is either a real device channel or virtual channel
@@ -280,10 +291,48 @@ public:
 
 	void print();								///< Prints info about current i/o devices to stdout.
 
+
+	/// Set memory to write offline output to
+
+	/// Frames are interleaved with channelsOutDevice() samples each. Once the
+	/// memory is full, rendering stops. This replaces any output file.
+	AudioIO& offlineOutput(float * buf, int numFrames);
+
+	/// Set file to write offline output to
+
+	/// The file is written as 32-bit float AU with the sample rate and number
+	/// of output channels current when rendering starts. It is completed when
+	/// the stream is closed. This replaces any output memory.
+	/// \returns true if the file could be opened
+	bool offlineOutput(const std::string& path);
+
+	/// Set memory to read offline input from
+
+	/// Frames are interleaved with channelsInDevice() samples each. Silence is
+	/// read after the last frame.
+	AudioIO& offlineInput(const float * buf, int numFrames);
+
+	/// Set speed of offline rendering started by start()
+
+	/// @param[in] v	multiple of real time, or 0 to render as fast as possible
+	AudioIO& offlineSpeed(double v);
+
+	/// Render offline buffers on the calling thread
+
+	/// This processes buffers until at least the given number of frames have
+	/// been rendered or the output memory is full. It does nothing while the
+	/// offline stream has been started.
+	/// \returns number of frames rendered
+	int render(int numFrames);
+
+	/// Returns number of frames written to offline output memory or file
+	int offlineFrames() const;
+
 	static const char * errorText(int errNum);		// Returns error string.
 
 private:
 	AudioDevice mInDevice, mOutDevice;
+	Backend mBackend;
 	bool mZeroNANs;			// whether to zero NANs
 	bool mClipOut;			// whether to clip output between -1 and 1
 	bool mAutoZeroOut;		// whether to automatically zero output buffers each block
@@ -292,6 +341,8 @@ private:
 	void init();			//
 	void reopen();			// reopen stream (restarts stream if needed)
 	void resizeBuffer(bool forOutput);
+	bool renderBuffer();	// render one offline buffer
+	friend struct OfflineThread;
 };
 
 
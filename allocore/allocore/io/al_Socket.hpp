@@ -104,6 +104,12 @@ public:
 	/// Get timeout duration, in seconds
 	al_sec timeout() const;
 
+	/// Get native socket descriptor, or -1 if not open
+
+	/// This can be passed to Main::watch to receive from the socket as soon
+	/// as data arrives.
+	int fileDescriptor() const;
+
 
 	/// Open socket (reopening if currently open)
 	bool open(uint16_t port, const char * address, al_sec timeout, int type);
@@ -0,0 +1,94 @@
+#ifndef INCLUDE_AL_FFT_HPP
+#define INCLUDE_AL_FFT_HPP
+
+/*	Allocore --
+	Multimedia / virtual environment application class library
+
+	Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+	Copyright (C) 2012. The Regents of the University of California.
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice,
+		this list of conditions and the following disclaimer.
+
+		Redistributions in binary form must reproduce the above copyright
+		notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+
+		Neither the name of the University of California nor the names of its
+		contributors may be used to endorse or promote products derived from
+		this software without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+
+
+
+	File description:
+	Fast Fourier transform of real sequences
+
+	Spectra are stored as separate real and imaginary arrays (split complex)
+	so that spectral arithmetic, such as the complex multiply-accumulate of
+	fast convolution, runs over contiguous floats.
+*/
+
+#include <vector>
+
+namespace al {
+
+/// Real-valued fast Fourier transform of power of two size
+class RFFT{
+public:
+
+	/// @param[in] size		transform size; a power of two, at least 4
+	RFFT(unsigned size=0);
+
+	/// Get transform size
+	unsigned size() const { return mSize; }
+
+	/// Get number of complex bins of a spectrum (size()/2 + 1)
+	unsigned bins() const { return mSize/2 + 1; }
+
+	/// Set transform size; returns false if size is not a power of two >= 4
+	bool resize(unsigned size);
+
+	/// Forward transform
+
+	/// @param[out] re		real parts of bins() DC to Nyquist bins
+	/// @param[out] im		imaginary parts of bins() DC to Nyquist bins
+	/// @param[in ] in		size() real samples
+	void forward(float * re, float * im, const float * in);
+
+	/// Inverse transform
+
+	/// The result is scaled by 1/size() so that inverse(forward(x)) = x.
+	/// The imaginary parts of the DC and Nyquist bins are ignored.
+	/// @param[out] out		size() real samples
+	/// @param[in ] re		real parts of bins() bins
+	/// @param[in ] im		imaginary parts of bins() bins
+	void inverse(float * out, const float * re, const float * im);
+
+private:
+	unsigned mSize;
+	std::vector<float> mCos, mSin;	// cos and sin of 2 pi k / size, k < size/2
+	std::vector<unsigned> mRev;		// bit reversal permutation of size/2
+	std::vector<float> mRe, mIm;	// half size complex work buffers
+
+	void fft(float * re, float * im, bool inverse) const;
+};
+
+} // al::
+
+#endif
@@ -177,6 +177,13 @@ template<class T> T gcd(const T& x, const T& y);
 /// @see http://en.wikipedia.org/wiki/Gudermannian_function
 template<class T> T gudermannian(const T& x);
 
+/// Fast reciprocal square root
+
+/// This is accurate to full single precision after three Newton steps and,
+/// unlike 1/sqrt(x), does not set errno, so loops calling it can be
+/// vectorized. The result is finite for zero, so x * invSqrt(x) is zero.
+float invSqrt(float x);
+
 /// Generalized Laguerre polynomial L{n,k}
 
 /// @param[in] n	degree, a non-negative integer
@@ -536,6 +543,18 @@ TEM T gudermannian(const T& x) {
 	return T(2) * atan(exp(x)) - T(M_PI_2);
 }
 
+inline float invSqrt(float x){
+	union{ float f; int32_t i; } u;
+	u.f = x;
+	u.i = 0x5f375a86 - (u.i >> 1);
+	float y = u.f;
+	float hx = 0.5f*x;
+	y *= 1.5f - hx*y*y;
+	y *= 1.5f - hx*y*y;
+	y *= 1.5f - hx*y*y;
+	return y;
+}
+
 TEM T laguerreL(int n, int k, T x){
 //	T res = 1, bin = 1;
 //
@@ -47,6 +47,7 @@
 #include <cmath>
 #include "allocore/types/al_Conversion.hpp"	/* req'd for int to float conversion */
 #include "allocore/math/al_Constants.hpp"
+#include "allocore/math/al_Vec.hpp"
 
 namespace al {
 
@@ -56,6 +57,7 @@ namespace rnd{
 class LinCon;
 class MulLinCon;
 class Tausworthe;
+class BulkRandom;
 template<class RNG> class Random;
 
 
@@ -278,6 +280,62 @@ private:
 };
 
 
+/// Fills arrays with random numbers from parallel Tausworthe generators
+
+/// This runs several independent combined Tausworthe generators in lock step
+/// so that each step produces a number for every lane at once, which the
+/// compiler can do in vector registers. The distributions are computed
+/// without rejection sampling so they vectorize as well. Numbers are made in
+/// blocks of 'lanes'; any left over at the end of a fill are discarded.
+///
+/// To get non-overlapping streams for several threads, give each thread a
+/// copy of one generator that has been jumped ahead a different number of
+/// times.
+class BulkRandom{
+public:
+
+	static const int lanes = 16;	///< Number of parallel generators
+
+	/// Default constructor uses a randomly generated seed
+	BulkRandom();
+
+	/// @param[in] seed		Initial seed value
+	BulkRandom(uint32_t seed);
+
+
+	/// Set seed
+	void seed(uint32_t v);
+
+	/// Advance all lanes by 2^log2Steps steps
+
+	/// This costs the same as log2Steps squarings of a 32x32 bit matrix per
+	/// component, regardless of the distance jumped.
+	BulkRandom& jump(int log2Steps = 64);
+
+
+	/// Fill array with uniform random integers in [0, 2^32)
+	void fill(uint32_t * out, int n);
+
+	/// Fill array with uniform randoms in [0, 1)
+	void uniform(float * out, int n);
+
+	/// Fill array with uniform randoms in [-1, 1)
+	void uniformS(float * out, int n);
+
+	/// Fill array with standard normal variates
+	void normal(float * out, int n);
+
+	/// Fill array with points within a unit ball
+	void ball3(Vec3f * out, int n);
+
+private:
+	uint32_t s1[lanes], s2[lanes], s3[lanes], s4[lanes];
+
+	// Step all lanes, writing one number per lane into r
+	void next(uint32_t * r);
+};
+
+
 /// Get global random number generator
 inline Random<>& global(){ static Random<> r; return r; }
 
@@ -0,0 +1,76 @@
+#ifndef INCLUDE_AL_TRANSFORM_HPP
+#define INCLUDE_AL_TRANSFORM_HPP
+
+/*	Allocore --
+	Multimedia / virtual environment application class library
+
+	Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+	Copyright (C) 2012. The Regents of the University of California.
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice,
+		this list of conditions and the following disclaimer.
+
+		Redistributions in binary form must reproduce the above copyright
+		notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+
+		Neither the name of the University of California nor the names of its
+		contributors may be used to endorse or promote products derived from
+		this software without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+
+
+
+	File description:
+	Transforms of arrays of points, vectors and normals
+
+	These apply one matrix or quaternion to many vectors at once, e.g. to
+	place instances of a mesh or to skin vertices on the CPU. The loops work
+	on the vector components directly and have no dependencies between
+	elements, so the compiler vectorizes them. The output array may be the
+	same as the input array.
+*/
+
+#include "allocore/math/al_Mat.hpp"
+#include "allocore/math/al_Quat.hpp"
+#include "allocore/math/al_Vec.hpp"
+
+namespace al{
+
+/// Transform points by a 4x4 matrix
+
+/// Each point is multiplied as (x, y, z, 1); the fourth row of the matrix is
+/// ignored, so the matrix should be affine.
+void transformPoints(const Mat4f& m, Vec3f * out, const Vec3f * in, int n);
+
+/// Transform direction vectors by the upper-left 3x3 part of a matrix
+void transformVectors(const Mat4f& m, Vec3f * out, const Vec3f * in, int n);
+
+/// Transform normals by the inverse transpose of the upper-left 3x3 part of a matrix
+
+/// The inverse transpose keeps normals perpendicular to surfaces under
+/// non-uniform scaling.
+/// @param[in] normalize	whether to normalize the transformed normals
+void transformNormals(const Mat4f& m, Vec3f * out, const Vec3f * in, int n, bool normalize=true);
+
+/// Rotate vectors by a unit quaternion
+void rotateVectors(const Quatf& q, Vec3f * out, const Vec3f * in, int n);
+
+} // al::
+
+#endif
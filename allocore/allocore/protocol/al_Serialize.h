@@ -127,6 +127,20 @@ static void serSwapBytes2(void * v);
 static void serSwapBytes4(void * v);
 static void serSwapBytes8(void * v);
 
+/* Copy arrays of 2, 4 or 8-byte elements reversing the byte order of each.
+   These are written so that compilers can vectorize them into byte shuffles.
+   The source and destination may be the same, but must not otherwise overlap.
+   Returns number of bytes copied. */
+static uint32_t serCopySwap2(void * dst, const void * src, uint32_t num);
+static uint32_t serCopySwap4(void * dst, const void * src, uint32_t num);
+static uint32_t serCopySwap8(void * dst, const void * src, uint32_t num);
+
+/* Returns pointer to the serialized elements following a header, without
+   copying, if their byte order matches the host; otherwise returns NULL.
+   The header is written to h. Note that the returned pointer is generally
+   not aligned to the element size. */
+static const char * serDecodeView(const char * b, struct SerHeader * h);
+
 /* Returns human-readable string of header */
 const char * serStringifyHeader(const struct SerHeader * h);
 
@@ -193,6 +207,50 @@ static inline void serSwapBytes8(void * v){
 }
 
 
+static inline uint32_t serCopySwap2(void * d, const void * s, uint32_t n){
+	uint32_t i;
+	for(i=0; i<n; ++i){
+		uint16_t v;
+		memcpy(&v, (const char *)s + 2*i, 2);
+		v = (uint16_t)((v >> 8) | (v << 8));
+		memcpy((char *)d + 2*i, &v, 2);
+	}
+	return n<<1;
+}
+
+static inline uint32_t serCopySwap4(void * d, const void * s, uint32_t n){
+	uint32_t i;
+	for(i=0; i<n; ++i){
+		uint32_t v;
+		memcpy(&v, (const char *)s + 4*i, 4);
+		v =	 (v >> 24)
+			| ((v >>  8) & 0x0000ff00UL)
+			| ((v <<  8) & 0x00ff0000UL)
+			|  (v << 24);
+		memcpy((char *)d + 4*i, &v, 4);
+	}
+	return n<<2;
+}
+
+static inline uint32_t serCopySwap8(void * d, const void * s, uint32_t n){
+	uint32_t i;
+	for(i=0; i<n; ++i){
+		uint64_t v;
+		memcpy(&v, (const char *)s + 8*i, 8);
+		v =	 (v >> 56)
+			| ((v >> 40) & 0x000000000000ff00ULL)
+			| ((v >> 24) & 0x0000000000ff0000ULL)
+			| ((v >>  8) & 0x00000000ff000000ULL)
+			| ((v <<  8) & 0x000000ff00000000ULL)
+			| ((v << 24) & 0x0000ff0000000000ULL)
+			| ((v << 40) & 0x00ff000000000000ULL)
+			|  (v << 56);
+		memcpy((char *)d + 8*i, &v, 8);
+	}
+	return n<<3;
+}
+
+
 static inline uint32_t serCopy1(void * d, const void * s, uint32_t n){
 	memcpy(d,s,n); return n;
 }
@@ -204,13 +262,9 @@ static inline uint32_t serCopy##B(void * d, const void * s, uint32_t n){\
 	return n;\
 }
 
-#define DEF_BE(p, B, S)\
+#define DEF_BE(B, S)\
 static inline uint32_t serCopy##B(void * d, const void * s, uint32_t n){\
-	n = n<<S;\
-	memcpy(d,s,n);\
-	char * t = (char *)d;\
-	for(uint32_t i=0; i<n; i+=B) swapBytes##B(t+i);\
-	return n;\
+	return serCopySwap##B(d,s,n);\
 }
 
 #ifdef SER_IS_BIG_ENDIAN
@@ -222,6 +276,14 @@ DEF_LE(2,1) DEF_LE(4,2) DEF_LE(8,3)
 #undef DEF_BE
 #undef DEF_LE
 
+static inline const char * serDecodeView(const char * b, struct SerHeader * h){
+	*h = serGetHeader(b);
+	#ifdef SER_IS_BIG_ENDIAN
+	if(serTypeSize(h->type) > 1) return NULL;
+	#endif
+	return b + SER_HEADER_SIZE;
+}
+
 #undef SOH
 
 #ifdef __cplusplus
@@ -81,12 +81,65 @@ template<> inline uint8_t getType<int16_t >(){ return 'H'; }
 template<> inline uint8_t getType<int32_t >(){ return 'i'; }
 template<> inline uint8_t getType<int64_t >(){ return 'I'; }
 
+
+
+/// Read-only typed view of serialized array elements
+
+/// A view refers directly to the elements inside a serialized buffer, so it
+/// is only valid as long as the buffer is. Since elements follow a 5-byte
+/// header, they are generally not aligned; operator[] and copy() are safe
+/// regardless of alignment while data() requires aligned().
+template <class T>
+class View{
+public:
+	View(): mData(0), mSize(0){}
+	View(const char * data, uint32_t size): mData(data), mSize(size){}
+
+	/// Get number of elements
+	uint32_t size() const { return mSize; }
+
+	/// Get element
+	T operator[](uint32_t i) const {
+		T v; memcpy(&v, mData + i*sizeof(T), sizeof(T)); return v;
+	}
+
+	/// Copy elements into an array
+	void copy(T * dst) const { memcpy(dst, mData, mSize*sizeof(T)); }
+
+	/// Returns whether elements are aligned in memory for direct access
+	bool aligned() const { return 0 == (size_t(mData) % sizeof(T)); }
+
+	/// Get pointer to first element; only valid if aligned()
+	const T * data() const { return (const T *)mData; }
+
+	/// Get pointer to first byte of element data
+	const char * bytes() const { return mData; }
+
+private:
+	const char * mData;
+	uint32_t mSize;
+};
+
 } // ser::
 
 
-///
+/// Serializes elements into a buffer
+
+/// By default, the buffer grows as needed. For repeated serialization, e.g.
+/// once per frame, call reset() to reuse the memory already allocated.
+/// Alternatively, a Serializer can be given a fixed, preallocated arena in
+/// which case it never allocates memory.
 struct Serializer{
 
+	/// Serialize into an internal, growable buffer
+	Serializer();
+
+	/// Serialize into a fixed memory arena
+
+	/// No memory is allocated. Elements that do not fit in the arena are not
+	/// written and cause overflow() to return true.
+	Serializer(char * arena, uint32_t capacity);
+
 	template <class T>
 	Serializer& operator<< (T v);
 
@@ -96,33 +149,69 @@ struct Serializer{
 	template <class T>
 	Serializer& add(const T * v, uint32_t num);
 
+	/// Get internal buffer (growable mode only)
 	const std::vector<char>& buf() const;
 
+	/// Get pointer to serialized data
+	const char * data() const;
+
+	/// Get size, in bytes, of serialized data
+	uint32_t size() const { return mSize; }
+
+	/// Returns whether elements did not fit in the arena
+	bool overflow() const { return mOverflow; }
+
+	/// Allocate enough memory to hold the given number of bytes (growable mode only)
+	Serializer& reserve(uint32_t bytes);
+
+	/// Discard serialized data while keeping allocated memory
+	Serializer& reset();
+
 private:
-	std::vector<char> mBuf, mTemp;
+	std::vector<char> mBuf;
+	char * mArena;
+	uint32_t mSize, mCapacity;
+	bool mOverflow;
 
-	template <class T> void checkSize(uint32_t n=1);
+	char * alloc(uint32_t bytes);
 };
 
 
-///
+/// Deserializes elements from a buffer
 struct Deserializer{
 
+	/// Deserialize from a copy of a buffer
 	Deserializer(const std::vector<char>& b);
 
-	Deserializer(const char * b, uint32_t n);
+	/// @param[in] b		serialized data
+	/// @param[in] n		size of serialized data, in bytes
+	/// @param[in] copy		whether to copy the data; if false, the data is
+	///						read in place and must outlive the Deserializer
+	Deserializer(const char * b, uint32_t n, bool copy=true);
 
 	template <class T>
 	Deserializer& operator>> (T& v);
 	Deserializer& operator>> (char * v);
 	Deserializer& operator>> (std::string& v);
 
+	/// Get view of next array of elements without copying them
+
+	/// \returns false if the next elements are not of type T or if their byte
+	/// order differs from the host's, in which case nothing is read.
+	template <class T>
+	bool view(ser::View<T>& v);
+
+	/// Returns whether there is more data to read
+	bool more() const { return mStart < mSize; }
+
+	/// Get internal copy of buffer (empty if not copied)
 	const std::vector<char>& buf() const;
 
 private:
-	int mStart;
+	uint32_t mStart, mSize;
+	const char * mData;		// external data, if not copied to mBuf
 	std::vector<char> mBuf;
-	char * bufDec();
+	const char * bufDec();
 };
 
 
@@ -138,17 +227,11 @@ template <class T> Serializer& Serializer::operator<< (T v){
 }
 
 template <class T> Serializer& Serializer::add(const T * v, uint32_t num){
-	checkSize<T>(num);
-	uint32_t n = ser::encode(&mTemp[0], v, num);
-	mBuf.insert(mBuf.end(), mTemp.begin(), mTemp.begin()+n);
+	char * b = alloc(num*sizeof(T) + serHeaderSize());
+	if(b) mSize += ser::encode(b, v, num);
 	return *this;
 }
 
-template <class T> void Serializer::checkSize(uint32_t n){
-	uint32_t need = n*sizeof(T) + serHeaderSize();
-	if(mTemp.size() < need) mTemp.resize(need);
-}
-
 
 template <class T> Deserializer& Deserializer::operator>> (T& v){
 	uint32_t n = serDecode(bufDec(), &v);
@@ -156,6 +239,15 @@ template <class T> Deserializer& Deserializer::operator>> (T& v){
 	return *this;
 }
 
+template <class T> bool Deserializer::view(ser::View<T>& v){
+	SerHeader h;
+	const char * elems = serDecodeView(bufDec(), &h);
+	if(!elems || h.type != ser::getType<T>()) return false;
+	v = ser::View<T>(elems, h.num);
+	mStart += serHeaderSize() + serElementsSize(&h);
+	return true;
+}
+
 //template <class T>
 //Deserializer& decode(const T * v, uint32_t num){
 //	uint32_t n = decode(bufDec(), v);
@@ -0,0 +1,209 @@
+#ifndef INCLUDE_AL_STATE_SYNC_HPP
+#define INCLUDE_AL_STATE_SYNC_HPP
+
+/*	Allocore --
+	Multimedia / virtual environment application class library
+
+	Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+	Copyright (C) 2012. The Regents of the University of California.
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice,
+		this list of conditions and the following disclaimer.
+
+		Redistributions in binary form must reproduce the above copyright
+		notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+
+		Neither the name of the University of California nor the names of its
+		contributors may be used to endorse or promote products derived from
+		this software without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+
+
+
+	File description:
+	Distribution of state frames from one process to others over UDP
+
+	A sender splits each frame, e.g. a POD struct of simulation state, into
+	datagrams that fit an Ethernet MTU. Every datagram carries the frame's
+	sequence number and its fragment index so receivers can reassemble
+	frames from packets arriving out of order. A session number, new for
+	each sender, lets receivers follow a sender that was restarted.
+	Receivers keep a small window of partial frames and hand the newest
+	complete one to the reader through a triple buffer. Late or incomplete
+	frames are dropped rather than waited for. The reader never blocks and
+	neither does the sender.
+
+	Frames are sent in native byte order, so senders and receivers should
+	share an architecture. To reach several renderers, send to a multicast
+	group, e.g. "239.255.0.1", that each receiver joins. Receivers in a
+	group share their port, so several of them can run on one machine;
+	the sender loops packets back to its own host. A broadcast address
+	also works, with one receiver per machine.
+*/
+
+#include <string.h>
+#include <vector>
+#include "allocore/io/al_Socket.hpp"
+#include "allocore/system/al_Thread.hpp"
+#include "allocore/types/al_TripleBuffer.hpp"
+
+namespace al{
+
+
+/// Sends state frames over UDP
+
+/// @ingroup allocore
+class StateSender{
+public:
+
+	/// Maximum payload per datagram, in bytes
+	enum{ MAX_PAYLOAD = 1400 };
+
+	StateSender();
+
+	/// @param[in] port		port to send to
+	/// @param[in] address	IP address to send to; may be a multicast group
+	StateSender(uint16_t port, const char * address = "127.0.0.1");
+
+	/// Open socket
+	bool open(uint16_t port, const char * address = "127.0.0.1");
+
+	/// Returns sequence number of next frame
+	unsigned frame() const { return mFrame; }
+
+	/// Send a frame
+
+	/// \returns whether all datagrams were sent
+	bool send(const void * data, int size);
+
+	/// Send a POD value as a frame
+	template <class T>
+	bool send(const T& state){ return send(&state, sizeof(T)); }
+
+private:
+	SocketClient mSocket;
+	std::vector<char> mPacket;
+	unsigned mFrame;
+	unsigned mSession;
+};
+
+
+
+/// Receives state frames over UDP
+
+/// Packets can be received either on a thread of the receiver's own, see
+/// start(), or by calling poll() from the reading thread.
+///
+/// @ingroup allocore
+class StateReceiver{
+public:
+
+	/// @param[in] frameSize	size of frames, in bytes; others are ignored
+	/// @param[in] port			port to listen on; if 0, call open() later
+	/// @param[in] window		number of frames to reassemble at once
+	/// @param[in] group		multicast group to join; if empty, none
+	StateReceiver(int frameSize, uint16_t port = 0, int window = 4, const char * group = "");
+
+	~StateReceiver();
+
+
+	/// Open socket
+
+	/// @param[in] port		port to listen on
+	/// @param[in] group	multicast group to join, e.g. "239.255.0.1";
+	///						if empty, only packets sent to this host are
+	///						received and the port is not shared
+	bool open(uint16_t port, const char * group = "");
+
+	/// Start receiving on a thread
+	bool start();
+
+	/// Stop receiving thread
+	void stop();
+
+	/// Receive all pending packets (when not started)
+
+	/// \returns number of frames completed
+	int poll();
+
+
+	/// Get newest complete frame (reader only)
+
+	/// \returns whether the frame is new since the last update
+	bool update(){ return mFrames.update(); }
+
+	/// Get frame data after update() (reader only)
+
+	/// Before the first frame arrives, this is all zeros.
+	const char * front() const { return &mFrames.front()[0]; }
+
+	/// Update and copy the newest frame to a POD value (reader only)
+
+	/// \returns whether the value is new
+	template <class T>
+	bool read(T& state){
+		bool isNew = update();
+		if(sizeof(T) == unsigned(mFrameSize)) memcpy(&state, front(), sizeof(T));
+		return isNew;
+	}
+
+
+	/// Returns frame size, in bytes
+	int frameSize() const { return mFrameSize; }
+
+	/// Returns number of frames completed
+	unsigned long framesReceived() const { return loadRelaxed(mReceived); }
+
+	/// Returns number of partial frames given up on
+	unsigned long framesDropped() const { return loadRelaxed(mDropped); }
+
+private:
+	struct Partial{
+		unsigned frame;
+		int count;					// fragments received
+		std::vector<char> data;
+		std::vector<char> got;		// whether each fragment was received
+	};
+
+	struct RecvThread : public ThreadFunction{
+		StateReceiver * receiver;
+		void operator()();
+	};
+
+	Socket mSocket;				// bound in open() after setting options
+	TripleBuffer<std::vector<char> > mFrames;
+	std::vector<Partial> mWindow;
+	std::vector<char> mPacket;
+	int mFrameSize, mFragments;
+	unsigned mLastFrame;
+	unsigned mSession;			// session of sender of last frame
+	bool mHaveFrame;
+	unsigned long mReceived, mDropped;
+	Thread mThread;
+	RecvThread mThreadFunc;
+	bool mRunning;
+
+	void init(int frameSize, int window);
+	bool receive();
+	bool onPacket(const char * packet, int size);
+};
+
+} // al::
+
+#endif
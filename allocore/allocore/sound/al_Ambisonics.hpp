@@ -48,9 +48,14 @@
 */
 
 #include <stdio.h>
+#include <map>
+#include <vector>
 #include "allocore/sound/al_AudioScene.hpp"
+#include "allocore/sound/al_Crossover.hpp"
+#include "allocore/system/al_ThreadPool.hpp"
 
-//#define MAX_ORDER 3
+/// Highest order supported by the ACN conventions (64 channels in 3D)
+#define AL_AMBI_MAX_ORDER 7
 
 
 /*
@@ -99,9 +104,17 @@ namespace al{
 class AmbiBase{
 public:
 
-	/// @param[in] dim		number of spatial dimensions (2 or 3)
-	/// @param[in] order	highest spherical harmonic order
-	AmbiBase(int dim, int order);
+	/// Channel ordering and normalization
+	enum Convention{
+		FUMA,		/**< Furse-Malham ordering and weights (up to 3rd order) */
+		ACN_SN3D,	/**< ACN ordering, SN3D normalization (AmbiX) */
+		ACN_N3D		/**< ACN ordering, N3D normalization */
+	};
+
+	/// @param[in] dim			number of spatial dimensions (2 or 3)
+	/// @param[in] order		highest spherical harmonic order
+	/// @param[in] convention	channel ordering and normalization
+	AmbiBase(int dim, int order, Convention convention=FUMA);
 
 	virtual ~AmbiBase();
 
@@ -111,15 +124,28 @@ public:
 	/// Get order
 	int order() const { return mOrder; }
 
+	/// Get channel ordering and normalization
+	Convention convention() const { return mConvention; }
+
+	/// Get highest order supported by the convention
+	int maxOrder() const { return FUMA == mConvention ? 3 : AL_AMBI_MAX_ORDER; }
+
+	/// Get spherical harmonic degree of an Ambisonic channel
+	int channelOrder(int channel) const;
+
 	/// Get Ambisonic channel weights
 	const float * weights() const { return mWeights; }
 
 	/// Returns total number of Ambisonic domain channels
 	int channels() const { return mChannels; }
 
-	/// Set the order
+	/// Set the order; values above maxOrder() are clamped
 	void order(int order);
 
+	/// Compute spherical harmonic weights of a unit direction in this
+	/// object's dimensions, order and convention
+	void encodeWeights(float * ws, float x, float y, float z) const;
+
 
 	/// Called whenever the number of Ambisonic channels changes
 	virtual void onChannelsChange(){}
@@ -139,14 +165,34 @@ public:
 	/// (x,y,z unit vector in the listener's coordinate frame)
 	static void encodeWeightsFuMa16(float * ws, float x, float y, float z);
 
+	/// Compute ACN ordered, SN3D or N3D normalized real spherical harmonics
+
+	/// Harmonics are evaluated with the associated Legendre recurrences, so
+	/// any order up to AL_AMBI_MAX_ORDER costs a few multiplies per channel.
+	/// In 2D, only the sectoral harmonics (|m| = n) are computed and they are
+	/// ordered W, sin(1A), cos(1A), sin(2A), cos(2A), ...
+	/// (x,y,z unit vector in the listener's coordinate frame)
+	static void encodeWeightsACN(float * ws, int dim, int order, float x, float y, float z, bool n3d=false);
+
+	/// Compute ACN weights for a block of directions
+
+	/// Directions are given as separate x, y and z arrays of length n. The
+	/// weight of channel c for direction i is written to ws[c*stride + i].
+	/// The inner loops run over directions so they can be vectorized.
+	static void encodeWeightsACN(
+		float * ws, int stride, int dim, int order,
+		const float * x, const float * y, const float * z, int n, bool n3d=false
+	);
+
 	static int orderToChannels(int dim, int order);
 	static int orderToChannelsH(int orderH);
 	static int orderToChannelsV(int orderV);
 
 protected:
 	int mDim;			// dimensions - 2d or 3d
-	int mOrder;			// order - 0th, 1st, 2nd, or 3rd
+	int mOrder;			// order - 0th to maxOrder()
 	int mChannels;		// cached for efficiency
+	Convention mConvention;
 	float * mWeights;	// weights for each ambi channel
 
 	template<typename T>
@@ -163,11 +209,19 @@ public:
 	/// @param[in] order		highest spherical harmonic order
 	/// @param[in] numSpeakers	number of speakers
 	/// @param[in] flavor		decoding algorithm
-	AmbiDecode(int dim, int order, int numSpeakers, int flavor=1);
+	/// @param[in] convention	channel ordering and normalization
+	AmbiDecode(int dim, int order, int numSpeakers, int flavor=1, Convention convention=FUMA);
 
 	virtual ~AmbiDecode();
 
 
+	/// Decode Ambisonic domain buffers, adding to the speaker buffers
+
+	/// The decode matrix is applied as a matrix multiply blocked over frames
+	/// and channels. When more than one thread is set and the decode is
+	/// large enough, speakers are split across threads. In dual-band mode,
+	/// 'enc' is filtered into bands a block of frames at a time before
+	/// decoding. Decoding does not allocate memory.
 	/// @param[out] dec				output time domain buffers (non-interleaved)
 	/// @param[in ] enc				input Ambisonic domain buffers (non-interleaved)
 	/// @param[in ] numDecFrames	number of frames in time domain buffers
@@ -183,21 +237,52 @@ public:
 	/// Returns number of speakers
 	int numSpeakers() const { return mNumSpeakers; }
 
+	/// Returns maximum number of threads used for decoding
+	int threads() const { return mPool ? mPool->size() + 1 : 1; }
+
+	/// Returns whether separate low and high frequency decoders are used
+	bool dualBand() const { return !mCrossovers.empty(); }
+
 	void print(FILE * fp = stdout, const char * append = "\n") const;
 
 
 	/// Set decoding algorithm
+
+	/// 0: none, 1: default, 2: in-phase, 3: max-rE. Above 4th order the
+	/// default flavor uses max-rE weights.
 	void flavor(int type);
 
 	/// Set number of speakers. Positions are zeroed upon resize.
 	void numSpeakers(int num);
 
+	/// Set maximum number of threads used for decoding
+
+	/// A pool of num-1 worker threads is started; the calling thread does
+	/// its share of the decode. Threads are only used for decodes of at least
+	/// speakers x channels x frames = 2^18 and require every speaker to have
+	/// its own device channel.
+	void threads(int num);
+
+	/// Use separate low and high frequency decoders
+
+	/// A crossover that sums to an allpass splits each Ambisonic channel in
+	/// two bands which are weighted with different decoding flavors. The
+	/// default is a basic decoder below the crossover and max-rE above it.
+	/// @param[in] crossoverFreq	crossover frequency, in Hz
+	/// @param[in] sampleRate		sample rate of decoded signals, in Hz
+	/// @param[in] loFlavor			decoding flavor of low band
+	/// @param[in] hiFlavor			decoding flavor of high band
+	void dualBand(float crossoverFreq, float sampleRate, int loFlavor=0, int hiFlavor=3);
+
+	/// Use a single decoder of the current flavor for all frequencies
+	void singleBand();
+
 	void setSpeakerRadians(int index, int deviceChannel, float azimuth, float elevation, float amp=1.f);
 
 	void setSpeaker(int index, int deviceChannel, float azimuth, float elevation=0, float amp=1.f);
 	//void zero();					///< Zeroes out internal ambisonic frame.
 
-    void setSpeakers(Speakers *spkrs) { mSpeakers = spkrs; }
+    void setSpeakers(Speakers *spkrs) { mSpeakers = spkrs; mGainsDirty = true; }
 
 //	float * azimuths();				///< Returns pointer to speaker azimuths.
 //	float * elevations();			///< Returns pointer to speaker elevations.
@@ -213,13 +298,40 @@ protected:
 	int mFlavor;				// decode flavor
 	float * mDecodeMatrix;		// deccoding matrix for each ambi channel & speaker
 								// cols are channels and rows are speakers
-	float mWOrder[5];			// weights for each order
+	float mWOrder[AL_AMBI_MAX_ORDER+1];	// weights for each order
+	float mWBand[2][AL_AMBI_MAX_ORDER+1];	// dual-band weights for each order
     Speakers* mSpeakers;
+
+	enum{ BAND_FRAMES = 256 };	// frames filtered into bands at a time
+
+	struct DecodeBody{
+		const AmbiDecode * decoder;
+		float * dec;
+		int decStride;
+		const float * enc;
+		int encStride;
+		int numFrames;
+		void operator()(int speaker0, int speaker1){
+			decoder->decodeSpeakers(dec, decStride, enc, encStride, numFrames, speaker0, speaker1);
+		}
+	};
+
+	// Decoding state; mutable since it is only a cache of the settings above
+	mutable std::vector<float> mGains;			// decode matrix times channel weights
+	mutable bool mGainsDirty;
+	mutable std::vector<Crossover<float> > mCrossovers;	// per channel, if dual-band
+	mutable std::vector<float> mBands;			// band-weighted input block
+	mutable bool mDistinctChannels;				// whether speakers have their own device channels
+	ThreadPool * mPool;
     //float * mPositions;		// speakers' azimuths + elevations
 	//float * mFrame;			// an ambisonic channel frame used for decode(int)
 
 	void updateChanWeights();
+	void orderWeights(int flavor, float * weights) const;
 	void resizeArrays(int numChannels, int numSpeakers);
+	void updateGains() const;
+	void decodeBlock(float * dec, int decStride, const float * enc, int encStride, int numFrames, int numThreads) const;
+	void decodeSpeakers(float * dec, int decStride, const float * enc, int encStride, int numFrames, int speaker0, int speaker1) const;
 
 	float decode(float * encFrame, int encNumChannels, int speakerNum);	// is this useful?
 
@@ -234,7 +346,17 @@ public:
 
 	/// @param[in] dim			number of spatial dimensions (2 or 3)
 	/// @param[in] order		highest spherical harmonic order
-	AmbiEncode(int dim, int order) : AmbiBase(dim, order) {}
+	/// @param[in] convention	channel ordering and normalization
+	AmbiEncode(int dim, int order, Convention convention=FUMA)
+	:	AmbiBase(dim, order, convention), mMaxFrames(0) {}
+
+	/// Set the largest number of frames encoded at once from directions
+
+	/// This allocates the memory used when encoding from an array of
+	/// directions so that encoding does not allocate on the audio thread.
+	void numFrames(int v);
+
+	virtual void onChannelsChange();
 
 //	/// Encode input sample and set decoder frame.
 //	void encode   (const AmbiDecode &dec, float input);
@@ -252,6 +374,9 @@ public:
 
 	/// Encode a buffer of samples
 
+	/// The weights for all directions are computed in one block before
+	/// being applied. Buffers longer than set by numFrames() cause memory
+	/// to be allocated.
 	/// @param[in] ambiChans	Ambisonic domain channels (non-interleaved)
 	/// @param[in] dir			unit vector in the listener's coordinate frame)
 	/// @param[in] input		time-domain sample buffer to encode
@@ -259,12 +384,29 @@ public:
 	template <class XYZ>
 	void encode(float * ambiChans, const XYZ * dir, const float * input, int numFrames);
 
+	/// Encode a buffer of samples of a moving source
+
+	/// The weights are linearly interpolated over the buffer from
+	/// 'weightsFrom', usually the weights at the end of the source's previous
+	/// buffer, to the current weights. This avoids computing the spherical
+	/// harmonics per sample.
+	/// @param[in] ambiChans	Ambisonic domain channels (non-interleaved)
+	/// @param[in] input		time-domain sample buffer to encode
+	/// @param[in] numFrames	number of frames to encode
+	/// @param[in] weightsFrom	weights at start of buffer (size channels())
+	void encode(float * ambiChans, const float * input, int numFrames, const float * weightsFrom) const;
+
 	/// Set spherical direction of source to be encoded
 	void direction(float az, float el);
 
 	/// Set Cartesian direction of source to be encoded
 	/// (x,y,z unit vector in the listener's coordinate frame)
 	void direction(float x, float y, float z);
+
+private:
+	std::vector<float> mDirs;		// SoA directions for block encoding
+	std::vector<float> mBlockWeights;
+	int mMaxFrames;
 };
 
 
@@ -272,12 +414,18 @@ public:
 class AmbisonicsSpatializer : public Spatializer {
 public:
 
-    AmbisonicsSpatializer(SpeakerLayout &sl, int dim, int order, int flavor=1);
+    AmbisonicsSpatializer(
+		SpeakerLayout &sl, int dim, int order, int flavor=1,
+		AmbiBase::Convention convention=AmbiBase::FUMA
+	);
 
     void zeroAmbi();
 
     float * ambiChans(unsigned channel=0);
 
+	/// Get decoder, e.g. to set threads or dual-band decoding
+	AmbiDecode& decoder(){ return mDecoder; }
+
     void compile(Listener& l);
 
     void numFrames(int v);
@@ -292,16 +440,31 @@ public:
     void perform(AudioIOData& io, SoundSource& src, Vec3d& relpos, const int& numFrames, int& frameIndex, float& sample);
 
     /// Per buffer processing
+
+	/// Weights are interpolated over the buffer from those used at the end
+	/// of the source's previous buffer.
     void perform(AudioIOData& io, SoundSource& src, Vec3d& relpos, const int& numFrames, float *samples);
 
     void finalize(AudioIOData& io);
 
+	/// Allocate interpolation state for a source
+	void addSource(SoundSource& src);
+
+	/// Free interpolation state of a source
+	void removeSource(SoundSource& src);
+
 private:
+	struct SourceWeights{
+		std::vector<float> weights;	// weights at end of previous buffer
+		bool valid;					// whether weights have been set
+	};
+
     AmbiDecode mDecoder;
     AmbiEncode mEncoder;
 	std::vector<float> mAmbiDomainChannels;
     Listener* mListener;
     int mNumFrames;
+	std::map<const SoundSource *, SourceWeights> mSourceWeights;
 };
 
 
@@ -357,55 +520,70 @@ inline float AmbiDecode::decode(float * encFrame, int encNumChannels, int speake
 //}
 
 inline void AmbiEncode::direction(float az, float el){
-	AmbiBase::encodeWeightsFuMa(mWeights, mDim, mOrder, az, el);
+	if(FUMA == mConvention){
+		AmbiBase::encodeWeightsFuMa(mWeights, mDim, mOrder, az, el);
+	}
+	else{
+		float cosel = cos(el);
+		float z = mDim>=3 ? sin(el) : 0;
+		encodeWeights(mWeights, cos(az) * cosel, sin(az) * cosel, z);
+	}
 }
 
 inline void AmbiEncode::direction(float x, float y, float z){
-	AmbiBase::encodeWeightsFuMa(mWeights, mDim, mOrder, x,y,z);
+	encodeWeights(mWeights, x,y,z);
 }
 
 inline void AmbiEncode::encode(float * ambiChans, int numFrames, int timeIndex, float timeSample) const {
-
-	// "Iterate" through spherical harmonics using Duff's device.
-	// This requires only a simple jump per time sample.
-	#define CS(c) case c: ambiChans[c*numFrames+timeIndex] += weights()[c] * timeSample;
-	int ch = channels()-1;
-	switch(ch){
-		CS(15) CS(14) CS(13) CS(12) CS(11) CS(10) CS( 9) CS( 8)
-		CS( 7) CS( 6) CS( 5) CS( 4) CS( 3) CS( 2) CS( 1) CS( 0)
-		default:;
+	float * out = ambiChans + timeIndex;
+	for(int c=0; c<channels(); ++c){
+		out[c*numFrames] += weights()[c] * timeSample;
 	}
-	#undef CS
 }
 
 template <class XYZ>
 void AmbiEncode::encode(float * ambiChans, const XYZ * dir, const float * input, int numFrames){
 
-	// TODO: how can we efficiently encode a moving source?
-
-	// Changing the position recomputes ALL the spherical harmonic weights.
-	// Ideally we only want to change the position for each time sample.
-	// However, for our loops to be most efficient, we want the inner loop
-	// to process over time since it will have around 64-512 iterations
-	// while the spatial loop will have at most 16 iterations.
+	// Compute weights for all frames up front (outer-space, inner-time) so
+	// that both the harmonics and the accumulation run over contiguous time
+	// samples.
+	const int Nc = channels();
+	if(numFrames > mMaxFrames) this->numFrames(numFrames);
+	float * xs = &mDirs[0];
+	float * ys = xs + numFrames;
+	float * zs = ys + numFrames;
+	for(int i=0; i<numFrames; ++i){
+		xs[i] = dir[i][0];
+		ys[i] = dir[i][1];
+		zs[i] = dir[i][2];
+	}
 
-	/* outer-space, inner-time
-	for(int c=0; c<channels(); ++c){
-		float * ambi = ambiChans[c];
-		//T
+	float * ws = &mBlockWeights[0];
+	if(FUMA == mConvention){
+		float w[16];
 		for(int i=0; i<numFrames; ++i){
-			position(pos[i][0], pos[i][1], pos[i][2]);
-			ambi[i] += weights()[c] * input[i];
+			encodeWeightsFuMa(w, mDim, mOrder, xs[i], ys[i], zs[i]);
+			for(int c=0; c<Nc; ++c) ws[c*numFrames + i] = w[c];
 		}
-	}*/
+	}
+	else{
+		encodeWeightsACN(ws, numFrames, mDim, mOrder, xs, ys, zs, numFrames, ACN_N3D == mConvention);
+	}
 
-	// outer-time, inner-space
-	for(int i=0; i<numFrames; ++i){
-		direction(dir[i][0], dir[i][1], dir[i][2]);
-		encode(ambiChans, numFrames, i, input[i]);
-		/*for(int c=0; c<channels(); ++c){
-			ambiChans[c][i] += weights()[c] * input[i];
-		}*/
+	for(int c=0; c<Nc; ++c){
+		float * ambi = ambiChans + c*numFrames;
+		const float * w = ws + c*numFrames;
+		for(int i=0; i<numFrames; ++i) ambi[i] += w[i] * input[i];
+	}
+}
+
+inline void AmbiEncode::encode(float * ambiChans, const float * input, int numFrames, const float * weightsFrom) const {
+	const float dt = 1.f/numFrames;
+	for(int c=0; c<channels(); ++c){
+		float * ambi = ambiChans + c*numFrames;
+		float w0 = weightsFrom[c];
+		float dw = (weights()[c] - w0) * dt;
+		for(int i=0; i<numFrames; ++i) ambi[i] += (w0 + dw*(i+1)) * input[i];
 	}
 }
 
@@ -126,6 +126,15 @@ public:
 	/// Called once per listener, after sources are rendered. ex. ambisonics decode
 	virtual void finalize(AudioIOData& io){};
 
+	/// Called when a source is added to the scene, outside of rendering
+
+	/// Spatializers keeping per-source state allocate it here so that
+	/// rendering does not allocate.
+	virtual void addSource(SoundSource& src){};
+
+	/// Called when a source is removed from the scene, outside of rendering
+	virtual void removeSource(SoundSource& src){};
+
 	/// Print out information about spatializer
 	virtual void print(){};
 
@@ -228,6 +237,12 @@ public:
 		return mUseAtten ? DistAtten<double>::attenuation(distance) : 1.0;
 	}
 
+	/// Get attenuation factors for an array of distances to listener
+	void attenuation(double * out, const double * distances, int n) const {
+		if(mUseAtten) DistAtten<double>::attenuation(out, distances, n);
+		else for(int i=0; i<n; ++i) out[i] = 1.0;
+	}
+
 	/// Get size of delay in samples
 	int delaySize() const { return mSound.size(); }
 
@@ -333,6 +348,8 @@ protected:
 	Sources mSources;
 	int mNumFrames;				// audio frames per block
 	std::vector<float> mBuffer;	// temporary frame buffer
+	std::vector<Vec3d> mRelPos;	// per frame source positions relative to listener
+	std::vector<double> mDistances, mGains;	// per frame distances and their gains
 	double mSpeedOfSound;		// distance per second
     bool mPerSampleProcessing;
 };
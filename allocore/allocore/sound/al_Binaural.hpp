@@ -0,0 +1,102 @@
+#ifndef INCLUDE_AL_BINAURAL_HPP
+#define INCLUDE_AL_BINAURAL_HPP
+
+/*	Allocore --
+	Multimedia / virtual environment application class library
+
+	Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+	Copyright (C) 2012. The Regents of the University of California.
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice,
+		this list of conditions and the following disclaimer.
+
+		Redistributions in binary form must reproduce the above copyright
+		notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+
+		Neither the name of the University of California nor the names of its
+		contributors may be used to endorse or promote products derived from
+		this software without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+
+
+
+	File description:
+	Binaural spatializer using HRTF convolution of virtual loudspeakers
+*/
+
+#include <vector>
+#include "allocore/sound/al_Ambisonics.hpp"
+#include "allocore/sound/al_Convolver.hpp"
+
+namespace al{
+
+/// Binaural spatializer
+
+/// Sources are encoded into 3D Ambisonics and decoded to a set of virtual
+/// speakers. Each virtual speaker is then convolved with the head-related
+/// impulse responses (HRIRs) measured at its position and mixed to two output
+/// channels. The cost of convolution is independent of the number of sources.
+/// The number of frames per buffer must be a power of two.
+class BinauralSpatializer : public Spatializer{
+public:
+
+	/// @param[in] virtualSpeakers	directions of the measured HRIRs
+	/// @param[in] hrirs			left and right ear HRIRs of each virtual
+	///								speaker; hrirs[2*s] is the left and
+	///								hrirs[2*s+1] the right ear of speaker s
+	/// @param[in] hrirLength		length of each HRIR, in samples
+	/// @param[in] order			Ambisonic order
+	BinauralSpatializer(
+		const SpeakerLayout& virtualSpeakers,
+		const float * const * hrirs, int hrirLength, int order=1
+	);
+
+	/// Set the output channels of the left and right ears
+	void outputChannels(int left, int right){ mLeft=left; mRight=right; }
+
+	void compile(Listener& l);
+
+	void numFrames(int v);
+
+	void prepare(AudioIOData& io);
+
+	/// Per sample processing
+	void perform(AudioIOData& io, SoundSource& src, Vec3d& relpos, const int& numFrames, int& frameIndex, float& sample);
+
+	/// Per buffer processing
+	void perform(AudioIOData& io, SoundSource& src, Vec3d& relpos, const int& numFrames, float *samples);
+
+	void finalize(AudioIOData& io);
+
+	/// Get HRIR convolver
+	Convolver& convolver(){ return mConvolver; }
+
+private:
+	SpeakerLayout mVirtual;				// virtual speakers with channels 0, 1, ...
+	AmbisonicsSpatializer mAmbi;
+	Convolver mConvolver;
+	std::vector<const float *> mHRIRs;
+	int mHRIRLength;
+	std::vector<float> mSpeakerBuf, mEarBuf;
+	int mLeft, mRight;
+};
+
+} // al::
+
+#endif
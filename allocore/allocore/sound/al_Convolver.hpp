@@ -0,0 +1,181 @@
+#ifndef INCLUDE_AL_CONVOLVER_HPP
+#define INCLUDE_AL_CONVOLVER_HPP
+
+/*	Allocore --
+	Multimedia / virtual environment application class library
+
+	Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+	Copyright (C) 2012. The Regents of the University of California.
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice,
+		this list of conditions and the following disclaimer.
+
+		Redistributions in binary form must reproduce the above copyright
+		notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+
+		Neither the name of the University of California nor the names of its
+		contributors may be used to endorse or promote products derived from
+		this software without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+
+
+
+	File description:
+	Partitioned FFT convolution of multichannel signals with long impulse
+	responses, e.g. for measured room reverberation or HRTF rendering
+
+	The impulse response is split into a head of short partitions, processed
+	with no latency beyond one block, and an optional tail of longer
+	partitions that can be processed in a background thread. Both use
+	uniformly partitioned overlap-save convolution with a frequency-domain
+	delay line per input.
+*/
+
+#include <vector>
+#include "allocore/math/al_FFT.hpp"
+#include "allocore/system/al_Atomic.hpp"
+#include "allocore/system/al_Thread.hpp"
+
+namespace al {
+
+/// Multichannel partitioned convolution engine
+
+/// A Convolver convolves each of its inputs with an impulse response (IR)
+/// per output and sums the results into the outputs. Once set up, process()
+/// does not allocate memory or lock, so it can be called from an audio
+/// callback.
+///
+/// IRs longer than two tail partitions are split into a head, using
+/// partitions of the block size, and a tail of larger partitions. A tail
+/// partition's result is not needed until one tail partition after its input
+/// is complete, so it can be computed in a background thread while the audio
+/// thread only processes the head. If the tail thread falls behind, the tail
+/// is left out of the output until the thread catches up, rather than making
+/// the audio thread wait.
+class Convolver{
+public:
+
+	Convolver();
+
+	~Convolver();
+
+
+	/// Set up convolution with a matrix of impulse responses
+
+	/// @param[in] blockSize		frames per call to process(); a power of two
+	/// @param[in] numInputs		number of input channels
+	/// @param[in] numOutputs		number of output channels
+	/// @param[in] irs				numInputs x numOutputs IRs, where
+	///								irs[i*numOutputs + o] is the IR from input i
+	///								to output o or NULL if there is none
+	/// @param[in] irLength			length of each IR, in samples
+	/// @param[in] tailBlockSize	partition size of the IR tail; a power of two
+	///								greater than blockSize, or 0 to use only
+	///								block size partitions
+	/// @param[in] tailThread		whether to process the tail in a
+	///								background thread
+	/// \returns true on success
+	bool setup(
+		int blockSize, int numInputs, int numOutputs,
+		const float * const * irs, int irLength,
+		int tailBlockSize=0, bool tailThread=true
+	);
+
+	/// Set up convolution of one input with one impulse response
+	bool setup(int blockSize, const float * ir, int irLength, int tailBlockSize=0, bool tailThread=true){
+		return setup(blockSize, 1,1, &ir, irLength, tailBlockSize, tailThread);
+	}
+
+
+	/// Convolve a block of input and add the result to the output
+
+	/// @param[out] out			numOutputs() non-interleaved output channels
+	/// @param[in ] in			numInputs() non-interleaved input channels
+	/// @param[in ] numFrames	frames per channel; must equal blockSize()
+	void process(float * out, const float * in, int numFrames);
+
+	/// Clear all internal signal history
+	void reset();
+
+
+	int blockSize() const { return mBlockSize; }
+	int tailBlockSize() const { return mTailBlockSize; }
+	int numInputs() const { return mNumInputs; }
+	int numOutputs() const { return mNumOutputs; }
+	int irLength() const { return mIRLength; }
+
+	/// Number of tail blocks at which the tail thread had fallen behind
+	unsigned tailUnderruns() const { return mTailUnderruns; }
+
+	/// Whether the tail thread is still working on a posted tail block
+
+	/// A block processed while this is true finds the thread busy and drops
+	/// the tail.
+	bool tailPending() const { return mRunning && loadAcquire(mTailDone) != mTailPosted; }
+
+private:
+
+	// Uniformly partitioned overlap-save convolution of one IR segment
+	struct Stage{
+		int size;		// partition size
+		int parts;		// number of partitions
+		int bins;		// size + 1 complex bins
+		int slot;		// newest slot of frequency-domain delay line
+		RFFT fft;		// transform of 2*size
+		std::vector<float> spectra;	// IR partitions [in][out][part][re,im]
+		std::vector<char> paths;	// whether input i has an IR to output o
+		std::vector<float> fdl;		// input spectra [in][slot][re,im]
+		std::vector<float> window;	// input windows [in][2*size]
+		std::vector<float> acc, time;
+
+		void init(int size, int numIn, int numOut, const float * const * irs, int begin, int end);
+		void compute(float * out, const float * in, int numIn, int numOut);
+		void clear();
+	};
+
+	struct TailWorker : public ThreadFunction{
+		Convolver * convolver;
+		void operator()(){ convolver->tailLoop(); }
+	};
+
+	int mBlockSize, mTailBlockSize, mNumInputs, mNumOutputs, mIRLength;
+	Stage mHead, mTail;
+	std::vector<float> mHeadOut;
+	std::vector<float> mTailIn[2];		// tail input blocks [in][tailBlockSize]
+	std::vector<float> mTailOut[2];		// tail output blocks [out][tailBlockSize]
+	int mTailPos;						// write position in current tail input block
+	unsigned mTailBlocks;				// completed tail input blocks
+	unsigned mTailUnderruns;
+	bool mTailDropped;					// tail is silent until the thread is idle
+
+	Thread mThread;
+	TailWorker mWorker;
+	volatile bool mRunning;
+	volatile unsigned mTailPosted, mTailDone;	// 1 + last tail block posted/done
+
+	void tailLoop();
+	void computeTail(unsigned block);
+	void postTail();
+	void clearTail();
+	void stop();
+};
+
+} // al::
+
+#endif
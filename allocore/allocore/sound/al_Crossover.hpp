@@ -48,6 +48,7 @@
 */
 #include <stdio.h>
 #include <float.h>
+#include <math.h>
 
 namespace al {
 
@@ -73,11 +74,11 @@ protected:
 
 
 template<>
-void Crossover<double> :: freq(double f, double fs) {
+inline void Crossover<double> :: freq(double f, double fs) {
 	double rad = M_PI * 2. * f / fs;
 	double cosine = cos(rad);
 	double sine = sin(rad);
-	if (abs(c) > 0.0001) {
+	if (fabs(cosine) > 0.0001) {
 		mC0 = (sine - 1.)/cosine;
 	} else {
 		mC0 = cosine * 0.5;
@@ -107,7 +108,7 @@ inline void Crossover<double> :: next(const double in, double * lo, double * hi)
 }
 
 template<>
-void Crossover<float> :: freq(float f, float fs) {
+inline void Crossover<float> :: freq(float f, float fs) {
 	float rad = M_PI * 2.f * f / fs;
 	float cosine = cosf(rad);
 	float sine = sinf(rad);
@@ -116,7 +117,7 @@ void Crossover<float> :: freq(float f, float fs) {
 	} else {
 		mC0 = cosine * 0.5f;
 	}
-	mC1 = (1f + mC0) * 0.5f;
+	mC1 = (1.f + mC0) * 0.5f;
 }
 
 template<>
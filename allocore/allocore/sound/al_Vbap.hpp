@@ -88,11 +88,19 @@ public:
 
 	void compile(Listener& listener);
 
+	/// Per Sample Processing
 	void perform(AudioIOData& io, SoundSource& src, Vec3d& relpos, const int& numFrames, int& frameIndex, float& sample);
 
+	/// Per Buffer Processing
+	void perform(AudioIOData& io, SoundSource& src, Vec3d& relpos, const int& numFrames, float *samples);
+
 	void print();
 
 private:
+	// Returns index of triplet enclosing a listener-relative position and
+	// its normalized gains, searching from the cached triplet
+	unsigned findTriple(const Vec3d& relpos, Vec3d& gains);
+
 	std::vector<SpeakerTriple> mTriplets;
 	unsigned mNumTriplets;
 	Listener* mListener;
@@ -122,12 +122,81 @@ public:
 		}
 	}
 
+	/// Get attenuation factors for an array of distances
+
+	/// This gives the same curve as attenuation(T), but the law is checked
+	/// once for the whole array so that the loop has no branches and can be
+	/// vectorized. The output may be the same array as the input.
+	void attenuation(T * out, const T * dist, int n) const {
+		attenuate(out, DistArray(dist), n);
+	}
+
+	/// Get attenuation factors for distances changing linearly
+
+	/// Distance i is dist0 + (dist1-dist0)*i/n, i.e. dist1 is the distance at
+	/// the start of the next block.
+	void attenuation(T * out, T dist0, T dist1, int n) const {
+		attenuate(out, DistRamp(dist0, (dist1-dist0)/T(n)), n);
+	}
+
 protected:
 	T mNear, mFar;		// clipping planes
 	T mFarBias;			// bias on far clip (linear model only)
 	T mScale;
 	AttenuationLaw mLaw;
 
+	struct DistArray{
+		const T * d;
+		DistArray(const T * d_): d(d_){}
+		T operator()(int i) const { return d[i]; }
+	};
+
+	struct DistRamp{
+		T d0, dd;
+		DistRamp(T d0_, T dd_): d0(d0_), dd(dd_){}
+		T operator()(int i) const { return d0 + dd*T(i); }
+	};
+
+	// Distances are clamped to the clip range instead of tested, which gives
+	// 1 at the near clip and, for the linear law, the bias at the far clip
+	template <class Dist>
+	void attenuate(T * out, const Dist& dist, int n) const {
+		const T nr = mNear, fr = mFar, s = mScale;
+		switch(mLaw){
+		case ATTEN_LINEAR:
+			for(int i=0; i<n; ++i){
+				T d = dist(i);
+				d = d < nr ? nr : d;
+				d = d < fr ? d : fr;
+				out[i] = T(1) - s*(d - nr);
+			}
+			break;
+
+		case ATTEN_INVERSE:
+			for(int i=0; i<n; ++i){
+				T d = dist(i);
+				d = d < nr ? nr : d;
+				out[i] = nr / (nr + s*(d - nr));
+			}
+			break;
+
+		case ATTEN_INVERSE_SQUARE:{
+			const T nearSqr = nr*nr;
+			for(int i=0; i<n; ++i){
+				T d = dist(i);
+				d = d < nr ? nr : d;
+				// d*d - nearSqr as a product; otherwise the compiler folds
+				// the square into the clamp, which then is no longer a select
+				out[i] = nearSqr / (nearSqr + s*(d - nr)*(d + nr));
+			}
+			}
+			break;
+
+		default:
+			for(int i=0; i<n; ++i) out[i] = T(1);
+		}
+	}
+
 	DistAtten& setScale(){
 		switch(mLaw){
 		case ATTEN_LINEAR:
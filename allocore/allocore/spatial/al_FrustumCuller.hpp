@@ -0,0 +1,200 @@
+#ifndef INCLUDE_AL_FRUSTUM_CULLER_HPP
+#define INCLUDE_AL_FRUSTUM_CULLER_HPP
+
+/*	Allocore --
+	Multimedia / virtual environment application class library
+
+	Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+	Copyright (C) 2012. The Regents of the University of California.
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice,
+		this list of conditions and the following disclaimer.
+
+		Redistributions in binary form must reproduce the above copyright
+		notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+
+		Neither the name of the University of California nor the names of its
+		contributors may be used to endorse or promote products derived from
+		this software without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+
+
+
+
+	File description:
+	Tests of many bounding volumes against a view frustum at once
+
+	Bounding spheres and boxes are kept in separate arrays per component so
+	that each frustum plane is tested against several objects at a time in
+	vector registers. Results are a visibility bit mask or a list of the
+	indices of visible objects. Large arrays can be split over a ThreadPool,
+	and objects in a HashSpace can be culled hierarchically by voxel region.
+*/
+
+#include <vector>
+#include "allocore/math/al_Frustum.hpp"
+#include "allocore/math/al_Vec.hpp"
+
+namespace al{
+
+class HashSpace;
+class ThreadPool;
+
+
+/// Bounding spheres stored as separate component arrays
+struct SphereArray{
+	std::vector<float> x, y, z;	///< centers
+	std::vector<float> r;		///< radii
+
+	SphereArray(int size=0){ resize(size); }
+
+	/// Get number of spheres
+	int size() const { return x.size(); }
+
+	/// Set number of spheres
+	void resize(int n){ x.resize(n); y.resize(n); z.resize(n); r.resize(n); }
+
+	/// Set sphere at index
+	void set(int i, const Vec3f& c, float rad){
+		x[i]=c[0]; y[i]=c[1]; z[i]=c[2]; r[i]=rad;
+	}
+};
+
+
+/// Axis-aligned boxes stored as separate component arrays
+struct BoxArray{
+	std::vector<float> x0, y0, z0;	///< minimum corners
+	std::vector<float> x1, y1, z1;	///< maximum corners
+
+	BoxArray(int size=0){ resize(size); }
+
+	/// Get number of boxes
+	int size() const { return x0.size(); }
+
+	/// Set number of boxes
+	void resize(int n){
+		x0.resize(n); y0.resize(n); z0.resize(n);
+		x1.resize(n); y1.resize(n); z1.resize(n);
+	}
+
+	/// Set box at index from its minimum and maximum corners
+	void set(int i, const Vec3f& lo, const Vec3f& hi){
+		x0[i]=lo[0]; y0[i]=lo[1]; z0[i]=lo[2];
+		x1[i]=hi[0]; y1[i]=hi[1]; z1[i]=hi[2];
+	}
+};
+
+
+/// Culls arrays of bounding volumes against the planes of a frustum
+
+/// An object is visible unless it is entirely outside one of the planes. As
+/// with Frustum::testBox, a box that is outside the frustum near one of its
+/// edges may still be reported as visible.
+///
+/// Visibility masks hold one bit per object; bit i%32 of word i/32 is set if
+/// object i is visible. A mask for n objects needs (n+31)/32 words.
+///
+/// @ingroup allocore
+class FrustumCuller{
+public:
+
+	FrustumCuller(){}
+
+	/// @param[in] f	frustum with computed planes
+	template <class T>
+	FrustumCuller(const Frustum<T>& f){ set(f); }
+
+	/// Set planes from a frustum; its planes must have been computed
+	template <class T>
+	FrustumCuller& set(const Frustum<T>& f);
+
+
+	/// Write visibility mask of spheres
+	void mask(uint32_t * visible, const SphereArray& s) const;
+
+	/// Write visibility mask of boxes
+	void mask(uint32_t * visible, const BoxArray& b) const;
+
+	/// Write visibility mask of spheres, splitting the work over a thread pool
+	void mask(uint32_t * visible, const SphereArray& s, ThreadPool& pool) const;
+
+	/// Write visibility mask of boxes, splitting the work over a thread pool
+	void mask(uint32_t * visible, const BoxArray& b, ThreadPool& pool) const;
+
+	/// Write indices of visible spheres and return how many there are
+
+	/// The index array must have room for all of the spheres.
+	///
+	int indices(int * visible, const SphereArray& s) const;
+
+	/// Write indices of visible boxes and return how many there are
+
+	/// The index array must have room for all of the boxes.
+	///
+	int indices(int * visible, const BoxArray& b) const;
+
+	/// Append indices of visible objects in a hash space
+
+	/// Objects are treated as spheres of a common radius. Voxel regions are
+	/// tested from the whole space down, so regions that are outside or
+	/// inside the frustum are handled without testing their objects. The
+	/// space is taken as the box [0, dim) on each axis; positions are not
+	/// wrapped around it.
+	/// @param[out] visible		indices of visible objects are appended
+	/// @param[in] space		space to cull
+	/// @param[in] radius		bounding radius of objects
+	/// \returns number of indices appended
+	int indices(std::vector<int>& visible, const HashSpace& space, float radius) const;
+
+	/// Convert a visibility mask to a list of indices; returns the count
+	static int maskToIndices(int * visible, const uint32_t * mask, int n);
+
+private:
+	float mNx[6], mNy[6], mNz[6], mD[6];
+
+	// Classify box against planes as a Frustum::OUTSIDE, INTERSECT or INSIDE
+	int classify(const float * lo, const float * hi) const;
+
+	void maskSpheres(uint32_t * visible, const SphereArray& s, int begin, int end) const;
+	void maskBoxes(uint32_t * visible, const BoxArray& b, int begin, int end) const;
+	void cullRegion(std::vector<int>& visible, const HashSpace& space, float radius, const int * org, int size, int leaf) const;
+
+	struct MaskSpheres;
+	struct MaskBoxes;
+};
+
+
+
+// Implementation --------------------------------------------------------------
+
+template <class T>
+FrustumCuller& FrustumCuller::set(const Frustum<T>& f){
+	for(int i=0; i<6; ++i){
+		const Plane<T>& p = f.pl[i];
+		mNx[i] = p.normal()[0];
+		mNy[i] = p.normal()[1];
+		mNz[i] = p.normal()[2];
+		mD[i] = p.d();
+	}
+	return *this;
+}
+
+} // al::
+
+#endif
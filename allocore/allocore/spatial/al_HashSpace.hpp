@@ -259,6 +259,7 @@ public:
 	static uint32_t invalidHash() { return UINT_MAX; }
 
 protected:
+	friend class FrustumCuller;
 
 	// integer distance squared
 	uint32_t distanceSquared(double a1, double a2, double a3) const;
@@ -48,6 +48,7 @@
 #include "allocore/math/al_Vec.hpp"
 #include "allocore/math/al_Quat.hpp"
 #include <stdio.h>
+#include <vector>
 
 
 namespace al {
@@ -373,6 +374,45 @@ protected:
 
 
 
+/// An array of poses stored as one array per component
+
+/// This layout lets operations on many poses, such as placing instances or
+/// composing the levels of a transform hierarchy, run several poses at a
+/// time in vector registers. Components are single-precision.
+struct PoseArray{
+	std::vector<float> px, py, pz;		///< positions
+	std::vector<float> qw, qx, qy, qz;	///< orientations
+
+	PoseArray(int size=0){ resize(size); }
+
+	/// Get number of poses
+	int size() const { return px.size(); }
+
+	/// Set number of poses; new poses are identities
+	void resize(int n);
+
+	/// Set pose at index
+	void set(int i, const Pose& p);
+
+	/// Get pose at index
+	Pose get(int i) const;
+
+	/// Apply parent poses to poses local to them
+
+	/// Each output pose has position parent.pos + parent.quat.rotate(local.pos)
+	/// and orientation parent.quat * local.quat, i.e., it is the local pose
+	/// expressed in the parent's frame. Note that Pose::operator*= does not
+	/// rotate the position. The output may be the same array as either input.
+	static void compose(PoseArray& out, const PoseArray& parent, const PoseArray& local);
+
+	/// Apply one parent pose to all poses local to it
+	static void compose(PoseArray& out, const Pose& parent, const PoseArray& local);
+
+	/// Write each pose as a column-major 4x4 transform matrix, e.g. for instancing
+	void matrices(float * m) const;
+};
+
+
 
 // Implementation --------------------------------------------------------------
 
@@ -0,0 +1,140 @@
+#ifndef INCLUDE_AL_ATOMIC_HPP
+#define INCLUDE_AL_ATOMIC_HPP
+
+/*	Allocore --
+	Multimedia / virtual environment application class library
+
+	Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+	Copyright (C) 2012. The Regents of the University of California.
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice,
+		this list of conditions and the following disclaimer.
+
+		Redistributions in binary form must reproduce the above copyright
+		notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+
+		Neither the name of the University of California nor the names of its
+		contributors may be used to endorse or promote products derived from
+		this software without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+
+
+
+	File description:
+	Loads and stores for sharing data between threads without locking
+
+	A store with release ordering makes all writes that precede it visible to
+	a thread that reads the stored value with an acquire load. This is enough
+	to hand buffers from one thread to another, e.g. from an audio thread to a
+	worker thread. The variables should be word-sized and naturally aligned.
+
+	Read-modify-write operations and full fences are provided for long
+	integers, which is what lock-free structures with several writers, such
+	as work-stealing deques, need.
+*/
+
+#ifdef _MSC_VER
+	#include <windows.h>
+#endif
+
+namespace al{
+
+/// Load a value shared with another thread with acquire ordering
+template <class T>
+inline T loadAcquire(const volatile T& v){
+	#if defined(__GNUC__)
+		return __atomic_load_n(&v, __ATOMIC_ACQUIRE);
+	#else
+		T r = v;
+		MemoryBarrier();
+		return r;
+	#endif
+}
+
+/// Store a value shared with another thread with release ordering
+template <class T>
+inline void storeRelease(volatile T& v, T x){
+	#if defined(__GNUC__)
+		__atomic_store_n(&v, x, __ATOMIC_RELEASE);
+	#else
+		MemoryBarrier();
+		v = x;
+	#endif
+}
+
+/// Load a value shared with another thread without ordering other accesses
+template <class T>
+inline T loadRelaxed(const volatile T& v){
+	#if defined(__GNUC__)
+		return __atomic_load_n(&v, __ATOMIC_RELAXED);
+	#else
+		return v;
+	#endif
+}
+
+/// Store a value shared with another thread without ordering other accesses
+template <class T>
+inline void storeRelaxed(volatile T& v, T x){
+	#if defined(__GNUC__)
+		__atomic_store_n(&v, x, __ATOMIC_RELAXED);
+	#else
+		v = x;
+	#endif
+}
+
+/// Order all preceding loads and stores before all following ones
+inline void fenceSeqCst(){
+	#if defined(__GNUC__)
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	#else
+		MemoryBarrier();
+	#endif
+}
+
+/// Replace a value if it equals an expected value, returning whether it did
+inline bool compareAndSwap(volatile long& v, long expected, long desired){
+	#if defined(__GNUC__)
+		return __atomic_compare_exchange_n(&v, &expected, desired, false,
+			__ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	#else
+		return InterlockedCompareExchange(&v, desired, expected) == expected;
+	#endif
+}
+
+/// Replace a value, returning the previous value
+inline long exchange(volatile long& v, long x){
+	#if defined(__GNUC__)
+		return __atomic_exchange_n(&v, x, __ATOMIC_ACQ_REL);
+	#else
+		return InterlockedExchange(&v, x);
+	#endif
+}
+
+/// Add to a value, returning the previous value
+inline long fetchAdd(volatile long& v, long x){
+	#if defined(__GNUC__)
+		return __atomic_fetch_add(&v, x, __ATOMIC_ACQ_REL);
+	#else
+		return InterlockedExchangeAdd(&v, x);
+	#endif
+}
+
+} // al::
+
+#endif
@@ -60,6 +60,15 @@ public:
 		virtual void onExit() {}
 	};
 
+	/// Handler of events on a file descriptor, e.g. a socket
+	class FDHandler {
+	public:
+		virtual ~FDHandler() {}
+
+		/// Called from the main loop when the descriptor has data to read
+		virtual void onReadable(int fd) = 0;
+	};
+
 	enum Driver {
 		SLEEP = 0,
 		GLUT,
@@ -72,10 +81,7 @@ public:
 
 	/// set the timer interval in seconds (minimum 1 millisecond)
 	/// actual behavior is driver dependent
-	Main& interval(al_sec v) {
-		mInterval = v > 0.001 ? v : 0.001;
-		return *this;
-	}
+	Main& interval(al_sec v);
 
 	/// takes over control of the current thread
 	/// starts the clock-driven scheduler
@@ -116,6 +122,25 @@ public:
 	Main& add(Main::Handler& v);
 	Main& remove(Main::Handler& v);
 
+	/// Call a handler whenever a file descriptor has data to read
+
+	/// Events are dispatched as soon as they arrive rather than once per
+	/// tick, so e.g. a socket can be drained by the handler instead of being
+	/// polled in onTick(). Only the NATIVE driver on Linux supports this;
+	/// it sleeps in epoll until a descriptor is ready, a tick is due or the
+	/// loop is woken. Returns whether the descriptor was registered, which
+	/// is false unless the driver has been set to NATIVE.
+	bool watch(int fd, Main::FDHandler& h);
+
+	/// Stop watching a file descriptor
+	Main& unwatch(int fd);
+
+	/// Wake the main loop from any thread
+
+	/// This interrupts the wait for the next tick so that, e.g., a stop()
+	/// from another thread takes effect immediately.
+	void wake();
+
 	// INTERNAL USE:
 
 	/// trigger a mainloop step (typically for implementation use only)
@@ -49,12 +49,59 @@ namespace al{
 
 /// Thread that calls a function periodically
 
-/// The sleep time is dynamically adjusted based on the time taken by the
-/// user-supplied thread function. This prevents drift that would occur in a
-/// more simplistic implementation using a fixed sleep interval.
+/// Calls are scheduled at absolute deadlines, start + k * period, on a
+/// monotonic clock, so that timing does not drift regardless of how long
+/// the function takes. Lateness of wake-ups (jitter), execution times and
+/// overruns are collected in histograms that may be read while the thread
+/// runs.
 class PeriodicThread : public Thread{
 public:
 
+	/// What to do when a call finishes after the next deadline
+	enum OverrunPolicy{
+		CATCH_UP,	///< Keep the schedule and make up missed calls
+		SKIP		///< Drop missed calls and continue at the next deadline
+	};
+
+	/// Timing statistics
+
+	/// Histograms have logarithmically spaced bins: bin 0 counts durations
+	/// below 1 us and bin i > 0 durations in [2^(i-1), 2^i) us. The last
+	/// bin also counts all longer durations.
+	struct Stats{
+		enum{ NUM_BINS = 24 };
+
+		unsigned long iterations;		///< Number of calls
+		unsigned long overruns;			///< Calls that finished after the next deadline
+		unsigned long skipped;			///< Calls dropped with the SKIP policy
+		unsigned long jitter[NUM_BINS];	///< Histogram of wake-up lateness
+		unsigned long exec[NUM_BINS];	///< Histogram of function execution times
+		al_nsec jitterMax;				///< Maximum wake-up lateness
+		al_nsec execMax;				///< Maximum execution time
+		al_nsec execSum;				///< Sum of execution times
+		al_nsec periodSmoothed;			///< Period measured by a delay-locked loop
+
+		/// Returns mean execution time, in seconds
+		double execMean() const;
+
+		/// Returns upper bin edge, in seconds, below which a fraction p of wake-up latenesses lie
+		double jitterPercentile(double p) const { return percentile(jitter, p); }
+
+		/// Returns upper bin edge, in seconds, below which a fraction p of execution times lie
+		double execPercentile(double p) const { return percentile(exec, p); }
+
+		/// Returns bin a duration falls in
+		static int bin(al_nsec dt);
+
+		/// Returns upper edge of a bin, in seconds
+		static double binEdge(int i);
+
+		static double percentile(const unsigned long * hist, double p);
+
+		void clear();
+	};
+
+
 	/// @param[in] periodSec	calling period in seconds
 	PeriodicThread(double periodSec=1);
 
@@ -64,16 +111,20 @@ public:
 
 	/// Set autocorrection factor
 
-	/// This parameter is used to compensate for occasional iterations that take
-	/// longer than the expected iteration period. Smaller values mean the
-	/// timing corrections will be spread over a larger number of iterations.
-	/// If all iterations take longer than the period, then no autocorrection
-	/// measures will be able to make up for the lost time.
+	/// This parameter limits how fast the thread catches up with its
+	/// schedule after late iterations with the CATCH_UP policy. Smaller
+	/// values mean the timing corrections will be spread over a larger
+	/// number of iterations. If all iterations take longer than the period,
+	/// then no autocorrection measures will be able to make up for the lost
+	/// time.
 	///
 	/// @param[in] factor	Maximum fraction of one period, in [0,1], to try to
 	///						make up each iteration if behind on timing.
 	PeriodicThread& autocorrect(float factor);
 
+	/// Set what to do when calls overrun their period
+	PeriodicThread& overrunPolicy(OverrunPolicy v);
+
 	/// Set period, in seconds
 	PeriodicThread& period(double sec);
 
@@ -84,9 +135,19 @@ public:
 	void start(ThreadFunction& func);
 
 	/// Stop the thread
+
+	/// The thread finishes its current call and exits. Use join() to wait
+	/// for it.
 	void stop();
 
 
+	/// Get timing statistics; safe to call while the thread runs
+	Stats stats() const;
+
+	/// Clear timing statistics, at the next call if the thread runs
+	void resetStats();
+
+
 	// Stuff for assignment
 	friend void swap(PeriodicThread& a, PeriodicThread& b);
 	PeriodicThread& operator= (PeriodicThread other);
@@ -96,12 +157,12 @@ private:
 	void go();
 
 	al_nsec mPeriod;
-	al_nsec mTimeCurr, mTimePrev;	// time measurements between frames
-	al_nsec mWait;					// actual time to sleep between frames
-	al_nsec mTimeBehind;
 	float mAutocorrect;
+	OverrunPolicy mOverrunPolicy;
 	ThreadFunction * mUserFunc;
 	bool mRun;
+	bool mResetStats;
+	Stats mStats;					// written by the thread only
 };
 
 } // al::
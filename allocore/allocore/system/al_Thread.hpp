@@ -101,9 +101,21 @@ public:
 	/// Set thread priority
 
 	/// @param[in] v	priority of thread in [0, 99]. A value greater than 0
-	///					makes the thread "real-time".
+	///					makes the thread "real-time" (SCHED_FIFO with
+	///					pthreads). If the process is not allowed to use
+	///					real-time scheduling, the thread starts with normal
+	///					scheduling. Takes effect when the thread is started.
 	Thread& priority(int v);
 
+	/// Set processors the thread may run on
+
+	/// @param[in] cpuMask	bit i allows the thread to run on processor i; if
+	///						0, the thread may run on any processor. Takes
+	///						effect when the thread is started. If none of
+	///						the processors exist, the thread may run on any
+	///						processor. Supported on Linux and Windows.
+	Thread& affinity(unsigned long long cpuMask);
+
 
 	/// Start executing thread function
 	bool start(ThreadFunction& func);
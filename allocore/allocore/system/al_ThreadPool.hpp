@@ -0,0 +1,207 @@
+#ifndef INCLUDE_AL_THREAD_POOL_HPP
+#define INCLUDE_AL_THREAD_POOL_HPP
+
+/*	Allocore --
+	Multimedia / virtual environment application class library
+
+	Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+	Copyright (C) 2012. The Regents of the University of California.
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice,
+		this list of conditions and the following disclaimer.
+
+		Redistributions in binary form must reproduce the above copyright
+		notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+
+		Neither the name of the University of California nor the names of its
+		contributors may be used to endorse or promote products derived from
+		this software without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+
+
+
+	File description:
+	Pool of worker threads that run index ranges in parallel
+
+	Work is split recursively and distributed with work-stealing deques: each
+	thread pushes the far half of a range onto its own deque and keeps working
+	on the near half, while idle threads steal the largest pending pieces from
+	other deques. The calling thread works on its own loop too, so a loop
+	finishes even if every worker is busy or asleep, and nothing is allocated
+	or locked while it runs. That makes parallelFor usable from an audio
+	callback.
+*/
+
+#include <vector>
+#include "allocore/system/al_Thread.hpp"
+
+namespace al{
+
+
+/// Pool of worker threads
+
+/// A typical use is
+/// \code
+///	struct Body{
+///		void operator()(int begin, int end){ for(int i=begin; i<end; ++i) ... }
+///	};
+///	ThreadPool pool;
+///	pool.start();
+///	Body body;
+///	pool.parallelFor(0, N, body, 64);
+/// \endcode
+///
+/// parallelFor may be called from one thread outside of the pool at a time
+/// and from within loop bodies (nested loops).
+///
+/// @ingroup allocore
+class ThreadPool{
+public:
+
+	/// @param[in] numWorkers	number of worker threads; if negative, one less
+	///							than the number of processors, since the
+	///							calling thread also does work
+	ThreadPool(int numWorkers = -1);
+
+	/// Stops the workers
+	~ThreadPool();
+
+
+	/// Returns number of worker threads
+	int size() const { return int(mAffinity.size()); }
+
+	/// Returns whether the worker threads have been started
+	bool running() const { return mRunning; }
+
+
+	/// Set number of worker threads (only when stopped)
+	ThreadPool& resize(int numWorkers);
+
+	/// Set priority of worker threads (only when stopped)
+
+	/// @param[in] v	priority in [0, 99]; greater than 0 requests real-time
+	///					scheduling (see Thread::priority)
+	ThreadPool& priority(int v);
+
+	/// Set processors a worker may run on (only when stopped)
+
+	/// @param[in] worker	worker index
+	/// @param[in] cpuMask	bit i allows processor i; 0 allows any processor
+	ThreadPool& affinity(int worker, unsigned long long cpuMask);
+
+	/// Pin each worker to its own processor (only when stopped)
+
+	/// Worker i runs on processor (firstCPU + i) modulo the number of
+	/// processors.
+	ThreadPool& pin(int firstCPU = 0);
+
+	/// Set how long idle workers busy-wait before sleeping
+
+	/// Sleeping workers poll for work at intervals of up to a millisecond.
+	/// Spinning for longer than the period between loops, e.g. an audio
+	/// buffer, keeps workers awake and their response immediate at the cost
+	/// of one busy processor per worker.
+	ThreadPool& spinTime(double sec);
+
+	/// Start worker threads
+	bool start();
+
+	/// Stop and join worker threads
+	void stop();
+
+
+	/// Run body(begin, end) over sub-ranges of [begin, end) in parallel
+
+	/// Ranges are split in halves until they are no longer than grain
+	/// indices. Returns once the whole range has been run. If the pool is
+	/// not running, the body is run on the calling thread over the whole
+	/// range.
+	template <class Body>
+	void parallelFor(int begin, int end, Body& body, int grain = 1);
+
+
+	// Internal interfaces; these are public only so templates can use them
+
+	struct RangeFunc{
+		virtual ~RangeFunc(){}
+		virtual void operator()(int begin, int end) = 0;
+	};
+
+	struct Job{
+		RangeFunc * func;
+		long grain;
+		volatile long pending;		// indices not yet run
+	};
+
+	void run(Job& job, int begin, int end);
+
+private:
+	class Deque;
+	struct Item;
+	struct Worker : public ThreadFunction{
+		ThreadPool * pool;
+		int index;
+		void operator()();
+	};
+
+	std::vector<unsigned long long> mAffinity;
+	int mPriority;
+	double mSpinTime;
+	Deque * mDeques;				// one per worker plus one for outside callers
+	Threads<Worker> mWorkers;
+	volatile bool mRunning;
+
+	int currentDeque() const;
+	void execute(Item& item, int deque);
+	bool findWork(Item& item, int deque);
+	void workerLoop(int index);
+
+	ThreadPool(const ThreadPool&);
+	ThreadPool& operator=(const ThreadPool&);
+};
+
+
+
+// Implementation
+//------------------------------------------------------------------------------
+
+template <class Body>
+void ThreadPool::parallelFor(int begin, int end, Body& body, int grain){
+	if(end <= begin) return;
+	if(!mRunning){
+		body(begin, end);
+		return;
+	}
+
+	struct F : public RangeFunc{
+		Body& body;
+		F(Body& b): body(b){}
+		void operator()(int b, int e){ body(b, e); }
+	} func(body);
+
+	Job job;
+	job.func = &func;
+	job.grain = grain < 1 ? 1 : grain;
+	job.pending = end - begin;
+	run(job, begin, end);
+}
+
+} // al::
+
+#endif
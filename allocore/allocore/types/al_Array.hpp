@@ -43,11 +43,16 @@
 #ifndef INCLUDE_ALLO_ARRAY_HPP
 #define INCLUDE_ALLO_ARRAY_HPP 1
 
+#include <math.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
+#include <string>
+#include <vector>
 #include "allocore/types/al_Array.h"
 #include "allocore/math/al_Functions.hpp"
 #include "allocore/math/al_Vec.hpp"
+#include "allocore/system/al_Thread.hpp"
 
 #define AL_ARRAY_DEFAULT_ALIGNMENT (4)
 
@@ -62,6 +67,21 @@ namespace al {
 class Array : public AlloArray {
 public:
 
+	/// Memory mapping modes, see map()
+	enum MapMode{
+		MAPPED_READ,			/**< Read-only; pages are shared with other processes */
+		MAPPED_COPY_ON_WRITE	/**< Writable; modified pages become private copies */
+	};
+
+	/// Access pattern hints for memory mapped data, see advise()
+	enum MapAdvice{
+		ADVISE_NORMAL,			/**< No special treatment */
+		ADVISE_SEQUENTIAL,		/**< Expect sequential access; read ahead aggressively */
+		ADVISE_RANDOM,			/**< Expect random access; do not read ahead */
+		ADVISE_WILLNEED,		/**< Expect access soon; start paging in now */
+		ADVISE_DONTNEED			/**< Not needed soon; pages may be released */
+	};
+
 	/// Empty constructor defines a 0-dimensional, 1-component array of void type; unallocated data
 	Array();
 
@@ -153,9 +173,38 @@ public:
 	void dataFree();
 
 	/// Set all data to zero
+
+	/// If the data is mapped read-only, the mapping is released and replaced
+	/// with zeroed memory.
 	void zero();
 
 
+	/// Map data directly from a file without copying
+
+	/// Pages are loaded lazily on first access and, in read-only mode, are
+	/// shared between all processes mapping the same file. Any previously held
+	/// data is freed. The offset need not be page aligned, however aligned
+	/// offsets avoid mapping a partial leading page.
+	/// Calling format() on a mapped array replaces the mapping with allocated
+	/// memory.
+	///
+	/// @param[in] path		path of file
+	/// @param[in] h		layout of data in file
+	/// @param[in] offset	byte offset of data from start of file
+	/// @param[in] mode		mapping mode
+	/// \returns whether the data was successfully mapped
+	bool map(const std::string& path, const AlloArrayHeader& h, size_t offset=0, MapMode mode=MAPPED_READ);
+
+	/// Returns true if data is memory mapped from a file, false otherwise
+	bool isMapped() const { return NULL != mMapBase; }
+
+	/// Give the OS a hint about how mapped data will be accessed
+
+	/// This has no effect if the data is not memory mapped.
+	///
+	void advise(MapAdvice v);
+
+
 	/// Get mutable component using 1-D index
 	template <class T> T& elem(size_t ic, size_t ix){
 		return cell<T>(ix)[ic]; }
@@ -290,6 +339,30 @@ public:
 	template<typename T, typename TP> void write_interp(const T* val, const Vec<2,TP> p) { write_interp(val, p[0], p[1]); }
 	template<typename T, typename TP> void write_interp(const T* val, const Vec<3,TP> p) { write_interp(val, p[0], p[1], p[2]); }
 
+	/// Linear interpolated lookup of many points (virtual array index)
+
+	/// This gives the same result as calling read_interp for each point
+	/// (xs[i], ys[i], zs[i]), but computes strides, wrapping and weights for
+	/// blocks of points at once so that the arithmetic can be vectorized.
+	/// The components of point i are written to vals[i*components() + c].
+	/// Coordinates along axes beyond dimcount() are ignored. Nothing is read
+	/// if T is not the array's component type.
+	template<typename T>
+	void read_interp_batch(T * vals, const float * xs, const float * ys, const float * zs, size_t n) const;
+
+	/// Linear interpolated write of many points (virtual array index)
+
+	/// AKA batch trilinear splat. This accumulates the same values as calling
+	/// write_interp for each point. The components of point i are read from
+	/// vals[i*components() + c].
+	/// When using multiple threads, the array is divided into z slabs that
+	/// are splatted in two passes (even slabs, then odd slabs) so that no two
+	/// threads ever write to the same cell. Arrays with fewer than three
+	/// dimensions are always splatted by the calling thread. Nothing is
+	/// written if T is not the array's component type.
+	template<typename T>
+	void write_interp_batch(const T * vals, const float * xs, const float * ys, const float * zs, size_t n, unsigned threads=1);
+
 	/// Print array information
 	void print(FILE * fp = stdout) const;
 
@@ -305,12 +378,32 @@ public:
 	static void deriveStride(AlloArrayHeader& h, size_t rowAlignSize);
 
 protected:
+	void * mMapBase;	// start of mapped region (page aligned), if mapped
+	size_t mMapSize;	// size of mapped region, in bytes
+	MapMode mMapMode;
+
 	void formatAlignedGeneral(int comps, AlloTy ty, uint32_t * dims, int numDims, size_t align);
+	void initMap(){ mMapBase=NULL; mMapSize=0; mMapMode=MAPPED_READ; }
 public:	// temporarily made public, because protected broke some other project code -gw
 	Array(const Array&);
 	Array& operator= (const Array&);
 protected:
 
+	// Cell offsets and corner weights for a block of interpolated points
+	struct InterpBlock{
+		enum{ SIZE = 64 };
+		size_t offset[SIZE];			// byte offset of lower corner
+		ptrdiff_t step[3][SIZE];		// byte offset to upper corner along each axis
+		float frac[3][SIZE];			// fractional position along each axis
+
+		void compute(const AlloArrayHeader& h, const float * xs, const float * ys, const float * zs, size_t n);
+	};
+
+	template<typename T>
+	void write_interp_points(const T * vals, const float * xs, const float * ys, const float * zs, const size_t * idx, size_t n);
+
+	template<typename T> struct SplatWorker;
+
 	// temporary hack because the one in al_Function gave a bad result
 	// for e.g. wrap<double>(-64.0, -32.0);
 	template<typename T>
@@ -644,6 +737,187 @@ template<typename T> inline void Array::write_interp(const T* val, double x0, do
 }
 
 
+inline void Array::InterpBlock::compute(const AlloArrayHeader& h, const float * xs, const float * ys, const float * zs, size_t n){
+	const float * ps[3] = {xs, ys, zs};
+	for(int d=0; d<3; ++d){
+		// Axes beyond the array's dimensions have no extent; the coordinate
+		// along them is ignored.
+		if(d >= h.dimcount){
+			for(size_t i=0; i<n; ++i){
+				step[d][i] = 0;
+				frac[d][i] = 0.f;
+				if(0 == d) offset[i] = 0;
+			}
+			continue;
+		}
+		const float * p = ps[d];
+		const int dim = h.dim[d];
+		const float fdim = dim;
+		const float invdim = 1.f/fdim;
+		const ptrdiff_t stride = h.stride[d];
+		const ptrdiff_t wrapStep = stride*(dim-1);
+		ptrdiff_t * st = step[d];
+		float * fr = frac[d];
+		for(size_t i=0; i<n; ++i){
+			float v = p[i];
+			v -= fdim * floorf(v * invdim);	// wrap into [0, dim]
+			int a = int(v);
+			fr[i] = v - a;
+			if(a >= dim) a = 0;
+			st[i] = a == dim-1 ? -wrapStep : stride;
+			if(0 == d)	offset[i]  = a*stride;
+			else		offset[i] += a*stride;
+		}
+	}
+}
+
+template<typename T>
+void Array::read_interp_batch(T * vals, const float * xs, const float * ys, const float * zs, size_t n) const {
+	if(!isType<T>()) return;
+	const int C = header.components;
+	InterpBlock B;
+	for(size_t i0=0; i0<n; i0+=InterpBlock::SIZE){
+		size_t m = n-i0 < size_t(InterpBlock::SIZE) ? n-i0 : size_t(InterpBlock::SIZE);
+		B.compute(header, xs+i0, ys+i0, zs+i0, m);
+		T * val = vals + i0*C;
+		for(size_t i=0; i<m; ++i){
+			const char * paaa = data.ptr + B.offset[i];
+			const ptrdiff_t sx = B.step[0][i], sy = B.step[1][i], sz = B.step[2][i];
+			const float xbf = B.frac[0][i], xaf = 1.f - xbf;
+			const float ybf = B.frac[1][i], yaf = 1.f - ybf;
+			const float zbf = B.frac[2][i], zaf = 1.f - zbf;
+			const T * c[8] = {
+				(const T *)(paaa),			(const T *)(paaa+sx),
+				(const T *)(paaa+sy),		(const T *)(paaa+sx+sy),
+				(const T *)(paaa+sz),		(const T *)(paaa+sx+sz),
+				(const T *)(paaa+sy+sz),	(const T *)(paaa+sx+sy+sz)
+			};
+			const float f[8] = {
+				xaf*yaf*zaf, xbf*yaf*zaf, xaf*ybf*zaf, xbf*ybf*zaf,
+				xaf*yaf*zbf, xbf*yaf*zbf, xaf*ybf*zbf, xbf*ybf*zbf
+			};
+			for(int p=0; p<C; ++p){
+				val[p] =	c[0][p]*f[0] + c[1][p]*f[1] + c[2][p]*f[2] + c[3][p]*f[3]
+						+	c[4][p]*f[4] + c[5][p]*f[5] + c[6][p]*f[6] + c[7][p]*f[7];
+			}
+			val += C;
+		}
+	}
+}
+
+// Splat points given by an index list (or all points if idx is NULL)
+template<typename T>
+void Array::write_interp_points(const T * vals, const float * xs, const float * ys, const float * zs, const size_t * idx, size_t n){
+	const int C = header.components;
+	InterpBlock B;
+	float bx[InterpBlock::SIZE], by[InterpBlock::SIZE], bz[InterpBlock::SIZE];
+	for(size_t i0=0; i0<n; i0+=InterpBlock::SIZE){
+		size_t m = n-i0 < size_t(InterpBlock::SIZE) ? n-i0 : size_t(InterpBlock::SIZE);
+		if(idx){
+			for(size_t i=0; i<m; ++i){
+				size_t k = idx[i0+i];
+				bx[i] = xs[k]; by[i] = ys[k]; bz[i] = zs[k];
+			}
+			B.compute(header, bx, by, bz, m);
+		}
+		else{
+			B.compute(header, xs+i0, ys+i0, zs+i0, m);
+		}
+		for(size_t i=0; i<m; ++i){
+			const T * val = vals + (idx ? idx[i0+i] : i0+i)*C;
+			char * paaa = data.ptr + B.offset[i];
+			const ptrdiff_t sx = B.step[0][i], sy = B.step[1][i], sz = B.step[2][i];
+			const float xbf = B.frac[0][i], xaf = 1.f - xbf;
+			const float ybf = B.frac[1][i], yaf = 1.f - ybf;
+			const float zbf = B.frac[2][i], zaf = 1.f - zbf;
+			T * c[8] = {
+				(T *)(paaa),		(T *)(paaa+sx),
+				(T *)(paaa+sy),		(T *)(paaa+sx+sy),
+				(T *)(paaa+sz),		(T *)(paaa+sx+sz),
+				(T *)(paaa+sy+sz),	(T *)(paaa+sx+sy+sz)
+			};
+			const float f[8] = {
+				xaf*yaf*zaf, xbf*yaf*zaf, xaf*ybf*zaf, xbf*ybf*zaf,
+				xaf*yaf*zbf, xbf*yaf*zbf, xaf*ybf*zbf, xbf*ybf*zbf
+			};
+			for(int p=0; p<C; ++p){
+				T tmp = val[p];
+				c[0][p] += tmp * f[0]; c[1][p] += tmp * f[1];
+				c[2][p] += tmp * f[2]; c[3][p] += tmp * f[3];
+				c[4][p] += tmp * f[4]; c[5][p] += tmp * f[5];
+				c[6][p] += tmp * f[6]; c[7][p] += tmp * f[7];
+			}
+		}
+	}
+}
+
+template<typename T>
+struct Array::SplatWorker : public ThreadFunction{
+	Array * array;
+	const T * vals;
+	const float * xs, * ys, * zs;
+	const size_t * idx;			// point indices sorted by slab
+	const size_t * slabBegin;	// start of each slab in idx
+	unsigned slab0, slabStep, slabEnd;
+
+	void operator()(){
+		for(unsigned s=slab0; s<slabEnd; s+=slabStep){
+			array->write_interp_points(vals, xs, ys, zs, idx + slabBegin[s], slabBegin[s+1] - slabBegin[s]);
+		}
+	}
+};
+
+template<typename T>
+void Array::write_interp_batch(const T * vals, const float * xs, const float * ys, const float * zs, size_t n, unsigned threads){
+	if(!isType<T>()) return;
+
+	// Slabs must be at least 2 cells thick so that a point only ever writes
+	// into its own slab and the next one. An even number of slabs ensures
+	// the last slab, which wraps into slab 0, is never processed alongside it.
+	const unsigned nz = header.dimcount >= 3 ? header.dim[2] : 1;
+	unsigned slabs = 2*threads;
+	if(slabs > nz/2) slabs = nz/2;
+	slabs &= ~1u;
+
+	if(threads <= 1 || slabs < 2 || n < slabs){
+		write_interp_points(vals, xs, ys, zs, (const size_t *)NULL, n);
+		return;
+	}
+
+	// Bin points by slab (counting sort)
+	std::vector<unsigned> slabOf(n);
+	std::vector<size_t> slabBegin(slabs+1, 0);
+	std::vector<size_t> idx(n);
+	const float fnz = nz;
+	for(size_t i=0; i<n; ++i){
+		float z = zs[i];
+		z -= fnz * floorf(z / fnz);
+		unsigned za = unsigned(z);
+		if(za >= nz) za = 0;
+		slabOf[i] = (unsigned long long)za * slabs / nz;
+		++slabBegin[slabOf[i]+1];
+	}
+	for(unsigned s=0; s<slabs; ++s) slabBegin[s+1] += slabBegin[s];
+	{	std::vector<size_t> fill(slabBegin.begin(), slabBegin.end()-1);
+		for(size_t i=0; i<n; ++i) idx[fill[slabOf[i]]++] = i;
+	}
+
+	Threads<SplatWorker<T> > workers(threads);
+	for(unsigned pass=0; pass<2; ++pass){
+		for(unsigned t=0; t<threads; ++t){
+			SplatWorker<T>& w = workers.function(t);
+			w.array = this;
+			w.vals = vals; w.xs = xs; w.ys = ys; w.zs = zs;
+			w.idx = &idx[0];
+			w.slabBegin = &slabBegin[0];
+			w.slab0 = pass + 2*t;
+			w.slabStep = 2*threads;
+			w.slabEnd = slabs;
+		}
+		workers.start();
+	}
+}
+
 template<typename T> void Array::fill(void (*func)(T * values, double normx)) {
 	int d0 = header.dim[0];
 	double inv_d0 = 1.0/(double)d0;
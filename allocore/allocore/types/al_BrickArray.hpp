@@ -0,0 +1,290 @@
+#ifndef INCLUDE_AL_BRICK_ARRAY_HPP
+#define INCLUDE_AL_BRICK_ARRAY_HPP
+
+/*	Allocore --
+	Multimedia / virtual environment application class library
+
+	Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+	Copyright (C) 2012. The Regents of the University of California.
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice,
+		this list of conditions and the following disclaimer.
+
+		Redistributions in binary form must reproduce the above copyright
+		notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+
+		Neither the name of the University of California nor the names of its
+		contributors may be used to endorse or promote products derived from
+		this software without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+
+
+
+	File description:
+	Out-of-core bricked volume storage
+
+	A bricked volume splits a 3D array into cubic bricks that are compressed
+	and stored individually in a file. Bricks are paged in on demand through a
+	fixed-size LRU cache so that volumes much larger than RAM can be sampled.
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <list>
+#include <string>
+#include <vector>
+#include "allocore/types/al_Array.hpp"
+
+namespace al {
+
+/// Brick compression codecs
+enum BrickCodec{
+	BRICK_RAW		= 0,	/**< Uncompressed */
+	BRICK_DEFLATE	= 1		/**< zlib deflate (requires zlib module) */
+};
+
+/// Returns whether a brick codec is available in this build
+bool brickCodecAvailable(BrickCodec c);
+
+
+
+/// Streaming writer for bricked volume files
+
+/// Volume data is written one z-slice at a time, e.g. as it is produced by a
+/// simulation. Once a full layer of slices has been received, its bricks are
+/// compressed and written out, so that only brickSize slices are ever held in
+/// memory.
+class BrickArrayWriter{
+public:
+
+	BrickArrayWriter();
+	~BrickArrayWriter();
+
+	/// Open a file for writing
+
+	/// @param[in] path			path of file
+	/// @param[in] components	number of components per cell
+	/// @param[in] ty			component type
+	/// @param[in] dimx			number of cells along x
+	/// @param[in] dimy			number of cells along y
+	/// @param[in] dimz			number of cells along z
+	/// @param[in] brickSize	number of cells along each edge of a brick
+	/// @param[in] codec		brick compression; falls back to BRICK_RAW if unavailable
+	/// \returns whether the file was opened
+	bool open(
+		const std::string& path,
+		int components, AlloTy ty, uint32_t dimx, uint32_t dimy, uint32_t dimz,
+		uint32_t brickSize=32, BrickCodec codec=BRICK_DEFLATE
+	);
+
+	/// Write next z-slice of cells
+
+	/// @param[in] cells	dimx * dimy tightly packed cells, x varying fastest
+	/// \returns whether the slice was written
+	bool writeSlice(const void * cells);
+
+	/// Write an entire 3D array with the same format as the volume
+	bool write(const Array& volume);
+
+	/// Flush remaining slices, write the brick index and close the file
+
+	/// \returns whether all slices were received and the file was completed
+	///
+	bool close();
+
+	/// Returns whether a file is open for writing
+	bool opened() const { return NULL != mFP; }
+
+	/// Returns number of slices written so far
+	uint32_t slices() const { return mSlice; }
+
+private:
+	FILE * mFP;
+	AlloArrayHeader mHeader;
+	uint32_t mBrickSize, mBricks[3], mSlice;
+	BrickCodec mCodec;
+	std::vector<char> mLayer;		// brickSize buffered z-slices
+	std::vector<char> mBrick, mPacked;
+	std::vector<uint64_t> mIndex;	// (offset, size|codec) per brick
+
+	bool flushLayer();
+};
+
+
+
+/// Bricked volume reader with on-demand paging
+
+/// Cell reads and interpolated lookups mirror those of Array. Each access
+/// loads the containing brick from disk if it is not already cached. Cached
+/// bricks are evicted least-recently-used first.
+class BrickArray{
+public:
+
+	/// @param[in] cacheBricks	maximum number of bricks held in memory
+	BrickArray(unsigned cacheBricks=256);
+
+	~BrickArray();
+
+	/// Open a bricked volume file written by BrickArrayWriter
+	bool open(const std::string& path);
+
+	/// Close file and free all cached bricks
+	void close();
+
+	/// Returns whether a file is open
+	bool opened() const { return NULL != mFP; }
+
+	/// Get layout of the whole volume (as if it were a dense Array)
+	const AlloArrayHeader& header() const { return mHeader; }
+
+	AlloTy type() const { return mHeader.type; }					///< Get type of elements
+	uint8_t components() const { return mHeader.components; }		///< Get number of components
+	uint32_t dim(int i=0) const { return mHeader.dim[i]; }			///< Get size of dimension
+	uint32_t brickSize() const { return mBrickSize; }				///< Get size of brick edge
+	uint32_t bricks(int i=0) const { return mBricks[i]; }			///< Get number of bricks along dimension
+
+
+	/// Set maximum number of bricks held in memory
+	void cacheCapacity(unsigned v);
+
+	/// Get maximum number of bricks held in memory
+	unsigned cacheCapacity() const { return mCapacity; }
+
+	/// Get number of bricks currently in memory
+	unsigned cacheSize() const { return mLRU.size(); }
+
+	/// Get number of brick loads from disk since opening
+	unsigned long cacheMisses() const { return mMisses; }
+
+
+	/// Get a brick, loading it if necessary
+
+	/// The returned Array remains valid until the brick is evicted, i.e. until
+	/// cacheCapacity() other bricks have been accessed.
+	/// Returns NULL if the brick could not be read.
+	const Array * brick(uint32_t bx, uint32_t by, uint32_t bz);
+
+	/// Read the component values of a cell into val array (no bounds checking)
+	template<typename T> void read(T* val, int x, int y, int z);
+
+	/// Read the component values of a cell into val array (wraps periodically at bounds)
+	template<typename T> void read_wrap(T* val, int x, int y, int z);
+
+	/// Linear interpolated lookup (virtual array index)
+
+	/// Reads the linearly interpolated component values into val array,
+	/// wrapping periodically at bounds like Array::read_interp.
+	template<typename T> void read_interp(T* val, double x, double y, double z);
+
+	template<typename T, typename TP> void read_interp(T* val, const Vec<3,TP> p){ read_interp(val, p[0], p[1], p[2]); }
+
+private:
+	FILE * mFP;
+	AlloArrayHeader mHeader;
+	uint32_t mBrickSize, mBricks[3];
+	std::vector<uint64_t> mIndex;
+	std::vector<char> mPacked;
+
+	// LRU cache; most recently used brick at front
+	typedef std::list<uint32_t> LRU;
+	LRU mLRU;
+	std::vector<Array *> mCache;			// per brick; NULL if not loaded
+	std::vector<LRU::iterator> mCachePos;	// per brick position in LRU
+	unsigned mCapacity;
+	unsigned long mMisses;
+
+	bool load(uint32_t i, Array& dst);
+	void evict();
+
+	static int wrapIndex(int v, int n){ v %= n; return v<0 ? v+n : v; }
+};
+
+
+
+
+// Implementation ______________________________________________________________
+
+template<typename T>
+inline void BrickArray::read(T* val, int x, int y, int z){
+	const Array * b = brick(x/mBrickSize, y/mBrickSize, z/mBrickSize);
+	if(b){
+		b->read(val, x%mBrickSize, y%mBrickSize, z%mBrickSize);
+	}
+	else{
+		for(int p=0; p<mHeader.components; ++p) val[p] = T(0);
+	}
+}
+
+template<typename T>
+inline void BrickArray::read_wrap(T* val, int x, int y, int z){
+	read(val, wrapIndex(x, dim(0)), wrapIndex(y, dim(1)), wrapIndex(z, dim(2)));
+}
+
+template<typename T>
+void BrickArray::read_interp(T* val, double x, double y, double z){
+	const int nx = dim(0), ny = dim(1), nz = dim(2);
+	const int xa = wrapIndex(int(floor(x)), nx);
+	const int ya = wrapIndex(int(floor(y)), ny);
+	const int za = wrapIndex(int(floor(z)), nz);
+	const int xb = xa+1 == nx ? 0 : xa+1;
+	const int yb = ya+1 == ny ? 0 : ya+1;
+	const int zb = za+1 == nz ? 0 : za+1;
+	const double xbf = x - floor(x), xaf = 1. - xbf;
+	const double ybf = y - floor(y), yaf = 1. - ybf;
+	const double zbf = z - floor(z), zaf = 1. - zbf;
+
+	const int xs[2] = {xa, xb};
+	const int ys[2] = {ya, yb};
+	const int zs[2] = {za, zb};
+	const double xf[2] = {xaf, xbf};
+	const double yf[2] = {yaf, ybf};
+	const double zf[2] = {zaf, zbf};
+
+	const int C = mHeader.components;
+	for(int p=0; p<C; ++p) val[p] = T(0);
+
+	// Common case: all corners lie in one brick
+	const uint32_t bs = mBrickSize;
+	if(xa/bs == xb/bs && ya/bs == yb/bs && za/bs == zb/bs){
+		const Array * b = brick(xa/bs, ya/bs, za/bs);
+		if(!b) return;
+		for(int k=0; k<2; ++k){
+		for(int j=0; j<2; ++j){
+		for(int i=0; i<2; ++i){
+			const double f = xf[i]*yf[j]*zf[k];
+			const T * c = b->cell<T>(xs[i]%bs, ys[j]%bs, zs[k]%bs);
+			for(int p=0; p<C; ++p) val[p] += c[p] * f;
+		}}}
+		return;
+	}
+
+	// Corners straddle bricks
+	T c[256];
+	for(int k=0; k<2; ++k){
+	for(int j=0; j<2; ++j){
+	for(int i=0; i<2; ++i){
+		const double f = xf[i]*yf[j]*zf[k];
+		read(c, xs[i], ys[j], zs[k]);
+		for(int p=0; p<C; ++p) val[p] += c[p] * f;
+	}}}
+}
+
+} // al::
+
+#endif
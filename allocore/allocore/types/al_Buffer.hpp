@@ -117,6 +117,32 @@ public:
 		else setSize(n);
 	}
 
+	/// Ensure capacity is at least the given number of elements
+
+	/// The size of the buffer is not changed.
+	///
+	void reserve(int n){
+		if(capacity() < n) mElems.resize(n);
+	}
+
+	/// Extend size of buffer and return pointer to the new elements
+
+	/// This adds n elements to the end of the buffer to be written directly
+	/// through the returned pointer. The capacity grows geometrically, so
+	/// repeated calls do not resize the buffer each time. The pointer is
+	/// valid until the capacity next changes.
+	/// \returns pointer to first new element or 0 if the buffer is empty
+	T * extend(int n, double growFactor=2){
+		const int oldsize = size();
+		const int newsize = oldsize + n;
+		if(capacity() < newsize){
+			int cap = capacity() * growFactor;
+			mElems.resize(cap < newsize ? newsize : cap);
+		}
+		setSize(newsize);
+		return capacity() ? &mElems[0] + oldsize : 0;
+	}
+
 	/// Appends element to end of buffer growing its size if necessary
 	void append(const T& v, double growFactor=2){
 
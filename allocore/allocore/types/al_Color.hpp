@@ -1040,6 +1040,38 @@ struct HCLuv{
 
 
 
+// Batch color space conversion
+//
+// These convert arrays of n colors and are several times faster than
+// assigning colors one at a time. The transfer functions are evaluated with
+// polynomial approximations, so results can differ from the scalar
+// conversions by up to about 1e-5 relative to the range of each component
+// for inputs in their nominal ranges (e.g., [0,1] for RGB and HSV). Color
+// outputs keep their alpha component. Black converts to Luv (0,0,0) and
+// back, where the scalar conversions divide by zero.
+void convert(const RGB * in, HSV * out, int n);
+void convert(const HSV * in, RGB * out, int n);
+void convert(const HSV * in, Color * out, int n);
+void convert(const RGB * in, CIEXYZ * out, int n);
+void convert(const CIEXYZ * in, RGB * out, int n);
+void convert(const CIEXYZ * in, Lab * out, int n);
+void convert(const Lab * in, CIEXYZ * out, int n);
+void convert(const RGB * in, Lab * out, int n);
+void convert(const Lab * in, RGB * out, int n);
+void convert(const Lab * in, HCLab * out, int n);
+void convert(const HCLab * in, Lab * out, int n);
+void convert(const RGB * in, HCLab * out, int n);
+void convert(const HCLab * in, RGB * out, int n);
+void convert(const CIEXYZ * in, Luv * out, int n);
+void convert(const Luv * in, CIEXYZ * out, int n);
+void convert(const RGB * in, Luv * out, int n);
+void convert(const Luv * in, RGB * out, int n);
+void convert(const Luv * in, HCLuv * out, int n);
+void convert(const HCLuv * in, Luv * out, int n);
+void convert(const RGB * in, HCLuv * out, int n);
+void convert(const HCLuv * in, RGB * out, int n);
+
+
 
 // Implementation --------------------------------------------------------------
 
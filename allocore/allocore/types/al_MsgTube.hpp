@@ -42,6 +42,7 @@
 	Graham Wakefield, 2010, grrrwaaa@gmail.com
 */
 
+#include "allocore/system/al_Printing.hpp"
 #include "allocore/system/al_Time.h"
 #include "allocore/types/al_SingleRWRingBuffer.hpp"
 #include <string.h>
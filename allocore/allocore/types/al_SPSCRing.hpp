@@ -0,0 +1,272 @@
+#ifndef INCLUDE_AL_SPSC_RING_HPP
+#define INCLUDE_AL_SPSC_RING_HPP
+
+/*	Allocore --
+	Multimedia / virtual environment application class library
+
+	Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+	Copyright (C) 2012. The Regents of the University of California.
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice,
+		this list of conditions and the following disclaimer.
+
+		Redistributions in binary form must reproduce the above copyright
+		notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+
+		Neither the name of the University of California nor the names of its
+		contributors may be used to endorse or promote products derived from
+		this software without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+
+
+
+	File description:
+	Lock-free single-producer single-consumer ring of typed elements
+
+	The read and write positions are published with acquire/release ordering
+	and live on separate cache lines. Each side keeps a cached copy of the
+	other side's position and only loads the shared one when the cached copy
+	says the ring is full (or empty), so in steady state neither side touches
+	the other's cache line.
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include "allocore/system/al_Atomic.hpp"
+#include "allocore/system/pstdint.h"
+
+namespace al {
+
+/// Round up to the next power of two
+inline uint32_t next_power_of_two(uint32_t v){
+	--v;
+	v |= v >> 1;
+	v |= v >> 2;
+	v |= v >> 4;
+	v |= v >> 8;
+	v |= v >>16;
+	return v+1;
+}
+
+
+/// Lock-free single-producer single-consumer ring buffer
+
+/// One thread may write (write, push, reserve/commit) and one other thread
+/// may read (read, peek, pop, readRegion/consume) at the same time. All
+/// elements of the ring can be filled.
+///
+/// reserve() and readRegion() give direct access to the largest contiguous
+/// region available, so data can be produced or consumed in place. When a
+/// region would cross the end of the ring, it is cut short there; the rest
+/// is available from the next call.
+///
+/// @ingroup allocore
+template <class T>
+class SPSCRing{
+public:
+
+	/// @param[in] size		number of elements; rounded up to a power of two
+	explicit SPSCRing(size_t size=256);
+
+	~SPSCRing(){ delete[] mData; }
+
+
+	/// Get number of elements the ring holds
+	size_t size() const { return mSize; }
+
+
+	/// Get number of elements available for writing (producer)
+	size_t writeSpace() const;
+
+	/// Copy up to n elements into the ring, returning number copied (producer)
+	size_t write(const T * src, size_t n);
+
+	/// Write one element, returning false if full (producer)
+	bool push(const T& v);
+
+	/// Get contiguous region for writing in place (producer)
+
+	/// @param[in,out] n	requested number of elements, set to the number
+	///						available in the returned region
+	/// \returns start of region
+	T * reserve(size_t& n);
+
+	/// Make n elements written to the reserved region readable (producer)
+	void commit(size_t n){ storeRelease(mWrite, mWrite + n); }
+
+
+	/// Get number of elements available for reading (consumer)
+	size_t readSpace() const;
+
+	/// Copy up to n elements out of the ring, returning number copied (consumer)
+	size_t read(T * dst, size_t n);
+
+	/// Copy up to n elements without removing them (consumer)
+	size_t peek(T * dst, size_t n) const;
+
+	/// Read one element, returning false if empty (consumer)
+	bool pop(T& v);
+
+	/// Get contiguous region for reading in place (consumer)
+
+	/// @param[in,out] n	requested number of elements, set to the number
+	///						available in the returned region
+	/// \returns start of region
+	const T * readRegion(size_t& n);
+
+	/// Remove n elements from the front of the ring (consumer)
+	void consume(size_t n){ storeRelease(mRead, mRead + n); }
+
+private:
+	enum{ CACHE_LINE = 64 };
+
+	// Positions increase freely and are wrapped on access. The padding puts
+	// each group on its own cache line(s).
+	T * mData;
+	size_t mSize, mWrap;
+	char mPad0[CACHE_LINE];
+
+	volatile size_t mWrite;			// written by producer
+	mutable size_t mReadCache;		// producer's copy of mRead
+	char mPad1[CACHE_LINE];
+
+	volatile size_t mRead;			// written by consumer
+	mutable size_t mWriteCache;		// consumer's copy of mWrite
+	char mPad2[CACHE_LINE];
+
+	// Copy n elements between ring and linear memory starting at position i
+	void copyIn(size_t i, const T * src, size_t n);
+	void copyOut(size_t i, T * dst, size_t n) const;
+
+	SPSCRing(const SPSCRing&);
+	SPSCRing& operator=(const SPSCRing&);
+};
+
+
+
+
+// Implementation
+//------------------------------------------------------------------------------
+
+template <class T>
+SPSCRing<T>::SPSCRing(size_t size)
+:	mSize(next_power_of_two(size < 2 ? 2 : size)), mWrap(mSize-1),
+	mWrite(0), mReadCache(0), mRead(0), mWriteCache(0)
+{
+	mData = new T[mSize];
+}
+
+template <class T>
+size_t SPSCRing<T>::writeSpace() const {
+	mReadCache = loadAcquire(mRead);
+	return mSize - (mWrite - mReadCache);
+}
+
+template <class T>
+size_t SPSCRing<T>::readSpace() const {
+	mWriteCache = loadAcquire(mWrite);
+	return mWriteCache - mRead;
+}
+
+template <class T>
+void SPSCRing<T>::copyIn(size_t i, const T * src, size_t n){
+	i &= mWrap;
+	size_t n1 = std::min(n, mSize - i);
+	std::copy(src, src + n1, mData + i);
+	std::copy(src + n1, src + n, mData);
+}
+
+template <class T>
+void SPSCRing<T>::copyOut(size_t i, T * dst, size_t n) const {
+	i &= mWrap;
+	size_t n1 = std::min(n, mSize - i);
+	std::copy(mData + i, mData + i + n1, dst);
+	std::copy(mData, mData + (n - n1), dst + n1);
+}
+
+template <class T>
+size_t SPSCRing<T>::write(const T * src, size_t n){
+	n = std::min(n, writeSpace());
+	if(n){
+		copyIn(mWrite, src, n);
+		commit(n);
+	}
+	return n;
+}
+
+template <class T>
+bool SPSCRing<T>::push(const T& v){
+	const size_t w = mWrite;
+	if(w - mReadCache == mSize && w - (mReadCache = loadAcquire(mRead)) == mSize){
+		return false;
+	}
+	mData[w & mWrap] = v;
+	storeRelease(mWrite, w + 1);
+	return true;
+}
+
+template <class T>
+T * SPSCRing<T>::reserve(size_t& n){
+	const size_t w = mWrite;
+	if(mSize - (w - mReadCache) < n) mReadCache = loadAcquire(mRead);
+	const size_t i = w & mWrap;
+	n = std::min(n, std::min(mSize - (w - mReadCache), mSize - i));
+	return mData + i;
+}
+
+template <class T>
+size_t SPSCRing<T>::read(T * dst, size_t n){
+	n = std::min(n, readSpace());
+	if(n){
+		copyOut(mRead, dst, n);
+		consume(n);
+	}
+	return n;
+}
+
+template <class T>
+size_t SPSCRing<T>::peek(T * dst, size_t n) const {
+	n = std::min(n, readSpace());
+	if(n) copyOut(mRead, dst, n);
+	return n;
+}
+
+template <class T>
+bool SPSCRing<T>::pop(T& v){
+	const size_t r = mRead;
+	if(mWriteCache == r && (mWriteCache = loadAcquire(mWrite)) == r){
+		return false;
+	}
+	v = mData[r & mWrap];
+	storeRelease(mRead, r + 1);
+	return true;
+}
+
+template <class T>
+const T * SPSCRing<T>::readRegion(size_t& n){
+	const size_t r = mRead;
+	if(mWriteCache - r < n) mWriteCache = loadAcquire(mWrite);
+	const size_t i = r & mWrap;
+	n = std::min(n, std::min(mWriteCache - r, mSize - i));
+	return mData + i;
+}
+
+} // al::
+
+#endif
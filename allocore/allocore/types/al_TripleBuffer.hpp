@@ -0,0 +1,121 @@
+#ifndef INCLUDE_AL_TRIPLE_BUFFER_HPP
+#define INCLUDE_AL_TRIPLE_BUFFER_HPP
+
+/*	Allocore --
+	Multimedia / virtual environment application class library
+
+	Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+	Copyright (C) 2012. The Regents of the University of California.
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice,
+		this list of conditions and the following disclaimer.
+
+		Redistributions in binary form must reproduce the above copyright
+		notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+
+		Neither the name of the University of California nor the names of its
+		contributors may be used to endorse or promote products derived from
+		this software without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+
+
+
+	File description:
+	Lock-free exchange of the newest value from one thread to another
+
+	The writer fills a back buffer and publishes it; the reader picks up the
+	most recently published buffer. Neither side ever waits for the other
+	and the reader never sees a partially written value. Intermediate values
+	are dropped if the writer is faster than the reader, which is what is
+	wanted for state such as a simulation frame sent to a renderer.
+*/
+
+#include "allocore/system/al_Atomic.hpp"
+
+namespace al{
+
+/// Triple buffer for one writer thread and one reader thread
+
+/// The writer calls back() and publish() (or write()), the reader calls
+/// update() and front() (or read()).
+///
+/// @ingroup allocore
+template <class T>
+class TripleBuffer{
+public:
+
+	TripleBuffer(): mFront(0), mMiddle(1), mBack(2){}
+
+	/// @param[in] init		initial value of all buffers
+	TripleBuffer(const T& init): mFront(0), mMiddle(1), mBack(2){
+		for(int i=0; i<3; ++i) mBufs[i] = init;
+	}
+
+
+	/// Get buffer to write next value into (writer only)
+	T& back(){ return mBufs[mBack]; }
+
+	/// Make the back buffer the newest value (writer only)
+	void publish(){
+		mBack = exchange(mMiddle, mBack | NEW) & INDEX;
+	}
+
+	/// Copy a value into the back buffer and publish it (writer only)
+	void write(const T& v){
+		back() = v;
+		publish();
+	}
+
+
+	/// Get newest published value, if any, into the front buffer (reader only)
+
+	/// \returns whether a new value was published since the last update
+	bool update(){
+		if(!(loadRelaxed(mMiddle) & NEW)) return false;
+		mFront = exchange(mMiddle, mFront) & INDEX;
+		return true;
+	}
+
+	/// Get front buffer (reader only)
+	const T& front() const { return mBufs[mFront]; }
+	T& front(){ return mBufs[mFront]; }
+
+	/// Update and copy the front buffer (reader only)
+
+	/// \returns whether the value is new
+	bool read(T& v){
+		bool isNew = update();
+		v = front();
+		return isNew;
+	}
+
+private:
+	enum{ INDEX = 3, NEW = 4, CacheLine = 64 };
+
+	T mBufs[3];
+	long mFront;					// reader only
+	char mPad1[CacheLine];
+	volatile long mMiddle;			// index of shared buffer and NEW flag
+	char mPad2[CacheLine];
+	long mBack;						// writer only
+};
+
+} // al::
+
+#endif
@@ -81,6 +81,11 @@ typedef float UnitsTy;
 #define METERS 0
 #define KILOMETERS 3
 
+/// Byte alignment of voxel data in files written by Voxels::writeToFile
+#define AL_VOXELS_DATA_ALIGNMENT 4096
+
+class File;
+
 /// OBJECT-oriented interface to AlloArray
 class Voxels : public Array {
 public:
@@ -165,10 +170,22 @@ public:
     }
   }
   
+  /// Write voxels to a file
+
+  /// Voxel data is stored at an offset aligned to AL_VOXELS_DATA_ALIGNMENT
+  /// so that it can be efficiently memory mapped with mapFromFile().
   bool writeToFile(std::string filename);
-  
+
+  /// Load voxels from a file, copying the data into memory
   bool loadFromFile(std::string filename);
 
+  /// Map voxels from a file without copying the data
+
+  /// Opening is near-instant regardless of file size since voxel data is
+  /// paged in lazily on access. Use advise() to hint at the access pattern.
+  /// \returns whether the file was successfully mapped
+  bool mapFromFile(std::string filename, MapMode mode = MAPPED_READ);
+
   ~Voxels() {
   }
 
@@ -177,6 +194,9 @@ protected:
   UnitsTy m_units;
   float m_sizex, m_sizey, m_sizez;
 
+  // Read file header and voxel size info; returns byte offset of data or 0
+  size_t readHeader(File& file, AlloArrayHeader& h);
+
 };
 
 } // ::al::
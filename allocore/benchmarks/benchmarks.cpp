@@ -0,0 +1,172 @@
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <new>
+#include "bnAllocore.h"
+
+// Count heap allocations made through operator new. This does not see
+// malloc/calloc calls made directly (e.g. by Array) and is not thread-safe, so
+// counts from benchmarks that allocate on several threads are approximate.
+static unsigned long long gAllocs = 0;
+static unsigned long long gAllocBytes = 0;
+
+#if __cplusplus >= 201103L
+	#define BN_THROW_BAD_ALLOC
+	#define BN_NOTHROW noexcept
+#else
+	#define BN_THROW_BAD_ALLOC throw(std::bad_alloc)
+	#define BN_NOTHROW throw()
+#endif
+
+void * operator new(size_t size) BN_THROW_BAD_ALLOC {
+	++gAllocs;
+	gAllocBytes += size;
+	void * p = malloc(size ? size : 1);
+	if(!p) throw std::bad_alloc();
+	return p;
+}
+void * operator new[](size_t size) BN_THROW_BAD_ALLOC {
+	return operator new(size);
+}
+void operator delete(void * p) BN_NOTHROW { free(p); }
+void operator delete[](void * p) BN_NOTHROW { free(p); }
+
+volatile char bnSink;
+
+unsigned long long Bench::allocations(){ return gAllocs; }
+unsigned long long Bench::allocatedBytes(){ return gAllocBytes; }
+
+
+Bench::Bench()
+:	mOut("allocore_bench.json"), mMinTime(0.1), mSamples(5)
+{}
+
+// Returns the value of a '--name=value' argument or NULL if it does not match
+static const char * option(const char * arg, const char * name){
+	size_t n = strlen(name);
+	return strncmp(arg, name, n)==0 ? arg+n : NULL;
+}
+
+bool Bench::parse(int argc, char ** argv){
+	for(int i=1; i<argc; ++i){
+		const char * v;
+		if((v = option(argv[i], "--filter=")))			mFilter = v;
+		else if((v = option(argv[i], "--min-time=")))	mMinTime = atof(v);
+		else if((v = option(argv[i], "--samples=")))	mSamples = std::max(1, atoi(v));
+		else if((v = option(argv[i], "--out=")))		mOut = v;
+		else{
+			fprintf(stderr,
+				"usage: %s [--filter=<str>] [--min-time=<sec>] [--samples=<n>] [--out=<path>|-]\n",
+				argv[0]);
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Bench::enabled(const char * name) const {
+	return mFilter.empty() || strstr(name, mFilter.c_str()) != NULL;
+}
+
+void Bench::run(const char * name, BenchFunc& func, double itemsPerOp, double bytesPerOp){
+	if(!enabled(name)) return;
+
+	Timer timer;
+	func(1); // warm up caches and any lazily allocated state
+
+	// Grow the iteration count until a sample lasts at least the minimum time
+	unsigned n = 1;
+	for(;;){
+		timer.start();
+		func(n);
+		timer.stop();
+		double t = timer.elapsedSec();
+		if(t >= mMinTime || n >= (1u<<30)) break;
+		double grow = t > 0 ? 1.2 * mMinTime / t : 100;
+		n = unsigned(n * std::min(std::max(grow, 2.), 100.));
+	}
+
+	std::vector<double> ns(mSamples);
+	unsigned long long allocs0 = gAllocs, bytes0 = gAllocBytes;
+	for(unsigned i=0; i<mSamples; ++i){
+		timer.start();
+		func(n);
+		timer.stop();
+		ns[i] = double(timer.elapsed()) / n;
+	}
+	double ops = double(n) * mSamples;
+	std::sort(ns.begin(), ns.end());
+
+	Result r;
+	r.name = name;
+	r.iterations = n;
+	r.nsPerOp = ns[mSamples/2];
+	r.nsPerOpMin = ns[0];
+	r.itemsPerOp = itemsPerOp;
+	r.bytesPerOp = bytesPerOp;
+	r.allocsPerOp = (gAllocs - allocs0) / ops;
+	r.allocBytesPerOp = (gAllocBytes - bytes0) / ops;
+	mResults.push_back(r);
+
+	fprintf(stderr, "%-40s %12.1f ns/op %10.3f allocs/op\n", name, r.nsPerOp, r.allocsPerOp);
+}
+
+void Bench::report(FILE * fp) const {
+	fprintf(fp, "{\n\t\"suite\": \"allocore_bench\",\n");
+	fprintf(fp, "\t\"min_time_sec\": %g,\n\t\"samples\": %u,\n", mMinTime, mSamples);
+	fprintf(fp, "\t\"results\": [");
+	for(unsigned i=0; i<mResults.size(); ++i){
+		const Result& r = mResults[i];
+		double sec = r.nsPerOp * 1e-9;
+		fprintf(fp, "%s\n\t\t{\"name\": \"%s\", \"iterations\": %u, "
+			"\"ns_per_op\": %.3f, \"ns_per_op_min\": %.3f, \"ops_per_sec\": %.6g, "
+			"\"items_per_sec\": %.6g, \"bytes_per_sec\": %.6g, "
+			"\"allocs_per_op\": %.6g, \"alloc_bytes_per_op\": %.6g}",
+			i ? "," : "", r.name.c_str(), r.iterations,
+			r.nsPerOp, r.nsPerOpMin, sec > 0 ? 1./sec : 0,
+			sec > 0 ? r.itemsPerOp/sec : 0, sec > 0 ? r.bytesPerOp/sec : 0,
+			r.allocsPerOp, r.allocBytesPerOp
+		);
+	}
+	fprintf(fp, "\n\t]\n}\n");
+}
+
+bool Bench::report() const {
+	if(mOut == "-"){
+		report(stdout);
+		return true;
+	}
+	FILE * fp = fopen(mOut.c_str(), "w");
+	if(!fp){
+		fprintf(stderr, "could not open %s for writing\n", mOut.c_str());
+		return false;
+	}
+	report(fp);
+	fclose(fp);
+	fprintf(stderr, "wrote %s\n", mOut.c_str());
+	return true;
+}
+
+
+int main(int argc, char ** argv){
+	Bench b;
+	if(!b.parse(argc, argv)) return 1;
+
+	// Which groups are available depends on the modules allocore was built
+	// with; see CMakeLists.txt in this directory.
+	#ifdef AL_BENCH_AUDIO
+	bnAudioScene(b);
+	#endif
+	#ifdef AL_BENCH_FIELD3D
+	bnField3D(b);
+	#endif
+	#ifdef AL_BENCH_GRAPHICS
+	bnGraphics(b);
+	#endif
+	bnOSC(b);
+	bnSerialize(b);
+	bnSpatial(b);
+	bnTypes(b);
+
+	return b.report() ? 0 : 1;
+}
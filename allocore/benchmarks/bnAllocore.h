@@ -0,0 +1,103 @@
+#ifndef INCLUDE_BN_ALLOCORE_H
+#define INCLUDE_BN_ALLOCORE_H
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "allocore/system/al_Time.hpp"
+
+using namespace al;
+
+
+/// Body of a benchmark
+
+/// The call operator must perform the measured operation 'iterations' times.
+/// Setup that should not be timed belongs in the constructor.
+struct BenchFunc{
+	virtual ~BenchFunc(){}
+	virtual void operator()(unsigned iterations) = 0;
+};
+
+
+/// Runs benchmarks and collects their results
+
+/// Each benchmark is first calibrated so that one sample takes at least the
+/// minimum sample time, then timed over a number of samples. The median
+/// sample is reported along with the number of heap allocations (operator
+/// new) made per operation.
+class Bench{
+public:
+
+	struct Result{
+		std::string name;
+		unsigned iterations;			// iterations per sample
+		double nsPerOp;					// median over samples
+		double nsPerOpMin;				// fastest sample
+		double itemsPerOp;
+		double bytesPerOp;
+		double allocsPerOp;
+		double allocBytesPerOp;
+	};
+
+	Bench();
+
+	/// Parse command line options; returns false if the program should exit
+
+	/// --filter=<str>		only run benchmarks whose name contains str
+	/// --min-time=<sec>	minimum duration of one sample
+	/// --samples=<n>		number of timed samples
+	/// --out=<path>		output path for JSON results ('-' is stdout)
+	bool parse(int argc, char ** argv);
+
+	/// Measure a benchmark
+
+	/// @param[in] name			unique name, e.g. "AudioScene.render.DBAP"
+	/// @param[in] func			benchmark body
+	/// @param[in] itemsPerOp	items processed per operation (frames, points, ...)
+	/// @param[in] bytesPerOp	bytes processed per operation
+	void run(const char * name, BenchFunc& func, double itemsPerOp=1, double bytesPerOp=0);
+
+	/// Whether a benchmark of the given name will be run
+	bool enabled(const char * name) const;
+
+	const std::vector<Result>& results() const { return mResults; }
+
+	/// Write results as JSON to the configured output; returns false on error
+	bool report() const;
+
+	/// Write results as JSON to a file stream
+	void report(FILE * fp) const;
+
+	/// Number of operator new calls made so far by the process
+	static unsigned long long allocations();
+
+	/// Number of bytes requested from operator new so far by the process
+	static unsigned long long allocatedBytes();
+
+private:
+	std::vector<Result> mResults;
+	std::string mFilter, mOut;
+	double mMinTime;
+	unsigned mSamples;
+};
+
+
+// Receives values passed to bnUse; defined in benchmarks.cpp
+extern volatile char bnSink;
+
+// Prevent the compiler from discarding a computed value
+template <class T>
+inline void bnUse(const T& v){
+	bnSink = *(const volatile char *)&v;
+}
+
+void bnAudioScene(Bench& b);
+void bnField3D(Bench& b);
+void bnGraphics(Bench& b);
+void bnOSC(Bench& b);
+void bnSerialize(Bench& b);
+void bnSpatial(Bench& b);
+void bnTypes(Bench& b);
+
+#endif
@@ -0,0 +1,193 @@
+#include <math.h>
+#include <vector>
+#include "allocore/io/al_AudioIO.hpp"
+#include "allocore/sound/al_Ambisonics.hpp"
+#include "allocore/sound/al_AudioScene.hpp"
+#include "allocore/sound/al_Binaural.hpp"
+#include "allocore/sound/al_Convolver.hpp"
+#include "allocore/sound/al_Dbap.hpp"
+#include "allocore/sound/al_Vbap.hpp"
+#include "bnAllocore.h"
+
+namespace{
+
+const int BLOCK = 256;
+const int NSRC = 32;
+
+// Dome of 17 speakers: rings of 8 at 0 degrees, 4 at +/-45 degrees and one
+// overhead. VBAP needs full 3D coverage to find triplets for every source.
+struct DomeSpeakerLayout : SpeakerLayout{
+	DomeSpeakerLayout(){
+		int c = 0;
+		for(int i=0; i<8; ++i) addSpeaker(Speaker(c++, i*45.f, 0));
+		for(int i=0; i<4; ++i) addSpeaker(Speaker(c++, i*90.f + 45.f, 45));
+		for(int i=0; i<4; ++i) addSpeaker(Speaker(c++, i*90.f, -45));
+		addSpeaker(Speaker(c++, 0, 90));
+	}
+};
+
+struct Render : BenchFunc{
+	AudioIO io;
+	AudioScene scene;
+	Spatializer * spatializer;
+	std::vector<SoundSource *> sources;
+	unsigned long frame;
+
+	Render(Spatializer * s, int numSpeakers)
+	:	io(BLOCK, 44100, 0, 0, numSpeakers, 0, AudioIO::OFFLINE), scene(BLOCK), spatializer(s), frame(0)
+	{
+		scene.createListener(spatializer);
+		for(int i=0; i<NSRC; ++i){
+			sources.push_back(new SoundSource);
+			scene.addSource(*sources.back());
+		}
+	}
+
+	~Render(){
+		for(unsigned i=0; i<sources.size(); ++i) delete sources[i];
+		delete spatializer;
+	}
+
+	void operator()(unsigned iterations){
+		for(unsigned k=0; k<iterations; ++k){
+			// Sources orbit the listener at different heights and speeds
+			for(int j=0; j<NSRC; ++j){
+				SoundSource& src = *sources[j];
+				double ang = frame * 1e-5 * (j+1);
+				src.pos(4*cos(ang), 4*sin(ang), (j%5) - 2);
+				for(int i=0; i<BLOCK; ++i) src.writeSample(sin((frame+i) * 0.01 * (j+1)));
+			}
+			io.zeroOut();
+			scene.render(io);
+			frame += BLOCK;
+		}
+		bnUse(io.out(0, 0));
+	}
+};
+
+// Decode of a 7th order 3D stream (64 channels) to 60 speakers
+struct Decode : BenchFunc{
+	Speakers speakers;
+	AmbiDecode dec;
+	std::vector<float> ambi, out;
+
+	Decode(bool dual)
+	:	dec(3, 7, 60, 1, AmbiBase::ACN_SN3D)
+	{
+		dec.setSpeakers(&speakers);
+		for(int s=0; s<60; ++s){
+			speakers.push_back(Speaker(s, s*37.f, (s%6)*30.f - 75.f));
+			dec.setSpeaker(s, s, speakers[s].azimuth, speakers[s].elevation);
+		}
+		if(dual) dec.dualBand(400, 44100);
+		ambi.resize(dec.channels()*BLOCK);
+		for(unsigned i=0; i<ambi.size(); ++i) ambi[i] = sin(i*0.01);
+		out.resize(60*BLOCK);
+	}
+
+	void operator()(unsigned iterations){
+		for(unsigned k=0; k<iterations; ++k){
+			dec.decode(&out[0], &ambi[0], BLOCK);
+		}
+		bnUse(out[0]);
+	}
+};
+
+// Synthetic exponentially decaying noise, standing in for measured IRs
+void decayingNoise(std::vector<float>& ir, int len, double decay, unsigned seed){
+	ir.resize(len);
+	for(int i=0; i<len; ++i){
+		seed = seed * 1664525u + 1013904223u;
+		ir[i] = (int(seed >> 9) / double(1<<22) - 1.) * exp(-i * decay);
+	}
+}
+
+// Stereo reverb with a 2 second IR per channel
+struct ConvReverb : BenchFunc{
+	Convolver conv;
+	std::vector<float> irs[2], in, out;
+
+	ConvReverb(int tailBlockSize){
+		const int len = 88200;
+		decayingNoise(irs[0], len, 1e-4, 1);
+		decayingNoise(irs[1], len, 1e-4, 2);
+		const float * p[4] = { &irs[0][0], NULL, NULL, &irs[1][0] };
+		// The tail is computed inline so the measured time includes it
+		conv.setup(BLOCK, 2, 2, p, len, tailBlockSize, false);
+		in.resize(2*BLOCK);
+		for(unsigned i=0; i<in.size(); ++i) in[i] = sin(i*0.05);
+		out.resize(2*BLOCK);
+	}
+
+	void operator()(unsigned iterations){
+		for(unsigned k=0; k<iterations; ++k){
+			conv.process(&out[0], &in[0], BLOCK);
+		}
+		bnUse(out[0]);
+	}
+};
+
+struct BinauralRender : Render{
+	static std::vector<const float *> hrirs(const SpeakerLayout& l, std::vector<float> * data){
+		std::vector<const float *> p;
+		for(int i=0; i<2*l.numSpeakers(); ++i){
+			decayingNoise(data[i], 256, 0.02, i+1);
+			p.push_back(&data[i][0]);
+		}
+		return p;
+	}
+
+	BinauralRender(const SpeakerLayout& l, std::vector<float> * data)
+	:	Render(new BinauralSpatializer(l, &hrirs(l, data)[0], 256, 2), 2)
+	{}
+};
+
+} // ::
+
+void bnAudioScene(Bench& b){
+	DomeSpeakerLayout layout;
+	int ns = layout.numSpeakers();
+
+	if(b.enabled("AudioScene.render.DBAP")){
+		Render f(new Dbap(layout), ns);
+		b.run("AudioScene.render.DBAP", f, BLOCK);
+	}
+	if(b.enabled("AudioScene.render.DBAP.perSample")){
+		Render f(new Dbap(layout), ns);
+		f.scene.usePerSampleProcessing(true);
+		b.run("AudioScene.render.DBAP.perSample", f, BLOCK);
+	}
+	if(b.enabled("AudioScene.render.VBAP")){
+		Render f(new Vbap(layout), ns);
+		b.run("AudioScene.render.VBAP", f, BLOCK);
+	}
+	if(b.enabled("AudioScene.render.Ambisonics3")){
+		Render f(new AmbisonicsSpatializer(layout, 3, 3), ns);
+		b.run("AudioScene.render.Ambisonics3", f, BLOCK);
+	}
+	if(b.enabled("AudioScene.render.Ambisonics7")){
+		Render f(new AmbisonicsSpatializer(layout, 3, 7, 1, AmbiBase::ACN_SN3D), ns);
+		b.run("AudioScene.render.Ambisonics7", f, BLOCK);
+	}
+	if(b.enabled("AudioScene.render.Binaural")){
+		std::vector<float> data[2*17];
+		BinauralRender f(layout, data);
+		b.run("AudioScene.render.Binaural", f, BLOCK);
+	}
+	if(b.enabled("Ambisonics.decode.o7s60")){
+		Decode f(false);
+		b.run("Ambisonics.decode.o7s60", f, BLOCK);
+	}
+	if(b.enabled("Ambisonics.decode.o7s60.dualband")){
+		Decode f(true);
+		b.run("Ambisonics.decode.o7s60.dualband", f, BLOCK);
+	}
+	if(b.enabled("Convolver.reverb2s.uniform")){
+		ConvReverb f(0);
+		b.run("Convolver.reverb2s.uniform", f, BLOCK);
+	}
+	if(b.enabled("Convolver.reverb2s.tail4096")){
+		ConvReverb f(4096);
+		b.run("Convolver.reverb2s.tail4096", f, BLOCK);
+	}
+}
@@ -0,0 +1,24 @@
+#include "alloutil/al_Field3D.hpp"
+#include "bnAllocore.h"
+
+namespace{
+
+struct Diffuse : BenchFunc{
+	Field3D<float> field;
+	unsigned passes;
+	Diffuse(int dim, unsigned passes_): field(3, dim,dim,dim), passes(passes_){
+		rnd::Random<> rng;
+		field.adduniformS(rng, 1.f);
+	}
+	void operator()(unsigned iterations){
+		for(unsigned k=0; k<iterations; ++k) field.diffuse(0.01f, passes);
+	}
+};
+
+} // ::
+
+void bnField3D(Bench& b){
+	Diffuse f(32, 14);
+	unsigned cells = f.field.dimx() * f.field.dimy() * f.field.dimz();
+	b.run("Field3D.diffuse.32.p14", f, cells, cells * f.field.components() * sizeof(float));
+}
@@ -0,0 +1,266 @@
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "allocore/graphics/al_GlyphAtlas.hpp"
+#include "allocore/graphics/al_Isosurface.hpp"
+#include "allocore/graphics/al_Mesh.hpp"
+#include "allocore/graphics/al_PolylineMesh.hpp"
+#include "allocore/system/al_ThreadPool.hpp"
+#include "bnAllocore.h"
+
+namespace{
+
+const int N = 32;
+
+// Sum of two metaballs sampled on an N^3 grid
+void fillField(std::vector<float>& field){
+	field.resize(N*N*N);
+	for(int k=0; k<N; ++k){
+	for(int j=0; j<N; ++j){
+	for(int i=0; i<N; ++i){
+		float x = float(i)/N - 0.5f, y = float(j)/N - 0.5f, z = float(k)/N - 0.5f;
+		float dx1 = x - 0.1f, dx2 = x + 0.1f;
+		field[i + N*(j + N*k)] =
+			0.01f / (dx1*dx1 + y*y + z*z + 1e-3f) +
+			0.01f / (dx2*dx2 + y*y + z*z + 1e-3f);
+	}}}
+}
+
+struct Generate : BenchFunc{
+	std::vector<float> field;
+	Isosurface iso;
+	Generate(){
+		fillField(field);
+		iso.level(0.25);
+		iso.fieldDims(N);
+		iso.cellLengths(1./N);
+	}
+	void operator()(unsigned iterations){
+		for(unsigned k=0; k<iterations; ++k) iso.generate(&field[0]);
+		bnUse(iso.vertices().size());
+	}
+};
+
+// Compress a triangle soup with shared vertices back into an indexed mesh
+struct Compress : BenchFunc{
+	std::vector<Mesh::Vertex> soup;
+	Mesh mesh;
+	Compress(){
+		Generate g;
+		g(1);
+		g.iso.decompress();
+		for(int i=0; i<g.iso.vertices().size(); ++i) soup.push_back(g.iso.vertices()[i]);
+	}
+	void operator()(unsigned iterations){
+		for(unsigned k=0; k<iterations; ++k){
+			mesh.reset();
+			mesh.vertex(&soup[0], soup.size());
+			mesh.compress();
+		}
+		bnUse(mesh.indices().size());
+	}
+};
+
+// Ribbons for a set of wavy streamlines, either one line at a time with
+// Mesh::ribbonize merged into one mesh or all at once with PolylineMesher
+struct Ribbons : BenchFunc{
+	enum Method{ PER_LINE, BATCH, POOL, TUBES };
+	enum{ L = 1000, P = 200 };
+	Polylines lines;
+	PolylineMesher mesher;
+	Mesh mesh, line;
+	ThreadPool pool;
+	Method method;
+
+	Ribbons(Method m): method(m){
+		std::vector<Vec3f> pts(P);
+		for(int l=0; l<L; ++l){
+			for(int i=0; i<P; ++i){
+				float t = i*0.05f;
+				pts[i].set(t, sin(t + l*0.1f) + l*0.01f, cos(t*0.7f + l*0.3f));
+			}
+			lines.add(&pts[0], P);
+		}
+		mesher.width(0.02).sides(8);
+		if(POOL == method) pool.start();
+	}
+
+	void operator()(unsigned iterations){
+		for(unsigned k=0; k<iterations; ++k){
+			switch(method){
+			case PER_LINE:
+				mesh.reset();
+				for(int l=0; l<L; ++l){
+					line.reset();
+					line.vertex(&lines.points[lines.starts[l]], P);
+					line.ribbonize(0.02);
+					mesh.merge(line);
+				}
+				break;
+			case BATCH: mesher.ribbons(mesh, lines); break;
+			case POOL: mesher.ribbons(mesh, lines, pool); break;
+			case TUBES: mesher.tubes(mesh, lines); break;
+			}
+		}
+		bnUse(mesh.vertices().size());
+	}
+};
+
+// Labels for a data set, 5000 labels showing 500 distinct strings. Labels
+// are either laid out and appended quad by quad, as Font::write does, or
+// taken from a TextCache and written in one pass. The cache is either looked
+// up for every label or its layouts are kept with the labels.
+struct Labels : BenchFunc{
+	enum Method{ APPEND, LOOKUP, CACHED };
+	enum{ N = 5000 };
+	GlyphAtlas atlas;
+	TextCache cache;
+	std::vector<std::string> texts;
+	std::vector<Vec3f> positions;
+	std::vector<TextLabel> labels;
+	Mesh mesh;
+	Method method;
+
+	Labels(Method m): atlas(256, 256), cache(atlas), method(m){
+		unsigned char bitmap[12*12] = {0};
+		atlas.addFace(12);
+		for(int c=32; c<127; ++c) atlas.add(0, c, bitmap, 8, 12, 12, 1, 10, 9);
+		char buf[32];
+		for(int i=0; i<N; ++i){
+			snprintf(buf, sizeof(buf), "node %d: %.2f", i%500, (i%500)*0.37);
+			texts.push_back(buf);
+			positions.push_back(Vec3f(i%70 * 40, i/70 * 14, 0));
+			labels.push_back(TextLabel(positions[i], cache.layout(texts[i], 0)));
+		}
+	}
+
+	void operator()(unsigned iterations){
+		for(unsigned k=0; k<iterations; ++k){
+			switch(method){
+			case APPEND:
+				mesh.reset();
+				for(int i=0; i<N; ++i){
+					float x = positions[i][0];
+					const float y = positions[i][1];
+					for(unsigned j=0; j<texts[i].size(); ++j){
+						const Glyph * g = atlas.glyph(0, texts[i][j]);
+						if(!g) continue;
+						const GlyphQuad& q = g->quad;
+						mesh.texCoord(q.s0, q.t0); mesh.vertex(x+q.x0, y+q.y0);
+						mesh.texCoord(q.s1, q.t0); mesh.vertex(x+q.x1, y+q.y0);
+						mesh.texCoord(q.s1, q.t1); mesh.vertex(x+q.x1, y+q.y1);
+						mesh.texCoord(q.s0, q.t1); mesh.vertex(x+q.x0, y+q.y1);
+						x += g->advance;
+					}
+				}
+				break;
+			case LOOKUP:
+				for(int i=0; i<N; ++i) labels[i].layout = cache.layout(texts[i], 0);
+				cache.write(mesh, labels);
+				break;
+			case CACHED: cache.write(mesh, labels); break;
+			}
+		}
+		bnUse(mesh.vertices().size());
+	}
+};
+
+// A height field of 256x256 vertices with normals, colors and triangle
+// indices, rebuilt every frame either by appending one element at a time or
+// by writing reserved spans, in separate buffers or interleaved
+struct Grid : BenchFunc{
+	enum Method{ APPEND, SPAN, INTERLEAVED };
+	enum{ N = 256 };
+	std::vector<float> heights;
+	Mesh mesh;
+	InterleavedMesh imesh;
+	Method method;
+
+	Grid(Method m): heights(N*N), method(m){
+		for(int j=0; j<N; ++j){
+		for(int i=0; i<N; ++i){
+			heights[j*N+i] = sin(i*0.1f) * cos(j*0.07f);
+		}}
+		const int attribs = Mesh::NORMAL | Mesh::COLORI;
+		mesh.reserve(N*N, 6*(N-1)*(N-1), attribs);
+		imesh.attributes(attribs).reserve(N*N, 6*(N-1)*(N-1));
+	}
+
+	static Mesh::Index * quads(Mesh::Index * t){
+		for(int j=0; j<N-1; ++j){
+		for(int i=0; i<N-1; ++i){
+			const Mesh::Index a = j*N+i;
+			t[0] = a; t[1] = a+1; t[2] = a+N+1;
+			t[3] = a; t[4] = a+N+1; t[5] = a+N;
+			t += 6;
+		}}
+		return t;
+	}
+
+	void operator()(unsigned iterations){
+		for(unsigned k=0; k<iterations; ++k){
+			switch(method){
+			case APPEND:
+				mesh.reset();
+				for(int j=0; j<N; ++j){
+				for(int i=0; i<N; ++i){
+					const float h = heights[j*N+i];
+					mesh.vertex(i, h, j);
+					mesh.normal(0, 1, 0);
+					mesh.color(Colori(h*127 + 128));
+				}}
+				for(int j=0; j<N-1; ++j){
+				for(int i=0; i<N-1; ++i){
+					const Mesh::Index a = j*N+i;
+					mesh.index(a); mesh.index(a+1); mesh.index(a+N+1);
+					mesh.index(a); mesh.index(a+N+1); mesh.index(a+N);
+				}}
+				break;
+			case SPAN:{
+				mesh.reset();
+				Mesh::Span s = mesh.addVertices(N*N, Mesh::NORMAL | Mesh::COLORI);
+				for(int j=0; j<N; ++j){
+				for(int i=0; i<N; ++i){
+					const int v = j*N+i;
+					const float h = heights[v];
+					s.vertices[v].set(i, h, j);
+					s.normals[v].set(0, 1, 0);
+					s.coloris[v] = Colori(h*127 + 128);
+				}}
+				quads(mesh.addIndices(6*(N-1)*(N-1)));
+				}break;
+			case INTERLEAVED:{
+				imesh.reset();
+				InterleavedVertex * vs = imesh.addVertices(N*N);
+				for(int j=0; j<N; ++j){
+				for(int i=0; i<N; ++i){
+					const int v = j*N+i;
+					const float h = heights[v];
+					vs[v].position.set(i, h, j);
+					vs[v].normal.set(0, 1, 0);
+					vs[v].color = Colori(h*127 + 128);
+				}}
+				quads(imesh.addIndices(6*(N-1)*(N-1)));
+				}break;
+			}
+		}
+		bnUse(mesh.indices().size() + imesh.indices().size());
+	}
+};
+
+} // ::
+
+void bnGraphics(Bench& b){
+	{ Generate f; b.run("Isosurface.generate.32", f, (N-1)*(N-1)*(N-1)); }
+	{ Compress f; b.run("Mesh.compress", f, f.soup.size()); }
+	{ Ribbons f(Ribbons::PER_LINE); b.run("PolylineMesher.ribbons1000x200.perLine", f, Ribbons::L*Ribbons::P); }
+	{ Ribbons f(Ribbons::BATCH); b.run("PolylineMesher.ribbons1000x200.batch", f, Ribbons::L*Ribbons::P); }
+	{ Ribbons f(Ribbons::POOL); b.run("PolylineMesher.ribbons1000x200.pool", f, Ribbons::L*Ribbons::P); }
+	{ Ribbons f(Ribbons::TUBES); b.run("PolylineMesher.tubes1000x200.batch", f, Ribbons::L*Ribbons::P); }
+	{ Labels f(Labels::APPEND); b.run("TextCache.labels5000.append", f, Labels::N); }
+	{ Labels f(Labels::LOOKUP); b.run("TextCache.labels5000.lookup", f, Labels::N); }
+	{ Labels f(Labels::CACHED); b.run("TextCache.labels5000.cached", f, Labels::N); }
+	{ Grid f(Grid::APPEND); b.run("Mesh.grid256.append", f, Grid::N*Grid::N); }
+	{ Grid f(Grid::SPAN); b.run("Mesh.grid256.span", f, Grid::N*Grid::N); }
+	{ Grid f(Grid::INTERLEAVED); b.run("Mesh.grid256.interleaved", f, Grid::N*Grid::N); }
+}
@@ -0,0 +1,76 @@
+#include "allocore/protocol/al_OSC.hpp"
+#include "bnAllocore.h"
+
+namespace{
+
+const int NMSG = 8;	// messages per bundle
+
+void buildBundle(osc::Packet& p, int tag){
+	p.clear();
+	p.beginBundle(tag);
+	for(int i=0; i<NMSG; ++i){
+		p.addMessage("/agent/pos", i, 0.1f, 0.2f, 0.3f);
+	}
+	p.endBundle();
+}
+
+struct Handler : osc::PacketHandler{
+	float sum;
+	Handler(): sum(0){}
+	void onMessage(osc::Message& m){
+		int i; float x,y,z;
+		m >> i >> x >> y >> z;
+		sum += x+y+z;
+	}
+};
+
+struct Build : BenchFunc{
+	osc::Packet p;
+	void operator()(unsigned iterations){
+		for(unsigned k=0; k<iterations; ++k) buildBundle(p, k);
+		bnUse(p.size());
+	}
+};
+
+struct Parse : BenchFunc{
+	osc::Packet p;
+	Handler h;
+	Parse(){ buildBundle(p, 1); }
+	void operator()(unsigned iterations){
+		for(unsigned k=0; k<iterations; ++k) h.parse(p.data(), p.size());
+		bnUse(h.sum);
+	}
+};
+
+// Send over loopback and receive each packet so the socket buffer never fills
+struct SendRecv : BenchFunc{
+	osc::Send s;
+	osc::Recv r;
+	Handler h;
+	SendRecv(unsigned port): s(port, "127.0.0.1"), r(port){
+		r.timeout(0.1);
+		r.handler(h);
+	}
+	void operator()(unsigned iterations){
+		for(unsigned k=0; k<iterations; ++k){
+			buildBundle(s, k);
+			s.send();
+			r.recv();
+		}
+		bnUse(h.sum);
+	}
+};
+
+} // ::
+
+void bnOSC(Bench& b){
+	{ Build f; b.run("OSC.build.bundle8", f, NMSG); }
+	{
+		Parse f;
+		b.run("OSC.parse.bundle8", f, NMSG, f.p.size());
+	}
+	if(b.enabled("OSC.sendrecv.loopback.bundle8")){
+		SendRecv f(4120);
+		b.run("OSC.sendrecv.loopback.bundle8", f, NMSG);
+	}
+}
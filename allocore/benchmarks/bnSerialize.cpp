@@ -0,0 +1,51 @@
+#include "allocore/protocol/al_Serialize.hpp"
+#include "bnAllocore.h"
+
+namespace{
+
+const unsigned N = 256;
+
+struct Encode : BenchFunc{
+	float v[N];
+	Serializer s;
+	Encode(){
+		for(unsigned i=0; i<N; ++i) v[i] = i;
+		s.reserve(N*sizeof(float) + 64);
+	}
+	void operator()(unsigned iterations){
+		for(unsigned k=0; k<iterations; ++k){
+			s.reset();
+			s << int32_t(k) << 0.5;
+			s.add(v, N);
+		}
+		bnUse(s.size());
+	}
+};
+
+struct Decode : BenchFunc{
+	Serializer s;
+	bool copy;
+	float v[N];
+	Decode(bool copy_): copy(copy_){
+		for(unsigned i=0; i<N; ++i) v[i] = i;
+		s.add(v, N);
+	}
+	void operator()(unsigned iterations){
+		for(unsigned k=0; k<iterations; ++k){
+			Deserializer d(s.data(), s.size(), copy);
+			ser::View<float> view;
+			d.view(view);
+			if(copy) view.copy(v);
+			else bnUse(view[N-1]);
+		}
+		bnUse(v[0]);
+	}
+};
+
+} // ::
+
+void bnSerialize(Bench& b){
+	{ Encode f; b.run("Serialize.encode.float32x256", f, N, N*sizeof(float)); }
+	{ Decode f(true); b.run("Serialize.decode.float32x256.copy", f, N, N*sizeof(float)); }
+	{ Decode f(false); b.run("Serialize.decode.float32x256.view", f, N, N*sizeof(float)); }
+}
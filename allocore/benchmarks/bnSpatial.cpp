@@ -0,0 +1,139 @@
+#include "allocore/math/al_Random.hpp"
+#include "allocore/spatial/al_DistAtten.hpp"
+#include "allocore/spatial/al_FrustumCuller.hpp"
+#include "allocore/spatial/al_HashSpace.hpp"
+#include "allocore/system/al_ThreadPool.hpp"
+#include "bnAllocore.h"
+
+namespace{
+
+const unsigned NOBJ = 10000;
+
+struct Space{
+	HashSpace space;
+	Space(): space(6, NOBJ){
+		for(unsigned i=0; i<NOBJ; ++i){
+			space.move(i, rnd::uniform(64.), rnd::uniform(64.), rnd::uniform(64.));
+		}
+	}
+};
+
+struct Move : BenchFunc, Space{
+	void operator()(unsigned iterations){
+		for(unsigned k=0; k<iterations; ++k){
+			unsigned i = k % NOBJ;
+			Vec3d p = space.object(i).pos;
+			space.move(i, space.wrap(p + Vec3d(0.5, 0.25, 0.125)));
+		}
+	}
+};
+
+struct Query : BenchFunc, Space{
+	HashSpace::Query query;
+	double radius;
+	Query(double r): query(64), radius(r){}
+	void operator()(unsigned iterations){
+		int found = 0;
+		for(unsigned k=0; k<iterations; ++k){
+			query.clear();
+			found += query(space, space.object(k % NOBJ).pos, radius);
+		}
+		bnUse(found);
+	}
+};
+
+// Culls bounding spheres spread over a 64-unit cube against a perspective
+// frustum that sees about a tenth of them
+struct Cull : BenchFunc{
+	enum Method{ SCALAR, BATCH, POOL, HASHSPACE };
+	enum{ N = 100000 };
+	Frustumd frustum;
+	FrustumCuller culler;
+	std::vector<Vec3d> centers;
+	SphereArray spheres;
+	HashSpace space;
+	std::vector<uint32_t> mask;
+	std::vector<int> visible;
+	ThreadPool pool;
+	Method method;
+
+	Cull(Method m): spheres(N), space(6, N), mask((N+31)/32), method(m){
+		frustum.ntl = Vec3d(31,33,60); frustum.ntr = Vec3d(33,33,60);
+		frustum.nbl = Vec3d(31,31,60); frustum.nbr = Vec3d(33,31,60);
+		frustum.ftl = Vec3d(18,46, 4); frustum.ftr = Vec3d(46,46, 4);
+		frustum.fbl = Vec3d(18,18, 4); frustum.fbr = Vec3d(46,18, 4);
+		frustum.computePlanes();
+		culler.set(frustum);
+		rnd::Random<> rng(1);
+		for(int i=0; i<N; ++i){
+			Vec3f c(rng.uniform(64.f), rng.uniform(64.f), rng.uniform(64.f));
+			centers.push_back(c);
+			spheres.set(i, c, 0.5f);
+			space.move(i, c);
+		}
+		visible.reserve(N);
+		if(POOL == method) pool.start();
+	}
+
+	void operator()(unsigned iterations){
+		int count = 0;
+		for(unsigned k=0; k<iterations; ++k){
+			switch(method){
+			case SCALAR:
+				for(int i=0; i<N; ++i){
+					count += frustum.testSphere(centers[i], 0.5f) != Frustumd::OUTSIDE;
+				}
+				break;
+			case BATCH: culler.mask(&mask[0], spheres); break;
+			case POOL: culler.mask(&mask[0], spheres, pool); break;
+			case HASHSPACE:
+				visible.clear();
+				count += culler.indices(visible, space, 0.5f);
+				break;
+			}
+		}
+		bnUse(count);
+		bnUse(mask[N/64]);
+	}
+};
+
+// Attenuates a block of distances spanning the clip range
+struct Atten : BenchFunc{
+	enum Method{ SCALAR, BLOCK };
+	enum{ N = 256 };
+	DistAtten<float> atten;
+	float dist[N], gain[N];
+	Method method;
+
+	Atten(AttenuationLaw law, Method m)
+	:	atten(1, 20, law), method(m)
+	{
+		for(int i=0; i<N; ++i) dist[i] = i*0.08f;
+	}
+
+	void operator()(unsigned iterations){
+		for(unsigned k=0; k<iterations; ++k){
+			switch(method){
+			case SCALAR: for(int i=0; i<N; ++i) gain[i] = atten.attenuation(dist[i]); break;
+			case BLOCK: atten.attenuation(gain, dist, N); break;
+			}
+			bnUse(gain[k%N]);
+		}
+	}
+};
+
+} // ::
+
+void bnSpatial(Bench& b){
+	{ Move f; b.run("HashSpace.move", f); }
+	{ Query f(4); b.run("HashSpace.query.r4", f); }
+	{ Query f(12); b.run("HashSpace.query.r12", f); }
+	{ Cull f(Cull::SCALAR); b.run("FrustumCuller.spheres100k.scalar", f, Cull::N); }
+	{ Cull f(Cull::BATCH); b.run("FrustumCuller.spheres100k.batch", f, Cull::N); }
+	{ Cull f(Cull::POOL); b.run("FrustumCuller.spheres100k.pool", f, Cull::N); }
+	{ Cull f(Cull::HASHSPACE); b.run("FrustumCuller.spheres100k.hashspace", f, Cull::N); }
+	{ Atten f(ATTEN_INVERSE, Atten::SCALAR); b.run("DistAtten.inverse256.scalar", f, Atten::N); }
+	{ Atten f(ATTEN_INVERSE, Atten::BLOCK); b.run("DistAtten.inverse256.block", f, Atten::N); }
+	{ Atten f(ATTEN_INVERSE_SQUARE, Atten::SCALAR); b.run("DistAtten.inverseSquare256.scalar", f, Atten::N); }
+	{ Atten f(ATTEN_INVERSE_SQUARE, Atten::BLOCK); b.run("DistAtten.inverseSquare256.block", f, Atten::N); }
+}
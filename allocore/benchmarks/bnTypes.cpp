@@ -0,0 +1,187 @@
+#include "allocore/math/al_Random.hpp"
+#include "allocore/system/al_Thread.hpp"
+#include "allocore/system/al_Time.h"
+#include "allocore/types/al_Color.hpp"
+#include "allocore/types/al_MsgQueue.hpp"
+#include "allocore/types/al_MsgTube.hpp"
+#include "allocore/types/al_SPSCRing.hpp"
+#include "bnAllocore.h"
+
+namespace{
+
+const unsigned BATCH = 64;	// messages sent before they are executed
+
+double gSum = 0;
+void accum(al_sec t, float a, int b){ gSum += a*b; }
+
+struct Tube : BenchFunc{
+	MsgTube tube;
+	void operator()(unsigned iterations){
+		for(unsigned k=0; k<iterations; ++k){
+			for(unsigned i=0; i<BATCH; ++i) tube.send(accum, 0.5f, int(i));
+			tube.executeUntil(tube.now);
+		}
+		bnUse(gSum);
+	}
+};
+
+struct Queue : BenchFunc{
+	MsgQueue queue;
+	Queue(): queue(BATCH){}
+	void operator()(unsigned iterations){
+		for(unsigned k=0; k<iterations; ++k){
+			al_sec t = queue.now();
+			for(unsigned i=0; i<BATCH; ++i) queue.send(t + i, accum, 0.5f, int(i));
+			queue.update(t + BATCH);
+		}
+		bnUse(gSum);
+	}
+};
+
+// Streams blocks of floats from the benchmark thread to a consumer thread,
+// either copying through write/read or in place through reserve/commit and
+// readRegion/consume
+struct Ring : BenchFunc{
+	enum{ BLOCK = 256 };
+
+	struct Consumer : public ThreadFunction{
+		SPSCRing<float> * ring;
+		bool inPlace;
+		unsigned long long count;
+		float sum;
+		void operator()(){
+			float buf[BLOCK];
+			sum = 0;
+			while(count){
+				size_t n = BLOCK;
+				if(inPlace){
+					const float * r = ring->readRegion(n);
+					for(size_t i=0; i<n; ++i) sum += r[i];
+					ring->consume(n);
+				}
+				else{
+					n = ring->read(buf, n);
+					for(size_t i=0; i<n; ++i) sum += buf[i];
+				}
+				count -= n;
+				if(!n) al_sleep_nsec(0); // let the producer run on a busy or single core machine
+			}
+		}
+	};
+
+	SPSCRing<float> ring;
+	Consumer consumer;
+	float block[BLOCK];
+
+	Ring(bool inPlace): ring(16*BLOCK){
+		consumer.ring = &ring;
+		consumer.inPlace = inPlace;
+		for(int i=0; i<BLOCK; ++i) block[i] = i;
+	}
+
+	void operator()(unsigned iterations){
+		consumer.count = (unsigned long long)iterations * BLOCK;
+		Thread thread(consumer);
+		for(unsigned k=0; k<iterations; ++k){
+			size_t left = BLOCK;
+			while(left){
+				size_t n = left;
+				if(consumer.inPlace){
+					float * w = ring.reserve(n);
+					std::copy(block + BLOCK - left, block + BLOCK - left + n, w);
+					ring.commit(n);
+				}
+				else{
+					n = ring.write(block + BLOCK - left, n);
+				}
+				left -= n;
+				if(!n) al_sleep_nsec(0);
+			}
+		}
+		thread.join();
+		bnUse(consumer.sum);
+	}
+};
+
+// Converts a field of colors, either in one batch call or one at a time
+template <class In, class Out>
+struct ColorConvert : BenchFunc{
+	enum{ N = 4096 };
+	std::vector<In> in;
+	std::vector<Out> out;
+	bool batch;
+
+	ColorConvert(bool batch_): in(N), out(N), batch(batch_){
+		for(int i=0; i<N; ++i) in[i] = RGB((i%17)/16.f, (i%19)/18.f, (i%23)/22.f);
+	}
+
+	void operator()(unsigned iterations){
+		for(unsigned k=0; k<iterations; ++k){
+			if(batch) convert(&in[0], &out[0], N);
+			else for(int i=0; i<N; ++i) out[i] = in[i];
+		}
+		bnUse(out[N/2]);
+	}
+};
+
+// Fills arrays with random numbers, either in bulk or one at a time
+struct RandomFill : BenchFunc{
+	enum{ N = 4096 };
+	enum Dist{ UNIFORM, NORMAL, BALL };
+	rnd::Random<> scalar;
+	rnd::BulkRandom bulk;
+	std::vector<float> out;
+	std::vector<Vec3f> points;
+	Dist dist;
+	bool batch;
+
+	RandomFill(Dist d, bool batch_): scalar(1), bulk(1), out(N), points(N), dist(d), batch(batch_){}
+
+	void operator()(unsigned iterations){
+		for(unsigned k=0; k<iterations; ++k){
+			switch(dist){
+			case UNIFORM:
+				if(batch) bulk.uniform(&out[0], N);
+				else for(int i=0; i<N; ++i) out[i] = scalar.uniform();
+				break;
+			case NORMAL:
+				if(batch) bulk.normal(&out[0], N);
+				else for(int i=0; i<N; i+=2) scalar.normal(out[i], out[i+1]);
+				break;
+			case BALL:
+				if(batch) bulk.ball3(&points[0], N);
+				else for(int i=0; i<N; ++i) scalar.ball<3>(&points[i][0]);
+				break;
+			}
+		}
+		bnUse(out[N/2]);
+		bnUse(points[N/2]);
+	}
+};
+
+} // ::
+
+void bnTypes(Bench& b){
+	{ Tube f; b.run("MsgTube.send_execute.x64", f, BATCH); }
+	{ Queue f; b.run("MsgQueue.send_update.x64", f, BATCH); }
+	{ Ring f(false); b.run("SPSCRing.write_read.float256", f, Ring::BLOCK, Ring::BLOCK*sizeof(float)); }
+	{ Ring f(true); b.run("SPSCRing.reserve_commit.float256", f, Ring::BLOCK, Ring::BLOCK*sizeof(float)); }
+
+	const int NC = ColorConvert<RGB, HSV>::N;
+	{ ColorConvert<RGB, HSV> f(false); b.run("Color.RGB_HSV.scalar4096", f, NC); }
+	{ ColorConvert<RGB, HSV> f(true); b.run("Color.RGB_HSV.batch4096", f, NC); }
+	{ ColorConvert<HSV, RGB> f(false); b.run("Color.HSV_RGB.scalar4096", f, NC); }
+	{ ColorConvert<HSV, RGB> f(true); b.run("Color.HSV_RGB.batch4096", f, NC); }
+	{ ColorConvert<RGB, Lab> f(false); b.run("Color.RGB_Lab.scalar4096", f, NC); }
+	{ ColorConvert<RGB, Lab> f(true); b.run("Color.RGB_Lab.batch4096", f, NC); }
+	{ ColorConvert<Lab, RGB> f(false); b.run("Color.Lab_RGB.scalar4096", f, NC); }
+	{ ColorConvert<Lab, RGB> f(true); b.run("Color.Lab_RGB.batch4096", f, NC); }
+
+	const int NR = RandomFill::N;
+	{ RandomFill f(RandomFill::UNIFORM, false); b.run("Random.uniform.scalar4096", f, NR); }
+	{ RandomFill f(RandomFill::UNIFORM, true); b.run("Random.uniform.bulk4096", f, NR); }
+	{ RandomFill f(RandomFill::NORMAL, false); b.run("Random.normal.scalar4096", f, NR); }
+	{ RandomFill f(RandomFill::NORMAL, true); b.run("Random.normal.bulk4096", f, NR); }
+	{ RandomFill f(RandomFill::BALL, false); b.run("Random.ball3.scalar4096", f, NR); }
+	{ RandomFill f(RandomFill::BALL, true); b.run("Random.ball3.bulk4096", f, NR); }
+}
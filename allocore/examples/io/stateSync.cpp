@@ -0,0 +1,55 @@
+/*
+Allocore Example: State Synchronization
+
+Description:
+This shows how a simulation can share its state with renderers running in
+other processes. Run one instance with the argument "send" and one or more
+with "recv". Frames are sent to a multicast group, so any number of
+receivers, on this machine or others on the network, get every frame. Each
+receiver always displays the newest complete frame, no matter how fast the
+sender runs.
+
+Author:
+AlloSphere Research Group
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "allocore/al_Allocore.hpp"
+using namespace al;
+
+// State must be plain old data; this one spans several datagrams
+struct State{
+	unsigned frame;
+	Vec3f positions[500];
+};
+
+int main(int argc, char * argv[]){
+	const uint16_t port = 11112;
+	const char * group = "239.255.0.1";
+	State state;
+	memset(&state, 0, sizeof state);
+
+	if(argc > 1 && !strcmp(argv[1], "send")){
+		StateSender sender(port, group);
+		for(unsigned k=0; ; ++k){
+			state.frame = k;
+			for(int i=0; i<500; ++i) state.positions[i].set(sin(k*0.01 + i), cos(k*0.01 + i), 0);
+			sender.send(state);
+			al_sleep(1./60);
+		}
+	}
+	else{
+		// Packets are received on a thread, so reading never blocks
+		StateReceiver receiver(sizeof(State), port, 4, group);
+		receiver.start();
+		while(true){
+			if(receiver.read(state)){
+				printf("frame %u, x[0] = %f, %lu frames, %lu dropped\n",
+					state.frame, state.positions[0].x,
+					receiver.framesReceived(), receiver.framesDropped());
+			}
+			al_sleep(1./30);
+		}
+	}
+}
@@ -0,0 +1,66 @@
+/*
+Allocore Example: Batch interpolated array access
+
+Description:
+This compares the time taken to sample and splat many particles through a 3D
+Array one point at a time versus in batches. Positions are stored as separate
+x, y and z arrays (structure of arrays) which is the layout the batch
+functions expect.
+*/
+
+#include <stdio.h>
+#include <vector>
+#include "allocore/math/al_Random.hpp"
+#include "allocore/system/al_Time.hpp"
+#include "allocore/types/al_Array.hpp"
+using namespace al;
+
+int main(){
+	const int N = 64;			// field cells along each dimension
+	const int Np = 1000000;		// number of particles
+	const int Nthreads = 4;
+
+	// A 3D vector field
+	Array field(3, AlloFloat32Ty, N,N,N);
+	for(unsigned i=0; i<field.cells()*3; ++i){
+		((float *)field.data.ptr)[i] = rnd::uniformS();
+	}
+
+	// Particle positions and velocities
+	std::vector<float> xs(Np), ys(Np), zs(Np), vels(Np*3);
+	for(int i=0; i<Np; ++i){
+		xs[i] = rnd::uniform(float(N));
+		ys[i] = rnd::uniform(float(N));
+		zs[i] = rnd::uniform(float(N));
+	}
+
+	Timer timer;
+
+	timer.start();
+	for(int i=0; i<Np; ++i) field.read_interp(&vels[i*3], xs[i], ys[i], zs[i]);
+	timer.stop();
+	printf("read_interp        %6.2f ns/point\n", double(timer.elapsed())/Np);
+
+	timer.start();
+	field.read_interp_batch(&vels[0], &xs[0], &ys[0], &zs[0], Np);
+	timer.stop();
+	printf("read_interp_batch  %6.2f ns/point\n", double(timer.elapsed())/Np);
+
+	field.zero();
+	timer.start();
+	for(int i=0; i<Np; ++i) field.write_interp(&vels[i*3], xs[i], ys[i], zs[i]);
+	timer.stop();
+	printf("write_interp       %6.2f ns/point\n", double(timer.elapsed())/Np);
+
+	field.zero();
+	timer.start();
+	field.write_interp_batch(&vels[0], &xs[0], &ys[0], &zs[0], Np);
+	timer.stop();
+	printf("write_interp_batch %6.2f ns/point (1 thread)\n", double(timer.elapsed())/Np);
+
+	field.zero();
+	timer.start();
+	field.write_interp_batch(&vels[0], &xs[0], &ys[0], &zs[0], Np, Nthreads);
+	timer.stop();
+	printf("write_interp_batch %6.2f ns/point (%d threads)\n", double(timer.elapsed())/Np, Nthreads);
+}
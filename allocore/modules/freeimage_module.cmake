@@ -3,6 +3,7 @@ find_package(FreeImage QUIET)
 
 set(FREEIMAGE_HEADERS
     allocore/graphics/al_Image.hpp
+    allocore/graphics/al_ImageLoader.hpp
 )
 
 if(FREEIMAGE_LIBRARY AND FREEIMAGE_INCLUDE_PATH)
@@ -11,7 +12,8 @@ if(GLUT_LIBRARY AND OPENGL_LIBRARY)
 message(STATUS "Building freeimage module.")
 
 list(APPEND ALLOCORE_SRC
-    src/graphics/al_Image.cpp)
+    src/graphics/al_Image.cpp
+    src/graphics/al_ImageLoader.cpp)
 
 list(APPEND ALLOCORE_HEADERS ${FREEIMAGE_HEADERS})
 
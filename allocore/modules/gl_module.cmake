@@ -6,12 +6,14 @@ set(GL_HEADERS
     allocore/graphics/al_BufferObject.hpp
     allocore/graphics/al_DisplayList.hpp
     allocore/graphics/al_FBO.hpp
+    allocore/graphics/al_GlyphAtlas.hpp
     allocore/graphics/al_GPUObject.hpp
     allocore/graphics/al_Graphics.hpp
     allocore/graphics/al_Isosurface.hpp
     allocore/graphics/al_Lens.hpp
     allocore/graphics/al_Light.hpp
     allocore/graphics/al_OpenGL.hpp
+    allocore/graphics/al_PolylineMesh.hpp
     allocore/graphics/al_Shader.hpp
     allocore/graphics/al_Slab.hpp
     allocore/graphics/al_Stereographic.hpp
@@ -28,11 +30,13 @@ message(STATUS "Building OpenGL module (OpenGL + GLEW).")
 list(APPEND ALLOCORE_SRC
   src/graphics/al_Graphics.cpp
   src/graphics/al_FBO.cpp
+  src/graphics/al_GlyphAtlas.cpp
   src/graphics/al_GPUObject.cpp
   src/graphics/al_Isosurface.cpp
   src/graphics/al_Lens.cpp
   src/graphics/al_Light.cpp
   src/graphics/al_Mesh.cpp
+  src/graphics/al_PolylineMesh.cpp
   src/graphics/al_Shader.cpp
   src/graphics/al_Shapes.cpp
   src/graphics/al_Stereographic.cpp
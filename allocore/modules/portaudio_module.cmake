@@ -5,6 +5,8 @@ set(PORTAUDIO_HEADERS
     allocore/io/al_AudioIO.hpp
     allocore/sound/al_Ambisonics.hpp
     allocore/sound/al_AudioScene.hpp
+    allocore/sound/al_Binaural.hpp
+    allocore/sound/al_Convolver.hpp
     allocore/sound/al_Crossover.hpp
     allocore/sound/al_Dbap.hpp
     allocore/sound/al_Reverb.hpp
@@ -36,6 +38,8 @@ list(APPEND ALLOCORE_SRC
     src/io/al_AudioIO.cpp
 	src/sound/al_AudioScene.cpp
     src/sound/al_Ambisonics.cpp
+    src/sound/al_Binaural.cpp
+    src/sound/al_Convolver.cpp
     src/sound/al_Dbap.cpp
     src/sound/al_Vbap.cpp
 )
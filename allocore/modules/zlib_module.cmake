@@ -0,0 +1,18 @@
+
+find_package(ZLIB QUIET)
+
+if(ZLIB_FOUND)
+message(STATUS "Building zlib module.")
+
+# Enables compressed bricks in al_BrickArray
+add_definitions(-DAL_ZLIB)
+
+list(APPEND ALLOCORE_DEP_INCLUDE_DIRS
+  ${ZLIB_INCLUDE_DIRS})
+
+list(APPEND ALLOCORE_LINK_LIBRARIES
+  ${ZLIB_LIBRARIES})
+
+else()
+message("NOT Building zlib module.")
+endif(ZLIB_FOUND)
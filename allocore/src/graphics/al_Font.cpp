@@ -1,4 +1,5 @@
 #include "allocore/graphics/al_Font.hpp"
+#include "allocore/graphics/al_GlyphAtlas.hpp"
 #include <vector>
 
 #if defined (__APPLE__) || defined (OSX)
@@ -258,3 +259,27 @@ void Font :: write(Mesh& mesh, const std::string& text) {
 	}
 }
 
+int Font :: addTo(GlyphAtlas& atlas) const {
+	if(!mImpl) return -1;
+
+	// Glyphs are copied as the whole cells of the texture grid that write()
+	// draws, placed the same way relative to the pen
+	const Array& arr = mTex.array();
+	const int rowstride = arr.header.stride[1];
+	const unsigned char * pixels = (const unsigned char *)arr.data.ptr;
+	const int margin = 2;
+	const int cdim = mFontSize + margin;
+
+	const int face = atlas.addFace(mFontSize);
+	for(int i=0; i < ASCII_SIZE; i++) {
+		const FontCharacter& c = mChars[i];
+		int xidx = i % GLYPHS_PER_ROW;
+		int yidx = i / GLYPHS_PER_ROW;
+		const unsigned char * cell = pixels + yidx*cdim*rowstride + xidx*cdim;
+		if(!atlas.add(face, i, cell, cdim, cdim, rowstride, c.x_offset, c.y_offset + margin, c.width)){
+			atlas.removeLastFace();
+			return -1;
+		}
+	}
+	return face;
+}
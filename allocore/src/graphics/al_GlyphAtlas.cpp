@@ -0,0 +1,211 @@
+#include <string.h>
+#include "allocore/graphics/al_GlyphAtlas.hpp"
+#include "allocore/graphics/al_Graphics.hpp"
+
+namespace al{
+
+GlyphAtlas::GlyphAtlas(int width, int height)
+:	mWidth(width), mHeight(height), mVersion(0)
+{
+	clear();
+}
+
+void GlyphAtlas::clear(){
+	mPixels.assign(mWidth*mHeight, 0);
+	mFaces.clear();
+	mPenX = mPenY = mRowHeight = 0;
+	++mVersion;
+}
+
+int GlyphAtlas::addFace(float lineHeight){
+	mFaces.push_back(Face());
+	Face& f = mFaces.back();
+	f.lineHeight = lineHeight;
+	f.penX = mPenX;
+	f.penY = mPenY;
+	f.rowHeight = mRowHeight;
+	return mFaces.size()-1;
+}
+
+void GlyphAtlas::removeLastFace(){
+	if(mFaces.empty()) return;
+	const Face& f = mFaces.back();
+
+	// Glyphs added since the face are right of the pen in its row and in
+	// every row below; everything there was empty before the face
+	for(int y=f.penY; y<mHeight; ++y){
+		const int x0 = y < f.penY + f.rowHeight ? f.penX : 0;
+		memset(&mPixels[y*mWidth + x0], 0, mWidth - x0);
+	}
+	mPenX = f.penX;
+	mPenY = f.penY;
+	mRowHeight = f.rowHeight;
+	mFaces.pop_back();
+	++mVersion;
+}
+
+bool GlyphAtlas::add(
+	int face, int code, const unsigned char * bitmap, int w, int h, int stride,
+	float left, float top, float advance
+){
+	// Each bitmap takes its size plus one pixel of padding to the left and
+	// above; the image border gives the padding to the right and below
+	if(mPenX + w + 2 > mWidth){
+		mPenX = 0;
+		mPenY += mRowHeight;
+		mRowHeight = 0;
+	}
+	if(mPenX + w + 2 > mWidth || mPenY + h + 2 > mHeight) return false;
+
+	const int x = mPenX + 1;
+	const int y = mPenY + 1;
+	for(int j=0; j<h; ++j){
+		memcpy(&mPixels[(y+j)*mWidth + x], bitmap + j*stride, w);
+	}
+	mPenX += w + 1;
+	if(mRowHeight < h + 1) mRowHeight = h + 1;
+
+	Glyph& g = mFaces[face].glyphs[code & 255];
+	g.quad.x0 = left;
+	g.quad.x1 = left + w;
+	g.quad.y0 = top;
+	g.quad.y1 = top - h;
+	g.quad.s0 = float(x) / mWidth;
+	g.quad.s1 = float(x + w) / mWidth;
+	g.quad.t0 = float(y) / mHeight;
+	g.quad.t1 = float(y + h) / mHeight;
+	g.advance = advance;
+	mFaces[face].has[code & 255] = true;
+	++mVersion;
+	return true;
+}
+
+
+
+namespace{
+
+// FNV-1a hash of a string and face
+uint32_t hashText(const std::string& text, int face){
+	uint32_t h = 2166136261u ^ uint32_t(face);
+	for(unsigned i=0; i<text.size(); ++i){
+		h = (h ^ (unsigned char)text[i]) * 16777619u;
+	}
+	return h;
+}
+
+} // ::
+
+int TextCache::layout(const std::string& text, int face){
+	const uint32_t hash = hashText(text, face);
+	const unsigned mask = mTable.size() - 1;
+	if(!mTable.empty()){
+		for(unsigned i = hash & mask; mTable[i] >= 0; i = (i+1) & mask){
+			const Layout& l = mLayouts[mTable[i]];
+			if(l.hash == hash && l.face == face && l.text == text) return mTable[i];
+		}
+	}
+
+	Layout l;
+	l.text = text;
+	l.face = face;
+	l.hash = hash;
+	l.begin = mQuads.size();
+	l.width = 0;
+	const float lineHeight = mAtlas->lineHeight(face);
+	float x = 0, y = 0;
+	for(unsigned i=0; i<text.size(); ++i){
+		const unsigned char c = text[i];
+		if('\n' == c){
+			if(l.width < x) l.width = x;
+			x = 0;
+			y -= lineHeight;
+			continue;
+		}
+		const Glyph * g = mAtlas->glyph(face, c);
+		if(!g) continue;
+		GlyphQuad q = g->quad;
+		q.x0 += x; q.x1 += x;
+		q.y0 += y; q.y1 += y;
+		mQuads.push_back(q);
+		x += g->advance;
+	}
+	if(l.width < x) l.width = x;
+	l.count = mQuads.size() - l.begin;
+
+	const int id = mLayouts.size();
+	mLayouts.push_back(l);
+
+	// Keep the table at most half full
+	if(mTable.size() < 2*mLayouts.size()){
+		mTable.assign(mTable.empty() ? 64 : 2*mTable.size(), -1);
+		for(int i=0; i<int(mLayouts.size()); ++i) insert(i);
+	}
+	else{
+		insert(id);
+	}
+	return id;
+}
+
+void TextCache::insert(int layout){
+	const unsigned mask = mTable.size() - 1;
+	unsigned i = mLayouts[layout].hash & mask;
+	while(mTable[i] >= 0) i = (i+1) & mask;
+	mTable[i] = layout;
+}
+
+void TextCache::clear(){
+	mLayouts.clear();
+	mTable.clear();
+	mQuads.clear();
+}
+
+// The first quad of each label is found by a running sum, so the buffers
+// are sized once and written in place
+void TextCache::write(Mesh& m, const TextLabel * labels, int n){
+	mStarts.resize(n+1);
+	mStarts[0] = 0;
+	for(int i=0; i<n; ++i) mStarts[i+1] = mStarts[i] + mLayouts[labels[i].layout].count;
+	const int total = mStarts[n];
+
+	m.reset();
+	m.primitive(Graphics::TRIANGLES);
+	if(!total) return;
+	m.vertices().size(4*total);
+	m.texCoord2s().size(4*total);
+	m.indices().size(6*total);
+	Mesh::Vertex * verts = m.vertices().elems();
+	Mesh::TexCoord2 * tcs = m.texCoord2s().elems();
+	Mesh::Index * inds = m.indices().elems();
+
+	for(int i=0; i<n; ++i){
+		const TextLabel& lab = labels[i];
+		const Layout& l = mLayouts[lab.layout];
+		const GlyphQuad * q = &mQuads[l.begin];
+		const float s = lab.scale;
+		const float ox = lab.pos[0] - lab.align * l.width * s;
+		const float oy = lab.pos[1];
+		const float z = lab.pos[2];
+		for(int k=0; k<l.count; ++k){
+			const int j = mStarts[i] + k;
+			const float x0 = ox + q[k].x0*s, x1 = ox + q[k].x1*s;
+			const float y0 = oy + q[k].y0*s, y1 = oy + q[k].y1*s;
+			Mesh::Vertex * v = verts + 4*j;
+			v[0].set(x0, y0, z);
+			v[1].set(x1, y0, z);
+			v[2].set(x1, y1, z);
+			v[3].set(x0, y1, z);
+			Mesh::TexCoord2 * t = tcs + 4*j;
+			t[0].set(q[k].s0, q[k].t0);
+			t[1].set(q[k].s1, q[k].t0);
+			t[2].set(q[k].s1, q[k].t1);
+			t[3].set(q[k].s0, q[k].t1);
+			// counterclockwise seen from +z
+			const Mesh::Index a = 4*j;
+			Mesh::Index * ind = inds + 6*j;
+			ind[0] = a; ind[1] = a+2; ind[2] = a+1;
+			ind[3] = a; ind[4] = a+3; ind[5] = a+2;
+		}
+	}
+}
+
+} // al::
@@ -300,4 +300,56 @@ void Graphics::draw(const Mesh& v, int count, int begin){
 	if(Nt2 || Nt3)	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
 }
 
+void Graphics::draw(const InterleavedMesh& m, int count, int begin){
+
+	const int Nv = m.vertices().size();
+	if(0 == Nv) return;
+
+	const int Ni = m.indices().size();
+	const int Nmax = Ni ? Ni : Nv;
+
+	if(count < 0) count += Nmax+1;
+	if(begin < 0) begin += Nmax+1;
+	if(begin >= Nmax) return;
+	if(begin + count > Nmax) count = Nmax - begin;
+
+	// All attributes share the stride of one vertex
+	const InterleavedVertex * v = m.vertices().elems();
+	const GLsizei stride = sizeof(InterleavedVertex);
+	const int attribs = m.attributes();
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glVertexPointer(3, GL_FLOAT, stride, &v->position);
+
+	if(attribs & Mesh::NORMAL){
+		glEnableClientState(GL_NORMAL_ARRAY);
+		glNormalPointer(GL_FLOAT, stride, &v->normal);
+	}
+	if(attribs & Mesh::COLORI){
+		glEnableClientState(GL_COLOR_ARRAY);
+		glColorPointer(4, GL_UNSIGNED_BYTE, stride, &v->color);
+	}
+	if(attribs & Mesh::TEXCOORD2){
+		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		glTexCoordPointer(2, GL_FLOAT, stride, &v->texCoord);
+	}
+
+	if(Ni){
+		glDrawElements(
+			((Graphics::Primitive)m.primitive()),
+			count,
+			GL_UNSIGNED_INT,
+			&m.indices()[begin]
+		);
+	}
+	else{
+		glDrawArrays(((Graphics::Primitive)m.primitive()), begin, count);
+	}
+
+									glDisableClientState(GL_VERTEX_ARRAY);
+	if(attribs & Mesh::NORMAL)		glDisableClientState(GL_NORMAL_ARRAY);
+	if(attribs & Mesh::COLORI)		glDisableClientState(GL_COLOR_ARRAY);
+	if(attribs & Mesh::TEXCOORD2)	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+}
+
 } // al::
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <string.h>
 
 #include "allocore/graphics/al_Image.hpp"
 #include "allocore/system/al_Config.h"
@@ -23,6 +24,42 @@ namespace al{
 
 static int initializedFreeImage = 0;
 
+/*	FreeImage stores 24- and 32-bit pixels in the platform's native order,
+	BGR(A) on little-endian machines, as given by the FI_RGBA_* byte offsets.
+	The order is either the identity or a swap of red and blue, so the same
+	kernels convert in both directions. They have no loop-carried dependencies
+	and are written so the compiler turns them into vector shuffles.
+*/
+static void swizzleRGB(uint8_t * dst, const uint8_t * src, unsigned n){
+	if(FI_RGBA_RED == 0){
+		memcpy(dst, src, n*3);
+		return;
+	}
+	for(unsigned i=0; i<n; ++i){
+		uint8_t r = src[3*i + FI_RGBA_RED];
+		uint8_t g = src[3*i + FI_RGBA_GREEN];
+		uint8_t b = src[3*i + FI_RGBA_BLUE];
+		dst[3*i  ] = r;
+		dst[3*i+1] = g;
+		dst[3*i+2] = b;
+	}
+}
+
+static void swizzleRGBA(uint8_t * dst, const uint8_t * src, unsigned n){
+	if(FI_RGBA_RED == 0){
+		memcpy(dst, src, n*4);
+		return;
+	}
+	// Red and blue are swapped only on little-endian machines, where they are
+	// the low and third bytes of each pixel read as a 32-bit word
+	for(unsigned i=0; i<n; ++i){
+		uint32_t p;
+		memcpy(&p, src + 4*i, 4);
+		p = (p & 0xff00ff00) | ((p >> 16) & 0xff) | ((p & 0xff) << 16);
+		memcpy(dst + 4*i, &p, 4);
+	}
+}
+
 class FreeImageImpl : public Image::Impl {
 public:
 	FreeImageImpl()
@@ -117,17 +154,10 @@ public:
 			case Image::RGB: {
 				switch(arr.type()) {
 					case AlloUInt8Ty: {
-						char *bp = (char *)(arr.data.ptr);
+						uint8_t *bp = (uint8_t *)(arr.data.ptr);
 						int rowstride = arr.stride(1);
-
 						for(unsigned j = 0; j < arr.dim(1); ++j) {
-							RGBTRIPLE * pix = (RGBTRIPLE *)FreeImage_GetScanLine(mImage, j);
-							Image::RGBPix<uint8_t> *o_pix = (Image::RGBPix<uint8_t> *)(bp + j*rowstride);
-							for(unsigned i=0; i < arr.dim(0); ++i) {
-								o_pix[i].r = pix[i].rgbtRed;
-								o_pix[i].g = pix[i].rgbtGreen;
-								o_pix[i].b = pix[i].rgbtBlue;
-							}
+							swizzleRGB(bp + j*rowstride, FreeImage_GetScanLine(mImage, j), arr.dim(0));
 						}
 					}
 					break;
@@ -154,17 +184,10 @@ public:
 			case Image::RGBA: {
 				switch(arr.type()) {
 					case AlloUInt8Ty: {
-						char *bp = (char *)(arr.data.ptr);
+						uint8_t *bp = (uint8_t *)(arr.data.ptr);
 						int rowstride = arr.stride(1);
 						for(unsigned j = 0; j < arr.dim(1); ++j) {
-							RGBQUAD *pix = (RGBQUAD *)FreeImage_GetScanLine(mImage, j);
-							Image::RGBAPix<uint8_t> *o_pix = (Image::RGBAPix<uint8_t> *)(bp + j*rowstride);
-							for(unsigned i=0; i < arr.dim(0); ++i) {
-								o_pix[i].r = pix[i].rgbRed;
-								o_pix[i].g = pix[i].rgbGreen;
-								o_pix[i].b = pix[i].rgbBlue;
-								o_pix[i].a = pix[i].rgbReserved;
-							}
+							swizzleRGBA(bp + j*rowstride, FreeImage_GetScanLine(mImage, j), arr.dim(0));
 						}
 					}
 					break;
@@ -301,16 +324,9 @@ public:
 				switch(arr.type()) {
 
 					case AlloUInt8Ty: { //printf("FreeImageImpl: save uint8/RGB\n");
-						char *bp = (char *)(arr.data.ptr);
-
+						const uint8_t *bp = (const uint8_t *)(arr.data.ptr);
 						for(unsigned j = 0; j < h; ++j) {
-							RGBTRIPLE * dst = (RGBTRIPLE *)FreeImage_GetScanLine(mImage, j);
-							const Image::RGBPix<uint8_t> * src = (const Image::RGBPix<uint8_t> *)(bp + j*rowstride);
-							for(unsigned i=0; i < w; ++i) {
-								dst[i].rgbtRed  = src[i].r;
-								dst[i].rgbtGreen= src[i].g;
-								dst[i].rgbtBlue = src[i].b;
-							}
+							swizzleRGB(FreeImage_GetScanLine(mImage, j), bp + j*rowstride, w);
 						}
 					}
 					break;
@@ -327,17 +343,9 @@ public:
 				switch(arr.type()) {
 
 					case AlloUInt8Ty: {
-						char *bp = (char *)(arr.data.ptr);
-
+						const uint8_t *bp = (const uint8_t *)(arr.data.ptr);
 						for(unsigned j = 0; j < h; ++j) {
-							RGBQUAD * dst = (RGBQUAD *)FreeImage_GetScanLine(mImage, j);
-							const Image::RGBAPix<uint8_t> * src = (const Image::RGBAPix<uint8_t> *)(bp + j*rowstride);
-							for(unsigned i=0; i < w; ++i) {
-								dst[i].rgbRed     = src[i].r;
-								dst[i].rgbGreen   = src[i].g;
-								dst[i].rgbBlue    = src[i].b;
-								dst[i].rgbReserved= src[i].a;
-							}
+							swizzleRGBA(FreeImage_GetScanLine(mImage, j), bp + j*rowstride, w);
 						}
 					}
 					break;
@@ -458,8 +466,12 @@ Image :: ~Image() {
 	if (mImpl) delete mImpl;
 }
 
-bool Image :: load(const std::string& filename) {
+void Image :: initImpl() {
 	if (!mImpl) mImpl = new FreeImageImpl();
+}
+
+bool Image :: load(const std::string& filename) {
+	initImpl();
 //	// TODO: if we add other image formats/libraries,
 //	// detect by file extension & redirect to appropriate implementation here:
 //	if (mImpl) delete mImpl;
@@ -470,7 +482,7 @@ bool Image :: load(const std::string& filename) {
 }
 
 bool Image :: save(const std::string& filename) {
-	if (!mImpl) mImpl = new FreeImageImpl();
+	initImpl();
 //	// TODO: if we add other image formats/libraries,
 //	// detect by file extension & redirect to appropriate implementation here:
 //	if (mImpl) delete mImpl;
@@ -0,0 +1,238 @@
+#include <algorithm>
+#include "allocore/system/al_Config.h"
+#include "allocore/graphics/al_ImageLoader.hpp"
+#include "allocore/system/al_Printing.hpp"
+
+#ifdef AL_WINDOWS
+	#define WIN32_MEAN_AND_LEAN
+	#include <windows.h>
+#else
+	#include <pthread.h>
+#endif
+
+namespace al{
+
+// A mutex with two conditions: one signaled when requests are queued or the
+// loader stops, the other when a request has finished decoding
+#ifdef AL_WINDOWS
+struct ImageLoader::Impl{
+	Impl(){
+		InitializeCriticalSection(&mMutex);
+		InitializeConditionVariable(&mQueued);
+		InitializeConditionVariable(&mDone);
+	}
+	~Impl(){ DeleteCriticalSection(&mMutex); }
+	void lock(){ EnterCriticalSection(&mMutex); }
+	void unlock(){ LeaveCriticalSection(&mMutex); }
+	void waitQueued(){ SleepConditionVariableCS(&mQueued, &mMutex, INFINITE); }
+	void waitDone(){ SleepConditionVariableCS(&mDone, &mMutex, INFINITE); }
+	void signalQueued(){ WakeConditionVariable(&mQueued); }
+	void broadcastQueued(){ WakeAllConditionVariable(&mQueued); }
+	void broadcastDone(){ WakeAllConditionVariable(&mDone); }
+
+	CRITICAL_SECTION mMutex;
+	CONDITION_VARIABLE mQueued, mDone;
+};
+#else
+struct ImageLoader::Impl{
+	Impl(){
+		pthread_mutex_init(&mMutex, NULL);
+		pthread_cond_init(&mQueued, NULL);
+		pthread_cond_init(&mDone, NULL);
+	}
+	~Impl(){
+		pthread_cond_destroy(&mDone);
+		pthread_cond_destroy(&mQueued);
+		pthread_mutex_destroy(&mMutex);
+	}
+	void lock(){ pthread_mutex_lock(&mMutex); }
+	void unlock(){ pthread_mutex_unlock(&mMutex); }
+	void waitQueued(){ pthread_cond_wait(&mQueued, &mMutex); }
+	void waitDone(){ pthread_cond_wait(&mDone, &mMutex); }
+	void signalQueued(){ pthread_cond_signal(&mQueued); }
+	void broadcastQueued(){ pthread_cond_broadcast(&mQueued); }
+	void broadcastDone(){ pthread_cond_broadcast(&mDone); }
+
+	pthread_mutex_t mMutex;
+	pthread_cond_t mQueued, mDone;
+};
+#endif
+
+
+void ImageLoader::Request::wait() const {
+	if(!mLoader) return;
+	Impl& impl = *mLoader->mImpl;
+	impl.lock();
+	while(!ready()) impl.waitDone();
+	impl.unlock();
+}
+
+void ImageLoader::Worker::operator()(){
+	loader->decodeLoop();
+}
+
+
+ImageLoader::ImageLoader(int numThreads, int capacity)
+:	mHead(0), mTail(0), mRunning(true), mImpl(new Impl),
+	mWorkers(numThreads > 0 ? numThreads : 1),
+	mCacheSize(0), mCacheClock(0)
+{
+	long n = 1;
+	while(n < capacity) n <<= 1;
+	mQueue.assign(n, (Request *)0);
+	mMask = n-1;
+
+	for(int i=0; i<mWorkers.size(); ++i){
+		mWorkers.function(i).loader = this;
+	}
+	mWorkers.start(false);
+}
+
+ImageLoader::~ImageLoader(){
+	mImpl->lock();
+	storeRelease(mRunning, false);
+	mImpl->broadcastQueued();
+	mImpl->unlock();
+	mWorkers.join();
+	clearCache();
+	delete mImpl;
+}
+
+bool ImageLoader::load(Request& req, const std::string& path, Callback * cb){
+	if(std::find(mPending.begin(), mPending.end(), &req) != mPending.end()){
+		AL_WARN("image request for %s is still pending", req.mPath.c_str());
+		return false;
+	}
+
+	// Workers advance the head after reading a slot, so a slot is free once
+	// the head has passed it
+	long tail = mTail;
+	if(tail - loadAcquire(mHead) > mMask){
+		return false;
+	}
+
+	req.mPath = path;
+	req.mCallback = cb;
+	req.mLoader = this;
+	mPending.push_back(&req);
+
+	if(mCacheSize){
+		Cache::iterator it = mCache.find(path);
+		if(it != mCache.end()){
+			it->second.used = ++mCacheClock;
+			copy(req.mImage, *it->second.image);
+			storeRelease(req.mState, long(Request::LOADED));
+			return true;
+		}
+	}
+
+	// Create the decoder here, so that libraries are initialized on one thread
+	req.mImage.initImpl();
+	req.mState = Request::PENDING;
+	mQueue[tail & mMask] = &req;
+	storeRelease(mTail, tail+1);
+
+	// Signal under the lock so a worker cannot miss the request between
+	// finding the queue empty and going to sleep
+	mImpl->lock();
+	mImpl->signalQueued();
+	mImpl->unlock();
+	return true;
+}
+
+ImageLoader::Request * ImageLoader::take(){
+	for(;;){
+		long head = loadAcquire(mHead);
+		if(head == loadAcquire(mTail)) return 0;
+		Request * req = mQueue[head & mMask];
+		if(compareAndSwap(mHead, head, head+1)) return req;
+	}
+}
+
+void ImageLoader::finish(Request& req, bool ok){
+	mImpl->lock();
+	storeRelease(req.mState, long(ok ? Request::LOADED : Request::FAILED));
+	mImpl->broadcastDone();
+	mImpl->unlock();
+}
+
+void ImageLoader::decodeLoop(){
+	while(loadAcquire(mRunning)){
+		Request * req = take();
+		if(req){
+			finish(*req, req->mImage.load(req->mPath));
+		}
+		else{
+			mImpl->lock();
+			while(loadAcquire(mRunning) && loadAcquire(mHead) == loadAcquire(mTail)){
+				mImpl->waitQueued();
+			}
+			mImpl->unlock();
+		}
+	}
+}
+
+int ImageLoader::poll(){
+	int n = 0;
+	for(unsigned i=0; i<mPending.size(); ){
+		Request& req = *mPending[i];
+		if(req.ready()){
+			mPending.erase(mPending.begin() + i);
+			if(req.ok()) addToCache(req);
+			if(req.mCallback) req.mCallback->onImageLoaded(req);
+			++n;
+		}
+		else{
+			++i;
+		}
+	}
+	return n;
+}
+
+ImageLoader& ImageLoader::cacheSize(int n){
+	mCacheSize = n > 0 ? n : 0;
+	evict(mCacheSize);
+	return *this;
+}
+
+const Image * ImageLoader::cached(const std::string& path){
+	Cache::iterator it = mCache.find(path);
+	if(it == mCache.end()) return 0;
+	it->second.used = ++mCacheClock;
+	return it->second.image;
+}
+
+void ImageLoader::clearCache(){
+	evict(0);
+}
+
+void ImageLoader::addToCache(const Request& req){
+	if(0 == mCacheSize) return;
+	Cache::iterator it = mCache.find(req.mPath);
+	if(it == mCache.end()){
+		evict(mCacheSize-1);
+		CacheEntry e = { new Image, 0 };
+		it = mCache.insert(Cache::value_type(req.mPath, e)).first;
+	}
+	it->second.used = ++mCacheClock;
+	copy(*it->second.image, req.mImage);
+}
+
+void ImageLoader::evict(int maxSize){
+	while(int(mCache.size()) > maxSize){
+		Cache::iterator lru = mCache.begin();
+		for(Cache::iterator it = mCache.begin(); it != mCache.end(); ++it){
+			if(it->second.used < lru->second.used) lru = it;
+		}
+		delete lru->second.image;
+		mCache.erase(lru);
+	}
+}
+
+void ImageLoader::copy(Image& dst, const Image& src){
+	dst.mArray = src.mArray;	// reuses memory if the format is unchanged
+	dst.mFilename = src.mFilename;
+	dst.mLoaded = src.mLoaded;
+}
+
+} // al::
@@ -22,6 +22,41 @@ Mesh& Mesh::reset() {
 	return *this;
 }
 
+Mesh& Mesh::reserve(int nv, int ni, int attributes){
+	vertices().reserve(nv);
+	if(attributes & NORMAL)		normals().reserve(nv);
+	if(attributes & COLOR)		colors().reserve(nv);
+	if(attributes & COLORI)		coloris().reserve(nv);
+	if(attributes & TEXCOORD2)	texCoord2s().reserve(nv);
+	if(attributes & TEXCOORD3)	texCoord3s().reserve(nv);
+	indices().reserve(ni);
+	return *this;
+}
+
+namespace{
+
+// Extend buffer to hold n elements starting at an index
+template <class T>
+T * extendFrom(Buffer<T>& b, int begin, int n){
+	if(b.size() != begin) b.size(begin);
+	return b.extend(n);
+}
+
+} // ::
+
+Mesh::Span Mesh::addVertices(int n, int attributes){
+	Span s;
+	s.begin = vertices().size();
+	s.size = n;
+	s.vertices = vertices().extend(n);
+	s.normals = attributes & NORMAL ? extendFrom(normals(), s.begin, n) : 0;
+	s.colors = attributes & COLOR ? extendFrom(colors(), s.begin, n) : 0;
+	s.coloris = attributes & COLORI ? extendFrom(coloris(), s.begin, n) : 0;
+	s.texCoord2s = attributes & TEXCOORD2 ? extendFrom(texCoord2s(), s.begin, n) : 0;
+	s.texCoord3s = attributes & TEXCOORD3 ? extendFrom(texCoord3s(), s.begin, n) : 0;
+	return s;
+}
+
 void Mesh::decompress(){
 	int Ni = indices().size();
 	if(Ni){
@@ -0,0 +1,254 @@
+#include <math.h>
+#include "allocore/graphics/al_PolylineMesh.hpp"
+#include "allocore/graphics/al_Graphics.hpp"
+#include "allocore/math/al_Constants.hpp"
+#include "allocore/math/al_Functions.hpp"
+#include "allocore/system/al_ThreadPool.hpp"
+
+namespace al{
+
+namespace{
+
+const int B = 64;	// points per block of frames
+
+// Unit normals and binormals at a block of points
+struct Frames{
+	float nx[B], ny[B], nz[B];
+	float bx[B], by[B], bz[B];
+
+	// Compute frames at m points from the m+2 points starting one before them.
+	// This is the same frame as Mesh::ribbonize, with the binormal along the
+	// cross product of the backward and forward differences.
+	void compute(const Vec3f * p, int m){
+		float x[B+2], y[B+2], z[B+2];
+		for(int k=0; k<m+2; ++k){
+			x[k] = p[k][0]; y[k] = p[k][1]; z[k] = p[k][2];
+		}
+		for(int k=0; k<m; ++k){
+			const float ax = x[k+1]-x[k],   ay = y[k+1]-y[k],   az = z[k+1]-z[k];
+			const float fx = x[k+2]-x[k+1], fy = y[k+2]-y[k+1], fz = z[k+2]-z[k+1];
+			const float dx = ax+fx, dy = ay+fy, dz = az+fz;
+			float cx = ay*fz - az*fy, cy = az*fx - ax*fz, cz = ax*fy - ay*fx;
+			float s = invSqrt(cx*cx + cy*cy + cz*cz);
+			cx *= s; cy *= s; cz *= s;
+			float ux = dy*cz - dz*cy, uy = dz*cx - dx*cz, uz = dx*cy - dy*cx;
+			s = invSqrt(ux*ux + uy*uy + uz*uz);
+			nx[k] = ux*s; ny[k] = uy*s; nz[k] = uz*s;
+			bx[k] = cx; by[k] = cy; bz[k] = cz;
+		}
+	}
+};
+
+// Writes the vertices and normals of one line
+struct Emitter{
+	const Vec3f * pts;		// points of line
+	const float * widths;	// width factors of line, or null
+	float * verts;			// first vertex of line
+	float * norms;			// first normal of line
+	float width;
+
+	// Width of count points starting at point j
+	void halfWidths(float * h, int j, int count) const {
+		if(widths)	for(int c=0; c<count; ++c) h[c] = width * widths[j+c];
+		else		for(int c=0; c<count; ++c) h[c] = width;
+	}
+
+	// Two vertices per point, offset along the edge direction (ex,ey,ez) and
+	// both facing (sx,sy,sz)
+	void ribbon(
+		const float * ex, const float * ey, const float * ez,
+		const float * sx, const float * sy, const float * sz,
+		int k, int j, int count
+	) const {
+		float h[B];
+		halfWidths(h, j, count);
+		const float * p = &pts[j][0];
+		float * v = verts + 6*j;
+		float * u = norms + 6*j;
+		for(int c=0; c<count; ++c){
+			const float ox = ex[k+c]*h[c], oy = ey[k+c]*h[c], oz = ez[k+c]*h[c];
+			const float px = p[3*c], py = p[3*c+1], pz = p[3*c+2];
+			v[6*c  ] = px - ox; v[6*c+1] = py - oy; v[6*c+2] = pz - oz;
+			v[6*c+3] = px + ox; v[6*c+4] = py + oy; v[6*c+5] = pz + oz;
+			u[6*c  ] = u[6*c+3] = sx[k+c];
+			u[6*c+1] = u[6*c+4] = sy[k+c];
+			u[6*c+2] = u[6*c+5] = sz[k+c];
+		}
+	}
+
+	// One ring of vertices per point, the ring directions being the normal
+	// rotated towards the binormal
+	void tube(const Frames& f, const float * cs, const float * sn, int sides, int k, int j, int count) const {
+		float h[B];
+		halfWidths(h, j, count);
+		for(int c=0; c<count; ++c){
+			const float nx = f.nx[k+c], ny = f.ny[k+c], nz = f.nz[k+c];
+			const float bx = f.bx[k+c], by = f.by[k+c], bz = f.bz[k+c];
+			const float px = pts[j+c][0], py = pts[j+c][1], pz = pts[j+c][2];
+			const float r = h[c];
+			float * v = verts + 3*sides*(j+c);
+			float * u = norms + 3*sides*(j+c);
+			for(int s=0; s<sides; ++s){
+				const float ux = cs[s]*nx + sn[s]*bx;
+				const float uy = cs[s]*ny + sn[s]*by;
+				const float uz = cs[s]*nz + sn[s]*bz;
+				u[3*s] = ux; u[3*s+1] = uy; u[3*s+2] = uz;
+				v[3*s] = px + ux*r; v[3*s+1] = py + uy*r; v[3*s+2] = pz + uz*r;
+			}
+		}
+	}
+};
+
+} // ::
+
+
+struct PolylineMesher::Generate{
+	const PolylineMesher * mesher;
+	Mesh * mesh;
+	const Polylines * lines;
+	void operator()(int begin, int end){
+		mesher->generate(*mesh, *lines, begin, end);
+	}
+};
+
+
+PolylineMesher::PolylineMesher()
+:	mWidth(0.04), mFaceBinormal(false), mTubes(false)
+{
+	sides(8);
+	mVertexStarts.assign(1, 0);
+	mIndexStarts.assign(1, 0);
+}
+
+PolylineMesher& PolylineMesher::sides(int v){
+	mSides = v < 3 ? 3 : v;
+	mCos.resize(mSides);
+	mSin.resize(mSides);
+	for(int s=0; s<mSides; ++s){
+		double a = M_2PI * s / mSides;
+		mCos[s] = cos(a);
+		mSin[s] = sin(a);
+	}
+	return *this;
+}
+
+// Every line with n >= 3 points has n-1 segments, each made of two triangles
+// for ribbons or two per side for tubes
+void PolylineMesher::layout(Mesh& m, const Polylines& lines, bool tubes){
+	mTubes = tubes;
+	const int vertsPerPoint = tubes ? mSides : 2;
+	const int indicesPerSegment = tubes ? 6*mSides : 6;
+	const int N = lines.size();
+	mVertexStarts.resize(N+1);
+	mIndexStarts.resize(N+1);
+	mVertexStarts[0] = mIndexStarts[0] = 0;
+	for(int i=0; i<N; ++i){
+		int n = lines.size(i);
+		if(n < 3) n = 0;
+		mVertexStarts[i+1] = mVertexStarts[i] + n*vertsPerPoint;
+		mIndexStarts[i+1] = mIndexStarts[i] + (n ? n-1 : 0)*indicesPerSegment;
+	}
+	m.reset();
+	m.vertices().size(mVertexStarts[N]);
+	m.normals().size(mVertexStarts[N]);
+	m.indices().size(mIndexStarts[N]);
+	m.primitive(Graphics::TRIANGLES);
+}
+
+void PolylineMesher::generate(Mesh& m, const Polylines& lines, int begin, int end) const {
+	Frames f;
+	const int S = mSides;
+
+	for(int l=begin; l<end; ++l){
+		const int n = lines.size(l);
+		if(n < 3) continue;
+		const int first = lines.starts[l];
+		const int v0 = mVertexStarts[l];
+
+		Emitter e;
+		e.pts = &lines.points[first];
+		e.widths = lines.widths.empty() ? 0 : &lines.widths[first];
+		e.verts = &m.vertices()[v0][0];
+		e.norms = &m.normals()[v0][0];
+		e.width = mWidth;
+
+		// Ribbons facing the binormal have their edges along the normal
+		const float *ex=f.bx, *ey=f.by, *ez=f.bz, *sx=f.nx, *sy=f.ny, *sz=f.nz;
+		if(mFaceBinormal){
+			ex=f.nx; ey=f.ny; ez=f.nz; sx=f.bx; sy=f.by; sz=f.bz;
+		}
+
+		// Interior points in blocks; end points take the frame of their neighbor
+		for(int i=1; i<n-1; i+=B){
+			const int cnt = n-1-i < B ? n-1-i : B;
+			f.compute(e.pts + i-1, cnt);
+			if(mTubes){
+				if(1 == i) e.tube(f, &mCos[0], &mSin[0], S, 0, 0, 1);
+				e.tube(f, &mCos[0], &mSin[0], S, 0, i, cnt);
+				if(n-1 == i+cnt) e.tube(f, &mCos[0], &mSin[0], S, cnt-1, n-1, 1);
+			}
+			else{
+				if(1 == i) e.ribbon(ex,ey,ez, sx,sy,sz, 0, 0, 1);
+				e.ribbon(ex,ey,ez, sx,sy,sz, 0, i, cnt);
+				if(n-1 == i+cnt) e.ribbon(ex,ey,ez, sx,sy,sz, cnt-1, n-1, 1);
+			}
+		}
+
+		// Triangles are wound counterclockwise when seen from the side their
+		// normals face
+		Mesh::Index * ind = &m.indices()[mIndexStarts[l]];
+		if(mTubes){
+			for(int j=0; j<n-1; ++j){
+				Mesh::Index * t = ind + 6*S*j;
+				const Mesh::Index a0 = v0 + S*j;
+				for(int s=0; s<S; ++s){
+					const Mesh::Index a = a0 + s;
+					const Mesh::Index b = s+1 < S ? a+1 : a0;
+					t[6*s  ] = a; t[6*s+1] = a+S; t[6*s+2] = b;
+					t[6*s+3] = b; t[6*s+4] = a+S; t[6*s+5] = b+S;
+				}
+			}
+		}
+		else{
+			// The edge and facing directions swap roles, which flips the winding
+			const int o = mFaceBinormal ? 1 : 2;
+			for(int j=0; j<n-1; ++j){
+				const Mesh::Index a = v0 + 2*j;
+				Mesh::Index * t = ind + 6*j;
+				t[0] = a; t[1] = a+o; t[2] = a+3-o;
+				t[3] = a+1; t[4] = a+4-o; t[5] = a+1+o;
+			}
+		}
+	}
+}
+
+void PolylineMesher::generate(Mesh& m, const Polylines& lines, ThreadPool& pool) const {
+	// Aim for a few thousand points per piece of work
+	const int N = lines.size();
+	const double pointsPerLine = double(lines.points.size()) / (N ? N : 1);
+	const int grain = 1 + int(2048. / (pointsPerLine + 1.));
+	Generate body = { this, &m, &lines };
+	pool.parallelFor(0, N, body, grain);
+}
+
+void PolylineMesher::ribbons(Mesh& m, const Polylines& lines){
+	layout(m, lines, false);
+	generate(m, lines, 0, lines.size());
+}
+
+void PolylineMesher::ribbons(Mesh& m, const Polylines& lines, ThreadPool& pool){
+	layout(m, lines, false);
+	generate(m, lines, pool);
+}
+
+void PolylineMesher::tubes(Mesh& m, const Polylines& lines){
+	layout(m, lines, true);
+	generate(m, lines, 0, lines.size());
+}
+
+void PolylineMesher::tubes(Mesh& m, const Polylines& lines, ThreadPool& pool){
+	layout(m, lines, true);
+	generate(m, lines, pool);
+}
+
+} // al::
@@ -6,6 +6,10 @@
 
 #include "portaudio.h"
 #include "allocore/io/al_AudioIO.hpp"
+#include "allocore/system/al_Atomic.hpp"
+#include "allocore/system/al_Thread.hpp"
+#include "allocore/system/al_Time.h"
+#include "allocore/types/al_Conversion.hpp"
 
 namespace al{
 
@@ -35,6 +39,18 @@ static int resize(T *& buf, int n){
 template <class T>
 static inline void zero(T * buf, int n){ memset(buf, 0, n*sizeof(T)); }
 
+static inline bool bigEndian(){
+	const unsigned short v = 1;
+	return 0 == *(const char *)&v;
+}
+
+static void serializeToBigEndian(char * out, unsigned in){
+	out[0] = in>>24;
+	out[1] = in>>16;
+	out[2] = in>> 8;
+	out[3] = in;
+}
+
 template <class T>
 static void deinterleave(T * dst, const T * src, int numFrames, int numChannels){
 	int numSamples = numFrames * numChannels;
@@ -55,6 +71,68 @@ static void interleave(T * dst, const T * src, int numFrames, int numChannels){
 	}
 }
 
+// Output post-processing of one sample: gain, NaN removal and clipping
+template <bool Gain, bool ZeroNANs, bool Clip>
+static inline float postSample(float s, float gain){
+	if(Gain) s *= gain;
+	if(ZeroNANs) s = (s != s) ? 0.f : s; // portable isnan; only nans do not equal themselves
+	if(Clip){
+		s = s < -1.f ? -1.f : s;
+		s = s >  1.f ?  1.f : s;
+	}
+	return s;
+}
+
+// Apply post-processing to non-interleaved output buffers in place and
+// interleave them into dst in a single pass. Channels are taken four at a
+// time so that each frame writes a contiguous run of dst.
+template <bool Gain, bool ZeroNANs, bool Clip>
+static void postProcessOut(
+	float * dst, float * src, int numFrames, int numChannels, float gain0, float dgain
+){
+	int c = 0;
+	for(; c+4 <= numChannels; c+=4){
+		float * s0 = src + (c  )*numFrames;
+		float * s1 = src + (c+1)*numFrames;
+		float * s2 = src + (c+2)*numFrames;
+		float * s3 = src + (c+3)*numFrames;
+		float * d = dst + c;
+		float gain = gain0;
+		for(int i=0; i<numFrames; ++i){
+			d[0] = s0[i] = postSample<Gain,ZeroNANs,Clip>(s0[i], gain);
+			d[1] = s1[i] = postSample<Gain,ZeroNANs,Clip>(s1[i], gain);
+			d[2] = s2[i] = postSample<Gain,ZeroNANs,Clip>(s2[i], gain);
+			d[3] = s3[i] = postSample<Gain,ZeroNANs,Clip>(s3[i], gain);
+			d += numChannels;
+			gain += dgain;
+		}
+	}
+	for(; c < numChannels; ++c){
+		float * s0 = src + c*numFrames;
+		float * d = dst + c;
+		float gain = gain0;
+		for(int i=0; i<numFrames; ++i){
+			*d = s0[i] = postSample<Gain,ZeroNANs,Clip>(s0[i], gain);
+			d += numChannels;
+			gain += dgain;
+		}
+	}
+}
+
+static void postProcessOut(
+	float * dst, float * src, int numFrames, int numChannels,
+	bool gain, float gain0, float dgain, bool zeroNANs, bool clip
+){
+	#define CASE(g,n,c)\
+		if(gain==g && zeroNANs==n && clip==c){\
+			postProcessOut<g,n,c>(dst, src, numFrames, numChannels, gain0, dgain);\
+			return;\
+		}
+	CASE(0,0,0) CASE(0,0,1) CASE(0,1,0) CASE(0,1,1)
+	CASE(1,0,0) CASE(1,0,1) CASE(1,1,0) CASE(1,1,1)
+	#undef CASE
+}
+
 
 //==============================================================================
 AudioDevice::AudioDevice(int deviceNum)
@@ -154,8 +232,19 @@ void AudioDevice::printAll(){
 
 
 //==============================================================================
+struct OfflineThread : public ThreadFunction{
+	AudioIO * io;
+	void operator()();
+};
+
 struct AudioIOData::Impl{
-	Impl(): mStream(0), mErrNum(0), mIsOpen(false), mIsRunning(false){}
+	Impl()
+	:	mStream(0), mErrNum(0), mIsOpen(false), mIsRunning(false),
+		mOffline(false), mOfflineSpeed(0),
+		mOutMem(0), mOutMemFrames(0), mInMem(0), mInMemFrames(0), mInPos(0),
+		mOutFile(0), mOutFileStarted(false), mOutFileBytes(0), mOutFrames(0),
+		mFrames(0), mProcessNsec(0), mThreadRun(false)
+	{}
 
 	bool error() const { return mErrNum != paNoError; }
 
@@ -166,6 +255,7 @@ struct AudioIOData::Impl{
 	}
 
 	bool supportsFPS(double fps) const {
+		if(mOffline) return fps > 0;
 		const PaStreamParameters * pi = mInParams.channelCount  == 0 ? 0 : &mInParams;
 		const PaStreamParameters * po = mOutParams.channelCount == 0 ? 0 : &mOutParams;
 		mErrNum = Pa_IsFormatSupported(pi, po, fps);
@@ -180,6 +270,12 @@ struct AudioIOData::Impl{
 
 	bool close(){
 		mErrNum = paNoError;
+		if(mOffline){
+			stop();
+			closeFile();
+			mIsOpen = false;
+			return true;
+		}
 		if(mIsOpen) mErrNum = Pa_CloseStream(mStream);
 		if(paNoError == mErrNum){
 			mIsOpen = false;
@@ -190,16 +286,56 @@ struct AudioIOData::Impl{
 
 	bool stop(){
 		mErrNum = paNoError;
+		if(mOffline){
+			if(mIsRunning){
+				storeRelease(mThreadRun, false);
+				mThread.join();
+				mIsRunning = false;
+			}
+			return true;
+		}
 		if(mIsRunning)				mErrNum = Pa_StopStream(mStream);
 		if(paNoError == mErrNum)	mIsRunning = false;
 		return paNoError == mErrNum;
 	}
 
+	// Complete the AU header with the data size and close the output file
+	void closeFile(){
+		if(!mOutFile) return;
+		if(mOutFileStarted && mOutFileBytes < 0xffffffffull){
+			char size[4];
+			serializeToBigEndian(size, (unsigned)mOutFileBytes);
+			fseek(mOutFile, 8, SEEK_SET);
+			fwrite(size, 1, 4, mOutFile);
+		}
+		fclose(mOutFile);
+		mOutFile = 0;
+	}
+
 	PaStreamParameters mInParams, mOutParams;	// Input and output stream parameters
 	PaStream * mStream;					// i/o stream
 	mutable PaError mErrNum;			// Most recent error number
 	bool mIsOpen;						// An audio device is open
 	bool mIsRunning;					// An audio stream is running
+
+	// Offline backend
+	bool mOffline;
+	double mOfflineSpeed;				// multiple of real time; 0 is as fast as possible
+	float * mOutMem;					// interleaved output memory
+	int mOutMemFrames;
+	const float * mInMem;				// interleaved input memory
+	int mInMemFrames;
+	int mInPos;							// next frame of input memory
+	FILE * mOutFile;
+	bool mOutFileStarted;				// header has been written
+	unsigned long long mOutFileBytes;	// bytes of sample data written
+	volatile int mOutFrames;			// frames written to output memory or file
+	std::vector<float> mDevI, mDevO;	// interleaved "device" buffers
+	unsigned long long mFrames;			// frames rendered since opening
+	al_nsec mProcessNsec;				// time spent processing since opening
+	Thread mThread;
+	OfflineThread mThreadFunc;
+	volatile bool mThreadRun;
 };
 
 AudioIOData::AudioIOData(void * userData)
@@ -227,7 +363,10 @@ int AudioIOData::channelsInDevice() const { return (int)mImpl->mInParams.channel
 int AudioIOData::channelsOutDevice() const { return (int)mImpl->mOutParams.channelCount; }
 
 double AudioIOData::framesPerSecond() const { return mFramesPerSecond; }
-double AudioIOData::time() const { return Pa_GetStreamTime(mImpl->mStream); }
+double AudioIOData::time() const {
+	if(mImpl->mOffline) return mImpl->mFrames / framesPerSecond();
+	return Pa_GetStreamTime(mImpl->mStream);
+}
 double AudioIOData::time(int frame) const { return (double)frame / framesPerSecond() + time(); }
 int AudioIOData::framesPerBuffer() const { return mFramesPerBuffer; }
 double AudioIOData::secondsPerBuffer() const { return (double)framesPerBuffer() / framesPerSecond(); }
@@ -243,12 +382,15 @@ static int paCallback(	const void *input,
 
 AudioIO::AudioIO(
 	int framesPerBuf, double framesPerSec, void (* callbackA)(AudioIOData &), void * userData,
-	int outChansA, int inChansA)
+	int outChansA, int inChansA, Backend backendA)
 :	AudioIOData(userData),
 	callback(callbackA),
 	mInDevice(AudioDevice::defaultInput()), mOutDevice(AudioDevice::defaultOutput()),
+	mBackend(backendA),
 	mZeroNANs(true), mClipOut(true), mAutoZeroOut(true)
 {
+	mImpl->mOffline = OFFLINE == mBackend;
+	mImpl->mThreadFunc.io = this;
 	init();
 	this->framesPerBuffer(framesPerBuf);
 	channels(inChansA, false);
@@ -265,8 +407,10 @@ AudioIO::~AudioIO(){
 void AudioIO::init(){
 
 	// Choose default devices for now...
-	deviceIn(AudioDevice::defaultInput());
-	deviceOut(AudioDevice::defaultOutput());
+	if(PORTAUDIO == mBackend){
+		deviceIn(AudioDevice::defaultInput());
+		deviceOut(AudioDevice::defaultOutput());
+	}
 
 //	inDevice(defaultInDevice());
 //	outDevice(defaultOutDevice());
@@ -367,6 +511,17 @@ void AudioIO::channels(int num, bool forOutput){
 		return;
 	}
 
+	// The offline device has as many channels as requested
+	if(OFFLINE == mBackend){
+		if(num == -1) num = channels(forOutput);
+		if(num != channels(forOutput)){
+			forOutput ? mNumO = num : mNumI = num;
+			resizeBuffer(forOutput);
+		}
+		params->channelCount = num;
+		return;
+	}
+
 	const PaDeviceInfo * info = Pa_GetDeviceInfo(params->device);
 	if(0 == info){
 		if(forOutput)	warn("attempt to set number of channels on invalid output device", "AudioIO");
@@ -402,6 +557,18 @@ bool AudioIO::open(){
 
 	i.mErrNum = paNoError;
 
+	if(OFFLINE == mBackend){
+		if(!i.mIsOpen){
+			// Buffers have at least one sample so they can always be indexed
+			i.mDevI.assign(channelsInDevice() * framesPerBuffer() + 1, 0.f);
+			i.mDevO.assign(channelsOutDevice() * framesPerBuffer() + 1, 0.f);
+			i.mFrames = 0;
+			i.mProcessNsec = 0;
+			i.mIsOpen = true;
+		}
+		return true;
+	}
+
 	if(!(i.mIsOpen || i.mIsRunning)){
 
 		PaStreamParameters * inParams = &i.mInParams;
@@ -431,19 +598,8 @@ bool AudioIO::open(){
 }
 
 
-int paCallback(
-	const void *input,
-	void *output,
-	unsigned long frameCount,
-	const PaStreamCallbackTimeInfo* timeInfo,
-	PaStreamCallbackFlags statusFlags,
-	void * userData
-){
-	AudioIO& io = *(AudioIO *)userData;
-
-	const float * paI = (const float *)input;
-	float * paO = (float *)output;
-
+// Process one buffer from and to interleaved device buffers
+static void processBuffer(AudioIO& io, const float * paI, float * paO){
 	bool bDeinterleave = true;
 
 	if(bDeinterleave){
@@ -457,46 +613,152 @@ int paCallback(
 	io.processAudio();	// call callback
 
 
-	// apply smoothly-ramped gain to all output channels
-	if(io.usingGain()){
+	// Apply smoothly-ramped gain to all output channels, kill pesky nans so
+	// we don't hurt anyone's ears, clip and interleave, all in one pass
+	bool usingGain = io.usingGain();
+	float dgain = (io.mGain-io.mGainPrev) / io.framesPerBuffer();
 
-		float dgain = (io.mGain-io.mGainPrev) / io.framesPerBuffer();
+	if(bDeinterleave){
+		postProcessOut(
+			paO, &io.out(0,0), io.framesPerBuffer(), io.channelsOutDevice(),
+			usingGain, io.mGainPrev, dgain, io.zeroNANs(), io.clipOut()
+		);
+	}
 
-		for(int j=0; j<io.channelsOutDevice(); ++j){
-			float * out = io.outBuffer(j);
-			float gain = io.mGainPrev;
+	if(usingGain) io.mGainPrev = io.mGain;
+}
 
-			for(int i=0; i<io.framesPerBuffer(); ++i){
-				out[i] *= gain;
-				gain += dgain;
-			}
-		}
+int paCallback(
+	const void *input,
+	void *output,
+	unsigned long frameCount,
+	const PaStreamCallbackTimeInfo* timeInfo,
+	PaStreamCallbackFlags statusFlags,
+	void * userData
+){
+	AudioIO& io = *(AudioIO *)userData;
+	processBuffer(io, (const float *)input, (float *)output);
+	return 0;
+}
 
-		io.mGainPrev = io.mGain;
-	}
 
-	// kill pesky nans so we don't hurt anyone's ears
-	if(io.zeroNANs()){
-		for(int i=0; i<io.framesPerBuffer()*io.channelsOutDevice(); ++i){
-			float& s = (&io.out(0,0))[i];
-			//if(isnan(s)) s = 0.f;
-			if(s != s) s = 0.f; // portable isnan; only nans do not equal themselves
+bool AudioIO::renderBuffer(){
+	Impl& i = *mImpl;
+	const int N = framesPerBuffer();
+	const int ci = channelsInDevice();
+	const int co = channelsOutDevice();
+
+	if(i.mOutMem && i.mOutFrames >= i.mOutMemFrames) return false;
+
+	float * bufI = &i.mDevI[0];
+	float * bufO = &i.mDevO[0];
+
+	int n = 0;
+	if(i.mInMem && i.mInPos < i.mInMemFrames){
+		n = min(N, i.mInMemFrames - i.mInPos);
+		memcpy(bufI, i.mInMem + i.mInPos*ci, n*ci*sizeof(float));
+		i.mInPos += n;
+	}
+	zero(bufI + n*ci, (N-n)*ci);
+
+	al_nsec t0 = al_time_nsec();
+	processBuffer(*this, bufI, bufO);
+	i.mProcessNsec += al_time_nsec() - t0;
+	i.mFrames += N;
+
+	if(i.mOutMem){
+		n = min(N, i.mOutMemFrames - i.mOutFrames);
+		memcpy(i.mOutMem + i.mOutFrames*co, bufO, n*co*sizeof(float));
+		storeRelease(i.mOutFrames, i.mOutFrames + n);
+	}
+	else if(i.mOutFile){
+		if(!i.mOutFileStarted){
+			// AU header: magic, data offset, data size (unknown until closed),
+			// sample type (6=float), sample rate, channels
+			char hdr[24] =
+				{'.','s','n','d', 0,0,0,24, -1,-1,-1,-1, 0,0,0,6, 0,0,0,0, 0,0,0,0};
+			serializeToBigEndian(hdr + 16, unsigned(framesPerSecond()));
+			serializeToBigEndian(hdr + 20, unsigned(co));
+			fwrite(hdr, 1, sizeof(hdr), i.mOutFile);
+			i.mOutFileStarted = true;
 		}
+		if(!bigEndian()) swapBytes(bufO, N*co);
+		fwrite(bufO, sizeof(float), N*co, i.mOutFile);
+		i.mOutFileBytes += N*co*sizeof(float);
+		storeRelease(i.mOutFrames, i.mOutFrames + N);
+	}
+	else{
+		storeRelease(i.mOutFrames, i.mOutFrames + N);
 	}
+	return true;
+}
 
-	if(io.clipOut()){
-		for(int i=0; i<io.framesPerBuffer()*io.channelsOutDevice(); ++i){
-			float& s = (&io.out(0,0))[i];
-			if		(s<-1.f) s =-1.f;
-			else if	(s> 1.f) s = 1.f;
+int AudioIO::render(int numFrames){
+	if(OFFLINE != mBackend || mImpl->mIsRunning || !open()) return 0;
+	int frames = 0;
+	while(frames < numFrames && renderBuffer()) frames += framesPerBuffer();
+	return frames;
+}
+
+void OfflineThread::operator()(){
+	AudioIOData::Impl& i = *io->mImpl;
+	al_sec t0 = al_time();
+	unsigned long long n = 0;
+	while(loadAcquire(i.mThreadRun) && io->renderBuffer()){
+		// Pace against the start time so that timing errors do not accumulate
+		if(i.mOfflineSpeed > 0){
+			++n;
+			al_sleep_until(t0 + n * io->secondsPerBuffer() / i.mOfflineSpeed);
 		}
 	}
+}
 
-	if(bDeinterleave){
-		interleave(paO, &io.out(0,0), io.framesPerBuffer(), io.channelsOutDevice());
+AudioIO& AudioIO::offlineOutput(float * buf, int numFrames){
+	mImpl->closeFile();
+	mImpl->mOutMem = buf;
+	mImpl->mOutMemFrames = buf ? numFrames : 0;
+	mImpl->mOutFrames = 0;
+	return *this;
+}
+
+bool AudioIO::offlineOutput(const std::string& path){
+	offlineOutput(0, 0);
+	mImpl->mOutFile = fopen(path.c_str(), "wb");
+	mImpl->mOutFileStarted = false;
+	mImpl->mOutFileBytes = 0;
+	if(!mImpl->mOutFile){
+		warn("could not open offline output file", "AudioIO");
+		return false;
 	}
+	return true;
+}
 
-	return 0;
+AudioIO& AudioIO::offlineInput(const float * buf, int numFrames){
+	mImpl->mInMem = buf;
+	mImpl->mInMemFrames = buf ? numFrames : 0;
+	mImpl->mInPos = 0;
+	return *this;
+}
+
+AudioIO& AudioIO::offlineSpeed(double v){
+	mImpl->mOfflineSpeed = v > 0 ? v : 0;
+	return *this;
+}
+
+int AudioIO::offlineFrames() const { return loadAcquire(mImpl->mOutFrames); }
+
+void AudioIO::backend(Backend v){
+	if(v == mBackend) return;
+	close();
+	mBackend = v;
+	mImpl->mOffline = OFFLINE == mBackend;
+
+	// Reopen the same number of effective channels on the new backend
+	int numI = mNumI, numO = mNumO;
+	mNumI = mNumO = 0;
+	init();
+	channels(numI, false);
+	channels(numO, true);
 }
 
 
@@ -547,6 +809,13 @@ void AudioIO::framesPerBuffer(int n){
 bool AudioIO::start(){
 	Impl& i = *mImpl;
 	i.mErrNum = paNoError;
+	if(OFFLINE == mBackend){
+		if(!i.mIsRunning && open()){
+			i.mThreadRun = true;
+			i.mIsRunning = i.mThread.start(i.mThreadFunc);
+		}
+		return i.mIsRunning;
+	}
 	if(!i.mIsOpen) open();
 	if(i.mIsOpen && !i.mIsRunning)	i.mErrNum = Pa_StartStream(i.mStream);
 	if(paNoError == i.mErrNum)	mImpl->mIsRunning = true;
@@ -559,7 +828,12 @@ bool AudioIO::stop(){ return mImpl->stop(); }
 bool AudioIO::supportsFPS(double fps) const { return mImpl->supportsFPS(fps); }
 
 void AudioIO::print(){
-	if(mInDevice.id() == mOutDevice.id()){
+	if(OFFLINE == mBackend){
+		printf("Device:      offline, ");
+		if(mImpl->mOfflineSpeed > 0)	printf("%gx real time\n", mImpl->mOfflineSpeed);
+		else							printf("as fast as possible\n");
+	}
+	else if(mInDevice.id() == mOutDevice.id()){
 		printf("I/O Device:  "); mInDevice.print();
 	}
 	else{
@@ -570,7 +844,7 @@ void AudioIO::print(){
 		printf("Chans In:    %d (%dD + %dV)\n", channelsIn(), channelsInDevice(), channelsIn() - channelsInDevice());
 		printf("Chans Out:   %d (%dD + %dV)\n", channelsOut(), channelsOutDevice(), channelsOut() - channelsOutDevice());
 
-	const PaStreamInfo * sInfo = Pa_GetStreamInfo(mImpl->mStream);
+	const PaStreamInfo * sInfo = mImpl->mOffline ? 0 : Pa_GetStreamInfo(mImpl->mStream);
 	if(sInfo){
 		printf("In Latency:  %.0f ms\nOut Latency: %0.f ms\nSample Rate: %0.f Hz\n",
 			sInfo->inputLatency * 1000., sInfo->outputLatency * 1000., sInfo->sampleRate);
@@ -592,7 +866,14 @@ void AudioIO::processAudio(){
 }
 
 int AudioIO::channels(bool forOutput) const { return forOutput ? channelsOut() : channelsIn(); }
-double AudioIO::cpu() const { return Pa_GetStreamCpuLoad(mImpl->mStream); }
+double AudioIO::cpu() const {
+	if(OFFLINE == mBackend){
+		// Fraction of real time spent processing
+		const Impl& i = *mImpl;
+		return i.mFrames ? i.mProcessNsec * al_time_ns2s * framesPerSecond() / i.mFrames : 0;
+	}
+	return Pa_GetStreamCpuLoad(mImpl->mStream);
+}
 bool AudioIO::zeroNANs() const { return mZeroNANs; }
 
 } // al::
@@ -28,8 +28,10 @@ You can actually use connect() on UDP socket as an option. In that case, you can
 #include "../private/al_ImplAPR.h"
 #ifdef AL_LINUX
 #include "apr-1.0/apr_network_io.h"
+#include "apr-1.0/apr_portable.h"
 #else
 #include "apr-1/apr_network_io.h"
+#include "apr-1/apr_portable.h"
 #endif
 
 #define PRINT_SOCKADDR(s)\
@@ -276,6 +278,12 @@ uint16_t Socket::port() const { return mImpl->mPort; }
 
 al_sec Socket::timeout() const { return mImpl->mTimeout; }
 
+int Socket::fileDescriptor() const {
+	apr_os_sock_t fd;
+	if(!mImpl->opened() || APR_SUCCESS != apr_os_sock_get(&fd, mImpl->mSock)) return -1;
+	return int(fd);
+}
+
 bool Socket::bind(){ return mImpl->bind(); }
 
 bool Socket::connect(){ return mImpl->connect(); }
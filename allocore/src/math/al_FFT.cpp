@@ -0,0 +1,130 @@
+#include <math.h>
+#include "allocore/math/al_FFT.hpp"
+
+namespace al{
+
+RFFT::RFFT(unsigned size)
+:	mSize(0)
+{
+	if(size) resize(size);
+}
+
+bool RFFT::resize(unsigned n){
+	if(n < 4 || (n & (n-1))) return false;
+	if(n == mSize) return true;
+	mSize = n;
+
+	const unsigned M = n/2;
+	mCos.resize(M);
+	mSin.resize(M);
+	for(unsigned k=0; k<M; ++k){
+		double ph = 2. * M_PI * k / n;
+		mCos[k] = cos(ph);
+		mSin[k] = sin(ph);
+	}
+
+	unsigned bits = 0;
+	while((1u<<bits) < M) ++bits;
+	mRev.resize(M);
+	for(unsigned i=0; i<M; ++i){
+		unsigned r = 0;
+		for(unsigned b=0; b<bits; ++b) r |= ((i>>b) & 1) << (bits-1-b);
+		mRev[i] = r;
+	}
+
+	mRe.resize(M);
+	mIm.resize(M);
+	return true;
+}
+
+// In-place radix-2 complex FFT of size/2 points (unscaled)
+void RFFT::fft(float * re, float * im, bool inverse) const {
+	const unsigned M = mSize/2;
+
+	for(unsigned i=0; i<M; ++i){
+		unsigned j = mRev[i];
+		if(i < j){
+			float t;
+			t = re[i]; re[i] = re[j]; re[j] = t;
+			t = im[i]; im[i] = im[j]; im[j] = t;
+		}
+	}
+
+	const float sgn = inverse ? 1.f : -1.f;
+	for(unsigned len=2; len<=M; len<<=1){
+		const unsigned half = len/2;
+		const unsigned step = mSize/len; // twiddle stride in units of 2 pi / size
+		for(unsigned j=0; j<half; ++j){
+			const float wr = mCos[j*step];
+			const float wi = sgn * mSin[j*step];
+			for(unsigned a=j; a<M; a+=len){
+				const unsigned b = a + half;
+				const float tr = re[b]*wr - im[b]*wi;
+				const float ti = re[b]*wi + im[b]*wr;
+				re[b] = re[a] - tr;
+				im[b] = im[a] - ti;
+				re[a] += tr;
+				im[a] += ti;
+			}
+		}
+	}
+}
+
+void RFFT::forward(float * re, float * im, const float * in){
+	const unsigned M = mSize/2;
+	float * zr = &mRe[0];
+	float * zi = &mIm[0];
+
+	// Pack even and odd samples as the real and imaginary parts of a half
+	// size complex sequence Z
+	for(unsigned k=0; k<M; ++k){
+		zr[k] = in[2*k];
+		zi[k] = in[2*k+1];
+	}
+	fft(zr, zi, false);
+
+	// Separate the spectra of the even (E) and odd (O) samples and combine:
+	// X[k] = E[k] + exp(-i 2 pi k / size) O[k]
+	re[0] = zr[0] + zi[0];
+	im[0] = 0;
+	re[M] = zr[0] - zi[0];
+	im[M] = 0;
+	for(unsigned k=1; k<M; ++k){
+		const float ar = zr[k],   ai = zi[k];
+		const float br = zr[M-k], bi =-zi[M-k];	// conj(Z[M-k])
+		const float er = 0.5f*(ar + br), ei = 0.5f*(ai + bi);
+		const float odr= 0.5f*(ai - bi), odi= 0.5f*(br - ar); // (Z[k] - conj(Z[M-k])) / 2i
+		const float wr = mCos[k], wi = -mSin[k];
+		re[k] = er + odr*wr - odi*wi;
+		im[k] = ei + odr*wi + odi*wr;
+	}
+}
+
+void RFFT::inverse(float * out, const float * re, const float * im){
+	const unsigned M = mSize/2;
+	float * zr = &mRe[0];
+	float * zi = &mIm[0];
+
+	// Z[k] = E[k] + i O[k], where
+	// E[k] = (X[k] + conj(X[M-k])) / 2 and
+	// O[k] = (X[k] - conj(X[M-k])) / 2 * exp(i 2 pi k / size)
+	for(unsigned k=0; k<M; ++k){
+		const float ar = re[k],   ai = k ? im[k] : 0;
+		const float br = re[M-k], bi = k ? -im[M-k] : 0;
+		const float er = 0.5f*(ar + br), ei = 0.5f*(ai + bi);
+		const float dr = 0.5f*(ar - br), di = 0.5f*(ai - bi);
+		const float wr = mCos[k], wi = mSin[k];
+		const float odr = dr*wr - di*wi, odi = dr*wi + di*wr;
+		zr[k] = er - odi;
+		zi[k] = ei + odr;
+	}
+	fft(zr, zi, true);
+
+	const float s = 1.f/M;
+	for(unsigned k=0; k<M; ++k){
+		out[2*k  ] = zr[k] * s;
+		out[2*k+1] = zi[k] * s;
+	}
+}
+
+} // al::
@@ -0,0 +1,222 @@
+#include <string.h>
+#include "allocore/math/al_Functions.hpp"
+#include "allocore/math/al_Random.hpp"
+
+namespace al{
+namespace rnd{
+
+namespace{
+
+const int L = BulkRandom::lanes;
+
+// The generator steps below are linear over GF(2), so any number of steps
+// of one component can be expressed as a 32x32 bit matrix. A matrix is
+// stored as its columns, i.e. the images of the single-bit states.
+struct BitMatrix{
+	uint32_t col[32];
+
+	uint32_t operator()(uint32_t x) const {
+		uint32_t r = 0;
+		for(int j=0; j<32; ++j){
+			if(x & (1u<<j)) r ^= col[j];
+		}
+		return r;
+	}
+
+	void square(){
+		BitMatrix m = *this;
+		for(int j=0; j<32; ++j) col[j] = m(m.col[j]);
+	}
+};
+
+// One step of a Tausworthe component
+inline uint32_t taus(uint32_t s, uint32_t mask, int a, int b, int c){
+	return ((s & mask) << a) ^ (((s << b) ^ s) >> c);
+}
+
+// Advance n states of one component by 2^log2Steps steps
+void jumpComponent(uint32_t * s, int n, int log2Steps, uint32_t mask, int a, int b, int c){
+	BitMatrix m;
+	for(int j=0; j<32; ++j) m.col[j] = taus(1u<<j, mask, a, b, c);
+	for(int k=0; k<log2Steps; ++k) m.square();
+	for(int i=0; i<n; ++i) s[i] = m(s[i]);
+}
+
+// Natural logarithm of a positive, normal number
+inline float logPos(float x){
+	int32_t i;
+	memcpy(&i, &x, 4);
+	int32_t e = (i >> 23) - 127;
+	i = (i & 0x007fffff) | 0x3f800000;	// mantissa in [1, 2)
+	// Move mantissa into [sqrt(1/2), sqrt(2)) so the series converges quickly
+	int32_t k = i > 0x3fb504f3;
+	i -= k << 23;
+	e += k;
+	float m;
+	memcpy(&m, &i, 4);
+	// log(m) = 2 atanh(s), s = (m-1)/(m+1)
+	float s = (m - 1.f)/(m + 1.f);
+	float s2 = s*s;
+	float p = 1.f + s2*(1.f/3 + s2*(1.f/5 + s2*(1.f/7 + s2*(1.f/9))));
+	return float(e)*0.69314718f + 2.f*s*p;
+}
+
+// Sine and cosine of an angle in [-pi/2, pi/2]
+inline float sinHalf(float x){
+	float x2 = x*x;
+	return x*(1.f + x2*(-1.f/6 + x2*(1.f/120 + x2*(-1.f/5040 + x2*(1.f/362880 + x2*(-1.f/39916800))))));
+}
+
+inline float cosHalf(float x){
+	float x2 = x*x;
+	return 1.f + x2*(-1.f/2 + x2*(1.f/24 + x2*(-1.f/720 + x2*(1.f/40320 + x2*(-1.f/3628800 + x2*(1.f/479001600))))));
+}
+
+// Unit float in (0, 1) from the upper 23 bits
+inline float unitOpen(uint32_t v){
+	return (float(int32_t(v >> 9)) + 0.5f) * (1.f/8388608.f);
+}
+
+// Direction of a random angle as a point on the unit circle. The upper bits
+// give an angle in the right half plane and the lowest bit mirrors it.
+inline void circle(uint32_t v, float& c, float& s){
+	float t = (unitOpen(v) - 0.5f) * float(M_PI);
+	c = cosHalf(t) * float(1 - 2*int32_t(v & 1));
+	s = sinHalf(t);
+}
+
+inline float maxf(float a, float b){ return a > b ? a : b; }
+
+// Copy the first n elements of a block; whole blocks are copied with a
+// constant size so the copy stays in registers
+template <class T, int N>
+inline void copyBlock(T * dst, const T (&src)[N], int n){
+	if(n >= N)	memcpy(dst, src, sizeof(src));
+	else		memcpy(dst, src, n*sizeof(T));
+}
+
+} // ::
+
+
+BulkRandom::BulkRandom(){ seed(al::rnd::seed()); }
+BulkRandom::BulkRandom(uint32_t sd){ seed(sd); }
+
+void BulkRandom::seed(uint32_t v){
+	LinCon g(v);
+	g();
+	// Same restrictions on initial states as Tausworthe::seed
+	for(int l=0; l<L; ++l){
+		uint32_t v1=g(), v2=g(), v3=g(), v4=g();
+		s1[l] = v1 & 0xffffffe ? v1 : ~v1;
+		s2[l] = v2 & 0xffffff8 ? v2 : ~v2;
+		s3[l] = v3 & 0xffffff0 ? v3 : ~v3;
+		s4[l] = v4 & 0xfffff80 ? v4 : ~v4;
+	}
+}
+
+BulkRandom& BulkRandom::jump(int log2Steps){
+	jumpComponent(s1, L, log2Steps, 0xfffffffe, 18,  6, 13);
+	jumpComponent(s2, L, log2Steps, 0xfffffff8,  2,  2, 27);
+	jumpComponent(s3, L, log2Steps, 0xfffffff0,  7, 13, 21);
+	jumpComponent(s4, L, log2Steps, 0xffffff80, 13,  3, 12);
+	return *this;
+}
+
+inline void BulkRandom::next(uint32_t * r){
+	for(int l=0; l<L; ++l){
+		uint32_t a = taus(s1[l], 0xfffffffe, 18,  6, 13);
+		uint32_t b = taus(s2[l], 0xfffffff8,  2,  2, 27);
+		uint32_t c = taus(s3[l], 0xfffffff0,  7, 13, 21);
+		uint32_t d = taus(s4[l], 0xffffff80, 13,  3, 12);
+		s1[l]=a; s2[l]=b; s3[l]=c; s4[l]=d;
+		r[l] = a ^ b ^ c ^ d;
+	}
+}
+
+// Each fill makes a block of numbers on the stack, where the compiler knows
+// they cannot alias the generator state, then copies out as many as needed.
+
+void BulkRandom::fill(uint32_t * out, int n){
+	uint32_t r[L];
+	for(int i=0; i<n; i+=L){
+		next(r);
+		copyBlock(out + i, r, n-i);
+	}
+}
+
+void BulkRandom::uniform(float * out, int n){
+	uint32_t r[L];
+	float f[L];
+	for(int i=0; i<n; i+=L){
+		next(r);
+		for(int l=0; l<L; ++l) r[l] = r[l] >> 9 | 0x3f800000;	// [1, 2)
+		memcpy(f, r, sizeof(f));
+		for(int l=0; l<L; ++l) f[l] -= 1.f;
+		copyBlock(out + i, f, n-i);
+	}
+}
+
+void BulkRandom::uniformS(float * out, int n){
+	uint32_t r[L];
+	float f[L];
+	for(int i=0; i<n; i+=L){
+		next(r);
+		for(int l=0; l<L; ++l) r[l] = r[l] >> 9 | 0x40000000;	// [2, 4)
+		memcpy(f, r, sizeof(f));
+		for(int l=0; l<L; ++l) f[l] -= 3.f;
+		copyBlock(out + i, f, n-i);
+	}
+}
+
+// Box-Muller transform using a pair of uniforms per pair of variates. The
+// radial uniform has 31 bits so the tails extend to about 6.6 deviations.
+void BulkRandom::normal(float * out, int n){
+	uint32_t a[L], b[L];
+	float f[2*L];
+	for(int i=0; i<n; i+=2*L){
+		next(a);
+		next(b);
+		for(int l=0; l<L; ++l){
+			float u = (float(int32_t(a[l] >> 1)) + 0.5f) * (1.f/2147483648.f);	// (0, 1]
+			float w = -2.f * logPos(u);
+			float r = w * invSqrt(w);
+			float c, s;
+			circle(b[l], c, s);
+			f[l  ] = r*c;
+			f[l+L] = r*s;
+		}
+		copyBlock(out + i, f, n-i);
+	}
+}
+
+// Points are made from a direction uniform on the sphere and a radius with
+// density proportional to r^2, which is that of the largest of three
+// uniforms.
+void BulkRandom::ball3(Vec3f * out, int n){
+	uint32_t rz[L], ra[L], r1[L], r2[L], r3[L];
+	float f[3*L];
+	for(int i=0; i<n; i+=L){
+		next(rz); next(ra); next(r1); next(r2); next(r3);
+		float x[L], y[L], z[L];
+		for(int l=0; l<L; ++l){
+			float h = (unitOpen(rz[l]) - 0.5f) * 2.f;	// height on sphere
+			float w = 1.f - h*h;
+			float rho = w * invSqrt(w);
+			float c, s;
+			circle(ra[l], c, s);
+			float rad = maxf(maxf(unitOpen(r1[l]), unitOpen(r2[l])), unitOpen(r3[l]));
+			x[l] = rad*rho*c;
+			y[l] = rad*rho*s;
+			z[l] = rad*h;
+		}
+		for(int l=0; l<L; ++l){
+			f[3*l  ] = x[l];
+			f[3*l+1] = y[l];
+			f[3*l+2] = z[l];
+		}
+		copyBlock(&out[i][0], f, 3*(n-i));
+	}
+}
+
+} // rnd::
+} // al::
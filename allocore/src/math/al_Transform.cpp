@@ -0,0 +1,106 @@
+#include "allocore/math/al_Functions.hpp"
+#include "allocore/math/al_Transform.hpp"
+
+namespace al{
+
+namespace{
+
+// Multiply n vectors by a column-major 3x3 matrix plus a translation. The
+// vectors are addressed as a flat array, which lets the compiler load and
+// store several of them per vector register.
+inline void affine(const float * m, const float * t, float * out, const float * in, int n){
+	const float m0=m[0], m1=m[1], m2=m[2], m3=m[3], m4=m[4], m5=m[5], m6=m[6], m7=m[7], m8=m[8];
+	const float t0=t[0], t1=t[1], t2=t[2];
+	for(int i=0; i<n; ++i){
+		const float x=in[3*i], y=in[3*i+1], z=in[3*i+2];
+		out[3*i  ] = m0*x + m3*y + m6*z + t0;
+		out[3*i+1] = m1*x + m4*y + m7*z + t1;
+		out[3*i+2] = m2*x + m5*y + m8*z + t2;
+	}
+}
+
+inline void normalize(float * v, int n){
+	for(int i=0; i<n; ++i){
+		const float x=v[3*i], y=v[3*i+1], z=v[3*i+2];
+		// the estimate is finite for zero, so zero vectors stay zero
+		const float s = invSqrt(x*x + y*y + z*z);
+		v[3*i  ] = x*s;
+		v[3*i+1] = y*s;
+		v[3*i+2] = z*s;
+	}
+}
+
+// Upper-left 3x3 part of a column-major 4x4 matrix
+void upper3x3(float * r, const Mat4f& m){
+	for(int c=0; c<3; ++c){
+		for(int k=0; k<3; ++k) r[3*c+k] = m[4*c+k];
+	}
+}
+
+// Calls a kernel with the same pointer for input and output when they are
+// the same array, so the compiler can see that each vector only depends on
+// itself; otherwise it checks for overlap at run time
+template <class Kernel>
+void dispatch(Kernel k, float * out, const float * in, int n){
+	if(out == in)	k(out, out, n);
+	else			k(out, in, n);
+}
+
+struct Affine{
+	const float * m, * t;
+	Affine(const float * m_, const float * t_): m(m_), t(t_){}
+	void operator()(float * out, const float * in, int n) const { affine(m, t, out, in, n); }
+};
+
+} // ::
+
+
+void transformPoints(const Mat4f& m, Vec3f * out, const Vec3f * in, int n){
+	float r[9];
+	upper3x3(r, m);
+	const float t[3] = { m[12], m[13], m[14] };
+	dispatch(Affine(r, t), out[0].elems(), in[0].elems(), n);
+}
+
+void transformVectors(const Mat4f& m, Vec3f * out, const Vec3f * in, int n){
+	float r[9];
+	upper3x3(r, m);
+	const float t[3] = { 0.f, 0.f, 0.f };
+	dispatch(Affine(r, t), out[0].elems(), in[0].elems(), n);
+}
+
+void transformNormals(const Mat4f& m, Vec3f * out, const Vec3f * in, int n, bool normalize_){
+	float a[9];
+	upper3x3(a, m);
+
+	// The inverse transpose is the cofactor matrix divided by the determinant
+	float r[9];
+	r[0] = a[4]*a[8] - a[5]*a[7];
+	r[1] = a[5]*a[6] - a[3]*a[8];
+	r[2] = a[3]*a[7] - a[4]*a[6];
+	r[3] = a[2]*a[7] - a[1]*a[8];
+	r[4] = a[0]*a[8] - a[2]*a[6];
+	r[5] = a[1]*a[6] - a[0]*a[7];
+	r[6] = a[1]*a[5] - a[2]*a[4];
+	r[7] = a[2]*a[3] - a[0]*a[5];
+	r[8] = a[0]*a[4] - a[1]*a[3];
+
+	// Normalizing leaves only the sign of the determinant to apply
+	const float det = a[0]*r[0] + a[3]*r[3] + a[6]*r[6];
+	if(det != 0.f){
+		const float s = normalize_ ? (det < 0.f ? -1.f : 1.f) : 1.f/det;
+		for(int i=0; i<9; ++i) r[i] *= s;
+	}
+
+	const float t[3] = { 0.f, 0.f, 0.f };
+	dispatch(Affine(r, t), out[0].elems(), in[0].elems(), n);
+	if(normalize_) normalize(out[0].elems(), n);
+}
+
+void rotateVectors(const Quatf& q, Vec3f * out, const Vec3f * in, int n){
+	Mat4f m;
+	q.toMatrix(m.elems());
+	transformVectors(m, out, in, n);
+}
+
+} // al::
@@ -2,10 +2,52 @@
 #include "allocore/protocol/al_Serialize.h"
 
 #ifdef __cplusplus
+#include <algorithm>
 #include "allocore/protocol/al_Serialize.hpp"
 
 namespace al{
 
+Serializer::Serializer()
+:	mArena(0), mSize(0), mCapacity(0), mOverflow(false)
+{}
+
+Serializer::Serializer(char * arena, uint32_t capacity)
+:	mArena(arena), mSize(0), mCapacity(capacity), mOverflow(false)
+{}
+
+char * Serializer::alloc(uint32_t bytes){
+	if(mArena){
+		if(mSize + bytes > mCapacity){
+			mOverflow = true;
+			return 0;
+		}
+		return mArena + mSize;
+	}
+	// Grow geometrically so appends are amortized constant time
+	if(mSize + bytes > mBuf.capacity()){
+		mBuf.reserve(std::max<size_t>(mSize + bytes, 2*mBuf.capacity()));
+	}
+	mBuf.resize(mSize + bytes);
+	return &mBuf[mSize];
+}
+
+Serializer& Serializer::reserve(uint32_t bytes){
+	if(!mArena) mBuf.reserve(bytes);
+	return *this;
+}
+
+Serializer& Serializer::reset(){
+	mSize = 0;
+	mOverflow = false;
+	mBuf.clear();
+	return *this;
+}
+
+const char * Serializer::data() const {
+	if(mArena) return mArena;
+	return mBuf.empty() ? 0 : &mBuf[0];
+}
+
 Serializer& Serializer::operator<< (const char * v){
 	return add(v, strlen(v)+1);
 }
@@ -18,11 +60,17 @@ const std::vector<char>& Serializer::buf() const { return mBuf; }
 
 
 
-Deserializer::Deserializer(const std::vector<char>& b): mStart(0), mBuf(b){}
+// Copied data is only referred to through mBuf, so that copies of a
+// Deserializer read from their own buffers
+Deserializer::Deserializer(const std::vector<char>& b)
+:	mStart(0), mSize(b.size()), mData(0), mBuf(b)
+{}
 
-Deserializer::Deserializer(const char * b, uint32_t n)
-:	mStart(0)
-{	mBuf.insert(mBuf.begin(), b, b+n); }
+Deserializer::Deserializer(const char * b, uint32_t n, bool copy)
+:	mStart(0), mSize(n), mData(copy ? 0 : b)
+{
+	if(copy) mBuf.insert(mBuf.begin(), b, b+n);
+}
 
 Deserializer& Deserializer::operator>> (char * v){
 	uint32_t n = serDecode(bufDec(), v);
@@ -39,7 +87,10 @@ Deserializer& Deserializer::operator>> (std::string& v){
 
 const std::vector<char>& Deserializer::buf() const { return mBuf; }
 
-char * Deserializer::bufDec(){ return &mBuf[mStart]; }
+const char * Deserializer::bufDec(){
+	if(mData) return mData + mStart;
+	return mBuf.empty() ? 0 : &mBuf[0] + mStart;
+}
 
 } // al::
 #endif
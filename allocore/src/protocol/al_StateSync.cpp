@@ -0,0 +1,278 @@
+#include <algorithm>
+#include "allocore/protocol/al_StateSync.hpp"
+#include "allocore/system/al_Config.h"
+#include "allocore/system/al_Printing.hpp"
+#include "allocore/system/al_Time.h"
+
+#ifdef AL_WINDOWS
+	#include <winsock2.h>
+	#include <ws2tcpip.h>
+#else
+	#include <sys/socket.h>
+	#include <netinet/in.h>
+	#include <arpa/inet.h>
+#endif
+
+namespace al{
+
+// Datagram header; fields are in native byte order
+struct StateHeader{
+	uint32_t magic;
+	uint32_t session;		// identifies a sender's sequence of frames
+	uint32_t frame;			// frame sequence number
+	uint32_t size;			// frame size, in bytes
+	uint16_t index;			// fragment index
+	uint16_t count;			// fragments per frame
+};
+
+static const uint32_t STATE_MAGIC = 0x416c5346; // "AlSF"
+static const int HEADER_SIZE = sizeof(StateHeader);
+
+// A sender starting over picks a new session, so receivers know to accept
+// its frame numbers restarting from zero
+static uint32_t newSession(const void * sender){
+	static uint32_t count = 0;
+	uint64_t t = al_time_nsec();
+	uint32_t s = uint32_t(t) ^ uint32_t(t >> 32) ^ uint32_t(size_t(sender)) ^ (++count * 0x9e3779b9);
+	return s ? s : 1;
+}
+
+static int numFragments(int size){
+	int n = (size + StateSender::MAX_PAYLOAD - 1) / StateSender::MAX_PAYLOAD;
+	return n > 0 ? n : 1;
+}
+
+
+StateSender::StateSender()
+:	mPacket(HEADER_SIZE + MAX_PAYLOAD), mFrame(0), mSession(newSession(this))
+{}
+
+StateSender::StateSender(uint16_t port, const char * address)
+:	mPacket(HEADER_SIZE + MAX_PAYLOAD), mFrame(0), mSession(newSession(this))
+{
+	open(port, address);
+}
+
+bool StateSender::open(uint16_t port, const char * address){
+	if(!mSocket.open(port, address, 0, Socket::UDP|Socket::DGRAM)) return false;
+
+	// Allow sending to broadcast addresses
+	int fd = mSocket.fileDescriptor();
+	int on = 1;
+	setsockopt(fd, SOL_SOCKET, SO_BROADCAST, (const char *)&on, sizeof(on));
+
+	// When sending to a multicast group, keep packets on the local network
+	// and deliver them to receivers on this host as well
+	#ifdef AL_WINDOWS
+	DWORD ttl = 1, loop = 1;
+	#else
+	unsigned char ttl = 1, loop = 1;
+	#endif
+	setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, (const char *)&ttl, sizeof(ttl));
+	setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, (const char *)&loop, sizeof(loop));
+	return true;
+}
+
+bool StateSender::send(const void * data, int size){
+	const int count = numFragments(size);
+	const char * src = static_cast<const char *>(data);
+	bool ok = true;
+
+	StateHeader h;
+	h.magic = STATE_MAGIC;
+	h.session = mSession;
+	h.frame = mFrame;
+	h.size = size;
+	h.count = count;
+
+	for(int i=0; i<count; ++i){
+		int offset = i * MAX_PAYLOAD;
+		int n = size - offset < MAX_PAYLOAD ? size - offset : MAX_PAYLOAD;
+		h.index = i;
+		memcpy(&mPacket[0], &h, HEADER_SIZE);
+		memcpy(&mPacket[HEADER_SIZE], src + offset, n);
+		ok &= mSocket.send(&mPacket[0], HEADER_SIZE + n) == size_t(HEADER_SIZE + n);
+	}
+
+	++mFrame;
+	return ok;
+}
+
+
+
+StateReceiver::StateReceiver(int frameSize, uint16_t port, int window, const char * group)
+:	mFrames(std::vector<char>(frameSize > 0 ? frameSize : 1, 0)),
+	mRunning(false)
+{
+	init(frameSize, window);
+	if(port) open(port, group);
+}
+
+StateReceiver::~StateReceiver(){
+	stop();
+}
+
+void StateReceiver::init(int frameSize, int window){
+	mFrameSize = frameSize;
+	mFragments = numFragments(frameSize);
+	mWindow.resize(window > 0 ? window : 1);
+	for(unsigned i=0; i<mWindow.size(); ++i){
+		Partial& p = mWindow[i];
+		p.frame = 0;
+		p.count = 0;
+		p.data.resize(mFrames.front().size());
+		p.got.resize(mFragments);
+	}
+	mPacket.resize(HEADER_SIZE + StateSender::MAX_PAYLOAD);
+	mLastFrame = 0;
+	mSession = 0;
+	mHaveFrame = false;
+	mReceived = mDropped = 0;
+	mThreadFunc.receiver = this;
+}
+
+bool StateReceiver::open(uint16_t port, const char * group){
+	if(!mSocket.open(port, "", 0, Socket::UDP|Socket::DGRAM)) return false;
+	const bool join = group && group[0];
+	int fd = mSocket.fileDescriptor();
+
+	// Members of a group share the port with other receivers on this host,
+	// so the address must be made reusable before binding
+	if(join){
+		int on = 1;
+		setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, (const char *)&on, sizeof(on));
+		#ifdef SO_REUSEPORT
+		setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, (const char *)&on, sizeof(on));
+		#endif
+	}
+
+	if(!mSocket.bind()){
+		mSocket.close();
+		return false;
+	}
+
+	if(join){
+		ip_mreq req;
+		memset(&req, 0, sizeof(req));
+		req.imr_multiaddr.s_addr = inet_addr(group);
+		req.imr_interface.s_addr = htonl(INADDR_ANY);
+		if(0 != setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, (const char *)&req, sizeof(req))){
+			AL_WARN("StateReceiver: could not join multicast group %s", group);
+			mSocket.close();
+			return false;
+		}
+	}
+	return true;
+}
+
+bool StateReceiver::start(){
+	if(mRunning) return true;
+	if(!mSocket.opened()) return false;
+
+	// Block briefly so the thread can notice when it is stopped
+	mSocket.timeout(0.1);
+	mRunning = true;
+	if(!mThread.start(mThreadFunc)){
+		mRunning = false;
+		mSocket.timeout(0);
+		return false;
+	}
+	return true;
+}
+
+void StateReceiver::stop(){
+	if(mRunning){
+		storeRelease(mRunning, false);
+		mThread.join();
+		mSocket.timeout(0);
+	}
+}
+
+void StateReceiver::RecvThread::operator()(){
+	while(loadAcquire(receiver->mRunning)) receiver->receive();
+}
+
+int StateReceiver::poll(){
+	int frames = 0;
+	while(mSocket.opened()){
+		int n = mSocket.recv(&mPacket[0], mPacket.size());
+		if(n <= 0) break;
+		frames += onPacket(&mPacket[0], n);
+	}
+	return frames;
+}
+
+bool StateReceiver::receive(){
+	int n = mSocket.recv(&mPacket[0], mPacket.size());
+	return n > 0 && onPacket(&mPacket[0], n);
+}
+
+bool StateReceiver::onPacket(const char * packet, int size){
+	if(size < HEADER_SIZE) return false;
+	StateHeader h;
+	memcpy(&h, packet, HEADER_SIZE);
+
+	const int offset = h.index * StateSender::MAX_PAYLOAD;
+	const int payload = size - HEADER_SIZE;
+	if(	h.magic != STATE_MAGIC
+		|| int(h.size) != mFrameSize || h.count != mFragments || h.index >= h.count
+		|| payload != std::min(int(StateSender::MAX_PAYLOAD), mFrameSize - offset)
+	) return false;
+
+	// A new sender session restarts the sequence; partial frames of the old
+	// one are given up on
+	if(h.session != mSession){
+		for(unsigned i=0; i<mWindow.size(); ++i){
+			if(mWindow[i].count){
+				mWindow[i].count = 0;
+				storeRelaxed(mDropped, mDropped + 1);
+			}
+		}
+		mSession = h.session;
+		mHaveFrame = false;
+	}
+
+	// Frames older than the last complete one are of no use. Sequence numbers
+	// are compared by their difference so that they may wrap around.
+	if(mHaveFrame && int(h.frame - mLastFrame) <= 0) return false;
+
+	// Find frame in window or replace the oldest one
+	Partial * p = 0;
+	for(unsigned i=0; i<mWindow.size(); ++i){
+		Partial& w = mWindow[i];
+		if(w.count && w.frame == h.frame){ p = &w; break; }
+		if(!p || (p->count && (!w.count || int(w.frame - p->frame) < 0))) p = &w;
+	}
+	if(p->frame != h.frame || !p->count){
+		if(p->count) storeRelaxed(mDropped, mDropped + 1);
+		p->frame = h.frame;
+		p->count = 0;
+		p->got.assign(p->got.size(), 0);
+	}
+
+	if(!p->got[h.index]){
+		p->got[h.index] = 1;
+		++p->count;
+		memcpy(&p->data[offset], packet + HEADER_SIZE, payload);
+	}
+	if(p->count < mFragments) return false;
+
+	// Complete; hand the frame over without copying and drop older partials
+	p->data.swap(mFrames.back());
+	mFrames.publish();
+	p->count = 0;
+	mLastFrame = h.frame;
+	mHaveFrame = true;
+	storeRelaxed(mReceived, mReceived + 1);
+
+	for(unsigned i=0; i<mWindow.size(); ++i){
+		Partial& w = mWindow[i];
+		if(w.count && int(w.frame - h.frame) < 0){
+			w.count = 0;
+			storeRelaxed(mDropped, mDropped + 1);
+		}
+	}
+	return true;
+}
+
+} // al::
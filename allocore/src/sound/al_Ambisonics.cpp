@@ -21,6 +21,35 @@ static const double c8_11		= 8./11.;
 static const double c40_11		= 40./11.;
 
 
+// Constants for evaluating ACN ordered spherical harmonics
+struct ACNTables{
+	float dfact[AL_AMBI_MAX_ORDER+1];	// (2m-1)!!
+	float sn3d[AL_AMBI_MAX_ORDER+1][AL_AMBI_MAX_ORDER+1];	// [n][m]
+	float n3d[AL_AMBI_MAX_ORDER+1][AL_AMBI_MAX_ORDER+1];	// [n][m]
+
+	ACNTables(){
+		double df = 1;
+		for(int m=0; m<=AL_AMBI_MAX_ORDER; ++m){
+			if(m) df *= 2*m - 1;
+			dfact[m] = df;
+		}
+
+		// SN3D: sqrt((2 - delta_m) (n-m)! / (n+m)!), N3D: SN3D * sqrt(2n+1)
+		for(int n=0; n<=AL_AMBI_MAX_ORDER; ++n){
+			for(int m=0; m<=n; ++m){
+				double r = 1;
+				for(int i=n-m+1; i<=n+m; ++i) r /= i;
+				double N = sqrt((m ? 2. : 1.) * r);
+				sn3d[n][m] = N;
+				n3d[n][m] = N * sqrt(2.*n + 1.);
+			}
+		}
+	}
+};
+
+static const ACNTables acnTables;
+
+
 //// @see http://www.ai.sri.com/ajh/ambisonics/
 //
 //// the three decode types:
@@ -40,8 +69,8 @@ static const double c40_11		= 40./11.;
 
 // AmbiBase
 
-AmbiBase::AmbiBase(int dim, int order)
-:	mDim(dim), mOrder(0), mWeights(0)
+AmbiBase::AmbiBase(int dim, int order, Convention convention)
+:	mDim(dim), mOrder(0), mConvention(convention), mWeights(0)
 {	this->order(order); }
 
 AmbiBase::~AmbiBase(){
@@ -49,7 +78,8 @@ AmbiBase::~AmbiBase(){
 }
 
 void AmbiBase::order(int o){
-	if(o != mOrder){
+	if(o > maxOrder()) o = maxOrder();
+	if(o != mOrder || 0 == mWeights){
 		mOrder = o;
 		mChannels = orderToChannels(mDim, mOrder);
 		resize(mWeights, channels());
@@ -57,6 +87,22 @@ void AmbiBase::order(int o){
 	}
 }
 
+int AmbiBase::channelOrder(int c) const {
+	if(2 == mDim) return (c+1)/2;
+	if(FUMA == mConvention){
+		// W, X, Y, U, V, P, Q, then Z, S, T, R, N, O, L, M, K
+		int h = orderToChannelsH(mOrder);
+		if(c < h) return (c+1)/2;
+		return int(sqrt(double(c - h))) + 1;
+	}
+	return int(sqrt(double(c)));
+}
+
+void AmbiBase::encodeWeights(float * ws, float x, float y, float z) const {
+	if(FUMA == mConvention)	encodeWeightsFuMa(ws, mDim, mOrder, x,y,z);
+	else					encodeWeightsACN(ws, mDim, mOrder, x,y,z, ACN_N3D == mConvention);
+}
+
 int AmbiBase::channelsToUniformOrder(int channels){
 	// M = floor(sqrt(N) - 1)
 	return (int)(sqrt((double)channels) - 1);
@@ -159,6 +205,109 @@ void AmbiBase::encodeWeightsFuMa16(float * ws, float az, float el){
 
 
 
+void AmbiBase::encodeWeightsACN(float * ws, int dim, int order, float x, float y, float z, bool n3d){
+	encodeWeightsACN(ws, 1, dim, order, &x, &y, &z, 1, n3d);
+}
+
+void AmbiBase::encodeWeightsACN(
+	float * ws, int stride, int dim, int order,
+	const float * x, const float * y, const float * z, int n, bool n3d
+){
+	// The harmonic of degree l and order m is
+	//		Y_lm = N_lm P_lm(z) cos(m A)	(or sin(|m| A) for m < 0)
+	// Writing the associated Legendre function as
+	//		P_lm(z) = Q_lm(z) cos^m(E),
+	// the azimuthal part becomes Re/Im((x + iy)^m), which is computed by
+	// complex multiplication, and Q obeys the same recurrence in l as P:
+	//		Q_mm = (2m-1)!!,  Q_(m+1)m = (2m+1) z Q_mm
+	//		(l-m) Q_lm = (2l-1) z Q_(l-1)m - (l+m-1) Q_(l-2)m
+	// so no trigonometric functions are evaluated. The Condon-Shortley phase
+	// is omitted, as in AmbiX.
+
+	static const int B = 64; // directions per block
+	float cm[B], sm[B], q0[B], q1[B], q2[B];
+
+	const float (*norm)[AL_AMBI_MAX_ORDER+1] = n3d ? acnTables.n3d : acnTables.sn3d;
+	if(order > AL_AMBI_MAX_ORDER) order = AL_AMBI_MAX_ORDER;
+
+	for(int k0=0; k0<n; k0+=B){
+		const int K = n-k0 < B ? n-k0 : B;
+		const float * xs = x + k0;
+		const float * ys = y + k0;
+		const float * zs = z + k0;
+		float * w = ws + k0;
+
+		for(int k=0; k<K; ++k){ cm[k]=1; sm[k]=0; }
+
+		for(int m=0; m<=order; ++m){
+			if(m){
+				for(int k=0; k<K; ++k){
+					float c = cm[k];
+					cm[k] = xs[k]*c - ys[k]*sm[k];
+					sm[k] = xs[k]*sm[k] + ys[k]*c;
+				}
+			}
+
+			if(2 == dim){ // circular harmonics: W, then sin and cos per order
+				if(0 == m){
+					for(int k=0; k<K; ++k) w[k] = 1;
+				}
+				else{
+					const float N = n3d ? float(M_SQRT2) : 1.f;
+					float * ws_ = w + (2*m-1)*stride;
+					float * wc_ = w + (2*m  )*stride;
+					for(int k=0; k<K; ++k){
+						ws_[k] = N * sm[k];
+						wc_[k] = N * cm[k];
+					}
+				}
+				continue;
+			}
+
+			// degree l = m
+			float qmm = acnTables.dfact[m];
+			{	const float N = norm[m][m] * qmm;
+				float * wc_ = w + (m*m + 2*m)*stride;
+				float * ws_ = w + (m*m      )*stride;
+				for(int k=0; k<K; ++k) wc_[k] = N * cm[k];
+				if(m) for(int k=0; k<K; ++k) ws_[k] = N * sm[k];
+			}
+			if(m == order) break;
+
+			// degree l = m+1
+			{	const float a = (2*m + 1) * qmm;
+				const float N = norm[m+1][m];
+				const int l = m+1;
+				float * wc_ = w + (l*l + l + m)*stride;
+				float * ws_ = w + (l*l + l - m)*stride;
+				for(int k=0; k<K; ++k){
+					q0[k] = qmm;
+					q1[k] = a * zs[k];
+					wc_[k] = N * q1[k] * cm[k];
+				}
+				if(m) for(int k=0; k<K; ++k) ws_[k] = N * q1[k] * sm[k];
+			}
+
+			// degrees l > m+1
+			float * qa = q0, * qb = q1, * qc = q2;
+			for(int l=m+2; l<=order; ++l){
+				const float a = float(2*l - 1) / (l - m);
+				const float b = float(l + m - 1) / (l - m);
+				const float N = norm[l][m];
+				float * wc_ = w + (l*l + l + m)*stride;
+				float * ws_ = w + (l*l + l - m)*stride;
+				for(int k=0; k<K; ++k){
+					qc[k] = a * zs[k] * qb[k] - b * qa[k];
+					wc_[k] = N * qc[k] * cm[k];
+				}
+				if(m) for(int k=0; k<K; ++k) ws_[k] = N * qc[k] * sm[k];
+				float * t = qa; qa = qb; qb = qc; qc = t;
+			}
+		}
+	}
+}
+
+
 
 // AmbiDecode
 
@@ -190,47 +339,213 @@ float AmbiDecode::flavorWeights[4][5][5] = {
 	}
 };
 
-AmbiDecode::AmbiDecode(int dim, int order, int numSpeakers, int flav)
-	: AmbiBase(dim, order),
-	mNumSpeakers(0), mDecodeMatrix(0)
+AmbiDecode::AmbiDecode(int dim, int order, int numSpeakers, int flav, Convention convention)
+	: AmbiBase(dim, order, convention),
+	mNumSpeakers(0), mDecodeMatrix(0), mGainsDirty(true), mDistinctChannels(true), mPool(0)
 {
 	resizeArrays(channels(), numSpeakers);
 	flavor(flav);
 }
 
 AmbiDecode::~AmbiDecode(){
+	delete mPool;
 	delete[] mDecodeMatrix;
 	//delete[] mSpeakers; // listener now owns speakers and will delete them
 }
 
 void AmbiDecode::decode(float * dec, const float * ambi, int numDecFrames) const {
+	if(mGainsDirty) updateGains();
 
-	// iterate speakers
-	for(int s=0; s<numSpeakers(); ++s){
-		// skip zero-amp speakers:
-		if ((*mSpeakers)[s].gain != 0.) {
-			float * out = dec + (*mSpeakers)[s].deviceChannel * numDecFrames;
+	const int Nc = channels();
+	const int N = numDecFrames;
+
+	// Split speakers across threads if the decode is large and each speaker
+	// writes to its own device channel
+	int numThreads = threads();
+	if(numThreads > 1){
+		if(numSpeakers() * Nc * N < (1<<18) || numSpeakers() < 2*numThreads || !mDistinctChannels){
+			numThreads = 1;
+		}
+	}
+
+	if(!dualBand()){
+		decodeBlock(dec, N, ambi, N, N, numThreads);
+		return;
+	}
+
+	// Split each channel into bands and weight them per order, a block of
+	// frames at a time so that the band buffer has a fixed size
+	for(int f0=0; f0<N; f0+=BAND_FRAMES){
+		const int Nb = N-f0 < BAND_FRAMES ? N-f0 : BAND_FRAMES;
+		for(int c=0; c<Nc; ++c){
+			const int n = channelOrder(c);
+			const float wlo = mWBand[0][n];
+			const float whi = mWBand[1][n];
+			Crossover<float>& xo = mCrossovers[c];
+			const float * in = ambi + c*N + f0;
+			float * out = &mBands[c*BAND_FRAMES];
+			for(int i=0; i<Nb; ++i){
+				float lo, hi;
+				xo.next(in[i], &lo, &hi);
+				out[i] = wlo*lo + whi*hi;
+			}
+		}
+		decodeBlock(dec + f0, N, &mBands[0], BAND_FRAMES, Nb, numThreads);
+	}
+}
+
+void AmbiDecode::decodeBlock(float * dec, int decStride, const float * enc, int encStride, int numFrames, int numThreads) const {
+	if(numThreads <= 1){
+		decodeSpeakers(dec, decStride, enc, encStride, numFrames, 0, numSpeakers());
+		return;
+	}
+	DecodeBody body = { this, dec, decStride, enc, encStride, numFrames };
+	mPool->parallelFor(0, numSpeakers(), body, (numSpeakers() + numThreads-1) / numThreads);
+}
+
+void AmbiDecode::decodeSpeakers(float * dec, int decStride, const float * ambi, int ambiStride, int numFrames, int speaker0, int speaker1) const {
+
+	// Out += Gains x Ambi, blocked so that a tile of Ambisonic frames stays
+	// in cache across speakers and each output frame is loaded once per four
+	// channels.
+	static const int B = 128;
+	const int Nc = channels();
+	const int N = numFrames;
+	const int S = ambiStride;
+
+	for(int i0=0; i0<N; i0+=B){
+		const int Nb = N-i0 < B ? N-i0 : B;
+		const float * in = ambi + i0;
+
+		// iterate speakers
+		for(int s=speaker0; s<speaker1; ++s){
+			// skip zero-amp speakers:
+			if((*mSpeakers)[s].gain == 0.) continue;
+
+			float * out = dec + (*mSpeakers)[s].deviceChannel * decStride + i0;
+			const float * g = &mGains[s * Nc];
 
 			// iterate ambi channels
-			for(int c=0; c<channels(); ++c){
-				const float * in = ambi + c * numDecFrames;
-				float w = decodeWeight(s, c);
-				for(int i=0; i<numDecFrames; ++i) out[i] += in[i] * w;
+			int c = 0;
+			for(; c+4<=Nc; c+=4){
+				const float * a0 = in + (c  )*S;
+				const float * a1 = in + (c+1)*S;
+				const float * a2 = in + (c+2)*S;
+				const float * a3 = in + (c+3)*S;
+				const float g0=g[c], g1=g[c+1], g2=g[c+2], g3=g[c+3];
+				for(int i=0; i<Nb; ++i){
+					out[i] += g0*a0[i] + g1*a1[i] + g2*a2[i] + g3*a3[i];
+				}
+			}
+			for(; c<Nc; ++c){
+				const float * a = in + c*S;
+				const float w = g[c];
+				for(int i=0; i<Nb; ++i) out[i] += w*a[i];
+			}
+		}
+	}
+}
+
+// Gains are sized when the number of channels or speakers is set
+void AmbiDecode::updateGains() const {
+	const int Nc = channels();
+	for(int s=0; s<numSpeakers(); ++s){
+		for(int c=0; c<Nc; ++c){
+			// In dual-band mode the order weights are applied to the input
+			mGains[s*Nc + c] = dualBand() ? mDecodeMatrix[s*Nc + c] : decodeWeight(s, c);
+		}
+	}
+
+	mDistinctChannels = true;
+	for(int s=0; s<numSpeakers() && mDistinctChannels; ++s){
+		for(int t=0; t<s; ++t){
+			if((*mSpeakers)[s].deviceChannel == (*mSpeakers)[t].deviceChannel){
+				mDistinctChannels = false;
+				break;
 			}
 		}
 	}
+	mGainsDirty = false;
+}
+
+void AmbiDecode::threads(int num){
+	delete mPool;
+	mPool = 0;
+	if(num > 1){
+		mPool = new ThreadPool(num-1);
+		mPool->start();
+	}
+}
+
+void AmbiDecode::dualBand(float crossoverFreq, float sampleRate, int loFlavor, int hiFlavor){
+	if(loFlavor < 4 && hiFlavor < 4){
+		orderWeights(loFlavor, mWBand[0]);
+		orderWeights(hiFlavor, mWBand[1]);
+		mCrossovers.assign(channels(), Crossover<float>(crossoverFreq, sampleRate));
+		mBands.resize(channels() * BAND_FRAMES);
+		mGainsDirty = true;
+	}
+}
+
+void AmbiDecode::singleBand(){
+	mCrossovers.clear();
+	mGainsDirty = true;
 }
 
 
 void AmbiDecode::flavor(int type){
 	if(type < 4){
 		mFlavor = type;
-		const int No = sizeof(mWOrder)/sizeof(mWOrder[0]);
-		for(int i=0; i<No; ++i) mWOrder[i] = flavorWeights[flavor()][i][order()];
+		orderWeights(type, mWOrder);
 		updateChanWeights();
 	}
 }
 
+// Legendre polynomial of degree n
+static double legendre(int n, double x){
+	double p0 = 1, p1 = x;
+	if(0 == n) return p0;
+	for(int l=2; l<=n; ++l){
+		double p2 = ((2*l - 1) * x * p1 - (l - 1) * p0) / l;
+		p0 = p1; p1 = p2;
+	}
+	return p1;
+}
+
+static double factorial(int n){
+	double r = 1;
+	for(int i=2; i<=n; ++i) r *= i;
+	return r;
+}
+
+void AmbiDecode::orderWeights(int type, float * w) const {
+	for(int i=0; i<=AL_AMBI_MAX_ORDER; ++i) w[i] = 0;
+
+	// Tabulated weights up to 4th order
+	if(mOrder <= 4){
+		for(int i=0; i<=4; ++i) w[i] = flavorWeights[type][i][mOrder];
+		return;
+	}
+
+	// Higher orders: compute in-phase or max-rE weights
+	const int N = mOrder;
+	for(int n=0; n<=N; ++n){
+		double g = 1;
+		switch(type){
+		case 2: // in-phase
+			if(3 == mDim)	g = factorial(N) * factorial(N+1) / (factorial(N+n+1) * factorial(N-n));
+			else			g = factorial(N) * factorial(N) / (factorial(N+n) * factorial(N-n));
+			break;
+		case 0: // none
+			break;
+		default: // max-rE
+			if(3 == mDim)	g = legendre(n, cos(137.9 * M_DEG2RAD / (N + 1.51)));
+			else			g = cos(n * M_PI / (2*N + 2));
+		}
+		w[n] = g;
+	}
+}
+
 void AmbiDecode::numSpeakers(int num){
 	resizeArrays(channels(), num);
 }
@@ -239,7 +554,7 @@ void AmbiDecode::numSpeakers(int num){
 
 void AmbiDecode::setSpeakerRadians(int index, int deviceChannel, float az, float el, float amp){
 	if(index >= numSpeakers()){
-		numSpeakers(index);	// grow adaptively
+		numSpeakers(index+1);	// grow adaptively
 	}
 
 	(*mSpeakers)[index].azimuth = az;
@@ -247,10 +562,29 @@ void AmbiDecode::setSpeakerRadians(int index, int deviceChannel, float az, float
 	(*mSpeakers)[index].deviceChannel = deviceChannel;
 	(*mSpeakers)[index].gain = amp;
 
+	mGainsDirty = true;
+
 	// update encoding weights
-	encodeWeightsFuMa(mDecodeMatrix + index * channels(), mDim, mOrder, az, el);
-	for (int i=0; i<channels(); i++) {
-		mDecodeMatrix[index * channels() + i] *= amp;
+	float * row = mDecodeMatrix + index * channels();
+	if(FUMA == mConvention){
+		encodeWeightsFuMa(row, mDim, mOrder, az, el);
+		for (int i=0; i<channels(); i++) {
+			row[i] *= amp;
+		}
+	}
+	else{
+		// Project onto the speaker's orthonormal harmonics; SN3D signals
+		// need each degree scaled by 2n+1 (2 in 2D) to match N3D.
+		float cosel = cos(el);
+		float z = mDim>=3 ? sin(el) : 0;
+		bool n3d = ACN_N3D == mConvention;
+		encodeWeightsACN(row, mDim, mOrder, cos(az)*cosel, sin(az)*cosel, z, n3d);
+		for(int i=0; i<channels(); ++i){
+			int n = channelOrder(i);
+			float k = 1;
+			if(!n3d) k = 3 == mDim ? 2*n + 1 : (n ? 2 : 1);
+			row[i] *= k * amp;
+		}
 	}
 }
 
@@ -259,37 +593,8 @@ void AmbiDecode::setSpeaker(int index, int deviceChannel, float az, float el, fl
 }
 
 void AmbiDecode::updateChanWeights(){
-	float * wc = mWeights;
-	*wc++ = mWOrder[0];
-
-	if(mOrder > 0){
-		*wc++ = mWOrder[1];				// X
-		*wc++ = mWOrder[1];				// Y
-		if (mOrder > 1) {
-			*wc++ = mWOrder[2];			// U
-			*wc++ = mWOrder[2];			// V
-			if (mOrder > 2) {
-				*wc++ = mWOrder[3];		// P
-				*wc++ = mWOrder[3];		// Q
-			}
-		}
-
-		if(3 == mDim){
-			*wc++ = mWOrder[1];			// Z
-			if (mOrder > 1) {
-				*wc++ = mWOrder[2];		// S
-				*wc++ = mWOrder[2];		// T
-				*wc++ = mWOrder[2];		// R
-				if (mOrder > 2) {
-					*wc++ = mWOrder[3];	// N
-					*wc++ = mWOrder[3];	// O
-					*wc++ = mWOrder[3];	// L
-					*wc++ = mWOrder[3];	// M
-					*wc   = mWOrder[3];	// K
-				}
-			}
-		}
-	}
+	for(int c=0; c<channels(); ++c) mWeights[c] = mWOrder[channelOrder(c)];
+	mGainsDirty = true;
 }
 
 void AmbiDecode::resizeArrays(int numChannels, int numSpeakers){
@@ -318,10 +623,16 @@ void AmbiDecode::resizeArrays(int numChannels, int numSpeakers){
 	}
 
 	mChannels = numChannels;
+	mGains.resize(numChannels * mNumSpeakers);
+	mGainsDirty = true;
 }
 
 void AmbiDecode::onChannelsChange(){
 	resizeArrays(channels(), mNumSpeakers);
+	if(dualBand()){
+		mCrossovers.resize(channels(), mCrossovers[0]);
+		mBands.resize(channels() * BAND_FRAMES);
+	}
 }
 
 void AmbiDecode::print(FILE * fp, const char * append) const {
@@ -330,10 +641,23 @@ void AmbiDecode::print(FILE * fp, const char * append) const {
 }
 
 
+void AmbiEncode::numFrames(int v){
+	mMaxFrames = v;
+	mDirs.resize(v*3);
+	mBlockWeights.resize(channels()*v);
+}
+
+void AmbiEncode::onChannelsChange(){
+	mBlockWeights.resize(channels()*mMaxFrames);
+}
+
+
 AmbisonicsSpatializer::AmbisonicsSpatializer(
-	SpeakerLayout &sl, int dim, int order, int flavor
+	SpeakerLayout &sl, int dim, int order, int flavor, AmbiBase::Convention convention
 )
-:	Spatializer(sl), mDecoder(dim, order, sl.numSpeakers(), flavor), mEncoder(dim,order)
+:	Spatializer(sl),
+	mDecoder(dim, order, sl.numSpeakers(), flavor, convention),
+	mEncoder(dim, order, convention)
 {
     setSpeakerLayout(sl);
 };
@@ -348,6 +672,7 @@ void AmbisonicsSpatializer::compile(Listener& l){
 
 void AmbisonicsSpatializer::numFrames(int v){
     mNumFrames = v;
+	mEncoder.numFrames(v);
 
     if(mAmbiDomainChannels.size() != (unsigned long)(mDecoder.channels() * v)){
 		mAmbiDomainChannels.resize(mDecoder.channels() * v);
@@ -397,15 +722,36 @@ void AmbisonicsSpatializer::perform(
 	double rf = urel.dot(axis);
 	//*/
 
-	for(int i = 0; i < numFrames; i++){
-		// cheaper:
-		Vec3d direction = mListener->quatHistory()[i].rotateTransposed(urel);
+	// Evaluate the harmonics once at the end of the buffer and interpolate
+	// from the weights reached at the end of the previous buffer
+	Vec3d direction = mListener->quatHistory()[numFrames-1].rotateTransposed(urel);
+	mEncoder.direction(-direction[2], -direction[0], direction[1]);
 
-		//mEncoder.direction(azimuth, elevation);
-		//mEncoder.direction(-rf, -rr, ru);
-		mEncoder.direction(-direction[2], -direction[0], direction[1]);
-		mEncoder.encode(ambiChans(), numFrames, i, samples[i]);
+	// Sources not added through addSource() are encoded without interpolation
+	std::map<const SoundSource *, SourceWeights>::iterator it = mSourceWeights.find(&src);
+	if(it == mSourceWeights.end()){
+		mEncoder.encode(ambiChans(), samples, numFrames, mEncoder.weights());
+		return;
 	}
+
+	SourceWeights& prev = it->second;
+	const int Nc = mEncoder.channels();
+	if(!prev.valid){
+		for(int c=0; c<Nc; ++c) prev.weights[c] = mEncoder.weights()[c];
+		prev.valid = true;
+	}
+	mEncoder.encode(ambiChans(), samples, numFrames, &prev.weights[0]);
+	for(int c=0; c<Nc; ++c) prev.weights[c] = mEncoder.weights()[c];
+}
+
+void AmbisonicsSpatializer::addSource(SoundSource& src){
+	SourceWeights& w = mSourceWeights[&src];
+	w.weights.assign(mEncoder.channels(), 0.f);
+	w.valid = false;
+}
+
+void AmbisonicsSpatializer::removeSource(SoundSource& src){
+	mSourceWeights.erase(&src);
 }
 
 
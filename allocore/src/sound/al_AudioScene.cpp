@@ -66,7 +66,7 @@ int SoundSource::bufferSize(double samplerate, double speedOfSound, double dista
 
 
 AudioScene::AudioScene(int numFrames_)
-:   mSpeedOfSound(344), mPerSampleProcessing(false)
+:   mNumFrames(0), mSpeedOfSound(344), mPerSampleProcessing(false)
 {
 	numFrames(numFrames_);
 }
@@ -83,15 +83,24 @@ AudioScene::~AudioScene(){
 
 void AudioScene::addSource(SoundSource& src){
 	mSources.push_back(&src);
+	for(unsigned i=0; i<mListeners.size(); ++i){
+		mListeners[i]->mSpatializer->addSource(src);
+	}
 }
 
 void AudioScene::removeSource(SoundSource& src){
 	mSources.remove(&src);
+	for(unsigned i=0; i<mListeners.size(); ++i){
+		mListeners[i]->mSpatializer->removeSource(src);
+	}
 }
 
 void AudioScene::numFrames(int v){
 	if(mNumFrames != v){
 		mBuffer.resize(v);
+		mRelPos.resize(v);
+		mDistances.resize(v);
+		mGains.resize(v);
 
 		Listeners::iterator it = mListeners.begin();
 		while(it != mListeners.end()){
@@ -105,6 +114,9 @@ void AudioScene::numFrames(int v){
 Listener * AudioScene::createListener(Spatializer* spatializer){
 	Listener * l = new Listener(mNumFrames, spatializer);
     l->compile();
+	for(Sources::iterator it = mSources.begin(); it != mSources.end(); ++it){
+		spatializer->addSource(**it);
+	}
 	mListeners.push_back(l);
 	return l;
 }
@@ -152,25 +164,31 @@ void AudioScene::render(AudioIOData& io){
 
             if(mPerSampleProcessing) //Original, inefficient, per sample processing
             {
-                // iterate time samples
+                // compute interpolated source positions relative to listener
+                // and their distances in world-space units
+                // TODO: this tends to warble when moving fast
                 for(int i=0; i<numFrames; ++i){
-
-                    // compute interpolated source position relative to listener
-                    // TODO: this tends to warble when moving fast
                     double alpha = double(i)/numFrames;
 
                     // moving average:
                     // cheaper & slightly less warbly than cubic,
                     // less glitchy than linear
-                    Vec3d relpos = (
+                    mRelPos[i] = (
                         (src.posHistory()[3]-l.posHistory()[3])*(1.-alpha) +
                         (src.posHistory()[2]-l.posHistory()[2]) +
                         (src.posHistory()[1]-l.posHistory()[1]) +
                         (src.posHistory()[0]-l.posHistory()[0])*(alpha)
                     )/3.0;
+                    mDistances[i] = mRelPos[i].mag();
+                }
+
+                // gains for the whole buffer at once
+                src.attenuation(&mGains[0], &mDistances[0], numFrames);
 
-					// Get distance in world-space units
-                    double dist = relpos.mag();
+                // iterate time samples
+                for(int i=0; i<numFrames; ++i){
+                    Vec3d& relpos = mRelPos[i];
+                    double dist = mDistances[i];
 
 					// Compute how many samples ago to read from buffer
 					// Start with time delay due to speed of sound
@@ -182,8 +200,7 @@ void AudioScene::render(AudioIOData& io){
 					// Is our delay line big enough?
 					if(samplesAgo <= src.maxIndex()){
 					//if(dist < src.farClip()){
-						double gain = src.attenuation(dist);
-						float s = src.readSample(samplesAgo) * gain;
+						float s = src.readSample(samplesAgo) * mGains[i];
 						spatializer->perform(io,src,relpos, numFrames, i, s);
 					}
 
@@ -0,0 +1,72 @@
+#include "allocore/sound/al_Binaural.hpp"
+
+namespace al{
+
+static SpeakerLayout virtualLayout(const SpeakerLayout& sl){
+	SpeakerLayout v;
+	for(int i=0; i<sl.numSpeakers(); ++i){
+		Speaker s = sl.speakers()[i];
+		s.deviceChannel = i;
+		v.addSpeaker(s);
+	}
+	return v;
+}
+
+BinauralSpatializer::BinauralSpatializer(
+	const SpeakerLayout& sl, const float * const * hrirs, int hrirLength, int order
+)
+:	Spatializer(sl), mVirtual(virtualLayout(sl)),
+	mAmbi(mVirtual, 3, order, 1, AmbiBase::ACN_SN3D),
+	mHRIRs(hrirs, hrirs + 2*sl.numSpeakers()), mHRIRLength(hrirLength),
+	mLeft(0), mRight(1)
+{}
+
+void BinauralSpatializer::compile(Listener& l){
+	mAmbi.compile(l);
+}
+
+void BinauralSpatializer::numFrames(int v){
+	mAmbi.numFrames(v);
+	mSpeakerBuf.resize(mVirtual.numSpeakers() * v);
+	mEarBuf.resize(2 * v);
+
+	// The speaker-to-ear IR matrix has the left and right HRIRs of each
+	// speaker in consecutive outputs
+	mConvolver.setup(v, mVirtual.numSpeakers(), 2, &mHRIRs[0], mHRIRLength);
+}
+
+void BinauralSpatializer::prepare(AudioIOData& io){
+	mAmbi.prepare(io);
+}
+
+void BinauralSpatializer::perform(
+	AudioIOData& io, SoundSource& src, Vec3d& relpos, const int& numFrames, int& frameIndex, float& sample
+){
+	mAmbi.perform(io, src, relpos, numFrames, frameIndex, sample);
+}
+
+void BinauralSpatializer::perform(
+	AudioIOData& io, SoundSource& src, Vec3d& relpos, const int& numFrames, float *samples
+){
+	mAmbi.perform(io, src, relpos, numFrames, samples);
+}
+
+void BinauralSpatializer::finalize(AudioIOData& io){
+	const int N = io.framesPerBuffer();
+	if(N != mConvolver.blockSize()) return;
+
+	memset(&mSpeakerBuf[0], 0, mSpeakerBuf.size()*sizeof(float));
+	mAmbi.decoder().decode(&mSpeakerBuf[0], mAmbi.ambiChans(), N);
+
+	memset(&mEarBuf[0], 0, mEarBuf.size()*sizeof(float));
+	mConvolver.process(&mEarBuf[0], &mSpeakerBuf[0], N);
+
+	float * outL = io.outBuffer(mLeft);
+	float * outR = io.outBuffer(mRight);
+	for(int i=0; i<N; ++i){
+		outL[i] += mEarBuf[i];
+		outR[i] += mEarBuf[N + i];
+	}
+}
+
+} // al::
@@ -0,0 +1,281 @@
+#include <string.h>
+#include "allocore/sound/al_Convolver.hpp"
+#include "allocore/system/al_Printing.hpp"
+#include "allocore/system/al_Time.h"
+
+namespace al{
+
+// Complex multiply-accumulate of split complex arrays: a += x * h
+static inline void cmac(
+	float * ar, float * ai,
+	const float * xr, const float * xi, const float * hr, const float * hi, int n
+){
+	for(int k=0; k<n; ++k){
+		ar[k] += xr[k]*hr[k] - xi[k]*hi[k];
+		ai[k] += xr[k]*hi[k] + xi[k]*hr[k];
+	}
+}
+
+
+void Convolver::Stage::init(int size_, int numIn, int numOut, const float * const * irs, int begin, int end){
+	size = size_;
+	parts = (end - begin + size - 1) / size;
+	bins = size + 1;
+	slot = 0;
+	fft.resize(2*size);
+
+	const int specSize = 2*bins;
+	spectra.assign(numIn * numOut * parts * specSize, 0.f);
+	paths.assign(numIn * numOut, 0);
+	fdl.assign(numIn * parts * specSize, 0.f);
+	window.assign(numIn * 2*size, 0.f);
+	acc.assign(specSize, 0.f);
+	time.assign(2*size, 0.f);
+
+	// Transform zero-padded IR partitions
+	for(int p=0; p<numIn*numOut; ++p){
+		const float * ir = irs[p];
+		if(!ir) continue;
+		paths[p] = 1;
+		for(int j=0; j<parts; ++j){
+			int b = begin + j*size;
+			int n = end - b < size ? end - b : size;
+			time.assign(2*size, 0.f);
+			memcpy(&time[0], ir + b, n*sizeof(float));
+			float * spec = &spectra[(p*parts + j) * specSize];
+			fft.forward(spec, spec + bins, &time[0]);
+		}
+	}
+}
+
+void Convolver::Stage::compute(float * out, const float * in, int numIn, int numOut){
+	const int specSize = 2*bins;
+
+	// Slide input windows and transform into the newest delay line slot
+	slot = slot+1 < parts ? slot+1 : 0;
+	for(int i=0; i<numIn; ++i){
+		float * w = &window[i * 2*size];
+		memcpy(w, w + size, size*sizeof(float));
+		memcpy(w + size, in + i*size, size*sizeof(float));
+		float * x = &fdl[(i*parts + slot) * specSize];
+		fft.forward(x, x + bins, w);
+	}
+
+	for(int o=0; o<numOut; ++o){
+		float * ar = &acc[0];
+		float * ai = ar + bins;
+		memset(ar, 0, specSize*sizeof(float));
+
+		for(int i=0; i<numIn; ++i){
+			const int p = i*numOut + o;
+			if(!paths[p]) continue;
+			const float * h = &spectra[p*parts * specSize];
+			const float * fdlIn = &fdl[i*parts * specSize];
+
+			// Partition j is applied to the input from j blocks ago
+			int s = slot;
+			for(int j=0; j<parts; ++j){
+				const float * x = fdlIn + s*specSize;
+				cmac(ar, ai, x, x + bins, h, h + bins, bins);
+				h += specSize;
+				s = s ? s-1 : parts-1;
+			}
+		}
+
+		// The second half of the circular convolution is free of aliasing
+		fft.inverse(&time[0], ar, ai);
+		memcpy(out + o*size, &time[size], size*sizeof(float));
+	}
+}
+
+void Convolver::Stage::clear(){
+	slot = 0;
+	fdl.assign(fdl.size(), 0.f);
+	window.assign(window.size(), 0.f);
+}
+
+
+Convolver::Convolver()
+:	mBlockSize(0), mTailBlockSize(0), mNumInputs(0), mNumOutputs(0), mIRLength(0),
+	mTailPos(0), mTailBlocks(0), mTailUnderruns(0), mTailDropped(false),
+	mRunning(false), mTailPosted(0), mTailDone(0)
+{
+	mHead.parts = mTail.parts = 0;
+	mWorker.convolver = this;
+}
+
+Convolver::~Convolver(){
+	stop();
+}
+
+bool Convolver::setup(
+	int blockSize, int numInputs, int numOutputs,
+	const float * const * irs, int irLength,
+	int tailBlockSize, bool tailThread
+){
+	stop();
+
+	if(blockSize < 2 || (blockSize & (blockSize-1))){
+		AL_WARN("Convolver block size %d is not a power of two", blockSize);
+		return false;
+	}
+	if(tailBlockSize && (tailBlockSize <= blockSize || (tailBlockSize & (tailBlockSize-1)))){
+		AL_WARN("Convolver tail block size %d is not a power of two greater than %d", tailBlockSize, blockSize);
+		return false;
+	}
+	if(numInputs < 1 || numOutputs < 1 || irLength < 1){
+		return false;
+	}
+
+	mBlockSize = blockSize;
+	mNumInputs = numInputs;
+	mNumOutputs = numOutputs;
+	mIRLength = irLength;
+
+	// The tail starts two tail blocks in, giving it one tail block of time
+	// to compute after its input is complete
+	int headEnd = irLength;
+	mTailBlockSize = 0;
+	if(tailBlockSize && irLength > 2*tailBlockSize){
+		headEnd = 2*tailBlockSize;
+		mTailBlockSize = tailBlockSize;
+	}
+
+	mHead.init(blockSize, numInputs, numOutputs, irs, 0, headEnd);
+	mHeadOut.assign(numOutputs * blockSize, 0.f);
+
+	if(mTailBlockSize){
+		mTail.init(mTailBlockSize, numInputs, numOutputs, irs, headEnd, irLength);
+		for(int b=0; b<2; ++b){
+			mTailIn[b].assign(numInputs * mTailBlockSize, 0.f);
+			mTailOut[b].assign(numOutputs * mTailBlockSize, 0.f);
+		}
+	}
+	else{
+		mTail.parts = 0;
+	}
+
+	mTailPos = 0;
+	mTailBlocks = mTailPosted = mTailDone = mTailUnderruns = 0;
+	mTailDropped = false;
+
+	if(mTailBlockSize && tailThread){
+		mRunning = true;
+		mThread.start(mWorker);
+	}
+	return true;
+}
+
+void Convolver::process(float * out, const float * in, int numFrames){
+	if(numFrames != mBlockSize || 0 == mHead.parts) return;
+	const int N = numFrames;
+
+	mHead.compute(&mHeadOut[0], in, mNumInputs, mNumOutputs);
+	for(int o=0; o<mNumOutputs; ++o){
+		float * dst = out + o*N;
+		const float * src = &mHeadOut[o*N];
+		for(int i=0; i<N; ++i) dst[i] += src[i];
+	}
+
+	if(!mTailBlockSize) return;
+	const int L = mTailBlockSize;
+
+	// Tail block k covers output [(k+2)L, (k+3)L), i.e. it is read while
+	// input block k+2 is being collected
+	const int b = mTailBlocks & 1;
+	if(!mTailDropped){
+		if(mTailBlocks >= 2){
+			for(int o=0; o<mNumOutputs; ++o){
+				float * dst = out + o*N;
+				const float * src = &mTailOut[b][o*L + mTailPos];
+				for(int i=0; i<N; ++i) dst[i] += src[i];
+			}
+		}
+
+		for(int i=0; i<mNumInputs; ++i){
+			memcpy(&mTailIn[b][i*L + mTailPos], in + i*N, N*sizeof(float));
+		}
+	}
+
+	mTailPos += N;
+	if(mTailPos == L){
+		mTailPos = 0;
+		if(mRunning){
+			postTail();
+		}
+		else{
+			computeTail(mTailBlocks);
+		}
+		++mTailBlocks;
+	}
+}
+
+void Convolver::computeTail(unsigned block){
+	const int b = block & 1;
+	mTail.compute(&mTailOut[b][0], &mTailIn[b][0], mNumInputs, mNumOutputs);
+}
+
+void Convolver::tailLoop(){
+	while(loadAcquire(mRunning)){
+		unsigned posted = loadAcquire(mTailPosted);
+		if(mTailDone != posted){
+			computeTail(posted - 1);
+			storeRelease(mTailDone, posted);
+		}
+		else{
+			al_sleep_nsec(100000);
+		}
+	}
+}
+
+// The thread is given one tail block at a time. Its buffers are reused by
+// the block after next, so if the thread has not finished by the time the
+// next block is complete, the tail is dropped rather than waited for. Once
+// the thread is idle again the tail restarts from silence.
+void Convolver::postTail(){
+	if(loadAcquire(mTailDone) != mTailPosted){
+		++mTailUnderruns;
+		mTailDropped = true;
+	}
+	else if(mTailDropped){
+		clearTail();
+		mTailDropped = false;
+	}
+	else{
+		storeRelease(mTailPosted, mTailBlocks + 1);
+	}
+}
+
+void Convolver::clearTail(){
+	mTail.clear();
+	for(int b=0; b<2; ++b){
+		mTailIn[b].assign(mTailIn[b].size(), 0.f);
+		mTailOut[b].assign(mTailOut[b].size(), 0.f);
+	}
+}
+
+void Convolver::stop(){
+	if(mRunning){
+		storeRelease(mRunning, false);
+		mThread.join();
+	}
+}
+
+void Convolver::reset(){
+	mHead.clear();
+	if(mTailBlockSize){
+		// A busy tail thread is not waited for; the tail is dropped and
+		// cleared once the thread is idle
+		if(tailPending()){
+			mTailDropped = true;
+		}
+		else{
+			clearTail();
+			mTailDropped = false;
+		}
+	}
+	// Block counters continue so that they stay in step with the tail thread
+	mTailPos = 0;
+}
+
+} // al::
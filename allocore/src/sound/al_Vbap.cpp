@@ -21,7 +21,7 @@ void SpeakerTriple::loadVectors(const std::vector<Speaker>& spkrs){
 
 
 Vbap::Vbap(const SpeakerLayout &sl)
-:	Spatializer(sl), mCachedTripletIndex(0), mIs3D(true)
+:	Spatializer(sl), mNumTriplets(0), mCachedTripletIndex(0), mIs3D(true)
 {}
 
 void Vbap::addTriple(const SpeakerTriple& st) {
@@ -131,7 +131,7 @@ void Vbap::findSpeakerTriplets(const std::vector<Speaker>& spkrs){
 
 
 	// remove too narrow triples
-	for(std::list<SpeakerTriple>::iterator it = triplets.begin(); it != triplets.end();++it){
+	for(std::list<SpeakerTriple>::iterator it = triplets.begin(); it != triplets.end();){
 		SpeakerTriple trip = (*it);
 
 		Vec3d xprod = cross(trip.s1Vec,trip.s2Vec);
@@ -147,19 +147,21 @@ void Vbap::findSpeakerTriplets(const std::vector<Speaker>& spkrs){
 
 		if (ratio < MIN_VOLUME_TO_LENGTH_RATIO) {
 			//printf("v=%f, l=%f, r=%f x=(%f,%f,%f)\n",volume,length,ratio,xprod[0],xprod[1],xprod[2]);
-			triplets.erase(it);
-			--it;
+			it = triplets.erase(it);
 		}
+		else ++it;
 	}
 
 
-	for(std::list<SpeakerTriple>::iterator it = triplets.begin(); it != triplets.end();++it){
+	for(std::list<SpeakerTriple>::iterator it = triplets.begin(); it != triplets.end();){
 		SpeakerTriple trip = (*it);
 		bool remove = false;
 		for(std::list<SpeakerTriple>::iterator it2 = triplets.begin(); it2 != triplets.end();++it2){
 			SpeakerTriple trip2 = (*it2);
 			for (unsigned j = 0; j < 3; ++j) {
 				Vec3d v = trip2.vec[j];
+				// a triple's own speakers can not cross it
+				if (v == trip.s1Vec || v == trip.s2Vec || v == trip.s3Vec) continue;
 				Vec3d c = cross(cross(trip.s1Vec, trip.s2Vec),cross(trip.s3Vec,v));
 				if (isCrossing(c,v,trip) || isCrossing(-c,v, trip)) {
 					remove = true;
@@ -169,16 +171,15 @@ void Vbap::findSpeakerTriplets(const std::vector<Speaker>& spkrs){
 			}
 		}
 
-		if (remove) {
-			triplets.erase(it);
-			--it;
-		}
+		if (remove) it = triplets.erase(it);
+		else ++it;
 	}
 
 	// remove triangles that contain other Speakers
-	for(std::list<SpeakerTriple>::iterator it = triplets.begin(); it != triplets.end();++it){
+	for(std::list<SpeakerTriple>::iterator it = triplets.begin(); it != triplets.end();){
 		SpeakerTriple trip = (*it);
 		Mat3d invMat = Mat3d(trip.mat).transpose();
+		bool remove = false;
 
 		for (int jj = 0; jj < numSpeakersSigned; ++jj) {
 			// check to see if the current speaker is one of the nodes of the triple
@@ -193,13 +194,15 @@ void Vbap::findSpeakerTriplets(const std::vector<Speaker>& spkrs){
 			bool y_inside = v[1] >= -1e-4;
 			bool z_inside = v[2] >= -1e-4;
 
-			if (x_inside && y_inside && (mIs3D || z_inside)){
+			if (x_inside && y_inside && (!mIs3D || z_inside)){
 				//printf("Removing v=(%f,%f,%f)\n",v[0],v[1],v[2]);
-				triplets.erase(it);
-				--it;
+				remove = true;
 				break;
 			}
 		}
+
+		if (remove) it = triplets.erase(it);
+		else ++it;
 	}
 
 	for(std::list<SpeakerTriple>::iterator it = triplets.begin(); it != triplets.end(); ++it) {
@@ -228,28 +231,21 @@ void Vbap::compile(Listener& listener){
 	}
 }
 
-void Vbap::perform(AudioIOData& io, SoundSource& src, Vec3d& relpos, const int& numFrames, int& frameIndex, float& sample){
+unsigned Vbap::findTriple(const Vec3d& relpos, Vec3d& gains){
 	unsigned currentTripletIndex = mCachedTripletIndex; // Cached source placement, so it starts searching from there.
 
-	Vec3d vec = Vec3d(relpos);
-	//printf("(%f,%f,%f)\n",vec[0],vec[1],vec[2]);
-
 	//Rotate vector according to listener-rotation
 	Quatd srcRot = this->mListener->pose().quat();
-	vec = srcRot.rotate(vec);
+	Vec3d vec = srcRot.rotate(relpos);
 
 	//Silent by default
-	Vec3d gains;
-	Vec3d gainsTemp;
+	gains = Vec3d(0,0,0);
 
 	// Search thru the triplets array in search of a match for the source position.
 	for (unsigned count = 0; count < mNumTriplets; ++count) {
-		gainsTemp = computeGains(vec, mTriplets[currentTripletIndex]);
+		Vec3d gainsTemp = computeGains(vec, mTriplets[currentTripletIndex]);
 		if ((gainsTemp[0] >= 0) && (gainsTemp[1] >= 0) && (!mIs3D || (gainsTemp[2] >= 0)) ){
-			//printf("Gainstemp: (%f,%f,%f)\n",gainsTemp[0],gainsTemp[1],gainsTemp[2]);
-			gainsTemp.normalize();
-			gains = gainsTemp*sample/relpos.mag();
-			//printf("Found: (%d,%d,%d) \n", mTriplets[currentTripletIndex].s1, mTriplets[currentTripletIndex].s2, mTriplets[currentTripletIndex].s3);
+			gains = gainsTemp.normalize();
 			break;
 		}
 
@@ -257,16 +253,21 @@ void Vbap::perform(AudioIOData& io, SoundSource& src, Vec3d& relpos, const int&
 		if (currentTripletIndex >= mNumTriplets){
 			currentTripletIndex = 0;
 		}
-		//printf("Index: %d\n",count);
 	}
-	//printf("Gains: (%f,%f,%f)\n",gains[0],gains[1],gains[2]);
 
-	SpeakerTriple triple = mTriplets[currentTripletIndex];
+	return currentTripletIndex;
+}
+
+void Vbap::perform(AudioIOData& io, SoundSource& src, Vec3d& relpos, const int& numFrames, int& frameIndex, float& sample){
+	Vec3d gains;
+	unsigned currentTripletIndex = findTriple(relpos, gains);
+	gains *= sample/relpos.mag();
+
+	SpeakerTriple& triple = mTriplets[currentTripletIndex];
 
 	if(mCachedTripletIndex!=currentTripletIndex){
 		printf("Triple: (%d,%d,%d)\n",triple.s1,triple.s2,triple.s3);
 		printf("Gains: (%f,%f,%f)\n",gains[0],gains[1],gains[2]);
-		printf("Gains-temp: (%f,%f,%f)\n",gainsTemp[0],gainsTemp[1],gainsTemp[2]);
 	}
 
 	mCachedTripletIndex = currentTripletIndex; // Store the new index
@@ -278,6 +279,26 @@ void Vbap::perform(AudioIOData& io, SoundSource& src, Vec3d& relpos, const int&
 	}
 }
 
+void Vbap::perform(AudioIOData& io, SoundSource& src, Vec3d& relpos, const int& numFrames, float *samples){
+	// The source position is constant over the buffer, so the triplet and
+	// gains only need to be found once
+	Vec3d gains;
+	mCachedTripletIndex = findTriple(relpos, gains);
+	gains /= relpos.mag();
+
+	const SpeakerTriple& triple = mTriplets[mCachedTripletIndex];
+	const int numOuts = mIs3D ? 3 : 2;
+	const int chans[3] = { triple.s1, triple.s2, triple.s3 };
+
+	for(int k = 0; k < numOuts; ++k){
+		float * out = io.outBuffer(chans[k]);
+		float gain = gains[k];
+		for(int i = 0; i < numFrames; ++i){
+			out[i] += gain * samples[i];
+		}
+	}
+}
+
 void Vbap::print() {
 	printf("Number of Triplets: %d\n",mNumTriplets);
 	for (unsigned i = 0; i < mNumTriplets; i++) {
@@ -0,0 +1,224 @@
+#include "allocore/spatial/al_FrustumCuller.hpp"
+#include "allocore/spatial/al_HashSpace.hpp"
+#include "allocore/system/al_ThreadPool.hpp"
+
+namespace al{
+
+namespace{
+
+const int B = 32;	// objects per mask word
+
+inline float minf(float a, float b){ return a < b ? a : b; }
+
+// Make a mask word from per-object flags of 0 or 1
+inline uint32_t packBits(const int * f, int n){
+	uint32_t w = 0;
+	for(int k=0; k<n; ++k) w |= uint32_t(f[k]) << k;
+	return w;
+}
+
+// Append indices of the set bits of a mask word
+inline int unpackBits(int * out, uint32_t w, int base, int n){
+	int k = 0;
+	for(int i=0; i<n; ++i){
+		out[k] = base + i;
+		k += (w >> i) & 1;
+	}
+	return k;
+}
+
+} // ::
+
+
+struct FrustumCuller::MaskSpheres{
+	const FrustumCuller * culler;
+	uint32_t * visible;
+	const SphereArray * spheres;
+	void operator()(int begin, int end){
+		int n = spheres->size();
+		culler->maskSpheres(visible + begin, *spheres, begin*B, end*B < n ? end*B : n);
+	}
+};
+
+struct FrustumCuller::MaskBoxes{
+	const FrustumCuller * culler;
+	uint32_t * visible;
+	const BoxArray * boxes;
+	void operator()(int begin, int end){
+		int n = boxes->size();
+		culler->maskBoxes(visible + begin, *boxes, begin*B, end*B < n ? end*B : n);
+	}
+};
+
+
+// The kernels take the smallest signed distance over the planes for a block
+// of objects. Each plane is applied to the whole block before the next, so
+// the inner loops run over objects and vectorize.
+
+void FrustumCuller::maskSpheres(uint32_t * visible, const SphereArray& s, int begin, int end) const {
+	for(int i=begin; i<end; i+=B){
+		const int n = end-i < B ? end-i : B;
+		const float * x = &s.x[i];
+		const float * y = &s.y[i];
+		const float * z = &s.z[i];
+		const float * r = &s.r[i];
+		float m[B];
+		for(int k=0; k<n; ++k) m[k] = x[k]*mNx[0] + y[k]*mNy[0] + z[k]*mNz[0] + mD[0];
+		for(int p=1; p<6; ++p){
+			const float nx=mNx[p], ny=mNy[p], nz=mNz[p], d=mD[p];
+			for(int k=0; k<n; ++k) m[k] = minf(m[k], x[k]*nx + y[k]*ny + z[k]*nz + d);
+		}
+		int f[B];
+		for(int k=0; k<n; ++k) f[k] = m[k] >= -r[k];
+		visible[(i-begin)/B] = packBits(f, n);
+	}
+}
+
+// Only the corner furthest along each plane's normal is tested
+void FrustumCuller::maskBoxes(uint32_t * visible, const BoxArray& b, int begin, int end) const {
+	for(int i=begin; i<end; i+=B){
+		const int n = end-i < B ? end-i : B;
+		float m[B];
+		for(int p=0; p<6; ++p){
+			const float nx=mNx[p], ny=mNy[p], nz=mNz[p], d=mD[p];
+			const float * x = nx > 0 ? &b.x1[i] : &b.x0[i];
+			const float * y = ny > 0 ? &b.y1[i] : &b.y0[i];
+			const float * z = nz > 0 ? &b.z1[i] : &b.z0[i];
+			if(0 == p){
+				for(int k=0; k<n; ++k) m[k] = x[k]*nx + y[k]*ny + z[k]*nz + d;
+			}
+			else{
+				for(int k=0; k<n; ++k) m[k] = minf(m[k], x[k]*nx + y[k]*ny + z[k]*nz + d);
+			}
+		}
+		int f[B];
+		for(int k=0; k<n; ++k) f[k] = m[k] >= 0.f;
+		visible[(i-begin)/B] = packBits(f, n);
+	}
+}
+
+void FrustumCuller::mask(uint32_t * visible, const SphereArray& s) const {
+	maskSpheres(visible, s, 0, s.size());
+}
+
+void FrustumCuller::mask(uint32_t * visible, const BoxArray& b) const {
+	maskBoxes(visible, b, 0, b.size());
+}
+
+// Work is split on mask words, so no two threads write the same word
+void FrustumCuller::mask(uint32_t * visible, const SphereArray& s, ThreadPool& pool) const {
+	MaskSpheres body = { this, visible, &s };
+	pool.parallelFor(0, (s.size()+B-1)/B, body, 64);
+}
+
+void FrustumCuller::mask(uint32_t * visible, const BoxArray& b, ThreadPool& pool) const {
+	MaskBoxes body = { this, visible, &b };
+	pool.parallelFor(0, (b.size()+B-1)/B, body, 64);
+}
+
+int FrustumCuller::indices(int * visible, const SphereArray& s) const {
+	const int N = s.size();
+	int count = 0;
+	for(int i=0; i<N; i+=B){
+		const int n = N-i < B ? N-i : B;
+		uint32_t w;
+		maskSpheres(&w, s, i, i+n);
+		count += unpackBits(visible + count, w, i, n);
+	}
+	return count;
+}
+
+int FrustumCuller::indices(int * visible, const BoxArray& b) const {
+	const int N = b.size();
+	int count = 0;
+	for(int i=0; i<N; i+=B){
+		const int n = N-i < B ? N-i : B;
+		uint32_t w;
+		maskBoxes(&w, b, i, i+n);
+		count += unpackBits(visible + count, w, i, n);
+	}
+	return count;
+}
+
+int FrustumCuller::maskToIndices(int * visible, const uint32_t * mask, int n){
+	int count = 0;
+	for(int i=0; i<n; i+=B){
+		count += unpackBits(visible + count, mask[i/B], i, n-i < B ? n-i : B);
+	}
+	return count;
+}
+
+int FrustumCuller::classify(const float * lo, const float * hi) const {
+	int result = Frustumd::INSIDE;
+	for(int p=0; p<6; ++p){
+		const float n[3] = { mNx[p], mNy[p], mNz[p] };
+		float dp = mD[p], dn = mD[p];
+		for(int k=0; k<3; ++k){
+			dp += n[k] * (n[k] > 0 ? hi[k] : lo[k]);
+			dn += n[k] * (n[k] > 0 ? lo[k] : hi[k]);
+		}
+		if(dp < 0) return Frustumd::OUTSIDE;
+		if(dn < 0) result = Frustumd::INTERSECT;
+	}
+	return result;
+}
+
+void FrustumCuller::cullRegion(
+	std::vector<int>& visible, const HashSpace& space, float radius,
+	const int * org, int size, int leaf
+) const {
+	float lo[3], hi[3];
+	for(int k=0; k<3; ++k){
+		lo[k] = org[k] - radius;
+		hi[k] = org[k] + size + radius;
+	}
+	const int c = classify(lo, hi);
+	if(Frustumd::OUTSIDE == c) return;
+
+	if(Frustumd::INTERSECT == c && size > leaf){
+		const int h = size/2;
+		for(int i=0; i<8; ++i){
+			int o[3] = { org[0] + (i&1)*h, org[1] + ((i>>1)&1)*h, org[2] + ((i>>2)&1)*h };
+			cullRegion(visible, space, radius, o, h, leaf);
+		}
+		return;
+	}
+
+	// Either the region is inside, or it is small enough that its objects
+	// are tested one at a time
+	const HashSpace::Object * first = &space.mObjects[0];
+	for(int z=org[2]; z<org[2]+size; ++z){
+	for(int y=org[1]; y<org[1]+size; ++y){
+	for(int x=org[0]; x<org[0]+size; ++x){
+		const HashSpace::Object * head = space.mVoxels[space.hash(x,y,z)].mObjects;
+		if(!head) continue;
+		const HashSpace::Object * o = head;
+		do{
+			bool in = true;
+			if(Frustumd::INTERSECT == c){
+				for(int p=0; p<6 && in; ++p){
+					in = o->pos[0]*mNx[p] + o->pos[1]*mNy[p] + o->pos[2]*mNz[p] + mD[p] >= -radius;
+				}
+			}
+			if(in) visible.push_back(int(o - first));
+			o = o->next;
+		} while(o != head);
+	}}}
+}
+
+int FrustumCuller::indices(std::vector<int>& visible, const HashSpace& space, float radius) const {
+	const int count = visible.size();
+	if(space.numObjects()){
+		// Regions are not subdivided once they hold only a few objects on
+		// average, since testing those is cheaper than testing sub-regions
+		const int dim = space.dim();
+		const double perVoxel = double(space.numObjects()) / (double(dim)*dim*dim);
+		int leaf = 1;
+		while(leaf < dim && perVoxel * (8*leaf*leaf*leaf) <= 4) leaf *= 2;
+		const int org[3] = {0,0,0};
+		cullRegion(visible, space, radius, org, dim, leaf);
+	}
+	return visible.size() - count;
+}
+
+} // al::
@@ -1,3 +1,4 @@
+#include <string.h>
 #include "allocore/spatial/al_Pose.hpp"
 
 namespace al{
@@ -216,4 +217,119 @@ void Nav::step(double dt){
 	}
 }
 
+
+
+void PoseArray::resize(int n){
+	px.resize(n, 0.f); py.resize(n, 0.f); pz.resize(n, 0.f);
+	qw.resize(n, 1.f); qx.resize(n, 0.f); qy.resize(n, 0.f); qz.resize(n, 0.f);
+}
+
+void PoseArray::set(int i, const Pose& p){
+	px[i] = p.pos()[0]; py[i] = p.pos()[1]; pz[i] = p.pos()[2];
+	qw[i] = p.quat().w; qx[i] = p.quat().x; qy[i] = p.quat().y; qz[i] = p.quat().z;
+}
+
+Pose PoseArray::get(int i) const {
+	return Pose(Vec3d(px[i], py[i], pz[i]), Quatd(qw[i], qx[i], qy[i], qz[i]));
+}
+
+// Compose poses given as component arrays. Parent components are indexed
+// with a stride PS of 1 for arrays or 0 for a single parent. Results go
+// through a block on the stack, which allows out to alias an input while
+// the compiler can still tell that the loop's loads and stores do not
+// overlap and vectorize it.
+template <int PS>
+static void composePoses(
+	float * opx, float * opy, float * opz, float * oqw, float * oqx, float * oqy, float * oqz,
+	const float * ppx, const float * ppy, const float * ppz,
+	const float * pqw, const float * pqx, const float * pqy, const float * pqz,
+	const float * lpx, const float * lpy, const float * lpz,
+	const float * lqw, const float * lqx, const float * lqy, const float * lqz,
+	int n
+){
+	enum{ BLOCK = 64 };
+	float r[7][BLOCK];
+	for(int b=0; b<n; b+=BLOCK){
+		const int m = n-b < BLOCK ? n-b : BLOCK;
+		for(int k=0; k<m; ++k){
+			const int i = b+k;
+			const int j = i*PS;
+			const float w = pqw[j], x = pqx[j], y = pqy[j], z = pqz[j];
+			const float vx = lpx[i], vy = lpy[i], vz = lpz[i];
+			const float qw = lqw[i], qx = lqx[i], qy = lqy[i], qz = lqz[i];
+
+			// Rotate local position as in Quat::rotate
+			const float tw =-x*vx - y*vy - z*vz;
+			const float tx = w*vx + y*vz - z*vy;
+			const float ty = w*vy - x*vz + z*vx;
+			const float tz = w*vz + x*vy - y*vx;
+			r[0][k] = ppx[j] + tx*w - tw*x + tz*y - ty*z;
+			r[1][k] = ppy[j] + ty*w - tw*y + tx*z - tz*x;
+			r[2][k] = ppz[j] + tz*w - tw*z + ty*x - tx*y;
+
+			// Multiply orientations as in Quat::multiply
+			r[3][k] = w*qw - x*qx - y*qy - z*qz;
+			r[4][k] = w*qx + x*qw + y*qz - z*qy;
+			r[5][k] = w*qy + y*qw + z*qx - x*qz;
+			r[6][k] = w*qz + z*qw + x*qy - y*qx;
+		}
+		float * const o[7] = { opx+b, opy+b, opz+b, oqw+b, oqx+b, oqy+b, oqz+b };
+		for(int c=0; c<7; ++c) memcpy(o[c], r[c], m*sizeof(float));
+	}
+}
+
+void PoseArray::compose(PoseArray& out, const PoseArray& parent, const PoseArray& local){
+	const int n = local.size() < parent.size() ? local.size() : parent.size();
+	out.resize(n);
+	if(!n) return;
+	composePoses<1>(
+		&out.px[0], &out.py[0], &out.pz[0], &out.qw[0], &out.qx[0], &out.qy[0], &out.qz[0],
+		&parent.px[0], &parent.py[0], &parent.pz[0],
+		&parent.qw[0], &parent.qx[0], &parent.qy[0], &parent.qz[0],
+		&local.px[0], &local.py[0], &local.pz[0],
+		&local.qw[0], &local.qx[0], &local.qy[0], &local.qz[0],
+		n
+	);
+}
+
+void PoseArray::compose(PoseArray& out, const Pose& parent, const PoseArray& local){
+	const int n = local.size();
+	out.resize(n);
+	if(!n) return;
+	const float pp[3] = { float(parent.pos()[0]), float(parent.pos()[1]), float(parent.pos()[2]) };
+	const float pq[4] = { float(parent.quat().w), float(parent.quat().x), float(parent.quat().y), float(parent.quat().z) };
+	composePoses<0>(
+		&out.px[0], &out.py[0], &out.pz[0], &out.qw[0], &out.qx[0], &out.qy[0], &out.qz[0],
+		pp, pp+1, pp+2, pq, pq+1, pq+2, pq+3,
+		&local.px[0], &local.py[0], &local.pz[0],
+		&local.qw[0], &local.qx[0], &local.qy[0], &local.qz[0],
+		n
+	);
+}
+
+void PoseArray::matrices(float * m) const {
+	const int n = size();
+	for(int i=0; i<n; ++i){
+		const float w = qw[i], x = qx[i], y = qy[i], z = qz[i];
+		float * c = m + 16*i;
+		// Same as Quat::toMatrix for a unit quaternion
+		c[ 0] = 1.f - 2.f*(y*y + z*z);
+		c[ 1] = 2.f*(x*y + z*w);
+		c[ 2] = 2.f*(x*z - y*w);
+		c[ 3] = 0.f;
+		c[ 4] = 2.f*(x*y - z*w);
+		c[ 5] = 1.f - 2.f*(x*x + z*z);
+		c[ 6] = 2.f*(y*z + x*w);
+		c[ 7] = 0.f;
+		c[ 8] = 2.f*(x*z + y*w);
+		c[ 9] = 2.f*(y*z - x*w);
+		c[10] = 1.f - 2.f*(x*x + y*y);
+		c[11] = 0.f;
+		c[12] = px[i];
+		c[13] = py[i];
+		c[14] = pz[i];
+		c[15] = 1.f;
+	}
+}
+
 } // al::
@@ -11,14 +11,138 @@ extern "C" void al_main_native_init();
 extern "C" void al_main_native_attach(al_sec interval);
 extern "C" void al_main_native_enter(al_sec interval);
 extern "C" void al_main_native_stop();
+extern "C" bool al_main_native_watch(int fd, void * handler);
+extern "C" void al_main_native_unwatch(int fd);
+extern "C" void al_main_native_wake();
 
 #ifdef AL_LINUX
+	#include <errno.h>
+	#include <stdint.h>
+	#include <string.h>
+	#include <unistd.h>
+	#include <sys/epoll.h>
+	#include <sys/eventfd.h>
+	#include <sys/timerfd.h>
+	#include <vector>
+
+	// The native loop sleeps in epoll until the tick timer (timerfd) fires,
+	// the loop is woken (eventfd) or a watched descriptor is readable.
+	namespace{
+		struct Watch{
+			int fd;
+			al::Main::FDHandler * handler;
+		};
+
+		int gEpollFD = -1;
+		int gTimerFD = -1;
+		int gWakeFD = -1;
+		al_sec gTimerInterval = 0;
+		std::vector<Watch *> gWatches;
+		std::vector<Watch *> gRetired;	// unwatched during dispatch
+
+		bool epollAdd(int fd, void * data){
+			epoll_event ev;
+			ev.events = EPOLLIN;
+			ev.data.ptr = data;
+			return 0 == epoll_ctl(gEpollFD, EPOLL_CTL_ADD, fd, &ev);
+		}
+	}
+
 	extern "C" void al_main_native_init(){
-		AL_WARN("Linux native loop not yet implemented");
+		gEpollFD = epoll_create1(EPOLL_CLOEXEC);
+		gTimerFD = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+		gWakeFD = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if(gEpollFD < 0 || gTimerFD < 0 || gWakeFD < 0
+			|| !epollAdd(gTimerFD, &gTimerFD) || !epollAdd(gWakeFD, &gWakeFD)
+		){
+			AL_WARN("Could not create Linux native loop: %s", strerror(errno));
+		}
+	}
+
+	extern "C" void al_main_native_attach(al_sec interval){
+		// A zero itimerspec would disarm the timer and leave the loop
+		// waiting forever
+		gTimerInterval = interval;
+		if(interval < 0.001) interval = 0.001;
+		itimerspec t;
+		t.it_interval.tv_sec = time_t(interval);
+		t.it_interval.tv_nsec = long((interval - t.it_interval.tv_sec) * 1e9);
+		t.it_value = t.it_interval;
+		timerfd_settime(gTimerFD, 0, &t, NULL);
+	}
+
+	extern "C" void al_main_native_enter(al_sec interval){
+		al::Main& M = al::Main::get();
+		al_main_native_attach(interval);
+
+		epoll_event events[16];
+		while(M.isRunning()){
+			int n = epoll_wait(gEpollFD, events, 16, -1);
+			if(n < 0){
+				if(EINTR == errno) continue;
+				AL_WARN("Linux native loop failed: %s", strerror(errno));
+				break;
+			}
+
+			for(int i=0; i<n && M.isRunning(); ++i){
+				void * data = events[i].data.ptr;
+				uint64_t count;
+				if(&gTimerFD == data){
+					// Ticks missed while busy are not made up
+					if(read(gTimerFD, &count, sizeof(count)) > 0) M.tick();
+				}
+				else if(&gWakeFD == data){
+					if(read(gWakeFD, &count, sizeof(count))){}
+				}
+				else{
+					Watch * w = static_cast<Watch *>(data);
+					if(w->handler) w->handler->onReadable(w->fd);
+				}
+			}
+
+			for(unsigned i=0; i<gRetired.size(); ++i) delete gRetired[i];
+			gRetired.clear();
+
+			// Main::interval() wakes the loop so a new interval applies now
+			// rather than at the next tick
+			if(M.interval() != gTimerInterval) al_main_native_attach(M.interval());
+		}
+	}
+
+	extern "C" void al_main_native_stop(){
+		al_main_native_wake();
+	}
+
+	extern "C" bool al_main_native_watch(int fd, void * handler){
+		al_main_native_unwatch(fd);
+		Watch * w = new Watch;
+		w->fd = fd;
+		w->handler = static_cast<al::Main::FDHandler *>(handler);
+		if(!epollAdd(fd, w)){
+			AL_WARN("Could not watch file descriptor %d: %s", fd, strerror(errno));
+			delete w;
+			return false;
+		}
+		gWatches.push_back(w);
+		return true;
+	}
+
+	extern "C" void al_main_native_unwatch(int fd){
+		for(unsigned i=0; i<gWatches.size(); ++i){
+			if(gWatches[i]->fd == fd){
+				epoll_ctl(gEpollFD, EPOLL_CTL_DEL, fd, NULL);
+				gWatches[i]->handler = 0;
+				gRetired.push_back(gWatches[i]);
+				gWatches.erase(gWatches.begin() + i);
+				return;
+			}
+		}
+	}
+
+	extern "C" void al_main_native_wake(){
+		uint64_t one = 1;
+		if(write(gWakeFD, &one, sizeof(one))){}
 	}
-	extern "C" void al_main_native_attach(al_sec interval){}
-	extern "C" void al_main_native_enter(al_sec interval){}
-	extern "C" void al_main_native_stop(){}
 
 #elif defined AL_WINDOWS
 	extern "C" void al_main_native_init(){
@@ -27,6 +151,9 @@ extern "C" void al_main_native_stop();
 	extern "C" void al_main_native_attach(al_sec interval){}
 	extern "C" void al_main_native_enter(al_sec interval){}
 	extern "C" void al_main_native_stop(){}
+	extern "C" bool al_main_native_watch(int fd, void * handler){ return false; }
+	extern "C" void al_main_native_unwatch(int fd){}
+	extern "C" void al_main_native_wake(){}
 #endif
 
 
@@ -249,6 +376,26 @@ Main& Main::remove(Main::Handler& v) {
 	return *this;
 }
 
+Main& Main::interval(al_sec v) {
+	mInterval = v > 0.001 ? v : 0.001;
+	if (mActive && NATIVE == mDriver) al_main_native_wake();
+	return *this;
+}
+
+bool Main::watch(int fd, Main::FDHandler& h) {
+	if (NATIVE != mDriver) return false;
+	return al_main_native_watch(fd, &h);
+}
+
+Main& Main::unwatch(int fd) {
+	if (mInited[NATIVE]) al_main_native_unwatch(fd);
+	return *this;
+}
+
+void Main::wake() {
+	if (mInited[NATIVE]) al_main_native_wake();
+}
+
 
 } //al::
 
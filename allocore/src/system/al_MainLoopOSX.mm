@@ -126,3 +126,8 @@ extern "C" void al_main_native_stop(){
 	[gClock dealloc]; // this will stop the timer
 	[NSApp stop:nil]; // exits run loop after last event is processed
 }
+
+// File descriptor watches are not yet supported by the Cocoa loop
+extern "C" bool al_main_native_watch(int fd, void * handler){ return false; }
+extern "C" void al_main_native_unwatch(int fd){}
+extern "C" void al_main_native_wake(){}
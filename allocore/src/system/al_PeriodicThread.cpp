@@ -1,20 +1,106 @@
 #include <algorithm>
+#include "allocore/system/al_Atomic.hpp"
 #include "allocore/system/al_PeriodicThread.hpp"
 
+#if defined(__linux__)
+	#include <errno.h>
+	#include <time.h>
+	#define AL_PERIODIC_CLOCK_NANOSLEEP
+#endif
+
 namespace al{
 
+// Time on a clock that is not affected by changes to the system time
+static al_nsec monotonicNow(){
+	#ifdef AL_PERIODIC_CLOCK_NANOSLEEP
+		timespec t;
+		clock_gettime(CLOCK_MONOTONIC, &t);
+		return al_nsec(t.tv_sec)*1000000000 + t.tv_nsec;
+	#else
+		return al_time_nsec();
+	#endif
+}
+
+// Sleep until an absolute time from monotonicNow()
+static void sleepUntil(al_nsec deadline){
+	#ifdef AL_PERIODIC_CLOCK_NANOSLEEP
+		timespec t;
+		t.tv_sec = deadline / 1000000000;
+		t.tv_nsec = deadline % 1000000000;
+		while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, NULL) == EINTR){}
+	#else
+		al_nsec dt = deadline - monotonicNow();
+		if(dt > 0) al_sleep_nsec(dt);
+	#endif
+}
+
+// Statistics are written by the periodic thread only and read by any
+// thread, so each value is accessed atomically
+static void add(unsigned long& v, unsigned long x){
+	storeRelaxed(v, loadRelaxed(v) + x);
+}
+
+static void addHist(unsigned long * hist, al_nsec& maxVal, al_nsec dt){
+	add(hist[PeriodicThread::Stats::bin(dt)], 1);
+	if(dt > loadRelaxed(maxVal)) storeRelaxed(maxVal, dt);
+}
+
+
+int PeriodicThread::Stats::bin(al_nsec dt){
+	al_nsec us = dt / 1000;
+	int i = 0;
+	while(us && i < NUM_BINS-1){ us >>= 1; ++i; }
+	return i;
+}
+
+double PeriodicThread::Stats::binEdge(int i){
+	return double(1UL << i) * 1e-6;
+}
+
+double PeriodicThread::Stats::percentile(const unsigned long * hist, double p){
+	unsigned long total = 0;
+	for(int i=0; i<NUM_BINS; ++i) total += hist[i];
+	double target = p * total;
+	unsigned long sum = 0;
+	for(int i=0; i<NUM_BINS; ++i){
+		sum += hist[i];
+		if(sum && sum >= target) return binEdge(i);
+	}
+	return 0;
+}
+
+double PeriodicThread::Stats::execMean() const {
+	return iterations ? execSum * 1e-9 / iterations : 0;
+}
+
+void PeriodicThread::Stats::clear(){
+	storeRelaxed(iterations, 0UL);
+	storeRelaxed(overruns, 0UL);
+	storeRelaxed(skipped, 0UL);
+	for(int i=0; i<NUM_BINS; ++i){
+		storeRelaxed(jitter[i], 0UL);
+		storeRelaxed(exec[i], 0UL);
+	}
+	storeRelaxed(jitterMax, al_nsec(0));
+	storeRelaxed(execMax, al_nsec(0));
+	storeRelaxed(execSum, al_nsec(0));
+	storeRelaxed(periodSmoothed, al_nsec(0));
+}
+
+
 PeriodicThread::PeriodicThread(double periodSec)
-:	mAutocorrect(0.1)
+:	mAutocorrect(0.1), mOverrunPolicy(CATCH_UP), mUserFunc(0),
+	mRun(false), mResetStats(false)
 {
 	period(periodSec);
+	mStats.clear();
 }
 
 PeriodicThread::PeriodicThread(const PeriodicThread& o)
-:	Thread(o), mPeriod(o.mPeriod), mTimeCurr(o.mTimeCurr),
-	mTimePrev(o.mTimePrev), mWait(o.mWait), mTimeBehind(o.mTimeBehind),
-	mAutocorrect(o.mAutocorrect),
+:	Thread(o), mPeriod(o.mPeriod),
+	mAutocorrect(o.mAutocorrect), mOverrunPolicy(o.mOverrunPolicy),
 	mUserFunc(o.mUserFunc),
-	mRun(o.mRun)
+	mRun(o.mRun), mResetStats(o.mResetStats), mStats(o.mStats)
 {}
 
 
@@ -29,13 +115,18 @@ PeriodicThread& PeriodicThread::autocorrect(float factor){
 	return *this;
 }
 
+PeriodicThread& PeriodicThread::overrunPolicy(OverrunPolicy v){
+	mOverrunPolicy=v;
+	return *this;
+}
+
 PeriodicThread& PeriodicThread::period(double sec){
-	mPeriod=sec * 1e9;
+	storeRelaxed(mPeriod, al_nsec(sec * 1e9));
 	return *this;
 }
 
 double PeriodicThread::period() const {
-	return mPeriod * 1e-9;
+	return loadRelaxed(mPeriod) * 1e-9;
 }
 
 void PeriodicThread::start(ThreadFunction& func){
@@ -45,7 +136,27 @@ void PeriodicThread::start(ThreadFunction& func){
 }
 
 void PeriodicThread::stop(){
-	mRun = false;
+	storeRelease(mRun, false);
+}
+
+PeriodicThread::Stats PeriodicThread::stats() const {
+	Stats s;
+	s.iterations = loadRelaxed(mStats.iterations);
+	s.overruns = loadRelaxed(mStats.overruns);
+	s.skipped = loadRelaxed(mStats.skipped);
+	for(int i=0; i<Stats::NUM_BINS; ++i){
+		s.jitter[i] = loadRelaxed(mStats.jitter[i]);
+		s.exec[i] = loadRelaxed(mStats.exec[i]);
+	}
+	s.jitterMax = loadRelaxed(mStats.jitterMax);
+	s.execMax = loadRelaxed(mStats.execMax);
+	s.execSum = loadRelaxed(mStats.execSum);
+	s.periodSmoothed = loadRelaxed(mStats.periodSmoothed);
+	return s;
+}
+
+void PeriodicThread::resetStats(){
+	storeRelease(mResetStats, true);
 }
 
 
@@ -54,11 +165,12 @@ void swap(PeriodicThread& a, PeriodicThread& b){
 	swap(static_cast<Thread&>(a), static_cast<Thread&>(b));
 	#define SWAP_(x) swap(a.x, b.x);
 	SWAP_(mPeriod);
-	SWAP_(mTimeCurr);
-	SWAP_(mTimePrev);
-	SWAP_(mWait);
+	SWAP_(mAutocorrect);
+	SWAP_(mOverrunPolicy);
 	SWAP_(mUserFunc);
 	SWAP_(mRun);
+	SWAP_(mResetStats);
+	SWAP_(mStats);
 	#undef SWAP_
 }
 
@@ -69,44 +181,58 @@ PeriodicThread& PeriodicThread::operator= (PeriodicThread other){
 
 void PeriodicThread::go(){
 	// Note: times are al_nsec (long long int)
-	mTimeCurr = al_time_nsec();
-	mWait = 0;
-	mTimeBehind = 0;
-	while(mRun){
-		(*mUserFunc)();
+	al_nsec period = loadRelaxed(mPeriod);
+	DelayLockedLoop dll(period * 1e-9);
+	al_nsec deadline = monotonicNow();
 
-		mTimePrev = mTimeCurr + mWait;
-		mTimeCurr = al_time_nsec();
-		al_nsec dt = mTimeCurr - mTimePrev;
-		// dt -> t_curr - (t_prev + wait)
+	while(loadAcquire(mRun)){
+		const al_nsec wake = monotonicNow();
 
-		// The wait amount is the ideal period minus the actual amount
-		// of time spent processing between iterations
-		if(dt<mPeriod){
-			mWait = mPeriod - dt;
-			al_sleep_nsec(mWait);
+		if(loadAcquire(mResetStats)){
+			mStats.clear();
+			storeRelease(mResetStats, false);
 		}
 
-		// This means we are behind, so don't wait
-		else{
-			mWait = 0;
-			mTimeBehind += dt - mPeriod;
+		al_nsec p = loadRelaxed(mPeriod);
+		if(p != period){
+			period = p;
+			dll = DelayLockedLoop(period * 1e-9);
 		}
+		dll.step(wake * 1e-9);
+		storeRelaxed(mStats.periodSmoothed, al_nsec(dll.period_smoothed() * 1e9));
 
-		if(mTimeBehind > 0){
-			al_nsec comp = mPeriod*mAutocorrect;
-			if(mTimeBehind < comp){
-				comp = mTimeBehind;
-				mTimeBehind = 0;
-			}
-			else{
-				mTimeBehind -= comp;
+		(*mUserFunc)();
+
+		const al_nsec done = monotonicNow();
+		add(mStats.iterations, 1);
+		addHist(mStats.jitter, mStats.jitterMax, wake > deadline ? wake - deadline : 0);
+		addHist(mStats.exec, mStats.execMax, done - wake);
+		storeRelaxed(mStats.execSum, loadRelaxed(mStats.execSum) + (done - wake));
+
+		deadline += period;
+		al_nsec target = deadline;
+
+		if(done > deadline){
+			add(mStats.overruns, 1);
+
+			if(SKIP == mOverrunPolicy){
+				// Resume at the first deadline after now
+				al_nsec missed = (done - deadline) / period + 1;
+				deadline += missed * period;
+				target = deadline;
+				add(mStats.skipped, missed);
+				dll.reset();
 			}
+		}
 
-			mWait -= comp;
+		// When behind, shorten periods by no more than the autocorrect
+		// fraction until back on schedule
+		if(CATCH_UP == mOverrunPolicy){
+			al_nsec earliest = wake + al_nsec(period * (1.f - mAutocorrect));
+			if(target < earliest) target = earliest;
 		}
 
-		//printf("period=%g, dt=%g, wait=%g\n", mPeriod, dt, mWait);
+		sleepUntil(target);
 	}
 }
 
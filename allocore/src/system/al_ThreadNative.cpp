@@ -7,6 +7,9 @@
 	#define USE_THREADEX
 #else
 	#define USE_PTHREAD
+	#include <errno.h>
+	#include <pthread.h>
+	#include <sched.h>
 #endif
 
 namespace al {
@@ -20,14 +23,39 @@ namespace al {
 
 struct Thread::Impl{
 	Impl()
-	:	mHandle(0)
+	:	mHandle(0), mPriority(0), mAffinity(0), mAttrAffinity(0)
 	{ //printf("Thread::Impl(): %p\n", this);
+		initAttr();
+	}
+
+	void initAttr(){
 		pthread_attr_init(&mAttr);
 
 		// threads are not required to be joinable by default, so make it so
 		pthread_attr_setdetachstate(&mAttr, PTHREAD_CREATE_JOINABLE);
+		priority(mPriority);
 	}
 
+	#ifdef __linux__
+	// Put the processor mask into the attributes. There is no portable way
+	// to unset a mask, so the attributes are rebuilt to allow any processor.
+	void attrAffinity(unsigned long long cpuMask){
+		if(cpuMask){
+			cpu_set_t cpus;
+			CPU_ZERO(&cpus);
+			for(int i=0; i<64; ++i){
+				if((cpuMask >> i) & 1) CPU_SET(i, &cpus);
+			}
+			pthread_attr_setaffinity_np(&mAttr, sizeof(cpus), &cpus);
+		}
+		else{
+			pthread_attr_destroy(&mAttr);
+			initAttr();
+		}
+		mAttrAffinity = cpuMask;
+	}
+	#endif
+
 	~Impl(){ //printf("Thread::~Impl(): %p\n", this);
 		pthread_attr_destroy(&mAttr);
 	}
@@ -35,8 +63,31 @@ struct Thread::Impl{
 
 	bool start(ThreadFunction& func){
 		if(mHandle) return false;
+
+		#ifdef __linux__
+		if(mAffinity != mAttrAffinity) attrAffinity(mAffinity);
+		#endif
+
 		//return 0 == pthread_create(&mHandle, NULL, cThreadFunc, &func);
-		return 0 == pthread_create(&mHandle, &mAttr, cThreadFunc, &func);
+		int err = pthread_create(&mHandle, &mAttr, cThreadFunc, &func);
+
+		// Real-time scheduling usually needs privileges; fall back to the
+		// creating thread's scheduling rather than not running at all
+		if(EPERM == err){
+			pthread_attr_setinheritsched(&mAttr, PTHREAD_INHERIT_SCHED);
+			err = pthread_create(&mHandle, &mAttr, cThreadFunc, &func);
+		}
+
+		#ifdef __linux__
+		// A mask with no existing processors is rejected; likewise, run on
+		// any processor rather than not at all
+		if(EINVAL == err && mAttrAffinity){
+			attrAffinity(0);
+			err = pthread_create(&mHandle, &mAttr, cThreadFunc, &func);
+		}
+		#endif
+		if(err) mHandle = 0;
+		return 0 == err;
 	}
 
 	bool join(){
@@ -48,6 +99,7 @@ struct Thread::Impl{
 	}
 
 	void priority(int v){
+		mPriority = v;
 		struct sched_param param;
 		if(v >= 1 && v <= 99){
 			param.sched_priority = v;
@@ -56,15 +108,20 @@ struct Thread::Impl{
 			pthread_attr_setschedpolicy(&mAttr, SCHED_FIFO);
 			//pthread_attr_setschedpolicy(&mAttr, SCHED_RR);
 			pthread_attr_setschedparam(&mAttr, &param);
+			// without this, the policy is inherited from the creating thread
+			pthread_attr_setinheritsched(&mAttr, PTHREAD_EXPLICIT_SCHED);
 		}
 		else{
 			param.sched_priority = 0;
 			//pthread_setschedparam(mHandle, SCHED_OTHER, &param);
 			pthread_attr_setschedpolicy(&mAttr, SCHED_OTHER);
 			pthread_attr_setschedparam(&mAttr, &param);
+			pthread_attr_setinheritsched(&mAttr, PTHREAD_INHERIT_SCHED);
 		}
 	}
 
+	void affinity(unsigned long long cpuMask){ mAffinity = cpuMask; }
+
 //	bool cancel(){
 //		return 0 == pthread_cancel(mHandle);
 //	}
@@ -75,6 +132,9 @@ struct Thread::Impl{
 
 	pthread_t mHandle;
 	pthread_attr_t mAttr;
+	int mPriority;
+	unsigned long long mAffinity;
+	unsigned long long mAttrAffinity;	// mask currently set in mAttr
 
 	static void * cThreadFunc(void * user){
 		ThreadFunction& tfunc = *((ThreadFunction*)user);
@@ -103,13 +163,18 @@ void * Thread::current(){
 //#define THREAD_FUNCTION(name) unsigned _stdcall * name(void * user)
 
 struct Thread::Impl{
-	Impl(): mHandle(0){}
+	Impl(): mHandle(0), mPriority(0), mAffinity(0){}
 
 	bool start(ThreadFunction& func){
 		if(mHandle) return false;
 		unsigned thread_id;
-		mHandle = _beginthreadex(NULL, 0, cThreadFunc, &func, 0, &thread_id);
-		if(mHandle) return true;
+		mHandle = _beginthreadex(NULL, 0, cThreadFunc, &func, CREATE_SUSPENDED, &thread_id);
+		if(mHandle){
+			if(mPriority > 0) SetThreadPriority((HANDLE)mHandle, THREAD_PRIORITY_TIME_CRITICAL);
+			if(mAffinity) SetThreadAffinityMask((HANDLE)mHandle, (DWORD_PTR)mAffinity);
+			ResumeThread((HANDLE)mHandle);
+			return true;
+		}
 		return false;
 	}
 
@@ -123,9 +188,10 @@ struct Thread::Impl{
 		return false;
 	}
 
-	// TODO: Threadx priority
-	void priority(int v){
-	}
+	// Any real-time priority maps to the highest thread priority
+	void priority(int v){ mPriority = v; }
+
+	void affinity(unsigned long long cpuMask){ mAffinity = cpuMask; }
 
 //	bool cancel(){
 //		TerminateThread((HANDLE)mHandle, 0);
@@ -136,6 +202,8 @@ struct Thread::Impl{
 //	}
 
 	unsigned long mHandle;
+	int mPriority;
+	unsigned long long mAffinity;
 //	ThreadFunction mRoutine;
 
 	static unsigned _stdcall cThreadFunc(void * user){
@@ -209,6 +277,11 @@ Thread& Thread::priority(int v){
 	return *this;
 }
 
+Thread& Thread::affinity(unsigned long long cpuMask){
+	mImpl->affinity(cpuMask);
+	return *this;
+}
+
 bool Thread::start(ThreadFunction& func){
 	return mImpl->start(func);
 }
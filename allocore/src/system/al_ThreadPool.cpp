@@ -0,0 +1,263 @@
+#include "allocore/system/al_Atomic.hpp"
+#include "allocore/system/al_Info.hpp"
+#include "allocore/system/al_ThreadPool.hpp"
+#include "allocore/system/al_Time.h"
+
+#if defined(_MSC_VER)
+	#define AL_THREAD_LOCAL __declspec(thread)
+#else
+	#define AL_THREAD_LOCAL __thread
+#endif
+
+namespace al{
+
+// Pool and deque of the calling thread; threads outside of any pool use
+// deque 0 of each pool
+static AL_THREAD_LOCAL ThreadPool * tlsPool = 0;
+static AL_THREAD_LOCAL int tlsDeque = 0;
+
+// Hint to the processor that we are busy-waiting
+static inline void cpuPause(){
+	#if defined(__i386__) || defined(__x86_64__)
+		__builtin_ia32_pause();
+	#elif defined(_MSC_VER)
+		YieldProcessor();
+	#endif
+}
+
+
+struct ThreadPool::Item{
+	Job * job;
+	long begin, end;
+};
+
+
+// Fixed-capacity work-stealing deque (Chase and Lev, 2005; memory orderings
+// after Le et al., 2013). The owning thread pushes and pops at the bottom,
+// other threads steal from the top. Item fields are accessed atomically
+// since a thief may read a slot while the owner overwrites it; the thief's
+// compare-and-swap on top then fails and the item is discarded.
+class ThreadPool::Deque{
+public:
+	Deque(): mTop(0), mBottom(0){}
+
+	bool push(const Item& v){
+		long b = loadRelaxed(mBottom);
+		long t = loadAcquire(mTop);
+		if(b - t >= long(Capacity)) return false;
+		Slot& s = mSlots[b & (Capacity-1)];
+		storeRelaxed(s.job, v.job);
+		storeRelaxed(s.begin, v.begin);
+		storeRelaxed(s.end, v.end);
+		storeRelease(mBottom, b+1);
+		return true;
+	}
+
+	bool pop(Item& v){
+		long b = loadRelaxed(mBottom) - 1;
+		storeRelaxed(mBottom, b);
+		fenceSeqCst();
+		long t = loadRelaxed(mTop);
+		if(t > b){
+			storeRelaxed(mBottom, b+1);
+			return false;
+		}
+		load(v, b);
+		if(t == b){ // last item; race against thieves
+			bool won = compareAndSwap(mTop, t, t+1);
+			storeRelaxed(mBottom, b+1);
+			return won;
+		}
+		return true;
+	}
+
+	bool steal(Item& v){
+		long t = loadAcquire(mTop);
+		fenceSeqCst();
+		long b = loadAcquire(mBottom);
+		if(t >= b) return false;
+		load(v, t);
+		return compareAndSwap(mTop, t, t+1);
+	}
+
+private:
+	enum{ Capacity = 256, CacheLine = 64 };
+
+	struct Slot{
+		Job * volatile job;
+		volatile long begin, end;
+	};
+
+	volatile long mTop;
+	char mPad1[CacheLine - sizeof(long)];
+	volatile long mBottom;
+	char mPad2[CacheLine - sizeof(long)];
+	Slot mSlots[Capacity];
+
+	void load(Item& v, long i) const {
+		const Slot& s = mSlots[i & (Capacity-1)];
+		v.job = loadRelaxed(s.job);
+		v.begin = loadRelaxed(s.begin);
+		v.end = loadRelaxed(s.end);
+	}
+};
+
+
+void ThreadPool::Worker::operator()(){
+	pool->workerLoop(index);
+}
+
+
+ThreadPool::ThreadPool(int numWorkers)
+:	mPriority(0), mSpinTime(0.0002), mDeques(0), mRunning(false)
+{
+	if(numWorkers < 0) numWorkers = numProcessors() - 1;
+	resize(numWorkers);
+}
+
+ThreadPool::~ThreadPool(){
+	stop();
+	delete[] mDeques;
+}
+
+ThreadPool& ThreadPool::resize(int n){
+	if(mRunning) return *this;
+	if(n < 0) n = 0;
+	mAffinity.assign(n, 0);
+	mWorkers.resize(n);
+	delete[] mDeques;
+	mDeques = new Deque[n+1];
+	for(int i=0; i<n; ++i){
+		mWorkers.function(i).pool = this;
+		mWorkers.function(i).index = i;
+	}
+	return *this;
+}
+
+ThreadPool& ThreadPool::priority(int v){
+	mPriority = v;
+	return *this;
+}
+
+ThreadPool& ThreadPool::affinity(int worker, unsigned long long cpuMask){
+	if(worker >= 0 && worker < size()) mAffinity[worker] = cpuMask;
+	return *this;
+}
+
+ThreadPool& ThreadPool::pin(int firstCPU){
+	int numCPUs = numProcessors();
+	if(numCPUs > 64) numCPUs = 64;
+	if(numCPUs < 1) numCPUs = 1;
+	for(int i=0; i<size(); ++i){
+		mAffinity[i] = 1ULL << ((firstCPU + i) % numCPUs);
+	}
+	return *this;
+}
+
+ThreadPool& ThreadPool::spinTime(double sec){
+	mSpinTime = sec;
+	return *this;
+}
+
+bool ThreadPool::start(){
+	if(mRunning) return true;
+	storeRelease(mRunning, true);
+	bool ok = true;
+	for(int i=0; i<size(); ++i){
+		Thread& t = mWorkers.thread(i);
+		t.priority(mPriority).affinity(mAffinity[i]);
+		ok &= t.start(mWorkers.function(i));
+	}
+	if(!ok) stop();
+	return ok;
+}
+
+void ThreadPool::stop(){
+	if(!mRunning) return;
+	storeRelease(mRunning, false);
+	mWorkers.join();
+}
+
+int ThreadPool::currentDeque() const {
+	return tlsPool == this ? tlsDeque : 0;
+}
+
+void ThreadPool::run(Job& job, int begin, int end){
+	const int d = currentDeque();
+	Item item = { &job, begin, end };
+	execute(item, d);
+
+	// Help out until all pieces, including stolen ones, are done
+	int misses = 0;
+	while(loadAcquire(job.pending)){
+		if(findWork(item, d)){
+			execute(item, d);
+			misses = 0;
+		}
+		else if(++misses < 64){
+			cpuPause();
+		}
+		else{
+			al_sleep_nsec(0);
+		}
+	}
+}
+
+void ThreadPool::execute(Item& item, int d){
+	Job& job = *item.job;
+	long b = item.begin, e = item.end;
+
+	// Leave upper halves for others; if the deque is full, run it all here
+	while(e - b > job.grain){
+		long m = b + (e - b)/2;
+		Item upper = { &job, m, e };
+		if(!mDeques[d].push(upper)) break;
+		e = m;
+	}
+
+	(*job.func)(int(b), int(e));
+
+	// The job may be gone once this is seen by the waiting thread
+	fetchAdd(job.pending, -(e - b));
+}
+
+bool ThreadPool::findWork(Item& item, int d){
+	if(mDeques[d].pop(item)) return true;
+	const int n = size() + 1;
+	for(int k=1; k<n; ++k){
+		if(mDeques[(d + k) % n].steal(item)) return true;
+	}
+	return false;
+}
+
+void ThreadPool::workerLoop(int index){
+	tlsPool = this;
+	tlsDeque = index + 1;
+
+	al_sec idleSince = -1;
+	al_nsec nap = 50000;
+
+	while(loadAcquire(mRunning)){
+		Item item;
+		if(findWork(item, tlsDeque)){
+			execute(item, tlsDeque);
+			idleSince = -1;
+			nap = 50000;
+			continue;
+		}
+
+		al_sec now = al_time();
+		if(idleSince < 0) idleSince = now;
+		if(now - idleSince < mSpinTime){
+			cpuPause();
+		}
+		else{
+			al_sleep_nsec(nap);
+			if(nap < 1000000) nap *= 2;
+		}
+	}
+
+	tlsPool = 0;
+}
+
+} // al::
@@ -1,9 +1,17 @@
 #include <stdio.h>
 #include "allocore/types/al_Array.hpp"
 
+#ifndef AL_WINDOWS
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
 namespace al{
 
 Array::Array(){
+	initMap();
 	data.ptr = NULL;
 	header.type= 0;
 	header.components = 1;
@@ -12,29 +20,35 @@ Array::Array(){
 }
 
 Array::Array(const AlloArray& cpy){
+	initMap();
 	data.ptr = 0;
     (*this) = cpy;
 }
 Array::Array(const Array& cpy) {
+	initMap();
 	data.ptr = 0;
     (*this) = cpy;
 }
 Array::Array(const AlloArrayHeader& h2){
+	initMap();
 	allo_array_clear(this);
 	format(h2);
 }
 
 Array::Array(int comps, AlloTy ty, uint32_t dimx){
+	initMap();
 	allo_array_clear(this);
 	format(comps, ty, dimx);
 }
 
 Array::Array(int comps, AlloTy ty, uint32_t dimx, uint32_t dimy){
+	initMap();
 	allo_array_clear(this);
 	format(comps, ty, dimx, dimy);
 }
 
 Array::Array(int comps, AlloTy ty, uint32_t dimx, uint32_t dimy, uint32_t dimz){
+	initMap();
 	allo_array_clear(this);
 	format(comps, ty, dimx, dimy, dimz);
 }
@@ -79,14 +93,30 @@ void Array::configure(const AlloArrayHeader& h2) {
 
 void Array::dataCalloc() { allo_array_allocate(this); }
 
-void Array::dataFree() { allo_array_free(this); }
+void Array::dataFree() {
+	if(isMapped()){
+		#ifndef AL_WINDOWS
+		munmap(mMapBase, mMapSize);
+		#endif
+		initMap();
+		data.ptr = NULL;
+	}
+	else{
+		allo_array_free(this);
+	}
+}
 
 void Array::deriveStride(AlloArrayHeader& h, size_t alignSize) {
 	allo_array_setstride(&h, alignSize);
 }
 
 void Array::format(const AlloArrayHeader& h2) {
-	if(!isFormat(h2)) {
+	if(isMapped()){
+		dataFree();
+		configure(h2);
+		dataCalloc();
+	}
+	else if(!isFormat(h2)) {
 		if(size() != allo_array_size_from_header(&h2)){
 			dataFree();
 			configure(h2);
@@ -140,10 +170,79 @@ void Array::formatAlignedGeneral(int comps, AlloTy ty, uint32_t * dims, int numD
 }
 
 void Array::zero(){
-	if(hasData())
+	if(isMapped() && MAPPED_READ == mMapMode){
+		dataFree();
+		dataCalloc();
+	}
+	else if(hasData())
 		memset(data.ptr, 0, size());
 }
 
+bool Array::map(const std::string& path, const AlloArrayHeader& h, size_t offset, MapMode mode){
+	dataFree();
+	size_t len = allo_array_size_from_header(&h);
+	if(0 == len) return false;
+
+	#ifdef AL_WINDOWS
+	// No mapping support here, so fall back to reading into memory
+	FILE * fp = fopen(path.c_str(), "rb");
+	if(NULL == fp) return false;
+	configure(h);
+	dataCalloc();
+	bool ok = 0 == fseek(fp, offset, SEEK_SET) && 1 == fread(data.ptr, len, 1, fp);
+	fclose(fp);
+	if(!ok) dataFree();
+	return ok;
+
+	#else
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if(fd < 0) return false;
+
+	struct stat st;
+	if(0 != fstat(fd, &st) || size_t(st.st_size) < offset + len){
+		::close(fd);
+		return false;
+	}
+
+	// mmap offsets must be page aligned
+	size_t lead = offset % size_t(sysconf(_SC_PAGESIZE));
+
+	void * base = mmap(
+		NULL, len + lead,
+		MAPPED_READ == mode ? PROT_READ : PROT_READ | PROT_WRITE,
+		MAPPED_READ == mode ? MAP_SHARED : MAP_PRIVATE,
+		fd, offset - lead
+	);
+
+	// the mapping keeps its own reference to the file
+	::close(fd);
+
+	if(MAP_FAILED == base) return false;
+
+	configure(h);
+	mMapBase = base;
+	mMapSize = len + lead;
+	mMapMode = mode;
+	data.ptr = (char *)base + lead;
+	return true;
+	#endif
+}
+
+void Array::advise(MapAdvice v){
+	#ifndef AL_WINDOWS
+	if(!isMapped()) return;
+	int a = MADV_NORMAL;
+	switch(v){
+		case ADVISE_SEQUENTIAL:	a = MADV_SEQUENTIAL; break;
+		case ADVISE_RANDOM:		a = MADV_RANDOM; break;
+		case ADVISE_WILLNEED:	a = MADV_WILLNEED; break;
+		case ADVISE_DONTNEED:	a = MADV_DONTNEED; break;
+		default:;
+	}
+	madvise(mMapBase, mMapSize, a);
+	#endif
+}
+
 void Array::print(FILE * fp) const {
 	/*printf("Array %p type %s components %d %d-D: ( ", this, allo_type_name(type()), components(), dimcount());
 	for (int i=0; i<dimcount(); i++) printf("%d(stride %d) ", dim(i), stride(i));
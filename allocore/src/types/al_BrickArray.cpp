@@ -0,0 +1,316 @@
+#include <string.h>
+#include <algorithm>
+#include "allocore/types/al_BrickArray.hpp"
+
+#ifdef AL_ZLIB
+	#include <zlib.h>
+#endif
+
+namespace al{
+
+/*
+File layout:
+	char[12]			magic "AlloBricks1"
+	AlloArrayHeader		dense layout of the whole volume (1-byte aligned)
+	uint32_t			brick size
+	uint32_t			(reserved)
+	uint64_t			byte offset of brick index
+	...					brick data
+	uint64_t[2N]		brick index; per brick the byte offset of its data
+						followed by (stored size << 32 | codec)
+*/
+static const char BRICK_MAGIC[12] = "AlloBricks1";
+static const size_t BRICK_INDEX_POS = 12 + sizeof(AlloArrayHeader) + 2*sizeof(uint32_t);
+
+static int seek64(FILE * fp, uint64_t pos){
+	#ifdef AL_WINDOWS
+	return _fseeki64(fp, pos, SEEK_SET);
+	#else
+	return fseeko(fp, off_t(pos), SEEK_SET);
+	#endif
+}
+
+static uint64_t tell64(FILE * fp){
+	#ifdef AL_WINDOWS
+	return _ftelli64(fp);
+	#else
+	return ftello(fp);
+	#endif
+}
+
+static size_t cellBytes(const AlloArrayHeader& h){
+	return h.components * allo_type_size(h.type);
+}
+
+bool brickCodecAvailable(BrickCodec c){
+	switch(c){
+	case BRICK_RAW: return true;
+	#ifdef AL_ZLIB
+	case BRICK_DEFLATE: return true;
+	#endif
+	default: return false;
+	}
+}
+
+
+
+BrickArrayWriter::BrickArrayWriter()
+:	mFP(NULL), mBrickSize(0), mSlice(0), mCodec(BRICK_RAW)
+{
+	allo_array_header_clear(&mHeader);
+	mBricks[0] = mBricks[1] = mBricks[2] = 0;
+}
+
+BrickArrayWriter::~BrickArrayWriter(){
+	close();
+}
+
+bool BrickArrayWriter::open(
+	const std::string& path,
+	int components, AlloTy ty, uint32_t dimx, uint32_t dimy, uint32_t dimz,
+	uint32_t brickSize, BrickCodec codec
+){
+	close();
+	if(0 == brickSize || 0 == dimx || 0 == dimy || 0 == dimz) return false;
+
+	mFP = fopen(path.c_str(), "wb");
+	if(NULL == mFP) return false;
+
+	mHeader.type = ty;
+	mHeader.components = components;
+	mHeader.dimcount = 3;
+	mHeader.dim[0] = dimx;
+	mHeader.dim[1] = dimy;
+	mHeader.dim[2] = dimz;
+	mHeader.dim[3] = 0;
+	Array::deriveStride(mHeader, 1);
+
+	mBrickSize = brickSize;
+	mCodec = brickCodecAvailable(codec) ? codec : BRICK_RAW;
+	mSlice = 0;
+	for(int i=0; i<3; ++i) mBricks[i] = (mHeader.dim[i] + brickSize - 1) / brickSize;
+
+	mLayer.assign(size_t(mHeader.stride[2]) * brickSize, 0);
+	mBrick.resize(cellBytes(mHeader) * brickSize*brickSize*brickSize);
+	mIndex.assign(2 * mBricks[0]*mBricks[1]*mBricks[2], 0);
+
+	uint32_t info[2] = {brickSize, 0};
+	uint64_t indexOffset = 0;	// patched on close
+	fwrite(BRICK_MAGIC, 1, 12, mFP);
+	fwrite(&mHeader, sizeof(AlloArrayHeader), 1, mFP);
+	fwrite(info, sizeof(uint32_t), 2, mFP);
+	return 1 == fwrite(&indexOffset, sizeof(uint64_t), 1, mFP);
+}
+
+bool BrickArrayWriter::writeSlice(const void * cells){
+	if(!opened() || mSlice >= mHeader.dim[2]) return false;
+	size_t sliceBytes = mHeader.stride[2];
+	memcpy(&mLayer[0] + (mSlice % mBrickSize) * sliceBytes, cells, sliceBytes);
+	++mSlice;
+	if(0 == mSlice % mBrickSize || mSlice == mHeader.dim[2]){
+		return flushLayer();
+	}
+	return true;
+}
+
+bool BrickArrayWriter::write(const Array& volume){
+	if(!opened()) return false;
+	if(volume.dimcount() != 3 || volume.type() != mHeader.type
+	|| volume.components() != mHeader.components) return false;
+	for(int i=0; i<3; ++i) if(volume.dim(i) != mHeader.dim[i]) return false;
+
+	// Repack rows in case the source rows are padded
+	std::vector<char> slice(mHeader.stride[2]);
+	size_t rowBytes = mHeader.stride[1];
+	for(uint32_t z=0; z<volume.dim(2); ++z){
+		for(uint32_t y=0; y<volume.dim(1); ++y){
+			memcpy(&slice[y*rowBytes], volume.cell<char>(0,y,z), rowBytes);
+		}
+		if(!writeSlice(&slice[0])) return false;
+	}
+	return true;
+}
+
+bool BrickArrayWriter::flushLayer(){
+	const uint32_t bs = mBrickSize;
+	const size_t cb = cellBytes(mHeader);
+	const uint32_t bz = (mSlice-1) / bs;
+	const uint32_t z0 = bz * bs;
+
+	for(uint32_t by=0; by<mBricks[1]; ++by){
+	for(uint32_t bx=0; bx<mBricks[0]; ++bx){
+
+		// Gather brick, zero-padding cells beyond the volume bounds
+		memset(&mBrick[0], 0, mBrick.size());
+		uint32_t nx = std::min(bs, mHeader.dim[0] - bx*bs);
+		uint32_t ny = std::min(bs, mHeader.dim[1] - by*bs);
+		uint32_t nz = std::min(bs, mSlice - z0);
+		for(uint32_t z=0; z<nz; ++z){
+		for(uint32_t y=0; y<ny; ++y){
+			const char * src = &mLayer[0] + z*mHeader.stride[2] + (by*bs + y)*mHeader.stride[1] + bx*bs*cb;
+			memcpy(&mBrick[0] + ((z*bs + y)*bs)*cb, src, nx*cb);
+		}}
+
+		const char * out = &mBrick[0];
+		uint64_t outSize = mBrick.size();
+		BrickCodec codec = BRICK_RAW;
+
+		#ifdef AL_ZLIB
+		if(BRICK_DEFLATE == mCodec){
+			uLongf packedSize = compressBound(mBrick.size());
+			mPacked.resize(packedSize);
+			if(Z_OK == compress2((Bytef *)&mPacked[0], &packedSize, (const Bytef *)&mBrick[0], mBrick.size(), Z_BEST_SPEED)
+				&& packedSize < mBrick.size()
+			){
+				out = &mPacked[0];
+				outSize = packedSize;
+				codec = BRICK_DEFLATE;
+			}
+		}
+		#endif
+
+		uint32_t i = bx + mBricks[0]*(by + mBricks[1]*bz);
+		mIndex[2*i  ] = tell64(mFP);
+		mIndex[2*i+1] = (outSize << 32) | uint64_t(codec);
+		if(outSize != fwrite(out, 1, outSize, mFP)) return false;
+	}}
+	return true;
+}
+
+bool BrickArrayWriter::close(){
+	if(!opened()) return false;
+	bool complete = mSlice == mHeader.dim[2];
+	if(complete){
+		uint64_t indexOffset = tell64(mFP);
+		complete = mIndex.size() == fwrite(&mIndex[0], sizeof(uint64_t), mIndex.size(), mFP);
+		seek64(mFP, BRICK_INDEX_POS);
+		complete &= 1 == fwrite(&indexOffset, sizeof(uint64_t), 1, mFP);
+	}
+	fclose(mFP);
+	mFP = NULL;
+	std::vector<char>().swap(mLayer);
+	return complete;
+}
+
+
+
+BrickArray::BrickArray(unsigned cacheBricks)
+:	mFP(NULL), mBrickSize(0), mCapacity(cacheBricks<1 ? 1 : cacheBricks), mMisses(0)
+{
+	allo_array_header_clear(&mHeader);
+	mBricks[0] = mBricks[1] = mBricks[2] = 0;
+}
+
+BrickArray::~BrickArray(){
+	close();
+}
+
+bool BrickArray::open(const std::string& path){
+	close();
+	mFP = fopen(path.c_str(), "rb");
+	if(NULL == mFP) return false;
+
+	char magic[12];
+	uint32_t info[2];
+	uint64_t indexOffset = 0;
+	if(	12 != fread(magic, 1, 12, mFP)
+	||	0 != memcmp(magic, BRICK_MAGIC, 12)
+	||	1 != fread(&mHeader, sizeof(AlloArrayHeader), 1, mFP)
+	||	2 != fread(info, sizeof(uint32_t), 2, mFP)
+	||	1 != fread(&indexOffset, sizeof(uint64_t), 1, mFP)
+	||	0 == indexOffset || 0 == info[0]
+	){
+		close();
+		return false;
+	}
+
+	mBrickSize = info[0];
+	for(int i=0; i<3; ++i) mBricks[i] = (mHeader.dim[i] + mBrickSize - 1) / mBrickSize;
+	size_t N = mBricks[0]*mBricks[1]*mBricks[2];
+
+	mIndex.resize(2*N);
+	seek64(mFP, indexOffset);
+	if(mIndex.size() != fread(&mIndex[0], sizeof(uint64_t), mIndex.size(), mFP)){
+		close();
+		return false;
+	}
+
+	mCache.assign(N, (Array *)NULL);
+	mCachePos.resize(N);
+	mMisses = 0;
+	return true;
+}
+
+void BrickArray::close(){
+	while(!mLRU.empty()) evict();
+	mCache.clear();
+	mCachePos.clear();
+	mIndex.clear();
+	if(mFP) fclose(mFP);
+	mFP = NULL;
+}
+
+void BrickArray::cacheCapacity(unsigned v){
+	mCapacity = v<1 ? 1 : v;
+	while(mLRU.size() > mCapacity) evict();
+}
+
+void BrickArray::evict(){
+	uint32_t i = mLRU.back();
+	mLRU.pop_back();
+	delete mCache[i];
+	mCache[i] = NULL;
+}
+
+const Array * BrickArray::brick(uint32_t bx, uint32_t by, uint32_t bz){
+	if(bx >= mBricks[0] || by >= mBricks[1] || bz >= mBricks[2]) return NULL;
+	uint32_t i = bx + mBricks[0]*(by + mBricks[1]*bz);
+
+	if(mCache[i]){
+		// move to front of LRU
+		mLRU.splice(mLRU.begin(), mLRU, mCachePos[i]);
+		return mCache[i];
+	}
+
+	if(mLRU.size() >= mCapacity) evict();
+
+	Array * b = new Array;
+	uint32_t bs = mBrickSize;
+	b->formatAligned(mHeader.components, mHeader.type, bs, bs, bs, 1);
+	if(!load(i, *b)){
+		delete b;
+		return NULL;
+	}
+	++mMisses;
+	mCache[i] = b;
+	mLRU.push_front(i);
+	mCachePos[i] = mLRU.begin();
+	return b;
+}
+
+bool BrickArray::load(uint32_t i, Array& dst){
+	uint64_t offset = mIndex[2*i];
+	uint64_t storedSize = mIndex[2*i+1] >> 32;
+	BrickCodec codec = BrickCodec(mIndex[2*i+1] & 0xffffffff);
+
+	if(0 != seek64(mFP, offset)) return false;
+
+	if(BRICK_RAW == codec){
+		return storedSize == dst.size()
+			&& storedSize == fread(dst.data.ptr, 1, storedSize, mFP);
+	}
+
+	#ifdef AL_ZLIB
+	if(BRICK_DEFLATE == codec){
+		mPacked.resize(storedSize);
+		if(storedSize != fread(&mPacked[0], 1, storedSize, mFP)) return false;
+		uLongf size = dst.size();
+		return Z_OK == uncompress((Bytef *)dst.data.ptr, &size, (const Bytef *)&mPacked[0], storedSize)
+			&& size == dst.size();
+	}
+	#endif
+
+	return false;
+}
+
+} // al::
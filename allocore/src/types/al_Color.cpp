@@ -1,6 +1,9 @@
 #include "allocore/types/al_Color.hpp"
+#include "allocore/math/al_Functions.hpp"
 #include "allocore/math/al_Mat.hpp"
 #include <cmath>
+#include <string.h>
+#include <stdint.h>
 
 namespace al{
 
@@ -342,4 +345,332 @@ Colori& Colori::operator=(const HCLuv& v){
 }
 
 
+
+
+// Batch conversions -----------------------------------------------------------
+
+/*	Colors are converted in blocks: each block is split into one array per
+	component, converted by a loop without branches or library calls that the
+	compiler can vectorize, then interleaved into the output. Powers,
+	logarithms and trigonometric functions are replaced by truncated series on
+	reduced ranges, each accurate to a few units in the last place of a float,
+	so results agree with the scalar conversions to within about 1e-5 relative
+	to the range of each component.
+*/
+namespace{
+
+const float PI_F = 3.14159265358979f;
+const float TAU_F = 6.28318530717959f;
+const float LAB_EPS = 216.f / 24389.f;
+const float LAB_KAPPA = 24389.f / 27.f;
+const float XN = 0.95047f, YN = 1.f, ZN = 1.08883f;	// D65 reference white
+const float UR = 4.f*XN / (XN + 15.f*YN + 3.f*ZN);	// u' and v' of white
+const float VR = 9.f*YN / (XN + 15.f*YN + 3.f*ZN);
+
+inline float asFloat(int32_t i){ float f; memcpy(&f, &i, 4); return f; }
+inline int32_t asInt(float f){ int32_t i; memcpy(&i, &f, 4); return i; }
+
+// Choose between two values with a bit mask; unlike ?:, this does not stop
+// the compiler from vectorizing when one of the values is computed by
+// floating-point arithmetic that could trap
+inline float select(bool c, float a, float b){
+	int32_t m = -int32_t(c);
+	return asFloat((asInt(a) & m) | (asInt(b) & ~m));
+}
+inline float minf(float a, float b){ return select(a<b, a, b); }
+inline float maxf(float a, float b){ return select(a>b, a, b); }
+
+// Base 2 logarithm of a positive normal number
+inline float log2Approx(float x){
+	int32_t i = asInt(x);
+	int32_t e = ((i >> 23) & 255) - 127;
+	float m = asFloat((i & 0x7fffff) | 0x3f800000);	// mantissa in [1, 2)
+	// Center the mantissa on 1, then use log(m) = 2 atanh((m-1)/(m+1))
+	bool hi = m > 1.41421356f;
+	m = select(hi, m*0.5f, m);
+	e += hi;
+	float z = (m - 1.f) / (m + 1.f);					// |z| < 0.172
+	float z2 = z*z;
+	float p = 2.88539008f + z2*(0.961796694f + z2*(0.577078016f + z2*(0.412198583f + z2*0.320598898f)));
+	return float(e) + z*p;
+}
+
+// Base 2 exponential
+inline float exp2Approx(float x){
+	x = minf(maxf(x, -126.f), 127.f);
+	int32_t i = int32_t(x);
+	i -= x < float(i);									// floor
+	float l = (x - float(i) - 0.5f) * 0.693147181f;	// |l| <= ln(2)/2
+	float p = 1.f + l*(1.f + l*(0.5f + l*(0.166666667f + l*(0.0416666667f + l*(0.00833333333f + l*0.00138888889f)))));
+	return p * 1.41421356f * asFloat((i + 127) << 23);
+}
+
+// x^y for positive x
+inline float powApprox(float x, float y){
+	return exp2Approx(y * log2Approx(x));
+}
+
+// Sine of x in [-pi, pi]
+inline float sinApprox(float x){
+	x = select(x >  0.5f*PI_F,  PI_F - x, x);
+	x = select(x < -0.5f*PI_F, -PI_F - x, x);
+	float x2 = x*x;
+	return x*(1.f + x2*(-0.166666667f + x2*(0.00833333333f + x2*(-1.98412698e-4f + x2*(2.75573192e-6f + x2*-2.50521084e-8f)))));
+}
+
+// Cosine of x in [-pi, pi]
+inline float cosApprox(float x){
+	x += 0.5f*PI_F;
+	return sinApprox(select(x > PI_F, x - TAU_F, x));
+}
+
+// Arctangent of y/x in [-pi, pi]
+inline float atan2Approx(float y, float x){
+	float ax = select(x<0.f, -x, x);
+	float ay = select(y<0.f, -y, y);
+	float mx = maxf(ax, ay);
+	float r = minf(ax, ay) / select(mx > 0.f, mx, 1.f);	// in [0, 1]
+	// atan(r) = pi/4 + atan((r-1)/(r+1)) brings the series argument below tan(pi/8)
+	bool big = r > 0.414213562f;
+	float u = select(big, (r - 1.f) / (r + 1.f), r);
+	float u2 = u*u;
+	float t = u*(1.f + u2*(-0.333333333f + u2*(0.2f + u2*(-0.142857143f + u2*(0.111111111f + u2*(-0.0909090909f + u2*(0.0769230769f + u2*-0.0666666667f)))))));
+	t = select(big, t + 0.25f*PI_F, t);
+	t = select(ay > ax, 0.5f*PI_F - t, t);
+	t = select(x < 0.f, PI_F - t, t);
+	return select(y < 0.f, -t, t);
+}
+
+inline float srgbDecode(float c){
+	float p = powApprox(maxf((c + 0.055f) * (1.f/1.055f), 1e-6f), 2.4f);
+	return select(c <= 0.04045f, c * (1.f/12.92f), p);
+}
+
+inline float srgbEncode(float c){
+	float p = 1.055f * powApprox(maxf(c, 0.0031308f), 1.f/2.4f) - 0.055f;
+	c = select(c <= 0.0031308f, c * 12.92f, p);
+	return minf(maxf(c, 0.f), 1.f);
+}
+
+inline float labForward(float t){
+	float p = powApprox(maxf(t, LAB_EPS), 1.f/3.f);
+	return select(t > LAB_EPS, p, (LAB_KAPPA * t + 16.f) * (1.f/116.f));
+}
+
+inline float labInverse(float f){
+	float f3 = f*f*f;
+	return select(f3 > LAB_EPS, f3, (116.f * f - 16.f) * (1.f/LAB_KAPPA));
+}
+
+inline float hsvChannel(float n, float h6, float s, float v){
+	float k = n + h6;
+	k = select(k >= 6.f, k - 6.f, k);
+	float t = minf(minf(k, 4.f - k), 1.f);
+	return v - v*s*maxf(t, 0.f);
+}
+
+
+// Conversions of single colors given as components, used by convertBlocks
+
+struct HSVToRGB{
+	static void apply(float h, float s, float v, float& r, float& g, float& b){
+		float h6 = h * 6.f;
+		r = hsvChannel(5.f, h6, s, v);
+		g = hsvChannel(3.f, h6, s, v);
+		b = hsvChannel(1.f, h6, s, v);
+	}
+};
+
+struct RGBToHSV{
+	static void apply(float r, float g, float b, float& h, float& s, float& v){
+		float mx = maxf(maxf(r, g), b);
+		float mn = minf(minf(r, g), b);
+		float rng = mx - mn;
+		bool chroma = (rng != 0.f) & (mx != 0.f);
+		float inv = 1.f / select(chroma, rng, 1.f);
+		float hl = select(r == mx, (g - b)*inv, select(g == mx, 2.f + (b - r)*inv, 4.f + (r - g)*inv));
+		hl = select(hl < 0.f, hl + 6.f, hl);
+		h = select(chroma, hl * (1.f/6.f), 0.f);
+		s = select(chroma, rng / select(chroma, mx, 1.f), 0.f);
+		v = mx;
+	}
+};
+
+struct RGBToXYZ{
+	static void apply(float r, float g, float b, float& x, float& y, float& z){
+		r = srgbDecode(r); g = srgbDecode(g); b = srgbDecode(b);
+		x = 0.4124f*r + 0.3576f*g + 0.1805f*b;
+		y = 0.2126f*r + 0.7152f*g + 0.0722f*b;
+		z = 0.0193f*r + 0.1192f*g + 0.9505f*b;
+	}
+};
+
+struct XYZToRGB{
+	static void apply(float x, float y, float z, float& r, float& g, float& b){
+		r = srgbEncode( 3.2405f*x - 1.5371f*y - 0.4985f*z);
+		g = srgbEncode(-0.9693f*x + 1.8760f*y + 0.0416f*z);
+		b = srgbEncode( 0.0556f*x - 0.2040f*y + 1.0572f*z);
+	}
+};
+
+struct XYZToLab{
+	static void apply(float x, float y, float z, float& l, float& a, float& b){
+		float fx = labForward(x * (1.f/XN));
+		float fy = labForward(y * (1.f/YN));
+		float fz = labForward(z * (1.f/ZN));
+		l = 116.f * fy - 16.f;
+		a = 500.f * (fx - fy);
+		b = 200.f * (fy - fz);
+	}
+};
+
+struct LabToXYZ{
+	static void apply(float l, float a, float b, float& x, float& y, float& z){
+		float fy = (l + 16.f) * (1.f/116.f);
+		float fx = a * (1.f/500.f) + fy;
+		float fz = fy - b * (1.f/200.f);
+		x = labInverse(fx) * XN;
+		y = select(l > LAB_EPS*LAB_KAPPA, fy*fy*fy, l * (1.f/LAB_KAPPA)) * YN;
+		z = labInverse(fz) * ZN;
+	}
+};
+
+struct HCLabToLab{
+	static void apply(float h, float c, float l, float& L, float& a, float& b){
+		h -= float(int32_t(h));
+		h = select(h < 0.f, h + 1.f, h);
+		float t = TAU_F * h - PI_F;
+		float m = c * 133.419f;
+		L = l * 100.f;
+		a = m * cosApprox(t);
+		b = m * sinApprox(t);
+	}
+};
+
+struct LabToHCLab{
+	static void apply(float L, float a, float b, float& h, float& c, float& l){
+		h = (atan2Approx(b, a) + PI_F) * (1.f/TAU_F);
+		h = select(h >= 1.f, h - 1.f, h);
+		float m2 = a*a + b*b;
+		c = m2 * invSqrt(m2) * (1.f/133.419f);
+		l = L * 0.01f;
+	}
+};
+
+struct XYZToLuv{
+	static void apply(float x, float y, float z, float& l, float& u, float& v){
+		float d = x + 15.f*y + 3.f*z;
+		float inv = 1.f / select(d > 0.f, d, 1.f);
+		// Same as the Lab lightness, including below the linear threshold
+		l = 116.f * labForward(y * (1.f/YN)) - 16.f;
+		u = 13.f * l * (4.f*x*inv - UR);
+		v = 13.f * l * (9.f*y*inv - VR);
+	}
+};
+
+struct LuvToXYZ{
+	static void apply(float l, float u, float v, float& x, float& y, float& z){
+		bool lit = l > 0.f;
+		float inv = 1.f / (13.f * select(lit, l, 1.f));
+		float up = u*inv + UR;
+		float vp = v*inv + VR;
+		float fy = (l + 16.f) * (1.f/116.f);
+		y = select(l > LAB_EPS*LAB_KAPPA, fy*fy*fy, l * (1.f/LAB_KAPPA)) * YN;
+		float q = y * 0.25f / select(vp != 0.f, vp, 1.f);
+		x = select(lit, 9.f*up*q, 0.f);
+		z = select(lit, (12.f - 3.f*up - 20.f*vp)*q, 0.f);
+	}
+};
+
+struct HCLuvToLuv{
+	static void apply(float h, float c, float l, float& L, float& u, float& v){
+		h -= float(int32_t(h));
+		h = select(h < 0.f, h + 1.f, h);
+		float t = TAU_F * h - PI_F;
+		float m = c * 178.387f;
+		L = l * 100.f;
+		u = m * cosApprox(t);
+		v = m * sinApprox(t);
+	}
+};
+
+struct LuvToHCLuv{
+	static void apply(float L, float u, float v, float& h, float& c, float& l){
+		h = (atan2Approx(v, u) + PI_F) * (1.f/TAU_F);
+		h = select(h >= 1.f, h - 1.f, h);
+		float m2 = u*u + v*v;
+		c = m2 * invSqrt(m2) * (1.f/178.387f);
+		l = L * 0.01f;
+	}
+};
+
+// Applies two conversions in turn
+template <class First, class Second>
+struct Chain{
+	static void apply(float a, float b, float c, float& x, float& y, float& z){
+		First::apply(a, b, c, x, y, z);
+		Second::apply(x, y, z, x, y, z);
+	}
+};
+
+template <class Kernel, class In, class Out>
+void convertBlocks(const In * in, Out * out, int n){
+	enum{ BLOCK = 64 };
+	float a[3][BLOCK] = {{0}}, b[3][BLOCK];
+	for(int i=0; i<n; i+=BLOCK){
+		const int m = n-i < BLOCK ? n-i : BLOCK;
+		for(int j=0; j<m; ++j){
+			a[0][j] = in[i+j][0];
+			a[1][j] = in[i+j][1];
+			a[2][j] = in[i+j][2];
+		}
+		// A fixed count lets the loop be vectorized without a scalar remainder
+		for(int j=0; j<BLOCK; ++j){
+			Kernel::apply(a[0][j], a[1][j], a[2][j], b[0][j], b[1][j], b[2][j]);
+		}
+		for(int j=0; j<m; ++j){
+			out[i+j][0] = b[0][j];
+			out[i+j][1] = b[1][j];
+			out[i+j][2] = b[2][j];
+		}
+	}
+}
+
+} // ::
+
+void convert(const RGB * in, HSV * out, int n){ convertBlocks<RGBToHSV>(in, out, n); }
+void convert(const HSV * in, RGB * out, int n){ convertBlocks<HSVToRGB>(in, out, n); }
+void convert(const HSV * in, Color * out, int n){ convertBlocks<HSVToRGB>(in, out, n); }
+void convert(const RGB * in, CIEXYZ * out, int n){ convertBlocks<RGBToXYZ>(in, out, n); }
+void convert(const CIEXYZ * in, RGB * out, int n){ convertBlocks<XYZToRGB>(in, out, n); }
+void convert(const CIEXYZ * in, Lab * out, int n){ convertBlocks<XYZToLab>(in, out, n); }
+void convert(const Lab * in, CIEXYZ * out, int n){ convertBlocks<LabToXYZ>(in, out, n); }
+void convert(const RGB * in, Lab * out, int n){ convertBlocks<Chain<RGBToXYZ, XYZToLab> >(in, out, n); }
+void convert(const Lab * in, RGB * out, int n){ convertBlocks<Chain<LabToXYZ, XYZToRGB> >(in, out, n); }
+void convert(const Lab * in, HCLab * out, int n){ convertBlocks<LabToHCLab>(in, out, n); }
+void convert(const HCLab * in, Lab * out, int n){ convertBlocks<HCLabToLab>(in, out, n); }
+
+void convert(const RGB * in, HCLab * out, int n){
+	convertBlocks<Chain<Chain<RGBToXYZ, XYZToLab>, LabToHCLab> >(in, out, n);
+}
+
+void convert(const HCLab * in, RGB * out, int n){
+	convertBlocks<Chain<Chain<HCLabToLab, LabToXYZ>, XYZToRGB> >(in, out, n);
+}
+
+void convert(const CIEXYZ * in, Luv * out, int n){ convertBlocks<XYZToLuv>(in, out, n); }
+void convert(const Luv * in, CIEXYZ * out, int n){ convertBlocks<LuvToXYZ>(in, out, n); }
+void convert(const RGB * in, Luv * out, int n){ convertBlocks<Chain<RGBToXYZ, XYZToLuv> >(in, out, n); }
+void convert(const Luv * in, RGB * out, int n){ convertBlocks<Chain<LuvToXYZ, XYZToRGB> >(in, out, n); }
+void convert(const Luv * in, HCLuv * out, int n){ convertBlocks<LuvToHCLuv>(in, out, n); }
+void convert(const HCLuv * in, Luv * out, int n){ convertBlocks<HCLuvToLuv>(in, out, n); }
+
+void convert(const RGB * in, HCLuv * out, int n){
+	convertBlocks<Chain<Chain<RGBToXYZ, XYZToLuv>, LuvToHCLuv> >(in, out, n);
+}
+
+void convert(const HCLuv * in, RGB * out, int n){
+	convertBlocks<Chain<Chain<HCLuvToLuv, LuvToXYZ>, XYZToRGB> >(in, out, n);
+}
+
 } // al::
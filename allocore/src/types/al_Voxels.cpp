@@ -1,11 +1,40 @@
 #include <string>
 #include <iostream>
+#include <string.h>
 #include "allocore/types/al_Voxels.hpp"
 #include "allocore/io/al_File.hpp"
 #include "allocore/system/al_Printing.hpp"
 
 namespace al{
 
+// Version 1 files store the voxel data directly after the size info.
+// Version 2 files store the byte offset of the data after the size info and
+// pad so that the data begins on an AL_VOXELS_DATA_ALIGNMENT boundary.
+static const char VOXELS_MAGIC_V1[12] = "Allo Voxels";
+static const char VOXELS_MAGIC_V2[12] = "AlloVoxels2";
+
+size_t Voxels::readHeader(File& data_file, AlloArrayHeader& h2) {
+  char validHeader[12];
+  if(data_file.read(&validHeader, sizeof(char), 12) != 12) return 0;
+
+  bool v2 = 0 == memcmp(validHeader, VOXELS_MAGIC_V2, 12);
+  if(!v2 && 0 != memcmp(validHeader, VOXELS_MAGIC_V1, 12)) return 0;
+
+  data_file.read(&h2, sizeof(AlloArrayHeader), 1);
+
+  data_file.read(&m_units, sizeof(UnitsTy), 1);
+  data_file.read(&m_sizex, sizeof(float), 1);
+  data_file.read(&m_sizey, sizeof(float), 1);
+  data_file.read(&m_sizez, sizeof(float), 1);
+
+  if(v2){
+    uint64_t offset = 0;
+    data_file.read(&offset, sizeof(uint64_t), 1);
+    return offset;
+  }
+  return 12 + sizeof(AlloArrayHeader) + sizeof(UnitsTy) + 3*sizeof(float);
+}
+
 bool Voxels::loadFromFile(std::string filename) {
   zero();
 
@@ -17,23 +46,46 @@ bool Voxels::loadFromFile(std::string filename) {
     AL_WARN("Cannot open data file");
     exit(EXIT_FAILURE);
   }
-  char validHeader[12];
-  data_file.read(&validHeader, sizeof(char), 12);
 
   AlloArrayHeader h2;
-  data_file.read(&h2, sizeof(AlloArrayHeader), 1);
-  
+  size_t offset = readHeader(data_file, h2);
+  if(0 == offset) {
+    AL_WARN("Not a valid voxel file");
+    exit(EXIT_FAILURE);
+  }
+
   format(h2);
 
-  data_file.read(&m_units, sizeof(UnitsTy), 1);
-  data_file.read(&m_sizex, sizeof(float), 1);
-  data_file.read(&m_sizey, sizeof(float), 1);
-  data_file.read(&m_sizez, sizeof(float), 1);
-  
-  data_file.read(data.ptr, size(), 1);
+  fseek(data_file.filePointer(), offset, SEEK_SET);
+  fread(data.ptr, 1, size(), data_file.filePointer());
+
+  data_file.close();
+
+  return true;
+}
+
+bool Voxels::mapFromFile(std::string filename, MapMode mode) {
+  File data_file(filename, "rb", true);
+
+  if(!data_file.opened()) {
+    AL_WARN("Cannot open data file %s", filename.c_str());
+    return false;
+  }
 
+  AlloArrayHeader h2;
+  size_t offset = readHeader(data_file, h2);
   data_file.close();
 
+  if(0 == offset) {
+    AL_WARN("Not a valid voxel file %s", filename.c_str());
+    return false;
+  }
+
+  if(!map(filename, h2, offset, mode)) {
+    AL_WARN("Cannot map voxel data from %s", filename.c_str());
+    return false;
+  }
+
   return true;
 }
 
@@ -46,9 +98,7 @@ bool Voxels::writeToFile(std::string filename) {
     exit(EXIT_FAILURE);
   }
 
-  char validHeader[12] = "Allo Voxels";
-
-  voxel_file.write(validHeader, sizeof(char), 12);
+  voxel_file.write(VOXELS_MAGIC_V2, sizeof(char), 12);
   
   voxel_file.write(&header, sizeof(AlloArrayHeader), 1);
 
@@ -57,11 +107,18 @@ bool Voxels::writeToFile(std::string filename) {
   voxel_file.write(&m_sizey, sizeof(float), 1);
   voxel_file.write(&m_sizez, sizeof(float), 1);
 
-  voxel_file.write(data.ptr, size(), 1);
+  const size_t headerSize = 12 + sizeof(AlloArrayHeader) + sizeof(UnitsTy) + 3*sizeof(float) + sizeof(uint64_t);
+  uint64_t offset = (headerSize + AL_VOXELS_DATA_ALIGNMENT - 1) / AL_VOXELS_DATA_ALIGNMENT * AL_VOXELS_DATA_ALIGNMENT;
+  voxel_file.write(&offset, sizeof(uint64_t), 1);
+
+  char padding[AL_VOXELS_DATA_ALIGNMENT] = {0};
+  voxel_file.write(padding, sizeof(char), offset - headerSize);
+
+  fwrite(data.ptr, 1, size(), voxel_file.filePointer());
   
   voxel_file.close();
   
   return true;
 }
 
-}
\ No newline at end of file
+}
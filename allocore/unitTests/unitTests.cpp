@@ -28,12 +28,17 @@ int main (int argc, char * const argv[]) {
 	RUNTEST(System);
 	RUNTEST(ProtocolOSC);
 	RUNTEST(ProtocolSerialize);
+	RUNTEST(SoundAmbisonics);
+	RUNTEST(SoundConvolver);
 
+	RUNTEST(IOAudioIOOffline);
 	RUNTEST(IOSocket);
+	RUNTEST(ProtocolStateSync);
 	RUNTEST(File);
 	RUNTEST(Thread);
 
 	RUNTEST(GraphicsMesh);
+	RUNTEST(GraphicsImageLoader);
 
 	// This test should always be run last since it calls exit()
 	printf("IOWindow\n");
@@ -17,14 +17,19 @@
 using namespace al;
 
 int utIOAudioIO();
+int utIOAudioIOOffline();
 int utIOSocket();
 int utIOWindowGL();
 int utMath();
 int utMathSpherical();
 int utGraphicsDraw();
 int utGraphicsMesh();
+int utGraphicsImageLoader();
 int utProtocolOSC();
 int utProtocolSerialize();
+int utProtocolStateSync();
+int utSoundAmbisonics();
+int utSoundConvolver();
 int utSpatial();
 int utSystem();
 int utTypes();
@@ -0,0 +1,78 @@
+#include "utAllocore.h"
+
+namespace {
+struct CountLoads : public ImageLoader::Callback{
+	int loaded, failed;
+	CountLoads(): loaded(0), failed(0){}
+	void onImageLoaded(ImageLoader::Request& req){
+		if(req.ok())	++loaded;
+		else			++failed;
+	}
+};
+} // ::
+
+int utGraphicsImageLoader(){
+
+	const char * path = "utGraphicsImageLoader.png";
+	const int N = 4;
+	unsigned char pixels[N*N*4];
+	for(int i=0; i<N*N*4; ++i) pixels[i] = i*3;
+	assert(Image::save(path, pixels, N,N, Image::RGBA));
+
+	{	ImageLoader loader(2);
+		loader.cacheSize(1);
+		CountLoads cb;
+
+		// Decode on a worker thread
+		ImageLoader::Request req;
+		assert(loader.load(req, path, &cb));
+		req.wait();
+		assert(req.ok());
+		assert(req.image().width() == unsigned(N));
+		assert(req.image().height() == unsigned(N));
+		assert(loader.pending() == 1);
+		assert(loader.poll() == 1);
+		assert(loader.pending() == 0);
+		assert(cb.loaded == 1);
+
+		// Decoded image is now cached
+		const Image * img = loader.cached(path);
+		assert(img);
+		assert(img->width() == unsigned(N));
+
+		// Cache hit is ready without a worker
+		ImageLoader::Request hit;
+		assert(loader.load(hit, path, &cb));
+		assert(hit.ready() && hit.ok());
+		assert(loader.poll() == 1);
+		assert(cb.loaded == 2);
+		for(int j=0; j<N; ++j){
+		for(int i=0; i<N; ++i){
+			Image::RGBAPix<uint8_t> a, b;
+			req.image().read(a, i,j);
+			hit.image().read(b, i,j);
+			assert(a.r==b.r && a.g==b.g && a.b==b.b && a.a==b.a);
+		}}
+
+		// Missing files fail and are not cached
+		ImageLoader::Request bad;
+		assert(loader.load(bad, "utGraphicsImageLoader.missing.png", &cb));
+		bad.wait();
+		assert(!bad.ok());
+		assert(loader.poll() == 1);
+		assert(cb.failed == 1);
+		assert(!loader.cached("utGraphicsImageLoader.missing.png"));
+
+		// A request that was never queued does not block
+		ImageLoader::Request idle;
+		idle.wait();
+		assert(!idle.ready());
+	}
+
+	// Destroying an idle loader wakes and joins its workers
+	{	ImageLoader loader(4);
+	}
+
+	::remove(path);
+	return 0;
+}
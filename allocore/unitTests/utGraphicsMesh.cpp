@@ -43,5 +43,316 @@ int utGraphicsMesh(){
 
 	}
 
+	// Batch transforms match transforming one vector at a time
+	{
+		const int N = 37;
+		Mesh m;
+		for(int i=0; i<N; ++i){
+			m.vertex(i*0.1, 1 - i*0.05, i%3);
+			m.normal(Vec3f(i%2, 1, i*0.1).normalize());
+		}
+		Mesh orig(m);
+
+		Mat4f xfm = Matrix4f::translate(1,2,3) * Matrix4f::rotate(0.7, 0,1,0) * Matrix4f::scale(2,1,0.5);
+		m.transform(xfm, 1, -2);
+		for(int i=0; i<N; ++i){
+			Vec3f v = orig.vertices()[i];
+			if(i >= 1 && i < N-1) v = (xfm * Vec4f(v, 1)).sub<3>();
+			for(int k=0; k<3; ++k) assert(fabs(m.vertices()[i][k] - v[k]) < 1e-5);
+		}
+
+		// Normals stay perpendicular to transformed tangents
+		m.transformNormals(xfm);
+		Vec3f t(1, -2, 0.3f);
+		t = t - orig.normals()[0] * t.dot(orig.normals()[0]);
+		Vec3f tx = (xfm * Vec4f(t, 0)).sub<3>();
+		assert(fabs(tx.dot(m.normals()[0])) < 1e-5);
+		for(int i=0; i<N; ++i) assert(fabs(m.normals()[i].mag() - 1) < 1e-5);
+
+		Mesh r(orig);
+		Quatf q = Quatf().fromAxisAngle(1.1, Vec3f(1,2,3).normalize());
+		r.rotate(q);
+		for(int i=0; i<N; ++i){
+			Vec3f v = q.rotate(orig.vertices()[i]);
+			Vec3f n = q.rotate(orig.normals()[i]);
+			for(int k=0; k<3; ++k){
+				assert(fabs(r.vertices()[i][k] - v[k]) < 1e-5);
+				assert(fabs(r.normals()[i][k] - n[k]) < 1e-5);
+			}
+		}
+	}
+
+	// Batch ribbons and tubes
+	{
+		// A helix long enough to span several blocks of frames, a line too
+		// short to make geometry and a line with width factors
+		const int N = 150;
+		std::vector<Vec3f> helix(N);
+		for(int i=0; i<N; ++i) helix[i].set(cos(i*0.2), sin(i*0.2), i*0.05);
+		Vec3f bend[3] = { Vec3f(0,0,0), Vec3f(1,0,0), Vec3f(1,1,0.5) };
+		float bendWidths[3] = { 1, 2, 3 };
+
+		Polylines lines;
+		lines.add(&helix[0], N);
+		lines.add(&helix[0], 2);
+		lines.add(bend, 3, bendWidths);
+		assert(lines.size() == 3 && lines.size(2) == 3);
+		assert(lines.widths.size() == lines.points.size() && lines.widths[0] == 1);
+
+		for(int face=0; face<2; ++face){
+			PolylineMesher mesher;
+			mesher.width(0.1).faceBinormal(face);
+			Mesh m;
+			mesher.ribbons(m, lines);
+			assert(m.vertices().size() == 2*(N+3) && m.normals().size() == m.vertices().size());
+			assert(m.indices().size() == 6*(N-1 + 2));
+			assert(mesher.firstVertex(1) == 2*N && mesher.firstVertex(2) == 2*N);
+
+			// Matches ribbonizing the line on its own
+			Mesh r;
+			r.vertex(&helix[0], N);
+			r.ribbonize(0.1, face);
+			for(int i=0; i<2*N; ++i){
+				for(int k=0; k<3; ++k){
+					assert(fabs(m.vertices()[i][k] - r.vertices()[i][k]) < 1e-5);
+					assert(fabs(m.normals()[i][k] - r.normals()[i][k]) < 1e-5);
+				}
+			}
+
+			// Width factors scale the ribbon
+			const int b = mesher.firstVertex(2);
+			for(int i=0; i<3; ++i){
+				float w = (m.vertices()[b+2*i+1] - m.vertices()[b+2*i]).mag();
+				assert(fabs(w - 0.2*bendWidths[i]) < 1e-5);
+			}
+
+			// Triangles face the same way as their normals
+			for(int i=0; i<m.indices().size(); i+=3){
+				const Vec3f& v0 = m.vertices()[m.indices()[i]];
+				const Vec3f& v1 = m.vertices()[m.indices()[i+1]];
+				const Vec3f& v2 = m.vertices()[m.indices()[i+2]];
+				assert(cross(v1-v0, v2-v0).dot(m.normals()[m.indices()[i]]) > 0);
+			}
+		}
+
+		PolylineMesher mesher;
+		mesher.width(0.1).sides(6);
+		Mesh m;
+		mesher.tubes(m, lines);
+		assert(m.vertices().size() == 6*(N+3) && m.indices().size() == 36*(N-1 + 2));
+		for(int l=0; l<3; l+=2){
+			const int b = mesher.firstVertex(l);
+			for(int i=0; i<lines.size(l); ++i){
+				const Vec3f& p = lines.points[lines.starts[l] + i];
+				const float w = 0.1 * lines.widths[lines.starts[l] + i];
+				for(int s=0; s<6; ++s){
+					const Vec3f& v = m.vertices()[b + 6*i + s];
+					const Vec3f& n = m.normals()[b + 6*i + s];
+					assert(fabs(n.mag() - 1) < 1e-5);
+					assert(((v - p) - n*w).mag() < 1e-5);
+				}
+			}
+		}
+		for(int i=0; i<m.indices().size(); i+=3){
+			const Vec3f& v0 = m.vertices()[m.indices()[i]];
+			const Vec3f& v1 = m.vertices()[m.indices()[i+1]];
+			const Vec3f& v2 = m.vertices()[m.indices()[i+2]];
+			assert(cross(v1-v0, v2-v0).dot(m.normals()[m.indices()[i]]) > 0);
+		}
+
+		// Splitting over threads gives the same mesh
+		for(int l=0; l<200; ++l) lines.add(&helix[l%50], 3 + l%97);
+		Mesh serial, parallel;
+		ThreadPool pool(2);
+		pool.start();
+		mesher.tubes(serial, lines);
+		mesher.tubes(parallel, lines, pool);
+		assert(parallel.vertices().size() == serial.vertices().size());
+		assert(!memcmp(parallel.vertices().elems(), serial.vertices().elems(), serial.vertices().size()*sizeof(Vec3f)));
+		assert(!memcmp(parallel.normals().elems(), serial.normals().elems(), serial.normals().size()*sizeof(Vec3f)));
+		assert(!memcmp(parallel.indices().elems(), serial.indices().elems(), serial.indices().size()*sizeof(Mesh::Index)));
+		mesher.ribbons(serial, lines);
+		mesher.ribbons(parallel, lines, pool);
+		assert(!memcmp(parallel.vertices().elems(), serial.vertices().elems(), serial.vertices().size()*sizeof(Vec3f)));
+		assert(!memcmp(parallel.indices().elems(), serial.indices().elems(), serial.indices().size()*sizeof(Mesh::Index)));
+		pool.stop();
+	}
+
+	// Glyph atlas and text layouts
+	{
+		unsigned char bitmap[8*8];
+		for(int i=0; i<64; ++i) bitmap[i] = i+1;
+
+		GlyphAtlas atlas(32, 24);
+		const int small = atlas.addFace(10);
+		const int large = atlas.addFace(20);
+		assert(atlas.add(small, 'A', bitmap, 5, 7, 8, 1, 7, 6));
+		assert(atlas.add(small, 'B', bitmap, 6, 6, 8, 0, 6, 7));
+		assert(atlas.add(large, 'A', bitmap, 8, 8, 8, 2, 8, 10));
+		assert(!atlas.glyph(small, 'C'));
+
+		// Bitmaps land where their texture coordinates say
+		const int codes[3] = { 'A', 'B', 'A' };
+		const int faces[3] = { small, small, large };
+		for(int i=0; i<3; ++i){
+			const Glyph& g = *atlas.glyph(faces[i], codes[i]);
+			int x = g.quad.s0 * atlas.width() + 0.5;
+			int y = g.quad.t0 * atlas.height() + 0.5;
+			int w = (g.quad.s1 - g.quad.s0) * atlas.width() + 0.5;
+			int h = g.quad.y0 - g.quad.y1;
+			assert(w == g.quad.x1 - g.quad.x0);
+			for(int j=0; j<h; ++j){
+				assert(!memcmp(atlas.pixels() + (y+j)*atlas.width() + x, bitmap + 8*j, w));
+			}
+		}
+
+		// Fill the atlas; packed glyphs do not overlap
+		int added = 3;
+		while(atlas.add(large, 'a' + added, bitmap, 7, 5, 8, 0, 5, 8)) ++added;
+		assert(added > 6);
+		std::vector<GlyphQuad> rects;
+		for(int f=0; f<atlas.numFaces(); ++f){
+			for(int c=0; c<256; ++c){
+				if(atlas.glyph(f, c)) rects.push_back(atlas.glyph(f, c)->quad);
+			}
+		}
+		assert(int(rects.size()) == added);
+		for(unsigned i=0; i<rects.size(); ++i){
+			assert(rects[i].s1 <= 1 && rects[i].t1 <= 1);
+			for(unsigned j=0; j<i; ++j){
+				assert(	rects[i].s1 <= rects[j].s0 || rects[j].s1 <= rects[i].s0 ||
+						rects[i].t1 <= rects[j].t0 || rects[j].t1 <= rects[i].t0);
+			}
+		}
+
+		TextCache cache(atlas);
+		const int ab = cache.layout("AB", small);
+		assert(cache.layout("AB", small) == ab);
+		assert(cache.layout("AB", large) != ab);
+		assert(cache.size(ab) == 2 && cache.width(ab) == 13);
+		assert(cache.quads(ab)[1].x0 == 6);
+
+		// Lines move down by the line height; missing glyphs are skipped
+		const int lines = cache.layout("A\nBC", small);
+		assert(cache.size(lines) == 2 && cache.width(lines) == 7);
+		assert(cache.quads(lines)[1].y0 == 6 - 10 && cache.quads(lines)[1].x0 == 0);
+		assert(cache.numLayouts() == 3);
+
+		// Lookups still find layouts after the table has grown
+		std::vector<int> ids;
+		for(int i=0; i<300; ++i) ids.push_back(cache.layout(std::string(i%7+2, 'A') + std::string(i/7, 'B'), i%2));
+		for(int i=0; i<300; ++i) assert(cache.layout(std::string(i%7+2, 'A') + std::string(i/7, 'B'), i%2) == ids[i]);
+		assert(cache.numLayouts() == 303 && cache.layout("AB", small) == ab);
+
+		std::vector<TextLabel> labels;
+		labels.push_back(TextLabel(Vec3f(0,0,0), ab));
+		labels.push_back(TextLabel(Vec3f(100,50,-1), ab, 2, 0.5));
+		labels.push_back(TextLabel(Vec3f(0,0,0), cache.layout("", small)));
+		labels.push_back(TextLabel(Vec3f(0,0,0), lines));
+		Mesh m;
+		cache.write(m, labels);
+		assert(m.vertices().size() == 4*6 && m.texCoord2s().size() == 4*6);
+		assert(m.indices().size() == 6*6);
+
+		// Second label is scaled by two and centered on its position
+		const Glyph& a = *atlas.glyph(small, 'A');
+		const Vec3f& v = m.vertices()[8];
+		assert(v == Vec3f(100 - 13 + 2*a.quad.x0, 50 + 2*a.quad.y0, -1));
+		assert(m.texCoord2s()[8] == Vec2f(a.quad.s0, a.quad.t0));
+		assert(m.texCoord2s()[10] == Vec2f(a.quad.s1, a.quad.t1));
+
+		for(int i=0; i<m.indices().size(); i+=3){
+			const Vec3f& v0 = m.vertices()[m.indices()[i]];
+			const Vec3f& v1 = m.vertices()[m.indices()[i+1]];
+			const Vec3f& v2 = m.vertices()[m.indices()[i+2]];
+			assert(cross(v1-v0, v2-v0)[2] > 0);
+		}
+
+		cache.write(m, &labels[2], 1);
+		assert(m.vertices().size() == 0 && m.indices().size() == 0);
+		cache.clear();
+		assert(cache.numLayouts() == 0);
+	}
+
+	// Removing a face that did not fit frees its space
+	{
+		unsigned char bitmap[8*8];
+		for(int i=0; i<64; ++i) bitmap[i] = i+1;
+
+		GlyphAtlas atlas(32, 24);
+		const int first = atlas.addFace(10);
+		assert(atlas.lineHeight(first) == 10);
+		assert(atlas.add(first, 'A', bitmap, 5, 7, 8, 1, 7, 6));
+		const std::vector<unsigned char> before(atlas.pixels(), atlas.pixels() + 32*24);
+
+		const int full = atlas.addFace(12);
+		int added = 0;
+		while(atlas.add(full, added, bitmap, 7, 5, 8, 0, 5, 8)) ++added;
+		assert(added > 3);
+		atlas.removeLastFace();
+		assert(atlas.numFaces() == 1);
+		assert(!memcmp(&before[0], atlas.pixels(), before.size()));
+
+		assert(atlas.add(first, 'B', bitmap, 6, 6, 8, 0, 6, 7));
+		assert(atlas.glyph(first, 'B')->quad.s0 == 7.f/32);
+	}
+
+	// Bulk building
+	{
+		Mesh m;
+		m.reserve(8, 12, Mesh::NORMAL | Mesh::COLORI);
+		assert(m.vertices().capacity() == 8 && m.vertices().size() == 0);
+		assert(m.normals().capacity() == 8 && m.colors().capacity() == 0);
+		const Mesh::Vertex * verts = m.vertices().elems();
+		const Mesh::Index * inds = m.indices().elems();
+
+		// Reserved memory is kept when rebuilding
+		for(int frame=0; frame<2; ++frame){
+			m.reset();
+			m.vertex(0,0,0);
+			Mesh::Span s = m.addVertices(3, Mesh::NORMAL | Mesh::COLORI);
+			assert(s.begin == 1 && s.size == 3);
+			assert(s.vertices == verts + 1 && s.normals == m.normals().elems() + 1);
+			assert(!s.colors && !s.texCoord2s && !s.texCoord3s);
+			for(int i=0; i<s.size; ++i){
+				s.vertices[i].set(i+1, 0, 0);
+				s.normals[i].set(0, 0, 1);
+				s.coloris[i] = Colori(i);
+			}
+			Mesh::Index * ind = m.addIndices(6);
+			assert(ind == inds);
+			for(int i=0; i<6; ++i) ind[i] = i%4;
+			assert(m.vertices().size() == 4 && m.indices().size() == 6);
+			assert(m.normals().size() == 4 && m.coloris().size() == 4);
+			assert(m.vertices()[3] == Vec3f(3,0,0) && m.coloris()[2].r == 1);
+			assert(m.vertices().elems() == verts && m.indices().elems() == inds);
+		}
+
+		// Buffers grow beyond what was reserved
+		Mesh::Span s = m.addVertices(100);
+		assert(s.begin == 4 && m.vertices().size() == 104 && !s.normals);
+		assert(m.vertices().capacity() >= 104);
+
+		InterleavedMesh im(Graphics::TRIANGLES, Mesh::NORMAL | Mesh::TEXCOORD2);
+		im.reserve(4, 6);
+		const InterleavedVertex * iverts = im.vertices().elems();
+		for(int frame=0; frame<2; ++frame){
+			im.reset();
+			InterleavedVertex * v = im.addVertices(4);
+			assert(v == iverts);
+			for(int i=0; i<4; ++i){
+				v[i].position.set(i&1, i>>1, 0);
+				v[i].normal.set(0, 0, 1);
+				v[i].texCoord.set(i&1, i>>1);
+			}
+			const Mesh::Index quad[] = {0,1,3, 0,3,2};
+			Mesh::Index * ind = im.addIndices(6);
+			for(int i=0; i<6; ++i) ind[i] = quad[i];
+			assert(im.vertices().size() == 4 && im.indices().size() == 6);
+			assert(im.vertices()[3].position == Vec3f(1,1,0));
+		}
+		assert(im.attributes() == (Mesh::NORMAL | Mesh::TEXCOORD2));
+	}
+
 	return 0;
 }
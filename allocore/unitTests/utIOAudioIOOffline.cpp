@@ -0,0 +1,58 @@
+#include "utAllocore.h"
+
+static void offlineCB(AudioIOData& io){
+	// Input channel times a per-channel gain; the last channel clips
+	while(io()){
+		for(int c=0; c<io.channelsOut(); ++c){
+			io.out(c) = io.in(c % io.channelsIn()) * (c+1)*0.25f;
+		}
+	}
+}
+
+int utIOAudioIOOffline(){
+
+	const int Nb = 64, Ni = 2, No = 5;
+	AudioIO io(Nb, 48000, offlineCB, 0, No, Ni, AudioIO::OFFLINE);
+	assert(io.backend() == AudioIO::OFFLINE);
+	assert(io.channelsIn() == Ni);
+	assert(io.channelsOut() == No);
+	assert(io.channelsOutDevice() == No);
+	assert(io.framesPerSecond() == 48000);
+
+	const int Nin = 200, Nout = 300;
+	std::vector<float> in(Nin*Ni), out(Nout*No, -2.f);
+	for(unsigned i=0; i<in.size(); ++i) in[i] = sin(i*0.1);
+
+	io.offlineInput(&in[0], Nin);
+	io.offlineOutput(&out[0], Nout);
+
+	// Rendering stops once output memory is full
+	int frames = io.render(1000);
+	assert(frames == 5*Nb);
+	assert(io.offlineFrames() == Nout);
+	assert(io.render(1) == 0);
+	assert(fabs(io.time() - frames/48000.) < 1e-9);
+
+	for(int i=0; i<Nout; ++i){
+		for(int c=0; c<No; ++c){
+			float x = i<Nin ? in[i*Ni + c%Ni] : 0.f;
+			float y = x * (c+1)*0.25f;
+			if(y > 1.f) y = 1.f; else if(y < -1.f) y = -1.f;
+			assert(fabs(out[i*No + c] - y) < 1e-6);
+		}
+	}
+
+	// Free-running rendering on the stream thread
+	io.offlineOutput(&out[0], Nout);
+	io.offlineInput(&in[0], Nin);
+	assert(io.start());
+	for(int k=0; k<1000 && io.offlineFrames() < Nout; ++k) al_sleep(0.001);
+	io.stop();
+	assert(io.offlineFrames() == Nout);
+	assert(fabs(out[(Nin-1)*No] - in[(Nin-1)*Ni]*0.25f) < 1e-6);
+	assert(out[Nin*No] == 0.f);
+
+	io.close();
+
+	return 0;
+}
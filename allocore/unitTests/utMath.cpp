@@ -862,6 +862,48 @@ int utMath(){
 				assert(M-eps < cnt && cnt < M+eps);
 			}
 		}
+
+		// Bulk generation
+		{
+			BulkRandom g(1);
+			const int M = 1001;	// not a multiple of the number of lanes
+			float v[M];
+			Vec3f p[M];
+
+			g.uniform(v, M);
+			for(int i=0; i<M; ++i) assert(0 <= v[i] && v[i] < 1);
+			g.uniformS(v, M);
+			for(int i=0; i<M; ++i) assert(-1 <= v[i] && v[i] < 1);
+
+			g.normal(v, M);
+			double mean=0, var=0;
+			for(int i=0; i<M; ++i){ mean += v[i]; var += v[i]*v[i]; }
+			mean /= M; var = var/M - mean*mean;
+			assert(fabs(mean) < 0.2 && fabs(var - 1) < 0.2);
+
+			g.ball3(p, M);
+			for(int i=0; i<M; ++i) assert(p[i].mag() < 1.00001);
+
+			// Jumped copies agree with each other but not with the original
+			BulkRandom a(7), b(7), c(7);
+			uint32_t x[5], y[5];
+			a.jump().fill(x, 5);
+			b.jump().fill(y, 5);
+			for(int i=0; i<5; ++i) assert(x[i] == y[i]);
+			c.fill(y, 5);
+			assert(x[0] != y[0]);
+
+			// Jumping 2^k steps matches stepping 2^k times
+			for(int k=0; k<8; ++k){
+				const int L = BulkRandom::lanes;
+				BulkRandom jumped(k+1), stepped(k+1);
+				uint32_t u[L], v[L];
+				jumped.jump(k).fill(u, L);
+				for(int i=0; i<(1<<k); ++i) stepped.fill(v, L);
+				stepped.fill(v, L);
+				for(int l=0; l<L; ++l) assert(u[l] == v[l]);
+			}
+		}
 	}
 
 
@@ -904,6 +946,32 @@ int utMath(){
 		assert(f.testSphere(Vec3d(2,2,2), 0.5) == Frustumd::OUTSIDE);
 	}
 
+	// FFT
+	{
+		RFFT fft;
+		assert(!fft.resize(12));
+		assert(fft.resize(64));
+		assert(fft.size() == 64 && fft.bins() == 33);
+
+		const int N = 64;
+		float x[N], y[N], re[N/2+1], im[N/2+1];
+		for(int i=0; i<N; ++i) x[i] = sin(i*1.3) + 0.01*i;
+		fft.forward(re, im, x);
+
+		for(int k=0; k<=N/2; ++k){
+			double r=0, j=0;
+			for(int n=0; n<N; ++n){
+				r += x[n] * cos(M_2PI*k*n/N);
+				j -= x[n] * sin(M_2PI*k*n/N);
+			}
+			assert(fabs(re[k] - r) < 1e-4);
+			assert(fabs(im[k] - j) < 1e-4);
+		}
+
+		fft.inverse(y, re, im);
+		for(int i=0; i<N; ++i) assert(fabs(y[i] - x[i]) < 1e-5);
+	}
+
 	return 0;
 }
 
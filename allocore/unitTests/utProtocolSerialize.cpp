@@ -89,6 +89,97 @@ int utProtocolSerialize(){
 			ASSERT(iun, oun);
 			ASSERT(iUn, oUn);
 		}
+
+		// Reusing memory and fixed arenas
+		{
+			const int N = 16;
+			float v[N];
+			for(int i=0; i<N; ++i) v[i] = i;
+
+			Serializer s;
+			s.reserve(256).add(v,N);
+			assert(s.size() == serHeaderSize() + N*sizeof(float));
+			assert(s.size() == s.buf().size());
+			const char * mem = s.data();
+			s.reset();
+			assert(s.size() == 0);
+			s.add(v,N);
+			assert(s.data() == mem); // memory was reused
+
+			char arena[serHeaderSize() + N*sizeof(float)];
+			Serializer a(arena, sizeof(arena));
+			a.add(v,N);
+			assert(!a.overflow());
+			assert(a.data() == arena);
+			assert(0 == memcmp(arena, s.data(), sizeof(arena)));
+			a << 1.f;
+			assert(a.overflow());
+			assert(a.size() == sizeof(arena));
+		}
+
+		// Zero-copy views
+		{
+			const int N = 9;
+			double in[N];
+			for(int i=0; i<N; ++i) in[i] = i*0.5;
+			int32_t tag = 7, otag = 0;
+
+			Serializer s;
+			s << tag;
+			s.add(in,N);
+
+			Deserializer d(s.data(), s.size(), false);
+			View<double> vf;
+			assert(!d.view(vf)); // not a double array
+			d >> otag;
+			assert(otag == tag);
+			View<double> v;
+			assert(d.view(v));
+			assert(!d.more());
+			assert(v.size() == N);
+			assert(v.bytes() > s.data() && v.bytes() < s.data() + s.size());
+			double out[N];
+			v.copy(out);
+			for(int i=0; i<N; ++i){
+				assert(v[i] == in[i]);
+				assert(out[i] == in[i]);
+			}
+		}
+
+		// Copies of a Deserializer read from their own buffers
+		{
+			Serializer s;
+			s << 1.5f << 2.5f;
+			Deserializer * d = new Deserializer(s.buf());
+			float f = 0;
+			*d >> f;
+			Deserializer c(*d);
+			Deserializer a(s.data(), 0);
+			a = *d;
+			delete d;
+			assert(c.more() && a.more());
+			c >> f;
+			assert(f == 2.5f && !c.more());
+			f = 0;
+			a >> f;
+			assert(f == 2.5f && !a.more());
+		}
+
+		// Byte swapping
+		{
+			uint16_t a2[3] = {0x0102, 0x0304, 0x0506};
+			uint32_t a4[3] = {0x01020304, 0x05060708, 0x090a0b0c};
+			uint64_t a8[2] = {0x0102030405060708ULL, 0x090a0b0c0d0e0f10ULL};
+			uint16_t b2[3]; uint32_t b4[3]; uint64_t b8[2];
+			assert(serCopySwap2(b2, a2, 3) == sizeof(a2));
+			assert(serCopySwap4(b4, a4, 3) == sizeof(a4));
+			assert(serCopySwap8(b8, a8, 2) == sizeof(a8));
+			assert(b2[0] == 0x0201 && b2[2] == 0x0605);
+			assert(b4[0] == 0x04030201 && b4[2] == 0x0c0b0a09);
+			assert(b8[0] == 0x0807060504030201ULL && b8[1] == 0x100f0e0d0c0b0a09ULL);
+			serCopySwap4(b4, b4, 3); // in place
+			for(int i=0; i<3; ++i) assert(b4[i] == a4[i]);
+		}
 	}
 
 	return 0;
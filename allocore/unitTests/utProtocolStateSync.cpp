@@ -0,0 +1,131 @@
+#include "utAllocore.h"
+
+namespace{
+	struct State{
+		unsigned frame;
+		float values[1000];	// spans several datagrams
+	};
+
+	void fill(State& s, unsigned frame){
+		s.frame = frame;
+		for(int i=0; i<1000; ++i) s.values[i] = frame + i*0.5f;
+	}
+
+	bool check(const State& s){
+		for(int i=0; i<1000; ++i) if(s.values[i] != s.frame + i*0.5f) return false;
+		return true;
+	}
+}
+
+int utProtocolStateSync(){
+
+	const uint16_t port = 4112;
+
+	// Frames are reassembled in order and the newest one is read
+	{
+		StateSender send(port, "127.0.0.1");
+		StateReceiver recv(sizeof(State), port);
+		assert(recv.frameSize() == int(sizeof(State)));
+
+		State s, r;
+		memset(&r, 0, sizeof r);
+		assert(!recv.read(r));
+		assert(r.frame == 0 && r.values[1] == 0);
+
+		for(unsigned k=1; k<=3; ++k){
+			fill(s, k);
+			assert(send.send(s));
+		}
+		al_sleep(0.01);
+		assert(recv.poll() == 3);
+		assert(recv.framesReceived() == 3);
+		assert(recv.read(r));
+		assert(r.frame == 3 && check(r));
+		assert(!recv.read(r));
+
+		// Reading on a receiver thread
+		assert(recv.start());
+		for(unsigned k=4; k<=20; ++k){
+			fill(s, k);
+			send.send(s);
+			al_sleep(0.001);
+		}
+		for(int i=0; i<100 && recv.framesReceived() < 20; ++i) al_sleep(0.01);
+		recv.stop();
+		assert(recv.read(r));
+		assert(r.frame == 20 && check(r));
+
+		// A restarted sender numbers its frames from zero again
+		{
+			StateSender restarted(port, "127.0.0.1");
+			assert(restarted.frame() == 0);
+			fill(s, 100);
+			assert(restarted.send(s));
+			al_sleep(0.01);
+			assert(recv.poll() == 1);
+			assert(recv.read(r));
+			assert(r.frame == 100 && check(r));
+		}
+	}
+
+	// Reassembly from out of order fragments; stale and partial frames are dropped
+	{
+		StateReceiver recv(sizeof(State), port+1);
+		SocketClient raw(port+1, "127.0.0.1");
+		StateSender send(port+2, "127.0.0.1");
+		SocketServer tap(port+2, "");
+
+		// Capture the datagrams of frames 0 and 1
+		std::vector<std::string> packets;
+		State s;
+		for(unsigned k=0; k<2; ++k){
+			fill(s, k);
+			send.send(s);
+			al_sleep(0.01);
+			char buf[2048];
+			int n;
+			while((n = tap.recv(buf, sizeof buf)) > 0) packets.push_back(std::string(buf, n));
+		}
+		const int frags = packets.size()/2;
+		assert(frags == (int(sizeof(State)) + StateSender::MAX_PAYLOAD-1) / StateSender::MAX_PAYLOAD);
+
+		// First fragment of frame 0, then all of frame 1 reversed, then the rest of frame 0
+		raw.send(packets[0].data(), packets[0].size());
+		for(int i=2*frags-1; i>=frags; --i) raw.send(packets[i].data(), packets[i].size());
+		for(int i=1; i<frags; ++i) raw.send(packets[i].data(), packets[i].size());
+		al_sleep(0.01);
+
+		assert(recv.poll() == 1);
+		assert(recv.framesReceived() == 1);
+		assert(recv.framesDropped() == 1);
+		State r;
+		assert(recv.read(r));
+		assert(r.frame == 1 && check(r));
+
+		// Garbage is ignored
+		raw.send("hello", 5);
+		al_sleep(0.01);
+		assert(recv.poll() == 0);
+	}
+
+	// Several receivers on one host listen to a multicast group
+	{
+		const char * group = "239.255.41.12";
+		StateReceiver recvA(sizeof(State), port+3, 4, group);
+		StateReceiver recvB(sizeof(State), port+3, 4, group);
+		StateSender send(port+3, group);
+
+		State s, r;
+		fill(s, 7);
+		assert(send.send(s));
+		al_sleep(0.01);
+		assert(recvA.poll() == 1);
+		assert(recvA.read(r));
+		assert(r.frame == 7 && check(r));
+		assert(recvB.poll() == 1);
+		assert(recvB.read(r));
+		assert(r.frame == 7 && check(r));
+	}
+
+	return 0;
+}
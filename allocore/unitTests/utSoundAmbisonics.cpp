@@ -0,0 +1,257 @@
+#include "utAllocore.h"
+
+int utSoundAmbisonics(){
+
+	const float eps = 1e-5;
+	#define NEAR(a, b) (fabs((a)-(b)) < eps)
+
+	// Some unit directions
+	const int Nd = 100;
+	float xs[Nd], ys[Nd], zs[Nd];
+	for(int i=0; i<Nd; ++i){
+		float az = i * 0.731f;
+		float el = (i * 0.173f) - 1.5f;
+		xs[i] = cos(az)*cos(el);
+		ys[i] = sin(az)*cos(el);
+		zs[i] = sin(el);
+	}
+
+	// ACN/SN3D against closed forms
+	{
+		float w[64];
+		for(int i=0; i<Nd; ++i){
+			float x=xs[i], y=ys[i], z=zs[i];
+			AmbiBase::encodeWeightsACN(w, 3, 2, x,y,z);
+			assert(NEAR(w[0], 1));
+			assert(NEAR(w[1], y));
+			assert(NEAR(w[2], z));
+			assert(NEAR(w[3], x));
+			assert(NEAR(w[4], sqrt(3.) * x*y));
+			assert(NEAR(w[5], sqrt(3.) * y*z));
+			assert(NEAR(w[6], 0.5 * (3*z*z - 1)));
+			assert(NEAR(w[7], sqrt(3.) * x*z));
+			assert(NEAR(w[8], sqrt(3.)/2 * (x*x - y*y)));
+		}
+	}
+
+	// Addition theorem: sum_m Y_nm(a) Y_nm(b) = P_n(a.b) for SN3D
+	{
+		const int N = AL_AMBI_MAX_ORDER;
+		float wa[64], wb[64];
+		for(int i=1; i<Nd; ++i){
+			AmbiBase::encodeWeightsACN(wa, 3, N, xs[i-1],ys[i-1],zs[i-1]);
+			AmbiBase::encodeWeightsACN(wb, 3, N, xs[i],ys[i],zs[i]);
+			double c = xs[i-1]*xs[i] + ys[i-1]*ys[i] + zs[i-1]*zs[i];
+			double p0 = 1, p1 = c;
+			for(int n=0; n<=N; ++n){
+				double Pn = n ? p1 : p0;
+				if(n>1){
+					double p2 = ((2*n-1)*c*p1 - (n-1)*p0)/n;
+					p0 = p1; p1 = Pn = p2;
+				}
+				double sum = 0;
+				for(int m=-n; m<=n; ++m) sum += wa[n*n+n+m] * wb[n*n+n+m];
+				assert(fabs(sum - Pn) < 1e-4);
+			}
+		}
+	}
+
+	// Block evaluation matches single directions
+	{
+		const int N = AL_AMBI_MAX_ORDER;
+		for(int dim=2; dim<=3; ++dim){
+			const int Nc = AmbiBase::orderToChannels(dim, N);
+			std::vector<float> block(Nc*Nd);
+			AmbiBase::encodeWeightsACN(&block[0], Nd, dim, N, xs,ys,zs, Nd, true);
+			float w[64];
+			for(int i=0; i<Nd; ++i){
+				AmbiBase::encodeWeightsACN(w, dim, N, xs[i],ys[i],zs[i], true);
+				for(int c=0; c<Nc; ++c) assert(NEAR(w[c], block[c*Nd + i]));
+			}
+		}
+	}
+
+	// 2D circular harmonics
+	{
+		float w[15];
+		for(int i=0; i<Nd; ++i){
+			double az = i * 0.0631;
+			AmbiBase::encodeWeightsACN(w, 2, AL_AMBI_MAX_ORDER, cos(az), sin(az), 0);
+			assert(NEAR(w[0], 1));
+			for(int n=1; n<=AL_AMBI_MAX_ORDER; ++n){
+				assert(NEAR(w[2*n-1], sin(n*az)));
+				assert(NEAR(w[2*n  ], cos(n*az)));
+			}
+		}
+	}
+
+	// Encoder
+	{
+		AmbiEncode enc(3, 7, AmbiBase::ACN_SN3D);
+		assert(enc.channels() == 64);
+		assert(enc.channelOrder(0) == 0);
+		assert(enc.channelOrder(3) == 1);
+		assert(enc.channelOrder(63) == 7);
+
+		AmbiEncode fuma(3, 9);
+		assert(fuma.order() == 3);
+		assert(fuma.channelOrder(6) == 3); // Q
+		assert(fuma.channelOrder(7) == 1); // Z
+		assert(fuma.channelOrder(15) == 3); // K
+
+		const int Nf = 16;
+		float in[Nf];
+		for(int i=0; i<Nf; ++i) in[i] = 1;
+		std::vector<float> ambi(enc.channels()*Nf, 0.f);
+
+		// interpolation reaches the current weights at the last frame
+		enc.direction(xs[3], ys[3], zs[3]);
+		std::vector<float> w0(enc.weights(), enc.weights() + enc.channels());
+		enc.direction(xs[4], ys[4], zs[4]);
+		enc.encode(&ambi[0], in, Nf, &w0[0]);
+		for(int c=0; c<enc.channels(); ++c){
+			assert(NEAR(ambi[c*Nf + Nf-1], enc.weights()[c]));
+		}
+
+		// block direction encoding matches per-sample encoding
+		Vec3f dirs[Nf];
+		for(int i=0; i<Nf; ++i) dirs[i].set(xs[i], ys[i], zs[i]);
+		std::vector<float> ambi2(enc.channels()*Nf, 0.f);
+		ambi.assign(ambi.size(), 0.f);
+		enc.encode(&ambi[0], dirs, in, Nf);
+		for(int i=0; i<Nf; ++i){
+			enc.direction(xs[i], ys[i], zs[i]);
+			enc.encode(&ambi2[0], Nf, i, in[i]);
+		}
+		for(unsigned i=0; i<ambi.size(); ++i) assert(NEAR(ambi[i], ambi2[i]));
+	}
+
+	// Decoder order weights above the tabulated orders
+	{
+		AmbiDecode dec(3, 7, 8, 3, AmbiBase::ACN_SN3D);
+		assert(dec.weights()[0] == 1);
+		for(int c=1; c<dec.channels(); ++c){
+			int n = dec.channelOrder(c);
+			float w = dec.weights()[c];
+			assert(w > 0 && w < 1);
+			if(c > 1 && n > dec.channelOrder(c-1)) assert(w < dec.weights()[c-1]);
+		}
+	}
+
+	// Blocked, threaded and dual-band decoding
+	{
+		const int Ns = 40, Nf = 300;
+		Speakers speakers;
+		AmbiDecode dec(3, 5, Ns, 1, AmbiBase::ACN_N3D);
+		dec.setSpeakers(&speakers);
+		for(int s=0; s<Ns; ++s){
+			speakers.push_back(Speaker(s, s*37.f, (s%7)*25.f - 75.f));
+			dec.setSpeaker(s, s, speakers[s].azimuth, speakers[s].elevation);
+		}
+
+		const int Nc = dec.channels();
+		std::vector<float> ambi(Nc*Nf);
+		for(unsigned i=0; i<ambi.size(); ++i) ambi[i] = sin(i*0.37);
+
+		std::vector<float> ref(Ns*Nf, 0.f), out(Ns*Nf, 0.f);
+		for(int s=0; s<Ns; ++s){
+			for(int i=0; i<Nf; ++i){
+				for(int c=0; c<Nc; ++c) ref[s*Nf+i] += dec.decodeWeight(s,c) * ambi[c*Nf+i];
+			}
+		}
+
+		dec.decode(&out[0], &ambi[0], Nf);
+		for(unsigned i=0; i<out.size(); ++i) assert(fabs(out[i] - ref[i]) < 1e-4);
+
+		dec.threads(3);
+		assert(dec.threads() == 3);
+		out.assign(out.size(), 0.f);
+		dec.decode(&out[0], &ambi[0], Nf);
+		for(unsigned i=0; i<out.size(); ++i) assert(fabs(out[i] - ref[i]) < 1e-4);
+		dec.threads(1);
+
+		// With the same flavor in both bands, a constant input decodes as in
+		// a single band once the crossover has settled
+		dec.dualBand(600, 44100, dec.flavor(), dec.flavor());
+		assert(dec.dualBand());
+		for(int i=0; i<Nf; ++i){
+			for(int c=0; c<Nc; ++c) ambi[c*Nf+i] = 1;
+		}
+		for(int k=0; k<100; ++k){
+			out.assign(out.size(), 0.f);
+			dec.decode(&out[0], &ambi[0], Nf);
+		}
+		for(int s=0; s<Ns; ++s){
+			float sum = 0;
+			for(int c=0; c<Nc; ++c) sum += dec.decodeWeight(s,c);
+			assert(fabs(out[s*Nf + Nf-1] - sum) < 1e-3);
+		}
+		dec.singleBand();
+		assert(!dec.dualBand());
+
+		// Dual-band decoding in blocks of frames is the same however the
+		// buffer is split
+		for(unsigned i=0; i<ambi.size(); ++i) ambi[i] = sin(i*0.37);
+		Speakers speakers2;
+		AmbiDecode dec2(3, 5, Ns, 1, AmbiBase::ACN_N3D);
+		dec2.setSpeakers(&speakers2);
+		for(int s=0; s<Ns; ++s){
+			speakers2.push_back(Speaker(s, s*37.f, (s%7)*25.f - 75.f));
+			dec2.setSpeaker(s, s, speakers2[s].azimuth, speakers2[s].elevation);
+		}
+		dec.dualBand(600, 44100);
+		dec2.dualBand(600, 44100);
+		out.assign(out.size(), 0.f);
+		dec.decode(&out[0], &ambi[0], Nf);
+		const int Nh = Nf/3;
+		std::vector<float> ambiH(Nc*Nh), outH(Ns*Nh);
+		for(int k=0; k<3; ++k){
+			for(int c=0; c<Nc; ++c){
+				for(int i=0; i<Nh; ++i) ambiH[c*Nh+i] = ambi[c*Nf + k*Nh+i];
+			}
+			outH.assign(outH.size(), 0.f);
+			dec2.decode(&outH[0], &ambiH[0], Nh);
+			for(int s=0; s<Ns; ++s){
+				for(int i=0; i<Nh; ++i) assert(fabs(outH[s*Nh+i] - out[s*Nf + k*Nh+i]) < 1e-4);
+			}
+		}
+	}
+
+	// Interpolation state follows sources added to and removed from a scene
+	{
+		const int Nf = 64;
+		AudioIO io(Nf, 44100, 0, 0, 4, 0, AudioIO::OFFLINE);
+		SpeakerRingLayout<4> layout;
+		AmbisonicsSpatializer spat(layout, 2, 1);
+		AudioScene scene(Nf);
+		scene.createListener(&spat);
+		SoundSource src;
+		src.useAttenuation(false);
+		src.useDoppler(false);
+		scene.addSource(src);
+
+		// A constant signal whose source moves is interpolated over the
+		// buffer after the move
+		for(int k=0; k<3; ++k){
+			if(2 == k) src.pos(4,0,0);
+			else src.pos(0,0,-4);
+			for(int i=0; i<Nf; ++i) src.writeSample(1);
+			io.zeroOut();
+			scene.render(io);
+		}
+		assert(fabs(io.out(0,0) - io.out(0,Nf-1)) > 1e-3);
+
+		// A source added again starts from its current direction
+		scene.removeSource(src);
+		src.pos(0,0,-4);
+		scene.addSource(src);
+		for(int i=0; i<Nf; ++i) src.writeSample(1);
+		io.zeroOut();
+		scene.render(io);
+		for(int i=1; i<Nf; ++i) assert(NEAR(io.out(0,i), io.out(0,0)));
+		scene.removeSource(src);
+	}
+
+	#undef NEAR
+	return 0;
+}
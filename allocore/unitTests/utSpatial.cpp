@@ -1,4 +1,6 @@
+#include <algorithm>
 #include "utAllocore.h"
+#include "allocore/spatial/al_HashSpace.hpp"
 
 int utSpatial(){
 
@@ -6,6 +8,122 @@ int utSpatial(){
 		Pose a;
 	}
 
+	// Composing arrays of poses matches composing rigid transforms
+	{
+		const int N = 70;
+		PoseArray parents(N), locals(N), world;
+		for(int i=0; i<N; ++i){
+			parents.set(i, Pose(Vec3d(i, 1, -i), Quatd().fromAxisAngle(0.1*i, Vec3d(0,1,1).normalize())));
+			locals.set(i, Pose(Vec3d(1, i*0.5, 2), Quatd().fromAxisAngle(-0.05*i, Vec3d(1,0,0))));
+		}
+
+		PoseArray::compose(world, parents, locals);
+		assert(world.size() == N);
+		for(int i=0; i<N; ++i){
+			Pose p = parents.get(i), l = locals.get(i), w = world.get(i);
+			Vec3d pos = p.pos() + p.quat().rotate(l.pos());
+			Quatd q = p.quat() * l.quat();
+			for(int k=0; k<3; ++k) assert(fabs(w.pos()[k] - pos[k]) < 1e-4);
+			for(int k=0; k<4; ++k) assert(fabs(w.quat()[k] - q[k]) < 1e-5);
+		}
+
+		// In place, with one parent
+		Pose p(Vec3d(3,2,1), Quatd().fromAxisAngle(0.3, Vec3d(0,0,1)));
+		world = locals;
+		PoseArray::compose(world, p, world);
+		for(int i=0; i<N; ++i){
+			Pose l = locals.get(i), w = world.get(i);
+			Vec3d pos = p.pos() + p.quat().rotate(l.pos());
+			for(int k=0; k<3; ++k) assert(fabs(w.pos()[k] - pos[k]) < 1e-4);
+		}
+
+		std::vector<float> mats(16*N);
+		world.matrices(&mats[0]);
+		for(int i=0; i<N; ++i){
+			Mat4d m = world.get(i).matrix();
+			for(int k=0; k<16; ++k) assert(fabs(mats[16*i+k] - m[k]) < 1e-5);
+		}
+	}
+
+	// Block attenuation follows the per-distance curve
+	{
+		const int N = 100;
+		double dist[N], out[N];
+		for(int i=0; i<N; ++i) dist[i] = i*0.25;
+
+		AttenuationLaw laws[] = {ATTEN_NONE, ATTEN_LINEAR, ATTEN_INVERSE, ATTEN_INVERSE_SQUARE};
+		for(int l=0; l<4; ++l){
+			DistAtten<double> a(1, 20, laws[l], 0.1);
+			a.attenuation(out, dist, N);
+			for(int i=0; i<N; ++i) assert(fabs(out[i] - a.attenuation(dist[i])) < 1e-12);
+
+			a.attenuation(out, 2., 27., N);
+			for(int i=0; i<N; ++i) assert(fabs(out[i] - a.attenuation(2 + i*0.25)) < 1e-12);
+		}
+	}
+
+	// Culling arrays of bounding volumes matches testing them one at a time
+	{
+		Frustumd f;
+		f.ntl = Vec3d( 7, 9,14); f.ntr = Vec3d( 9, 9,14);
+		f.nbl = Vec3d( 7, 7,14); f.nbr = Vec3d( 9, 7,14);
+		f.ftl = Vec3d( 2,14, 2); f.ftr = Vec3d(14,14, 2);
+		f.fbl = Vec3d( 2, 2, 2); f.fbr = Vec3d(14, 2, 2);
+		f.computePlanes();
+		FrustumCuller culler(f);
+
+		const int N = 1000;	// not a multiple of the mask word size
+		const float r = 0.5f;
+		SphereArray spheres(N);
+		BoxArray boxes(N);
+		HashSpace space(4, N);
+		rnd::Random<> rng(1);
+		for(int i=0; i<N; ++i){
+			Vec3f c(rng.uniform(16.f), rng.uniform(16.f), rng.uniform(16.f));
+			spheres.set(i, c, r);
+			boxes.set(i, c - r, c + r);
+			space.move(i, c);
+		}
+
+		std::vector<uint32_t> mask((N+31)/32), boxMask((N+31)/32);
+		std::vector<int> idx(N), boxIdx(N);
+		culler.mask(&mask[0], spheres);
+		culler.mask(&boxMask[0], boxes);
+		int count = culler.indices(&idx[0], spheres);
+		int boxCount = culler.indices(&boxIdx[0], boxes);
+
+		int k = 0, kb = 0;
+		for(int i=0; i<N; ++i){
+			Vec3d c(spheres.x[i], spheres.y[i], spheres.z[i]);
+			bool vis = f.testSphere(c, r) != Frustumd::OUTSIDE;
+			assert(vis == bool(mask[i/32] & (1u << (i%32))));
+			if(vis) assert(idx[k++] == i);
+			bool boxVis = f.testBox(c - r, Vec3d(2*r)) != Frustumd::OUTSIDE;
+			assert(boxVis == bool(boxMask[i/32] & (1u << (i%32))));
+			if(boxVis) assert(boxIdx[kb++] == i);
+		}
+		assert(k == count && count > 0 && count < N);
+		assert(kb == boxCount);
+
+		std::vector<int> maskIdx(N);
+		assert(FrustumCuller::maskToIndices(&maskIdx[0], &mask[0], N) == count);
+		for(int i=0; i<count; ++i) assert(maskIdx[i] == idx[i]);
+
+		ThreadPool pool(2);
+		pool.start();
+		std::vector<uint32_t> poolMask((N+31)/32);
+		culler.mask(&poolMask[0], spheres, pool);
+		assert(poolMask == mask);
+		culler.mask(&poolMask[0], boxes, pool);
+		assert(poolMask == boxMask);
+		pool.stop();
+
+		std::vector<int> found;
+		assert(culler.indices(found, space, r) == count);
+		std::sort(found.begin(), found.end());
+		for(int i=0; i<count; ++i) assert(found[i] == idx[i]);
+	}
+
 	{
 		Nav a;
 		a.smooth(0);
@@ -1,8 +1,45 @@
 #include "utAllocore.h"
 
+#ifdef AL_LINUX
+	#include <unistd.h>
+#endif
+
 template <class T>
 bool aboutEqual(T v, T to, T r){ return v<(to+r) && v>(to-r); }
 
+namespace{
+	// Stops the main loop once a byte is read
+	struct StopOnRead : public Main::FDHandler{
+		int reads;
+		StopOnRead(): reads(0){}
+		void onReadable(int fd){
+			char c;
+			if(read(fd, &c, 1) == 1) ++reads;
+			Main::get().stop();
+		}
+	};
+
+	// Stops the main loop after some ticks
+	struct StopOnTicks : public Main::Handler{
+		int ticks;
+		StopOnTicks(): ticks(0){}
+		void onTick(){ if(++ticks == 3) Main::get().stop(); }
+	};
+
+	void * setInterval(void * interval){
+		al_sleep(0.02);
+		Main::get().interval(*(al_sec *)interval);
+		return NULL;
+	}
+
+	void * stopMain(void *){
+		while(!Main::get().isRunning()) al_sleep(0.001);
+		al_sleep(0.02);
+		Main::get().stop();
+		return NULL;
+	}
+}
+
 int utSystem(){
 
 	// Timing
@@ -50,5 +87,50 @@ int utSystem(){
 		assert(al_time_ns2s * tm.elapsed() == tm.elapsedSec());
 	}
 
+	// Native main loop
+	#ifdef AL_LINUX
+	{
+		Main& M = Main::get();
+		int fds[2];
+		assert(0 == pipe(fds));
+		StopOnRead reader;
+		assert(!M.watch(fds[0], reader)); // only with the native driver
+
+		M.driver(Main::NATIVE).interval(10);
+		assert(M.watch(fds[0], reader));
+
+		// A readable descriptor is dispatched without waiting for a tick
+		al_sec t = al_time();
+		assert(1 == write(fds[1], "x", 1));
+		M.start();
+		assert(reader.reads == 1);
+		assert(al_time() - t < 1);
+		M.unwatch(fds[0]);
+
+		// Stopping from another thread wakes the loop
+		t = al_time();
+		Thread stopper(stopMain, NULL);
+		M.start();
+		stopper.join();
+		assert(al_time() - t < 1);
+
+		// A new interval applies before the current one runs out
+		StopOnTicks ticker;
+		M.add(ticker);
+		al_sec fast = 0.001;
+		t = al_time();
+		Thread setter(setInterval, &fast);
+		M.start();
+		setter.join();
+		assert(ticker.ticks == 3);
+		assert(al_time() - t < 1);
+		M.remove(ticker);
+
+		M.interval(0.01).driver(Main::SLEEP);
+		close(fds[0]);
+		close(fds[1]);
+	}
+	#endif
+
 	return 0;
 }
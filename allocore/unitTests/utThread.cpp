@@ -1,9 +1,23 @@
 #include "utAllocore.h"
+#ifdef AL_LINUX
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 void * threadFunc(void * user){
 	*(int *)user = 1; return NULL;
 }
 
+#ifdef AL_LINUX
+// Gets number of processors the calling thread may run on
+void * countCPUs(void * user){
+	cpu_set_t cpus;
+	pthread_getaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+	*(int *)user = CPU_COUNT(&cpus);
+	return NULL;
+}
+#endif
+
 struct MyThreadFunc : public ThreadFunction{
 	MyThreadFunc(int& x_): x(x_){}
 	void operator()(){
@@ -12,6 +26,34 @@ struct MyThreadFunc : public ThreadFunction{
 	int& x;
 };
 
+// Counts visits to each index; nested loops split each index again
+struct PoolBody{
+	ThreadPool * pool;
+	std::vector<int> * hits;
+	int nested;
+	void operator()(int begin, int end){
+		for(int i=begin; i<end; ++i){
+			if(nested){
+				PoolBody inner = { pool, hits, 0 };
+				pool->parallelFor(i*nested, (i+1)*nested, inner);
+			}
+			else{
+				++(*hits)[i];
+			}
+		}
+	}
+};
+
+struct PeriodicFunc : public ThreadFunction{
+	PeriodicFunc(double sleepTime_=0): calls(0), sleepTime(sleepTime_){}
+	int calls;
+	double sleepTime;
+	void operator()(){
+		++calls;
+		if(sleepTime > 0) al_sleep(sleepTime);
+	}
+};
+
 int utThread() {
 
 	//UT_PRINTF("system: thread\n");
@@ -54,5 +96,120 @@ int utThread() {
 		assert(1 == x);
 	}
 
+	#ifdef AL_LINUX
+	// Affinity
+	{
+		cpu_set_t cpus;
+		sched_getaffinity(0, sizeof(cpus), &cpus);
+		const int all = CPU_COUNT(&cpus);
+		int first = 0;
+		while(!CPU_ISSET(first, &cpus)) ++first;
+
+		int n = 0;
+		Thread t;
+		t.affinity(1ULL << first);
+		assert(t.start(countCPUs, &n));
+		t.join();
+		assert(1 == n);
+
+		// Clearing the mask allows all processors again
+		n = 0;
+		t.affinity(0);
+		assert(t.start(countCPUs, &n));
+		t.join();
+		assert(all == n);
+
+		// A mask of only missing processors still starts the thread
+		if(all < 64){
+			n = 0;
+			t.affinity(1ULL << 63);
+			assert(t.start(countCPUs, &n));
+			t.join();
+			assert(all == n);
+		}
+	}
+	#endif
+
+	// Thread pool
+	{
+		const int N = 1000;
+		std::vector<int> hits(N, 0);
+
+		ThreadPool pool(3);
+		assert(pool.size() == 3);
+		PoolBody body = { &pool, &hits, 0 };
+
+		// Runs inline until started
+		pool.parallelFor(0, N, body, 16);
+		for(int i=0; i<N; ++i) assert(hits[i] == 1);
+
+		pool.pin().spinTime(0.001);
+		assert(pool.start());
+		assert(pool.running());
+		for(int k=0; k<20; ++k) pool.parallelFor(0, N, body, 1 + k);
+		for(int i=0; i<N; ++i) assert(hits[i] == 21);
+
+		// Nested loops from within loop bodies
+		body.nested = 10;
+		pool.parallelFor(0, N/10, body, 2);
+		for(int i=0; i<N; ++i) assert(hits[i] == 22);
+
+		// Empty range and restart
+		pool.parallelFor(5, 5, body);
+		pool.stop();
+		assert(!pool.running());
+		body.nested = 0;
+		assert(pool.start());
+		pool.parallelFor(0, N, body, 7);
+		for(int i=0; i<N; ++i) assert(hits[i] == 23);
+
+		// Real-time workers fall back to normal scheduling if not permitted
+		pool.stop();
+		pool.resize(2).priority(50);
+		assert(pool.size() == 2);
+		assert(pool.start());
+		pool.parallelFor(0, N, body, 50);
+		for(int i=0; i<N; ++i) assert(hits[i] == 24);
+	}
+
+	// Periodic thread
+	{
+		typedef PeriodicThread::Stats Stats;
+		assert(Stats::bin(0) == 0);
+		assert(Stats::bin(999) == 0);
+		assert(Stats::bin(1000) == 1);
+		assert(Stats::bin(1999) == 1);
+		assert(Stats::bin(2000) == 2);
+		assert(Stats::bin(al_nsec(1e12)) == Stats::NUM_BINS-1);
+
+		PeriodicFunc f;
+		PeriodicThread t(0.002);
+		t.start(f);
+		al_sleep(0.1);
+		t.stop();
+		t.join();
+
+		Stats s = t.stats();
+		assert(s.iterations == unsigned(f.calls));
+		assert(s.iterations > 10 && s.iterations < 60);
+		unsigned long nj = 0, ne = 0;
+		for(int i=0; i<Stats::NUM_BINS; ++i){ nj += s.jitter[i]; ne += s.exec[i]; }
+		assert(nj == s.iterations && ne == s.iterations);
+		assert(s.jitterPercentile(0.5) <= s.jitterPercentile(1));
+		assert(s.execMean() * 1e9 <= s.execMax);
+
+		// Calls taking longer than the period skip deadlines
+		PeriodicFunc slow(0.005);
+		PeriodicThread ts(0.002);
+		ts.overrunPolicy(PeriodicThread::SKIP).start(slow);
+		al_sleep(0.05);
+		ts.stop();
+		ts.join();
+		s = ts.stats();
+		assert(s.overruns == s.iterations);
+		assert(s.skipped >= 2*s.overruns);
+		assert(s.execPercentile(0.5) >= 0.004);
+	}
+
 	return 0;
 }
@@ -2,6 +2,8 @@
 
 typedef double data_t;
 
+struct TripleBufferFrame{ unsigned n, values[15]; };
+
 int utTypes(){
 
 
@@ -191,6 +193,163 @@ int utTypes(){
 		}	// end size loop
 	}
 
+	{	// Batch interpolated read/write
+		const int N = 7, Nc = 2, Np = 300;
+		float xs[Np], ys[Np], zs[Np];
+		float vals[Np*Nc];
+		for(int i=0; i<Np; ++i){
+			// cover negative and out-of-bounds positions to test wrapping
+			xs[i] = (i*0.137f) - 11.f;
+			ys[i] = (i*0.311f) - 5.f;
+			zs[i] = (i*0.071f) - 3.f;
+			vals[i*Nc  ] = i;
+			vals[i*Nc+1] = 1;
+		}
+
+		Array a(Nc, AlloFloat32Ty, N,N+1,N+2);
+		for(unsigned i=0; i<a.cells()*Nc; ++i) ((float *)a.data.ptr)[i] = i;
+
+		float batch[Np*Nc];
+		a.read_interp_batch(batch, xs, ys, zs, Np);
+		for(int i=0; i<Np; ++i){
+			float v[Nc];
+			a.read_interp(v, xs[i], ys[i], zs[i]);
+			for(int c=0; c<Nc; ++c) assert(fabs(v[c] - batch[i*Nc+c]) < 1e-2);
+		}
+
+		Array single(Nc, AlloFloat32Ty, N,N+1,N+2);
+		Array serial(Nc, AlloFloat32Ty, N,N+1,N+2);
+		Array parallel(Nc, AlloFloat32Ty, N,N+1,N+2);
+		for(int i=0; i<Np; ++i) single.write_interp(vals+i*Nc, xs[i], ys[i], zs[i]);
+		serial.write_interp_batch(vals, xs, ys, zs, Np);
+		parallel.write_interp_batch(vals, xs, ys, zs, Np, 4);
+		for(unsigned i=0; i<single.cells()*Nc; ++i){
+			float v = ((float *)single.data.ptr)[i];
+			assert(fabs(v - ((float *)serial.data.ptr)[i]) < 1e-2);
+			assert(fabs(v - ((float *)parallel.data.ptr)[i]) < 1e-2);
+		}
+
+		// Lower dimensional arrays match 3D arrays with unit trailing dims
+		for(int dims=1; dims<3; ++dims){
+			Array lo, hi(Nc, AlloFloat32Ty, N, dims>1 ? N+1 : 1, 1);
+			if(dims == 1)	lo.format(Nc, AlloFloat32Ty, N);
+			else			lo.format(Nc, AlloFloat32Ty, N, N+1);
+			for(unsigned i=0; i<lo.cells()*Nc; ++i){
+				((float *)lo.data.ptr)[i] = ((float *)hi.data.ptr)[i] = i;
+			}
+
+			float batchHi[Np*Nc];
+			lo.read_interp_batch(batch, xs, ys, zs, Np);
+			hi.read_interp_batch(batchHi, xs, ys, zs, Np);
+			for(int i=0; i<Np*Nc; ++i) assert(fabs(batch[i] - batchHi[i]) < 1e-2);
+
+			lo.zero(); hi.zero();
+			lo.write_interp_batch(vals, xs, ys, zs, Np, 4);
+			hi.write_interp_batch(vals, xs, ys, zs, Np);
+			for(unsigned i=0; i<lo.cells()*Nc; ++i){
+				assert(fabs(((float *)lo.data.ptr)[i] - ((float *)hi.data.ptr)[i]) < 1e-2);
+			}
+		}
+
+		// Mismatched component type is a no-op
+		double dvals[Np*Nc];
+		for(int i=0; i<Np*Nc; ++i) dvals[i] = -1;
+		a.read_interp_batch(dvals, xs, ys, zs, Np);
+		for(int i=0; i<Np*Nc; ++i) assert(dvals[i] == -1);
+		single.zero();
+		single.write_interp_batch(dvals, xs, ys, zs, Np, 4);
+		for(unsigned i=0; i<single.cells()*Nc; ++i) assert(((float *)single.data.ptr)[i] == 0);
+	}
+
+	{	// Memory mapped Array
+		const char * path = "utTypesArray.bin";
+		const int N = 64;
+		const int offset = 12; // deliberately not page aligned
+
+		float src[N + offset/4];
+		for(int i=0; i<N + offset/4; ++i) src[i] = i - offset/4;
+		assert(File::write(path, src, sizeof(src)));
+
+		AlloArrayHeader hdr;
+		{	Array tmp(1, AlloFloat32Ty, N);
+			hdr = tmp.header;
+		}
+
+		Array a;
+		assert(!a.isMapped());
+		assert(!a.map("thisfiledoesnotexist.bin", hdr));
+		assert(a.map(path, hdr, offset));
+		assert(a.isMapped());
+		assert(a.isFormat(hdr));
+		a.advise(Array::ADVISE_SEQUENTIAL);
+		for(int i=0; i<N; ++i) assert(a.elem<float>(0,i) == float(i));
+
+		// copy-on-write changes are not written back to the file
+		Array b;
+		assert(b.map(path, hdr, offset, Array::MAPPED_COPY_ON_WRITE));
+		b.elem<float>(0,0) = -1;
+		assert(b.elem<float>(0,0) == -1);
+		assert(a.elem<float>(0,0) == 0);
+
+		// zeroing read-only mapped data detaches it from the file
+		a.zero();
+		assert(!a.isMapped());
+		assert(a.hasData());
+		for(int i=0; i<N; ++i) assert(a.elem<float>(0,i) == 0);
+
+		b.format(1, AlloFloat32Ty, 4);
+		assert(!b.isMapped());
+
+		::remove(path);
+	}
+
+	{	// Bricked volume
+		const char * path = "utTypesBricks.bin";
+		const int Nx=21, Ny=10, Nz=9, Nc=2;
+
+		Array vol(Nc, AlloFloat32Ty, Nx,Ny,Nz);
+		for(int k=0; k<Nz; ++k){
+		for(int j=0; j<Ny; ++j){
+		for(int i=0; i<Nx; ++i){
+			vol.elem<float>(0,i,j,k) = i + j*Nx + k*Nx*Ny;
+			vol.elem<float>(1,i,j,k) = -1;
+		}}}
+
+		{	BrickArrayWriter w;
+			assert(w.open(path, Nc, AlloFloat32Ty, Nx,Ny,Nz, 4));
+			assert(w.write(vol));
+			assert(w.slices() == Nz);
+			assert(w.close());
+		}
+
+		BrickArray b(3); // small cache to exercise eviction
+		assert(b.open(path));
+		assert(b.dim(0) == Nx && b.dim(1) == Ny && b.dim(2) == Nz);
+		assert(b.bricks(0) == 6 && b.bricks(1) == 3 && b.bricks(2) == 3);
+
+		for(int k=0; k<Nz; ++k){
+		for(int j=0; j<Ny; ++j){
+		for(int i=0; i<Nx; ++i){
+			float v[Nc];
+			b.read(v, i,j,k);
+			assert(v[0] == vol.elem<float>(0,i,j,k));
+			assert(v[1] == -1);
+		}}}
+		assert(b.cacheSize() == 3);
+
+		// interpolation matches dense Array, including across brick edges
+		for(double x=-1.3; x<Nx; x+=1.7){
+			float v1[Nc], v2[Nc];
+			vol.read_interp(v1, x, x*0.4, x*0.3);
+			b.read_interp(v2, x, x*0.4, x*0.3);
+			for(int c=0; c<Nc; ++c) assert(fabs(v1[c] - v2[c]) < 1e-3);
+		}
+
+		b.close();
+		assert(!b.opened());
+		::remove(path);
+	}
+
 
 	{
 		Buffer<int> a(0,2);
@@ -218,6 +377,24 @@ int utTypes(){
 		assert(a[0] == 7);
 		assert(a[1] == 7);
 
+		// Reserving and extending
+		{
+			Buffer<int> c;
+			assert(0 == c.extend(0));
+			c.reserve(6);
+			assert(c.size() == 0 && c.capacity() == 6);
+			int * p = c.extend(4);
+			assert(p == c.elems() && c.size() == 4);
+			p = c.extend(2);
+			assert(p == c.elems() + 4 && c.capacity() == 6);
+			c.extend(1);
+			assert(c.size() == 7 && c.capacity() == 12);
+			c.extend(20);
+			assert(c.size() == 27 && c.capacity() == 27);
+			c.reserve(4);
+			assert(c.capacity() == 27);
+		}
+
 		// Appending another Buffer
 		{
 			Buffer<int> b(4);
@@ -286,6 +463,214 @@ int utTypes(){
 		assert(a.read(3) == 2);
 	}
 
+	{
+		SPSCRing<int> a(6);
+		assert(a.size() == 8);
+		assert(a.writeSpace() == 8);
+		assert(a.readSpace() == 0);
+
+		int src[8] = {0,1,2,3,4,5,6,7}, dst[8];
+		assert(a.write(src, 5) == 5);
+		assert(a.read(dst, 3) == 3);
+		for(int i=0; i<3; ++i) assert(dst[i] == i);
+
+		// Wrap around the end; the ring can be filled completely
+		assert(a.write(src, 8) == 6);
+		assert(a.writeSpace() == 0);
+		assert(!a.push(8));
+		assert(a.peek(dst, 8) == 8);
+		assert(dst[0] == 3 && dst[1] == 4 && dst[2] == 0 && dst[7] == 5);
+		assert(a.read(dst, 8) == 8);
+		int v;
+		assert(!a.pop(v));
+
+		// Regions stop at the end of the ring
+		size_t n = 8;
+		int * w = a.reserve(n);
+		assert(n == 5); // write position is 3
+		for(size_t i=0; i<n; ++i) w[i] = 10 + i;
+		a.commit(n);
+		n = 8;
+		a.reserve(n);
+		assert(n == 3);
+		n = 8;
+		const int * r = a.readRegion(n);
+		assert(n == 5 && r[0] == 10 && r[4] == 14);
+		a.consume(2);
+		assert(a.pop(v) && v == 12);
+		assert(a.readSpace() == 2);
+	}
+
+	// Stream between two threads
+	{
+		struct Producer : public ThreadFunction{
+			SPSCRing<unsigned> * ring;
+			unsigned count;
+			void operator()(){
+				unsigned i = 0;
+				while(i < count){
+					size_t n = 7;
+					unsigned * w = ring->reserve(n);
+					if(n > count - i) n = count - i;
+					for(size_t k=0; k<n; ++k) w[k] = i++;
+					ring->commit(n);
+				}
+			}
+		};
+
+		SPSCRing<unsigned> ring(64);
+		Producer p;
+		p.ring = &ring;
+		p.count = 100000;
+		Thread t(p);
+		unsigned expect = 0;
+		while(expect < p.count){
+			unsigned v;
+			if(ring.pop(v)){
+				assert(v == expect);
+				++expect;
+			}
+		}
+		t.join();
+	}
+
+	// Triple buffer
+	{
+		TripleBuffer<int> a(-1);
+		int v = 0;
+		assert(!a.update());
+		assert(!a.read(v) && v == -1);
+
+		a.write(1);
+		a.back() = 2;
+		a.publish();
+		assert(a.read(v) && v == 2); // newest value only
+		assert(!a.update() && a.front() == 2);
+
+		a.write(3);
+		assert(a.update() && a.front() == 3);
+	}
+
+	// Reader always sees a complete, newer value
+	{
+		struct Writer : public ThreadFunction{
+			TripleBuffer<TripleBufferFrame> * buf;
+			unsigned count;
+			void operator()(){
+				for(unsigned i=1; i<=count; ++i){
+					TripleBufferFrame& f = buf->back();
+					f.n = i;
+					for(int k=0; k<15; ++k) f.values[k] = i + k;
+					buf->publish();
+				}
+			}
+		};
+
+		TripleBuffer<TripleBufferFrame> buf;
+		buf.front().n = 0;
+		Writer w;
+		w.buf = &buf;
+		w.count = 100000;
+		Thread t(w);
+		unsigned last = 0;
+		while(last < w.count){
+			if(buf.update()){
+				const TripleBufferFrame& f = buf.front();
+				assert(f.n > last);
+				for(int k=0; k<15; ++k) assert(f.values[k] == f.n + k);
+				last = f.n;
+			}
+			else al_sleep_nsec(0);
+		}
+		t.join();
+	}
+
+	// Batch color conversions agree with converting one color at a time
+	{
+		const int N = 200;
+		RGB rgb[N], rgb2[N];
+		HSV hsv[N];
+		Lab lab[N];
+		HCLab hcl[N];
+		Color col[N];
+		for(int i=0; i<N; ++i){
+			rgb[i] = RGB((i%7)/6.f, (i%11)/10.f, (i%13)/12.f);
+			col[i].a = 0.5f;
+		}
+
+		convert(rgb, hsv, N);
+		for(int i=0; i<N; ++i){
+			HSV h(rgb[i]);
+			assert(fabs(h.h - hsv[i].h) < 1e-5 && fabs(h.s - hsv[i].s) < 1e-5 && h.v == hsv[i].v);
+		}
+
+		convert(hsv, rgb2, N);
+		convert(hsv, col, N);
+		for(int i=0; i<N; ++i){
+			RGB c(hsv[i]);
+			for(int k=0; k<3; ++k) assert(fabs(c[k] - rgb2[i][k]) < 1e-5 && col[i][k] == rgb2[i][k]);
+			assert(col[i].a == 0.5f);
+		}
+
+		convert(rgb, lab, N);
+		for(int i=0; i<N; ++i){
+			Lab c(rgb[i]);
+			for(int k=0; k<3; ++k) assert(fabs(c[k] - lab[i][k]) < 1e-3);
+		}
+
+		convert(lab, rgb2, N);
+		for(int i=0; i<N; ++i){
+			RGB c(lab[i]);
+			for(int k=0; k<3; ++k) assert(fabs(c[k] - rgb2[i][k]) < 1e-5);
+		}
+
+		convert(lab, hcl, N);
+		for(int i=0; i<N; ++i){
+			HCLab c(lab[i]);
+			assert(fabs(c.c - hcl[i].c) < 1e-5 && fabs(c.l - hcl[i].l) < 1e-5);
+			// hue wraps around
+			float dh = fabs(c.h - hcl[i].h);
+			assert(dh < 1e-5 || dh > 1 - 1e-5 || c.c < 1e-6);
+		}
+
+		convert(hcl, rgb2, N);
+		for(int i=0; i<N; ++i){
+			RGB c(hcl[i]);
+			for(int k=0; k<3; ++k) assert(fabs(c[k] - rgb2[i][k]) < 1e-4);
+		}
+
+		// The scalar Luv conversions divide by zero for black, rgb[0]
+		Luv luv[N];
+		HCLuv hcv[N];
+		convert(rgb, luv, N);
+		assert(luv[0].l == 0 && luv[0].u == 0 && luv[0].v == 0);
+		for(int i=1; i<N; ++i){
+			Luv c(rgb[i]);
+			for(int k=0; k<3; ++k) assert(fabs(c[k] - luv[i][k]) < 1e-3);
+		}
+
+		convert(luv, rgb2, N);
+		for(int k=0; k<3; ++k) assert(rgb2[0][k] == 0);
+		for(int i=1; i<N; ++i){
+			RGB c(luv[i]);
+			for(int k=0; k<3; ++k) assert(fabs(c[k] - rgb2[i][k]) < 1e-5);
+		}
+
+		convert(luv, hcv, N);
+		for(int i=1; i<N; ++i){
+			HCLuv c(luv[i]);
+			assert(fabs(c.c - hcv[i].c) < 1e-5 && fabs(c.l - hcv[i].l) < 1e-5);
+			float dh = fabs(c.h - hcv[i].h);
+			assert(dh < 1e-5 || dh > 1 - 1e-5 || c.c < 1e-6);
+		}
+
+		convert(hcv, rgb2, N);
+		for(int i=1; i<N; ++i){
+			RGB c(hcv[i]);
+			for(int k=0; k<3; ++k) assert(fabs(c[k] - rgb2[i][k]) < 1e-4);
+		}
+	}
+
 	return 0;
 }
 
@@ -1,10 +1,21 @@
+#include <stdio.h>
+#include <string.h>
+#include <vector>
 #include "alloutil/al_WarpBlend.hpp"
 #include "allocore/graphics/al_Image.hpp"
 #include "allocore/graphics/al_Shader.hpp"
 #include "allocore/io/al_File.hpp"
 #include "allocore/math/al_Functions.hpp"
+#include "allocore/system/al_Config.h"
+#include "allocore/system/al_ThreadPool.hpp"
 #include "allocore/system/al_Time.hpp"
 
+#ifndef AL_WINDOWS
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <unistd.h>
+#endif
+
 using namespace al;
 
 Graphics gl;
@@ -870,37 +881,179 @@ void WarpnBlend::readBlend(std::string path) {
 	alphaMap.print();
 }
 
-void WarpnBlend::read3D(std::string path) {
-	File f(path, "rb");
-	if (!f.open()) {
-		printf("failed to open file %s\n", path.c_str());
-		exit(-1);
+// Calibration map cache
+//
+// Calibration maps are stored as planar float arrays, one plane per
+// component. The first time a map is read it is converted into a cache file
+// next to it ("<path>.cache") holding interleaved cells, already flipped
+// into texture row order, after a header padded to a page. Later reads map
+// the cache into memory and copy it straight into the texture and mesh.
+namespace {
+
+const int CACHE_HEADER_BYTES = 4096;
+const int32_t CACHE_VERSION = 1;
+
+struct CacheHeader {
+	char magic[8];
+	int32_t version, width, height, components;
+	al_sec sourceModified;
+};
+
+// Interleaves rows of planar data, optionally flipping them vertically
+struct InterleaveRows {
+	const float * planes;
+	float * cells;
+	int w, h, comps;
+	bool flip;
+	float scale, offset;
+	void operator()(int y0, int y1){
+		for(int y=y0; y<y1; ++y){
+			const int ysrc = flip ? h-y-1 : y;
+			float * row = cells + y*w*comps;
+			for(int c=0; c<comps; ++c){
+				const float * src = planes + (c*h + ysrc)*w;
+				for(int x=0; x<w; ++x) row[x*comps + c] = src[x]*scale + offset;
+			}
+		}
+	}
+};
+
+// Cells of a map, either mapped from a cache file or converted in memory
+class MapCells {
+public:
+	MapCells(): width(0), height(0), mCells(0), mMapped(0), mMappedSize(0){}
+	~MapCells(){ unmap(); }
+
+	const float * cells() const { return mCells; }
+	int width, height;
+
+	bool load(const std::string& path, int comps, bool flip, float scale, float offset){
+		std::string cachePath = path + ".cache";
+		bool haveSource = File::exists(path);
+		al_sec modified = haveSource ? File::modified(path) : 0;
+
+		if(mapCache(cachePath, comps, modified, haveSource)) return true;
+		if(!haveSource) return false;
+
+		File f(path, "rb");
+		if(!f.open()) return false;
+		int32_t dim[2];
+		f.read((void *)dim, sizeof(int32_t), 2);
+		width = dim[1];
+		height = dim[0]/comps;
+		const int elems = width*height;
+		std::vector<float> planes(elems*comps);
+		f.read((void *)&planes[0], sizeof(float), elems*comps);
+		f.close();
+
+		// Rows convert independently; spread them over processors
+		mConverted.resize(elems*comps);
+		InterleaveRows body = { &planes[0], &mConverted[0], width, height, comps, flip, scale, offset };
+		ThreadPool pool;
+		pool.start();
+		pool.parallelFor(0, height, body, 16);
+		pool.stop();
+		mCells = &mConverted[0];
+
+		writeCache(cachePath, comps, modified);
+		return true;
 	}
 
-	int32_t dim[2];
-	f.read((void *)dim, sizeof(int32_t), 2);
-	printf("reading map %s: %dx%d; ", path.c_str(), dim[0], dim[1]);
-
-	int32_t w = dim[1];
-	int32_t h = dim[0]/3;
-	int32_t elems = w*h;
-	//printf("array %dx%d = %d\n", w, h, elems);
-
-	int r = 0;
+private:
+	const float * mCells;
+	std::vector<float> mConverted;
+	void * mMapped;
+	size_t mMappedSize;
+
+	bool mapCache(const std::string& cachePath, int comps, al_sec modified, bool checkModified){
+		if(!File::exists(cachePath)) return false;
+		size_t size = File::sizeFile(cachePath);
+		if(size < size_t(CACHE_HEADER_BYTES)) return false;
+
+		#ifdef AL_WINDOWS
+			mConverted.resize((size + sizeof(float)-1) / sizeof(float));
+			File f(cachePath, "rb", true);
+			if(!f.opened() || f.read(&mConverted[0], 1, size) != int(size)) return false;
+			const char * bytes = (const char *)&mConverted[0];
+		#else
+			int fd = ::open(cachePath.c_str(), O_RDONLY);
+			if(fd < 0) return false;
+			void * m = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			::close(fd);
+			if(MAP_FAILED == m) return false;
+			mMapped = m;
+			mMappedSize = size;
+			const char * bytes = (const char *)m;
+		#endif
+
+		CacheHeader h;
+		memcpy(&h, bytes, sizeof(h));
+		if(	memcmp(h.magic, "ALWARPC", 8) || h.version != CACHE_VERSION
+			|| h.components != comps || h.width <= 0 || h.height <= 0
+			|| size != CACHE_HEADER_BYTES + sizeof(float)*h.width*h.height*comps
+			|| (checkModified && h.sourceModified != modified)
+		){
+			unmap();
+			return false;
+		}
+		width = h.width;
+		height = h.height;
+		mCells = (const float *)(bytes + CACHE_HEADER_BYTES);
+		return true;
+	}
 
-	float * t = (float *)malloc(sizeof(float) * elems);
-	r = f.read((void *)t, sizeof(float), elems);
-	//printf("read %d elements (array size %d)\n", r, elems);
+	void writeCache(const std::string& cachePath, int comps, al_sec modified){
+		std::vector<char> head(CACHE_HEADER_BYTES, 0);
+		CacheHeader h;
+		memset(&h, 0, sizeof(h));
+		memcpy(h.magic, "ALWARPC", 8);
+		h.version = CACHE_VERSION;
+		h.width = width;
+		h.height = height;
+		h.components = comps;
+		h.sourceModified = modified;
+		memcpy(&head[0], &h, sizeof(h));
+
+		// Write to a temporary file and rename it over the cache, so that a
+		// process mapping the cache never sees a partly written file
+		const std::string tmpPath = cachePath + ".tmp";
+		File f(tmpPath, "wb");
+		bool ok =	f.open()
+				&&	f.write(&head[0], 1, head.size())
+				&&	f.write(mCells, sizeof(float)*comps, width*height);
+		f.close();
+
+		#ifdef AL_WINDOWS
+		// rename does not replace an existing file on Windows
+		if(ok) ::remove(cachePath.c_str());
+		#endif
+		if(!ok || 0 != ::rename(tmpPath.c_str(), cachePath.c_str())){
+			::remove(tmpPath.c_str());
+			printf("could not write map cache %s\n", cachePath.c_str());
+		}
+	}
 
-	float * u = (float *)malloc(sizeof(float) * elems);
-	r = f.read((void *)u, sizeof(float), elems);
-	//printf("read %d elements (array size %d)\n", r, elems);
+	void unmap(){
+		#ifndef AL_WINDOWS
+		if(mMapped) munmap(mMapped, mMappedSize);
+		#endif
+		mMapped = 0;
+		mCells = 0;
+	}
+};
 
-	float * v = (float *)malloc(sizeof(float) * elems);
-	r = f.read((void *)v, sizeof(float), elems);
-	//printf("read %d elements (array size %d)\n", r, elems);
+} // ::
 
-	f.close();
+void WarpnBlend::read3D(std::string path) {
+	MapCells map;
+	if (!map.load(path, 3, true, 1, 0)) {
+		printf("failed to open file %s\n", path.c_str());
+		exit(-1);
+	}
+	const int w = map.width;
+	const int h = map.height;
+	const Vec3f * cells = (const Vec3f *)map.cells();
+	printf("reading map %s: %dx%d; ", path.c_str(), w, h);
 
 	pixelMap.resize(w, h);
 	pixelMap.target(Texture::TEXTURE_2D);
@@ -909,90 +1062,26 @@ void WarpnBlend::read3D(std::string path) {
 	pixelMap.filterMin(Texture::LINEAR);
 	pixelMap.allocate(4);
 	pixelMap.print();
-	//pixelMap.array().print();
 	Array& arr = pixelMap.array();
-
-//	inversePixelMap.resize(w, h);
-//	inversePixelMap.target(Texture::TEXTURE_2D);
-//	inversePixelMap.format(Graphics::RGBA);
-//	inversePixelMap.type(Graphics::FLOAT);
-//	inversePixelMap.filterMin(Texture::LINEAR);
-//	inversePixelMap.allocate(4);
-//	inversePixelMap.print();
-//	inversePixelMap.array().print();
-//	Array& arrinv = inversePixelMap.array();
-//	arrinv.setall(0);
-
-	int total = 0;
-	float sum = 0;
-
 	for (int y=0; y<h; y++) {
-		for (int x=0; x<w; x++) {
-			// Y axis appears to be inverted
-			int32_t y1 = (h-y-1);
-			// input data is row-major format
-			int32_t idx = y1*w+x;
-
-			float * cell = arr.cell<float>(x, y);
-			// coordinate system change:
-			cell[0] = t[idx];//*0.5+0.5;
-			cell[1] = u[idx];//*0.5+0.5;
-			cell[2] = v[idx];//*0.5+0.5;
-
-			Vec3f n(cell[0], cell[1], cell[2]);
-			float mag = n.mag();
-			sum += mag;
-			total++;
-
-			/*
-			Vec3f n(cell[0], cell[1], cell[2]);
-			// TODO: subtract from center & rotate first...
-			n = n.normalize();
-
-			// convert to polar:
-			float d = sqrt(n.x*n.x + n.y*n.y + n.z*n.z);
-			float a = atan2(n.z, n.x);	// -pi..pi
-			float e = acos(n.y/d);	// 0..pi
-
-			if (d >= 0.) {
-
-				// normalize azimuth/elevation to texture dimensions:
-				int x1 = w * fmod(a + M_2PI, M_2PI) / M_2PI; //((a/M_PI)+0.5) * w;
-				int y1 = (e/M_PI) * h;
-
-				if (x == w/2) {
-					//printf("%d, %d: ", x, y); n.print(); printf("-> %d %d (%f %f %f)\n", x1, y1, a, e, d);
-				}
-
-				if (x1 >= 0 && x1 < w && y1 >= 0 && y1 < h) {
-					// TODO: use a blending splat instead:
-					float * cellinv = arrinv.cell<float>(x1, y1);
-					cellinv[0] = n.x;
-					cellinv[1] = n.y;
-					cellinv[2] = n.z;
-					cellinv[3] = 1.;
-				}
-			}
-			*/
-		}
+		memcpy(arr.cell<float>(0, y), cells + y*w, sizeof(Vec3f)*w);
 	}
 
-	float avg = sum / total;
-	printf("average radius %f\n", avg);
+	float sum = 0;
+	for (int i=0; i<w*h; i++) sum += cells[i].mag();
+	printf("average radius %f\n", sum / (w*h));
 
 	// also write this data into a mesh:
-	arr = pixelMap.array();
-	for (unsigned y=0; y<arr.height(); y++) {
-	for (unsigned x=0; x<arr.width(); x++) {
-		Vec3f v(arr.cell<float>(x, y));
-		pixelMesh.vertex(v);
-		pixelMesh.color(x/float(arr.width()), y/float(arr.height()), 0.);
-		pixelMesh.texCoord(x/float(arr.width()), y/float(arr.height()));
+	const int n0 = pixelMesh.vertices().size();
+	pixelMesh.vertices().append(cells, w*h);
+	pixelMesh.colors().size(n0 + w*h);
+	pixelMesh.texCoord2s().size(n0 + w*h);
+	for (int y=0; y<h; y++) {
+	for (int x=0; x<w; x++) {
+		const int i = n0 + y*w + x;
+		pixelMesh.colors()[i] = Color(x/float(w), y/float(h), 0.);
+		pixelMesh.texCoord2s()[i].set(x/float(w), y/float(h));
 	}}
-
-	free(t);
-	free(u);
-	free(v);
 }
 
 void WarpnBlend::readProj(std::string path) {
@@ -1011,32 +1100,14 @@ void WarpnBlend::readProj(std::string path) {
 }
 
 void WarpnBlend::readWarp(std::string path) {
-	File f(path, "rb");
-	if (!f.open()) {
+	MapCells map;
+	if (!map.load(path, 2, false, 0.5, 0.5)) {
 		printf("failed to open file %s\n", path.c_str());
 		exit(-1);
 	}
-
-	int32_t dim[2];
-	f.read((void *)dim, sizeof(int32_t), 2);
-	printf("reading map %dx%d; ", dim[0], dim[1]);
-
-	int32_t w = dim[1];
-	int32_t h = dim[0]/2;
-	int32_t elems = w*h;
-	//printf("array %dx%d = %d\n", w, h, elems);
-
-	int r = 0;
-
-	float * u = (float *)malloc(sizeof(float) * elems);
-	r = f.read((void *)u, sizeof(float), elems);
-	//printf("read %d elements (array size %d)\n", r, elems);
-
-	float * v = (float *)malloc(sizeof(float) * elems);
-	r = f.read((void *)v, sizeof(float), elems);
-	//printf("read %d elements (array size %d)\n", r, elems);
-
-	f.close();
+	const int w = map.width;
+	const int h = map.height;
+	printf("reading map %dx%d; ", h*2, w);
 
 	geometryMap.resize(w, h);
 	geometryMap.target(Texture::TEXTURE_2D);
@@ -1045,30 +1116,10 @@ void WarpnBlend::readWarp(std::string path) {
 	geometryMap.filterMin(Texture::LINEAR_MIPMAP_LINEAR);
 	geometryMap.allocate(4);
 	geometryMap.print();
-	//geometryMap.array().print();
 	Array& arr = geometryMap.array();
-
-	float c0, c1;
-
 	for (int y=0; y<h; y++) {
-		for (int x=0; x<w; x++) {
-			int32_t idx = y*w+x;	// row-major format
-
-			float * cell = arr.cell<float>(x, y);
-			cell[0] = u[idx]*0.5+0.5;
-			cell[1] = v[idx]*0.5+0.5;
-
-
-			if (y == h/2) {
-				//printf("x %d y %d: u %f v %f\n", x, y, cell[0]-c0, cell[1]-c1);
-				c0 = cell[0];
-				c1 = cell[1];
-			}
-		}
+		memcpy(arr.cell<float>(0, y), map.cells() + y*w*2, sizeof(float)*2*w);
 	}
-
-	free(u);
-	free(v);
 }
 
 void WarpnBlend::readModelView(std::string path){